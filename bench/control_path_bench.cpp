@@ -0,0 +1,583 @@
+#include <QCoreApplication>
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "compensator.h"
+#include "control_loop.h"
+#include "fsm_controller.h"
+#include "gimbal_controller.h"
+#include "hardware_simulated.h"
+#include "joystick_interface.h"
+#include "latency_histogram.h"
+#include "output_limiter.h"
+#include "tracker_interface.h"
+#include "track_estimator.h"
+#include "tracker_status.h"
+
+// Offline microbenchmarks of the control path on the simulated backend
+//
+//   bc-trail-bench [--iterations N] [--filter <substring>]
+//                  [--servo-pid kp,ki[,kd]] [--servo-lead zero,pole]
+//                  [--servo-notch hz,q,depth-db]...
+//
+// Each benchmark reports the mean time per operation, heap allocations per
+// operation made by the benchmark thread, and percentiles of the cycle
+// count of single operations (TSC ticks on x86, nanoseconds elsewhere).
+// No DAQ card, tracker card or joystick is needed.
+//
+// The servo options take the bc-trail syntax. Their closed-loop step
+// response on the simulated FSM plant is checked after the benchmarks.
+// The exit status is 1 if it does not settle, or if the FSM data ready
+// handler allocated.
+
+namespace {
+
+// Heap allocations made by the benchmark thread; other threads (the
+// simulated hardware) are not counted
+thread_local uint64_t t_allocations = 0;
+
+inline uint64_t readCycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+#endif
+}
+
+inline int64_t monotonicNs()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+}
+
+struct Benchmark {
+    const char *name;
+    std::function<void()> prepare;   // Untimed, before each operation
+    std::function<void()> operation;
+};
+
+struct Options {
+    uint64_t iterations;
+    std::string filter;
+    AxisCompensator::Config servo;
+
+    Options()
+        : iterations(100000)
+    {
+    }
+};
+
+// Comma separated numbers, false unless there are min to max of them
+bool parseList(const char *text, double *values, int min, int max)
+{
+    int count = 0;
+    const char *p = text;
+    while (count < max) {
+        char *end;
+        values[count++] = std::strtod(p, &end);
+        if (end == p || (*end != ',' && *end != '\0')) {
+            return false;
+        }
+        if (*end == '\0') {
+            return count >= min;
+        }
+        p = end + 1;
+    }
+    return false;
+}
+
+struct StepResponse {
+    double overshoot;    // Peak beyond the step, fraction of the step
+    double settlingMs;   // Last time outside the 2 % band
+    double finalError;   // Fraction of the step
+    bool settled;
+};
+
+// Closed-loop step of one FSM axis on the simulated plant. The compensator
+// runs once per control tick on the plant position at the end of the tick
+// and its output is held for the next one, as with the default one-sample
+// feedback filter. The output slew limiter is left out; at its default
+// FSM limits a small step passes it within two ticks.
+StepResponse servoStep(const AxisCompensator::Config &servoConfig, const SimulationConfig &plant,
+                       double rateHz, double step, double durationS)
+{
+    StepResponse response = {0.0, 0.0, 0.0, false};
+
+    AxisCompensator::Config config = servoConfig;
+    config.sampleRateHz = rateHz;
+    AxisCompensator servo;
+    if (!servo.configure(config)) {
+        return response;
+    }
+
+    // Integrated like SimulatedBufferedAnalogIn
+    const double wn = 2.0 * M_PI * plant.plantNaturalHz;
+    const int substeps = std::max(1, static_cast<int>(std::ceil(20.0 * plant.plantNaturalHz / rateHz)));
+    const double h = 1.0 / (rateHz * substeps);
+    double position = 0.0;
+    double velocity = 0.0;
+
+    const int ticks = static_cast<int>(durationS * rateHz);
+    double peak = 0.0;
+    int lastOutside = 0;
+    for (int k = 0; k < ticks; k++) {
+        const double u = plant.plantGain * servo.update(step, position);
+        for (int i = 0; i < substeps; i++) {
+            const double accel = wn * wn * (u - position) - 2.0 * plant.plantDamping * wn * velocity;
+            velocity += accel * h;
+            position += velocity * h;
+        }
+
+        if (!std::isfinite(position)) {
+            return response;
+        }
+        peak = std::max(peak, position);
+        if (std::fabs(position - step) > 0.02 * std::fabs(step)) {
+            lastOutside = k + 1;
+        }
+    }
+
+    response.overshoot = std::max(0.0, (peak - step) / step);
+    response.settlingMs = 1000.0 * lastOutside / rateHz;
+    response.finalError = (position - step) / step;
+
+    // Settled within the first half of the run and still inside the band
+    response.settled = lastOutside < ticks / 2;
+    return response;
+}
+
+// Returns the heap allocations made by the timed operations
+uint64_t run(const Benchmark &bench, const Options &options)
+{
+    if (!options.filter.empty() && std::string(bench.name).find(options.filter) == std::string::npos) {
+        return 0;
+    }
+
+    static LatencyHistogram cycles;
+
+    // Warm caches and lazily allocated state before measuring
+    const uint64_t warmup = std::max<uint64_t>(options.iterations / 10, 1);
+    for (uint64_t i = 0; i < warmup; i++) {
+        if (bench.prepare) bench.prepare();
+        bench.operation();
+    }
+
+    // Applied by the first record() below
+    cycles.reset();
+
+    uint64_t allocations = 0;
+    int64_t elapsedNs = 0;
+    for (uint64_t i = 0; i < options.iterations; i++) {
+        if (bench.prepare) bench.prepare();
+
+        const uint64_t allocBefore = t_allocations;
+        const int64_t start = monotonicNs();
+        const uint64_t c0 = readCycles();
+        bench.operation();
+        const uint64_t c1 = readCycles();
+        elapsedNs += monotonicNs() - start;
+        allocations += t_allocations - allocBefore;
+
+        cycles.record(static_cast<int64_t>(c1 - c0));
+    }
+
+    const LatencySummary summary = cycles.summary();
+    std::printf("%-34s %10" PRIu64 " %10.1f %8.3f %10" PRId64 " %10" PRId64 " %10" PRId64 " %10" PRId64 "\n",
+                bench.name, options.iterations,
+                static_cast<double>(elapsedNs) / options.iterations,
+                static_cast<double>(allocations) / options.iterations,
+                summary.p50Ns, summary.p99Ns, summary.p999Ns, summary.maxNs);
+    return allocations;
+}
+
+/**
+ * @brief Acquisition replaying one section, always ready to be read
+ *
+ * Stands in for the driver so the data ready handler can be called from
+ * the benchmark thread with a full section pending every time.
+ */
+class ReplayAnalogIn : public BufferedAnalogIn
+{
+public:
+    ReplayAnalogIn(int channelCount, int32 sectionScans)
+        : m_volts(static_cast<size_t>(channelCount) * sectionScans)
+        , m_raw(m_volts.size())
+    {
+        for (size_t i = 0; i < m_volts.size(); i++) {
+            m_volts[i] = 2.0 * std::sin(0.1 * i);
+            m_raw[i] = static_cast<int16>(static_cast<uint16_t>((m_volts[i] + 10.0) * (65536.0 / 20.0)));
+        }
+    }
+
+    bool open(int, int, double, int32, std::string &) override { return true; }
+    void close() override {}
+    bool isOpen() const override { return true; }
+
+    void setDataReadyHandler(EventProc, void *) override {}
+    void setStoppedHandler(EventProc, void *) override {}
+
+    int32 bufferCapacity() override { return static_cast<int32>(m_volts.size()); }
+
+    ErrorCode start() override { return Success; }
+    ErrorCode stop() override { return Success; }
+
+    ErrorCode read(int32 count, double *volts) override
+    {
+        std::memcpy(volts, m_volts.data(), sizeof(double) * std::min<size_t>(count, m_volts.size()));
+        return Success;
+    }
+
+    ErrorCode readRaw(int32 count, int16 *raw) override
+    {
+        std::memcpy(raw, m_raw.data(), sizeof(int16) * std::min<size_t>(count, m_raw.size()));
+        return Success;
+    }
+
+    bool rawScaling(double &voltsPerCount, double &voltsAtZero) override
+    {
+        voltsPerCount = 20.0 / 65536.0;
+        voltsAtZero = -10.0;
+        return true;
+    }
+
+private:
+    std::vector<double> m_volts;
+    std::vector<int16> m_raw;
+};
+
+void usage(const char *argv0)
+{
+    std::fprintf(stderr,
+                 "usage: %s [--iterations N] [--filter <substring>]\n"
+                 "       [--servo-pid kp,ki[,kd]] [--servo-lead zero,pole] [--servo-notch hz,q,depth-db]...\n"
+                 "  Microbenchmarks of the control path on the simulated backend\n",
+                 argv0);
+}
+
+} // namespace
+
+void *operator new(size_t size)
+{
+    t_allocations++;
+    void *p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *operator new[](size_t size)
+{
+    t_allocations++;
+    void *p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    t_allocations++;
+    return std::malloc(size ? size : 1);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    t_allocations++;
+    return std::malloc(size ? size : 1);
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+void operator delete[](void *p, size_t) noexcept { std::free(p); }
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--iterations" && i + 1 < argc) {
+            options.iterations = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--filter" && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (arg == "--servo-pid" && i + 1 < argc) {
+            double pid[3] = {0.0, 0.0, 0.0};
+            if (!parseList(argv[++i], pid, 2, 3)) {
+                usage(argv[0]);
+                return 2;
+            }
+            options.servo.kp = pid[0];
+            options.servo.ki = pid[1];
+            options.servo.kd = pid[2];
+        } else if (arg == "--servo-lead" && i + 1 < argc) {
+            double lead[2];
+            if (!parseList(argv[++i], lead, 2, 2)) {
+                usage(argv[0]);
+                return 2;
+            }
+            options.servo.leadLagEnabled = true;
+            options.servo.leadZeroHz = lead[0];
+            options.servo.leadPoleHz = lead[1];
+        } else if (arg == "--servo-notch" && i + 1 < argc && options.servo.notchCount < AxisCompensator::MAX_NOTCHES) {
+            double notch[3];
+            if (!parseList(argv[++i], notch, 3, 3)) {
+                usage(argv[0]);
+                return 2;
+            }
+            AxisCompensator::Notch &n = options.servo.notches[options.servo.notchCount++];
+            n.frequencyHz = notch[0];
+            n.q = notch[1];
+            n.depthDb = notch[2];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (options.iterations == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    QCoreApplication app(argc, argv);
+
+    // Simulated cards only. A private tracker object keeps a running
+    // bc-trail undisturbed, and a slow synthetic tracker rarely races the
+    // messages posted by the benchmark.
+    SimulationConfig simConfig;
+    simConfig.trackerRateHz = 1.0;
+    simConfig.trackerShmName = "/bc-trail-bench-7007";
+    Simulation::setConfig(simConfig);
+    Hardware::setBackend(Hardware::Backend::SIMULATED);
+
+    std::printf("%-34s %10s %10s %8s %10s %10s %10s %10s\n",
+                "benchmark", "iters", "ns/op", "allocs", "p50 cyc", "p99 cyc", "p99.9 cyc", "max cyc");
+
+    // FSM feedback: one AI section through the decimating filter
+    FSMController fsm;
+    const int32 scans = 16;
+    std::vector<double> aiBlock(scans * 2);
+    for (int32 i = 0; i < scans; i++) {
+        aiBlock[2 * i] = 2.0 * std::sin(0.1 * i);
+        aiBlock[2 * i + 1] = 2.0 * std::cos(0.1 * i);
+    }
+    run(Benchmark{"fsm/processAnalogInput(16 scans)", nullptr, [&]() {
+        fsm.replayFeedback(aiBlock.data(), scans);
+    }}, options);
+
+    // The whole data ready handler, with samples scaled by the driver and
+    // from raw counts. It runs on the acquisition thread and must not
+    // allocate; the exit status is 1 if it does.
+    bool allocationFree = true;
+    for (bool raw : {false, true}) {
+        FSMController replay;
+        std::unique_ptr<BufferedAnalogIn> input(new ReplayAnalogIn(replay.getChannelCount(), scans));
+        if (!replay.replayAcquisition(std::move(input), raw)) {
+            std::fprintf(stderr, "FSM controller failed to set up the replayed acquisition\n");
+            return 1;
+        }
+        const char *name = raw ? "fsm/onAiDataReady(raw)" : "fsm/onAiDataReady(volts)";
+        const uint64_t allocations = run(Benchmark{name, nullptr, [&]() {
+            replay.replayDataReady(scans * 2);
+        }}, options);
+        if (allocations != 0) {
+            std::fprintf(stderr, "%s allocated %" PRIu64 " times on the acquisition thread\n", name, allocations);
+            allocationFree = false;
+        }
+    }
+
+    // FSM output commit: a new command every time, and an unchanged one
+    // that the LSB check skips
+    if (!fsm.initialize()) {
+        std::fprintf(stderr, "FSM controller failed to initialize on the simulated backend\n");
+        return 1;
+    }
+    uint64_t step = 0;
+    run(Benchmark{"fsm/commitOutputs(changed)", [&]() {
+        fsm.setManualInputs(0.5 * std::sin(0.01 * step), 0.5 * std::cos(0.01 * step));
+        step++;
+    }, [&]() {
+        fsm.commitOutputs();
+    }}, options);
+    run(Benchmark{"fsm/commitOutputs(unchanged)", nullptr, [&]() {
+        fsm.commitOutputs();
+    }}, options);
+
+    GimbalController gimbal;
+    if (!gimbal.initialize()) {
+        std::fprintf(stderr, "Gimbal controller failed to initialize on the simulated backend\n");
+        return 1;
+    }
+    gimbal.start();
+    run(Benchmark{"gimbal/commitOutputs(changed)", [&]() {
+        gimbal.setPosition(0.2 * std::sin(0.01 * step), 0.2 * std::cos(0.01 * step), 0.0);
+        step++;
+    }, [&]() {
+        gimbal.commitOutputs();
+    }}, options);
+
+    // Tracker: per-field reads against the status block copy and parse on
+    // an 8-byte aligned buffer standing in for the BAR, then
+    // readStatusData() on the simulated card
+    alignas(8) static uint16_t bar[STATUS_MESSAGE_OFFSET / 2 + STATUS_MESSAGE_WORDS];
+    {
+        uint16_t *message = bar + STATUS_MESSAGE_OFFSET / 2;
+        message[0] = TRACKER_SYNC_WORD;
+        message[1] = 0xFF01;
+        message[2] = 100;
+        message[3] = static_cast<uint16_t>(-50);
+        message[5] = TRACKER_STATE_TRACKING << 3;
+        message[7] = TrackerStatus::checksum(message, STATUS_MESSAGE_WORDS - 1);
+    }
+    TrackData parsed;
+
+    // Baseline: one volatile 16-bit read per field, as readStatusData()
+    // did before the block copy; on the card each is a PCIe round trip
+    const auto readWord = [](size_t offset) {
+        return *reinterpret_cast<const volatile uint16_t *>(reinterpret_cast<const char *>(bar) + offset);
+    };
+    run(Benchmark{"tracker/readWord per field", nullptr, [&]() {
+        if (readWord(STATUS_MESSAGE_OFFSET + STATUS_SYNC_WORD) != TRACKER_SYNC_WORD ||
+            (readWord(STATUS_MESSAGE_OFFSET + STATUS_MSG_TYPE) & 0xFF00) != 0xFF00) {
+            return;
+        }
+        parsed.rawErrorX = static_cast<float>(static_cast<int16_t>(readWord(STATUS_MESSAGE_OFFSET + STATUS_ERROR_X))) / 32.0f;
+        parsed.rawErrorY = static_cast<float>(static_cast<int16_t>(readWord(STATUS_MESSAGE_OFFSET + STATUS_ERROR_Y))) / 32.0f;
+        parsed.trackState = (readWord(STATUS_MESSAGE_OFFSET + STATUS_STATUS_WORD) >> 3) & 0x0007;
+        parsed.status = readWord(STATUS_MESSAGE_OFFSET + STATUS_STATUS);
+    }}, options);
+    run(Benchmark{"tracker/copyBlock+parse", nullptr, [&]() {
+        uint16_t words[STATUS_MESSAGE_WORDS];
+        TrackerStatus::copyBlock(bar, words);
+        TrackerStatus::parse(words, parsed);
+    }}, options);
+
+    // Parse alone, from a block already in cached memory
+    uint16_t copied[STATUS_MESSAGE_WORDS];
+    TrackerStatus::copyBlock(bar, copied);
+    run(Benchmark{"tracker/parse", nullptr, [&]() {
+        TrackerStatus::parse(copied, parsed);
+    }}, options);
+
+    TrackerInterface tracker;
+    if (!tracker.initialize()) {
+        std::fprintf(stderr, "Tracker interface failed to initialize on the simulated backend\n");
+        return 1;
+    }
+    run(Benchmark{"tracker/readStatusData", [&]() {
+        uint16_t message[STATUS_MESSAGE_WORDS];
+        message[0] = TRACKER_SYNC_WORD;
+        message[1] = 0xFF01;
+        message[2] = static_cast<uint16_t>(step % 200);
+        message[3] = static_cast<uint16_t>(-20);
+        message[4] = 0;
+        message[5] = TRACKER_STATE_TRACKING << 3;
+        message[6] = 0;
+        message[7] = TrackerStatus::checksum(message, STATUS_MESSAGE_WORDS - 1);
+        tracker.postStatusMessage(message);
+        step++;
+    }, [&]() {
+        tracker.readStatusData(parsed);
+    }}, options);
+
+    // Track estimator: one message folded in every fourth tick, a
+    // prediction every tick, as in auto track at 250 Hz / 1 kHz
+    TrackEstimator estimator;
+    volatile double predicted = 0.0;
+    run(Benchmark{"track/estimator update+predict", nullptr, [&]() {
+        const int64_t nowNs = static_cast<int64_t>(step) * 1000000LL;
+        if (step % 4 == 0) {
+            estimator.update(std::sin(step * 0.01), std::cos(step * 0.01), nowNs);
+        }
+        double x, y;
+        estimator.predict(nowNs, x, y);
+        predicted = x + y;
+        step++;
+    }}, options);
+
+    // Output slew limiter on the three gimbal channels, limited with jerk
+    // and bypassed, following a command that keeps moving
+    const OutputLimitConfig outputLimits;
+    OutputLimiter::Config limiterConfig;
+    limiterConfig.channel[0] = outputLimits.gimbalAz;
+    limiterConfig.channel[1] = outputLimits.gimbalEl;
+    limiterConfig.channel[2] = outputLimits.gimbalAuxEl;
+    for (bool bypass : {false, true}) {
+        limiterConfig.bypass = bypass;
+        OutputLimiter limiter;
+        limiter.configure(limiterConfig, 3, 100.0);
+        volatile double limited = 0.0;
+        run(Benchmark{bypass ? "output/limiter bypassed" : "output/limiter rate+accel+jerk", nullptr, [&]() {
+            double outputs[3] = {std::sin(step * 0.05), std::cos(step * 0.05), (step / 50) % 2 ? 0.5 : -0.5};
+            limiter.apply(outputs);
+            limited = outputs[0] + outputs[1] + outputs[2];
+            step++;
+        }}, options);
+    }
+
+    // Joystick: calibration and normalization of one axis event
+    JoystickInterface joystick;
+    for (int axis = 0; axis < 6; axis++) {
+        joystick.setAxisCalibration(axis, -32768, 32767, 120 * (axis + 1));
+    }
+    volatile double normalized = 0.0;
+    run(Benchmark{"joystick/normalizeAxisValue", nullptr, [&]() {
+        normalized = joystick.normalizeAxisValue(static_cast<int>(step % 6),
+                                                 static_cast<int>(step * 37 % 65536) - 32768);
+        step++;
+    }}, options);
+
+    // Whole control ticks with every component running on the simulated
+    // backend: AI sections arrive, the synthetic tracker and the AO plant run
+    ControlLoop loop;
+    if (!loop.initialize() || !loop.start()) {
+        std::fprintf(stderr, "Control loop failed to start on the simulated backend\n");
+        return 1;
+    }
+    loop.detachControlThread();
+    loop.setOperationMode(ControlLoop::OperationMode::AUTO_TRACK);
+    run(Benchmark{"loop/controlLoopTick(auto)", nullptr, [&]() {
+        loop.runTick();
+    }}, options);
+
+    // Instrumentation added to the hot path
+    LatencyHistogram histogram;
+    run(Benchmark{"instrumentation/histogram.record", nullptr, [&]() {
+        histogram.record(static_cast<int64_t>(step++ * 7919 % 100000));
+    }}, options);
+
+    loop.stop();
+
+    // Closed-loop check of the servo gains on the plant of the simulated
+    // backend, at the default control rate
+    if (options.filter.empty() || std::string("servo/step").find(options.filter) != std::string::npos) {
+        const StepResponse response = servoStep(options.servo, simConfig, ControlRateConfig().rateHz, 0.05, 0.5);
+        std::printf("\n%-34s %10s %10s %10s %8s\n", "closed loop", "overshoot", "settle ms", "error", "result");
+        std::printf("%-34s %9.1f%% %10.1f %9.2f%% %8s\n", "servo/step(0.05)",
+                    100.0 * response.overshoot, response.settlingMs, 100.0 * response.finalError,
+                    response.settled ? "ok" : "FAIL");
+        if (!response.settled) {
+            return 1;
+        }
+    }
+    return allocationFree ? 0 : 1;
+}
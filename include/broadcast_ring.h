@@ -0,0 +1,154 @@
+#ifndef BROADCAST_RING_H
+#define BROADCAST_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * @brief Single-writer ring that any number of readers tail independently.
+ *
+ * The writer never waits for readers: it overwrites the oldest slot, and
+ * each slot is guarded by its own sequence like a SeqLock. A reader keeps
+ * its own cursor, so a slow reader loses the samples that were overwritten
+ * before it got to them and knows how many, without affecting the writer or
+ * any other reader. The ring holds no pointers and only lock-free atomics,
+ * so it can live in memory shared between processes.
+ */
+template <typename T, size_t Capacity>
+class BroadcastRing
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "BroadcastRing capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "BroadcastRing requires a trivially copyable type");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "BroadcastRing requires lock-free 64-bit atomics");
+
+public:
+    BroadcastRing()
+        : m_head(0)
+    {
+        for (size_t i = 0; i < Capacity; ++i) {
+            m_slots[i].sequence.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // Writer side, one thread only
+    void push(const T &value)
+    {
+        uint64_t buffer[WORDS] = {};
+        std::memcpy(buffer, &value, sizeof(T));
+
+        const uint64_t pos = m_head.load(std::memory_order_relaxed);
+        Slot &slot = m_slots[pos & MASK];
+        slot.sequence.store(2 * pos + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < WORDS; ++i) {
+            slot.words[i].store(buffer[i], std::memory_order_relaxed);
+        }
+
+        slot.sequence.store(2 * pos + 2, std::memory_order_release);
+        m_head.store(pos + 1, std::memory_order_release);
+    }
+
+    // Position the next push() will write; elements [head - Capacity, head)
+    // may still be readable
+    uint64_t head() const { return m_head.load(std::memory_order_acquire); }
+
+    enum class ReadResult {
+        OK,
+        NOT_YET,       // Not written yet
+        OVERWRITTEN    // Already replaced by a newer element
+    };
+
+    /**
+     * @brief Read the element written at position pos
+     */
+    ReadResult read(uint64_t pos, T &value) const
+    {
+        const Slot &slot = m_slots[pos & MASK];
+        const uint64_t expected = 2 * pos + 2;
+
+        const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before != expected) {
+            return before < expected ? ReadResult::NOT_YET : ReadResult::OVERWRITTEN;
+        }
+
+        uint64_t buffer[WORDS];
+        for (size_t i = 0; i < WORDS; ++i) {
+            buffer[i] = slot.words[i].load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != before) {
+            return ReadResult::OVERWRITTEN;
+        }
+
+        std::memcpy(&value, buffer, sizeof(T));
+        return ReadResult::OK;
+    }
+
+    /**
+     * @brief Copy up to maxCount elements from cursor on and advance it
+     * @param lost Incremented by the elements overwritten before they were read
+     * @return Number of elements copied
+     */
+    size_t readFrom(uint64_t &cursor, T *out, size_t maxCount, uint64_t &lost) const
+    {
+        const uint64_t end = head();
+        if (end - cursor > Capacity) {
+            lost += end - Capacity - cursor;
+            cursor = end - Capacity;
+        }
+
+        size_t count = 0;
+        while (cursor < end && count < maxCount) {
+            const ReadResult result = read(cursor, out[count]);
+            if (result == ReadResult::NOT_YET) {
+                break;
+            }
+            if (result == ReadResult::OK) {
+                count++;
+            } else {
+                lost++;
+            }
+            cursor++;
+        }
+        return count;
+    }
+
+    /**
+     * @brief Read the newest element
+     * @return False if nothing has been written yet
+     */
+    bool latest(T &value) const
+    {
+        for (;;) {
+            const uint64_t end = head();
+            if (end == 0) {
+                return false;
+            }
+            if (read(end - 1, value) == ReadResult::OK) {
+                return true;
+            }
+        }
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    static const size_t MASK = Capacity - 1;
+    static const size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    struct Slot {
+        std::atomic<uint64_t> sequence;   // 2 * pos + 1 while writing pos, 2 * pos + 2 once written
+        std::atomic<uint64_t> words[WORDS];
+    };
+
+    Slot m_slots[Capacity];
+    alignas(64) std::atomic<uint64_t> m_head;
+};
+
+#endif // BROADCAST_RING_H
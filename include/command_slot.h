@@ -0,0 +1,100 @@
+#ifndef COMMAND_SLOT_H
+#define COMMAND_SLOT_H
+
+#include <atomic>
+#include <cstdint>
+#include <sched.h>
+
+#include "seqlock.h"
+
+/**
+ * @brief Lock-free slot for a command or feedback value shared between threads.
+ *
+ * A SeqLock whose writers are serialized by a spin flag, so any thread may
+ * store. Readers never block a writer. Every retry (a reader racing a write,
+ * or two writers racing each other) is counted, so contentionCount() shows
+ * how often the slot was actually contended.
+ */
+template <typename T>
+class CommandSlot
+{
+public:
+    CommandSlot()
+        : m_contention(0)
+    {
+        m_writer.clear();
+    }
+
+    explicit CommandSlot(const T &initial)
+        : CommandSlot()
+    {
+        m_value.store(initial);
+    }
+
+    void store(const T &value)
+    {
+        int spins = 0;
+        while (m_writer.test_and_set(std::memory_order_acquire)) {
+            m_contention.fetch_add(1, std::memory_order_relaxed);
+            // The other writer holds the flag for a few stores only, but
+            // may have been preempted
+            if (++spins > 64) {
+                sched_yield();
+            }
+        }
+
+        m_value.store(value);
+        m_writer.clear(std::memory_order_release);
+    }
+
+    T load() const
+    {
+        T value;
+        while (!m_value.tryLoad(value)) {
+            m_contention.fetch_add(1, std::memory_order_relaxed);
+        }
+        return value;
+    }
+
+    /**
+     * @brief Single read attempt if the value changed since seenVersion
+     *
+     * For a reader that must not spin, such as the control tick: a store
+     * in progress is counted and reported as no change, to be picked up
+     * on a later attempt. On success seenVersion is updated.
+     * @return True if value was replaced by a newer one
+     */
+    bool loadIfChanged(T &value, uint32_t &seenVersion) const
+    {
+        uint32_t version;
+        if (!m_value.tryLoad(value, version)) {
+            m_contention.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (version == seenVersion) {
+            return false;
+        }
+        seenVersion = version;
+        return true;
+    }
+
+    // Number of completed stores, usable as a change counter
+    uint32_t version() const { return m_value.version(); }
+
+    uint64_t contentionCount() const { return m_contention.load(std::memory_order_relaxed); }
+
+private:
+    SeqLock<T> m_value;
+    std::atomic_flag m_writer;
+    mutable std::atomic<uint64_t> m_contention;
+};
+
+/**
+ * @brief X/Y pair for two-axis commands and feedback
+ */
+struct AxisPair {
+    double x;
+    double y;
+};
+
+#endif // COMMAND_SLOT_H
@@ -0,0 +1,166 @@
+#ifndef COMPENSATOR_H
+#define COMPENSATOR_H
+
+/**
+ * @brief Second-order IIR section (transposed direct form II)
+ */
+class Biquad
+{
+public:
+    Biquad();
+
+    // Pass-through section
+    void setIdentity();
+
+    /**
+     * @brief Discretize an analog second-order section with the bilinear
+     *        transform, prewarped at prewarpHz (0 for no prewarping)
+     *
+     * H(s) = (b2 s^2 + b1 s + b0) / (a2 s^2 + a1 s + a0)
+     */
+    void setAnalog(double b2, double b1, double b0,
+                   double a2, double a1, double a0,
+                   double sampleRateHz, double prewarpHz);
+
+    void reset(double steadyInput = 0.0);
+
+    double process(double x)
+    {
+        const double y = m_b0 * x + m_z1;
+        m_z1 = m_b1 * x - m_a1 * y + m_z2;
+        m_z2 = m_b2 * x - m_a2 * y;
+        return y;
+    }
+
+    double dcGain() const;
+
+private:
+    double m_b0, m_b1, m_b2;
+    double m_a1, m_a2;
+    double m_z1, m_z2;
+};
+
+/**
+ * @brief Discrete-time compensator for one FSM axis.
+ *
+ * u = limit(ff * r + notch(leadlag(PID(r - y))))
+ *
+ * The PID uses conditional integration for anti-windup and a first-order
+ * filtered derivative on the measurement. Lead-lag and notch sections are
+ * biquads. All coefficients are computed in configure(); update() costs a
+ * few multiply-adds and never allocates.
+ */
+class AxisCompensator
+{
+public:
+    static const int MAX_NOTCHES = 3;
+
+    struct Notch {
+        double frequencyHz;  // Mirror resonance to suppress
+        double q;            // Quality factor of the notch
+        double depthDb;      // Attenuation at the notch centre
+    };
+
+    struct Config {
+        double sampleRateHz;
+
+        double feedforward;        // Gain applied to the setpoint
+        double kp;
+        double ki;                 // Per second
+        double kd;                 // Seconds
+        double derivativeCutoffHz; // Derivative low-pass corner
+        double outputLimit;        // Symmetric output clamp
+
+        bool leadLagEnabled;
+        double leadZeroHz;
+        double leadPoleHz;
+
+        int notchCount;
+        Notch notches[MAX_NOTCHES];
+
+        Config();
+    };
+
+    AxisCompensator();
+
+    /**
+     * @brief Precompute coefficients
+     * @return False if the configuration is invalid; the previous one is kept
+     */
+    bool configure(const Config &config);
+    const Config &config() const { return m_config; }
+
+    /**
+     * @brief Clear all states
+     */
+    void reset();
+
+    /**
+     * @brief Preload states so the next output equals `output` for the
+     *        given setpoint and measurement (bumpless engagement)
+     */
+    void initialize(double output, double setpoint, double measurement);
+
+    /**
+     * @brief Run one sample
+     * @param setpoint Commanded position
+     * @param measurement Measured position
+     * @return Limited output command
+     */
+    double update(double setpoint, double measurement)
+    {
+        const double error = setpoint - measurement;
+
+        // Conditional integration: freeze while saturated in the same direction
+        if (!(m_saturated && error * m_lastOutput > 0.0)) {
+            m_integral += m_kiTs * error;
+            if (m_integral > m_limit) m_integral = m_limit;
+            else if (m_integral < -m_limit) m_integral = -m_limit;
+        }
+
+        // Filtered derivative on measurement (no setpoint kick)
+        m_derivative = m_dAlpha * m_derivative - m_dGain * (measurement - m_lastMeasurement);
+        m_lastMeasurement = measurement;
+
+        double u = m_kp * error + m_integral + m_derivative;
+        u = m_leadLag.process(u);
+        for (int i = 0; i < m_notchCount; ++i) {
+            u = m_notch[i].process(u);
+        }
+        u += m_ff * setpoint;
+
+        m_saturated = true;
+        if (u > m_limit) u = m_limit;
+        else if (u < -m_limit) u = -m_limit;
+        else m_saturated = false;
+
+        m_lastOutput = u;
+        return u;
+    }
+
+    double lastOutput() const { return m_lastOutput; }
+    bool isSaturated() const { return m_saturated; }
+
+private:
+    Config m_config;
+
+    // Precomputed coefficients
+    double m_ff;
+    double m_kp;
+    double m_kiTs;
+    double m_dAlpha;
+    double m_dGain;
+    double m_limit;
+    int m_notchCount;
+    Biquad m_leadLag;
+    Biquad m_notch[MAX_NOTCHES];
+
+    // States
+    double m_integral;
+    double m_derivative;
+    double m_lastMeasurement;
+    double m_lastOutput;
+    bool m_saturated;
+};
+
+#endif // COMPENSATOR_H
@@ -2,9 +2,9 @@
 #define CONTROL_LOOP_H
 
 #include <QObject>
-#include <QThread>
-#include <QTimer>
 #include <QMutex>
+#include <QStringList>
+#include <QTimer>
 #include <atomic>
 #include <memory>
 
@@ -12,6 +12,106 @@
 #include "gimbal_controller.h"
 #include "tracker_interface.h"
 #include "joystick_interface.h"
+#include "realtime_thread.h"
+#include "telemetry.h"
+#include "compensator.h"
+#include "latency_histogram.h"
+#include "tick_monitor.h"
+#include "manual_input.h"
+#include "command_slot.h"
+#include "rate_group.h"
+#include "track_estimator.h"
+#include "gimbal_offload.h"
+#include "output_limiter.h"
+#include "track_loss.h"
+
+// Interval of the scheduler health check on the GUI thread, and the
+// shortest interval between two overrun warnings
+#define TICK_HEALTH_CHECK_MS 1000
+#define TICK_WARNING_INTERVAL_MS 10000
+
+// Overruns per health check that raise a warning by default
+#define TICK_OVERRUN_WARN_DEFAULT 5
+
+// Interval of the GUI thread poll that signals mode changes made by the
+// control thread
+#define CONTROL_NOTIFY_INTERVAL_MS 20
+
+// Default fade between the command sources of two operation modes
+#define MODE_TRANSITION_DEFAULT_MS 100
+
+// Supported control rates
+#define CONTROL_RATE_MIN_HZ 100
+#define CONTROL_RATE_MAX_HZ 20000
+
+// Longest wait of an AI-driven tick for the next section before it gives
+// the thread a chance to see stop()
+#define CONTROL_AI_WAIT_TIMEOUT_MS 20
+
+/**
+ * @brief Rate of the control tick and what paces it.
+ *
+ * The FSM feedback is sampled at rateHz * aiSectionScans, so every tick
+ * gets one AI section. Timer driven, the tick runs on its own
+ * clock_nanosleep deadline; AI driven, it runs as each section arrives,
+ * on the card's conversion clock.
+ */
+struct ControlRateConfig {
+    int rateHz;           // Control ticks per second
+    int aiSectionScans;   // AI scans per tick
+    bool aiDriven;        // Wake on each AI section instead of a timer
+
+    ControlRateConfig()
+        : rateHz(1000)
+        , aiSectionScans(1)
+        , aiDriven(false)
+    {
+    }
+};
+
+/**
+ * @brief Rates of the task groups of the control tick, as divisors of the
+ *        control rate. The FSM feedback, servo and output run every tick.
+ */
+struct RateGroupConfig {
+    int trackerDivisor;    // Take tracker frames every n ticks
+    int joystickDivisor;   // Apply joystick positions every n ticks
+    int gimbalDivisor;     // Read and command the gimbal every n ticks
+
+    RateGroupConfig()
+        : trackerDivisor(1)
+        , joystickDivisor(4)
+        , gimbalDivisor(10)
+    {
+    }
+};
+
+/**
+ * @brief Slew limits of the five analog outputs, per second of motion in
+ *        normalized units. Applied as each output is committed, the FSM
+ *        at the control rate and the gimbal at the gimbal group rate.
+ *        A zero limit disables that stage.
+ */
+struct OutputLimitConfig {
+    bool bypass;                            // Commit commands unlimited
+    OutputLimiter::ChannelLimits fsmX;
+    OutputLimiter::ChannelLimits fsmY;
+    OutputLimiter::ChannelLimits gimbalAz;
+    OutputLimiter::ChannelLimits gimbalEl;
+    OutputLimiter::ChannelLimits gimbalAuxEl;
+
+    // Full FSM travel in 10 ms with no jerk delay in the fast loop;
+    // full gimbal travel in a second with 0.1 s acceleration ramps
+    OutputLimitConfig()
+        : bypass(false)
+        , fsmX{200.0, 100000.0, 0.0}
+        , fsmY{200.0, 100000.0, 0.0}
+        , gimbalAz{2.0, 10.0, 100.0}
+        , gimbalEl{2.0, 10.0, 100.0}
+        , gimbalAuxEl{2.0, 10.0, 100.0}
+    {
+    }
+};
 
 class ControlLoop : public QObject
 {
@@ -24,38 +124,196 @@ public:
         AUTO_TRACK     // Automatic tracking using tracker card data
     };
 
+    // Stage boundaries on the path from each sensor to the DACs
+    enum class LatencyStage {
+        TRACK_INGEST,      // Tracker mailbox seen to sample published
+        TRACK_TO_COMMAND,  // Tracker mailbox seen to staged on the FSM
+        TRACK_TO_DAC,      // Tracker mailbox seen to FSM DAC write
+        JOYSTICK_PUBLISH,  // Joystick event to axes published
+        JOYSTICK_TO_DAC,   // Joystick event to DAC write
+        AI_TO_FEEDBACK,    // AI data-ready event to feedback published
+        FEEDBACK_TO_DAC,   // Feedback published to the next DAC write
+        TICK_WAKEUP,       // Control tick deadline to tick running
+        TICK_TO_DAC,       // Control tick deadline to DAC write
+        COUNT
+    };
+
     explicit ControlLoop(QObject *parent = nullptr);
     ~ControlLoop();
 
     bool initialize();
     bool start();
     bool stop();
+    bool isRunning() const { return m_running.load(); }
 
     // Set operation mode
     void setOperationMode(OperationMode mode);
     OperationMode getOperationMode() const;
 
+    // Control rate and FSM acquisition, set while stopped. Applied on the
+    // next start().
+    bool setControlRateConfig(const ControlRateConfig &config);
+    ControlRateConfig getControlRateConfig() const;
+
+    // Scheduling of the control thread, applied on the next start()
+    void setRealtimeConfig(const RealtimeConfig &config);
+    RealtimeConfig getRealtimeConfig() const;
+
+    // Tracker ingest thread configuration, applied on the next initialize().
+    // A scheduled config polls the mailbox from the tracker task instead.
+    void setTrackerIngestConfig(const TrackerIngestConfig &config);
+
+    // Task group rates, applied on the next start()
+    void setRateGroupConfig(const RateGroupConfig &config);
+    RateGroupConfig getRateGroupConfig() const;
+
+    // Length of the fade between the outputs of two operation modes, 0 to
+    // switch in one commit. Mode changes while running are applied by the
+    // control tick.
+    void setModeTransitionTime(int ms);
+    int getModeTransitionTime() const;
+
+    // Output slew limits. Also re-applied by start() at the configured
+    // rates; changing them while running restarts the limiters at the
+    // current outputs.
+    bool setOutputLimitConfig(const OutputLimitConfig &config);
+    OutputLimitConfig getOutputLimitConfig() const;
+
+    // Scheduling of the joystick input thread, applied on the next start()
+    void setJoystickRealtimeConfig(const RealtimeConfig &config);
+
+    // Stream the FSM command through the hardware-clocked AO buffer at the
+    // AI sample rate, one section of scans per control tick. Applied on
+    // the next start().
+    void setFsmClockedOutput(bool enabled, int leadScans = 2);
+
+    // Read the FSM feedback as raw counts and scale them in one batch per
+    // section. Applied on the next start().
+    void setFsmRawAcquisition(bool enabled);
+
+    // Decimating filter of the FSM feedback, applied on the next
+    // initialize(), or at once if the FSM is already initialized
+    bool setFeedbackFilterConfig(const FeedbackFilter::Config &config);
+    FeedbackFilter::Config getFeedbackFilterConfig() const;
+
+    // Control tick rate
+    int getControlRate() const;
+
+    // Control thread statistics. Overruns include AI sections that arrived
+    // while an AI-driven tick was still running.
+    uint64_t getCycleCount() const;
+    uint64_t getOverrunCount() const;
+
+    // Times a thread had to retry or wait on shared state, summed over the
+    // control tick and all components
+    uint64_t getContentionCount() const;
+
+    // Deadzones, inversions and enables of the joystick drive, applied by
+    // the control tick to the next joystick position without locking
+    void setManualInputConfig(const ManualInputConfig &config);
+    ManualInputConfig getManualInputConfig() const;
+
+    // Closed-loop FSM servo. Coefficients are computed here, at
+    // configuration time; the sample rate is the control rate.
+    bool setServoConfig(const AxisCompensator::Config &xConfig,
+                        const AxisCompensator::Config &yConfig);
+    void setServoEnabled(bool enabled);
+    bool isServoEnabled() const;
+
+    // Estimator between the tracker and the FSM in auto track. Enabled,
+    // the FSM follows the track error predicted to each tick instead of
+    // the last report. Takes effect on the next tracker message.
+    bool setTrackEstimatorConfig(const TrackEstimator::Config &config);
+    TrackEstimator::Config getTrackEstimatorConfig() const;
+
+    // What auto track does when the tracker loses the target: coast on
+    // the estimator, hold, then fall back. Evaluated every control tick.
+    bool setTrackLossConfig(const TrackLossPolicy::Config &config);
+    TrackLossPolicy::Config getTrackLossConfig() const;
+    TrackLossStatistics getTrackLossStatistics() const;
+
+    // Gimbal off-load in auto track. Enabled, the gimbal stays powered in
+    // auto track and is driven at the gimbal rate to keep the FSM centred.
+    bool setGimbalOffloadConfig(const GimbalOffload::Config &config);
+    GimbalOffload::Config getGimbalOffloadConfig() const;
+
+    // Components driven by the loop. Clients configure and inspect them
+    // here rather than opening the hardware a second time.
+    FSMController *fsmController() const { return m_fsmController.get(); }
+    GimbalController *gimbalController() const { return m_gimbalController.get(); }
+    TrackerInterface *trackerInterface() const { return m_trackerInterface.get(); }
+    JoystickInterface *joystickInterface() const { return m_joystickInterface.get(); }
+
+    // Lock-free telemetry published by the control thread every tick
+    TelemetryChannel *telemetry() { return &m_telemetry; }
+
+    // Latency histograms, recorded on the thread that owns each stage
+    LatencySummary getLatency(LatencyStage stage) const;
+    static QString latencyStageName(LatencyStage stage);
+    void resetLatency();
+
+    // One line per stage with count, p50, p99, p99.9 and max in us
+    QStringList latencyReport() const;
+
+    // Wake-up, duration and slack of every control tick since the last
+    // start() or reset, and the ticks with the least slack
+    TickStatistics getTickStatistics() const;
+    int getWorstTicks(TickRecord *out) const;
+    void resetTickStatistics();
+    QStringList schedulerReport() const;
+
+    // Track losses, how they ended, reacquisition time percentiles and
+    // the tracked share of auto track time, since the last latency reset
+    QStringList trackLossReport() const;
+
+    // Warn when more than threshold ticks overrun within one health check
+    // interval; 0 disables the warning
+    void setOverrunWarning(int threshold);
+
+    // For bc-trail-bench: stop the control thread of a started loop but
+    // leave its components running, then run ticks on the calling thread
+    void detachControlThread();
+    void runTick();
+
 signals:
     void statusChanged(const QString &message);
     void errorOccurred(const QString &error);
     void operationModeChanged(OperationMode mode);
-    void telemetryUpdated(double fsmX, double fsmY,
-                         double gimbalAz, double gimbalEl, double gimbalAuxEl,
-                         double joystickX, double joystickY, double joystickZ,
-                         double trackErrorX, double trackErrorY);
 
 private slots:
     void handleJoystickModeButtonPressed();
-    void handleJoystickPositionChanged(double x, double y, double z);
-    void handleJoystickRotationChanged(double rx, double ry, double rz);
     void handleTrackingStatusChanged(bool isTracking);
-    void handleTrackingErrorsUpdated(double xError, double yError);
-    void handleFSMFeedbackUpdated(double x, double y);
-    void controlLoopTick();
+    void checkSchedulerHealth();
+    void deliverNotifications();
 
 private:
+    // Runs on the real-time control thread once per period
+    void controlLoopTick();
+
+    // Picks up configuration published since the last tick
+    bool applyConfigUpdates();
+
+    // Tasks of the control tick, registered with m_scheduler by start()
+    void configureRateGroups();
+    bool applyOutputLimits(const OutputLimitConfig &config);
+    void readFsmFeedback();
+    void readGimbal();
+    void readJoystick();
+    void readTracker();
+    void computeManual();
+    void computeTracking();
+    void predictTracking();
+    void computeOffload();
+    void transitionMode();
+    void handleTrackLoss();
+    void computeServo();
+    void writeFsm();
+    void writeGimbal();
+    void publishTick();
+
     // Helper methods
-    void updateControlMode();
+    void updateControlMode(OperationMode mode, int fsmCommits = 0, int gimbalCommits = 0);
+    void requestModeUpdate();
     void cycleOperationMode();
 
     // Component objects
@@ -63,20 +321,159 @@ private:
     std::unique_ptr<GimbalController> m_gimbalController;
     std::unique_ptr<TrackerInterface> m_trackerInterface;
     std::unique_ptr<JoystickInterface> m_joystickInterface;
+    FeedbackFilter::Config m_feedbackFilterConfig;
+
+    // Dedicated periodic thread running controlLoopTick()
+    RealtimeThread m_rtThread;
+    RealtimeConfig m_rtConfig;
+
+    // Task groups run by the tick at sub-multiples of the control rate
+    RateGroupScheduler m_scheduler;
+    RateGroupConfig m_rateConfig;
+    OutputLimitConfig m_outputLimits;
+    uint64_t m_tickIndex;
+    int m_gimbalDivisor;
+    std::atomic<bool> m_trackerScheduled;
+
+    // Inputs and results shared by the tasks. Values read by a slower
+    // group hold until it runs again; the *Applied flags cover this tick.
+    struct TickState {
+        int64_t startNs;       // Tick started
+        int64_t wakeNs;        // Deadline the tick was scheduled for
+        int64_t commitNs;      // FSM output written
+        OperationMode mode;
+        uint32_t flags;        // TICK_* bits
+
+        double fsmX, fsmY;
+        int64_t feedbackNs;
+        FeedbackFilter::BlockStats feedbackStats;
+        double gimbalAz, gimbalEl, gimbalAuxEl;
 
-    // High-precision timer for control loop
-    QTimer *m_controlTimer;
+        JoystickAxes joystick;
+        uint32_t joystickVersion;
+        bool joystickApplied;
 
-    // Operation state
-    OperationMode m_mode;
+        double trackErrorX, trackErrorY;
+        int64_t trackArrivalNs;
+        uint64_t trackFrame;
+        bool isTracking;
+        bool trackApplied;
+    };
+    TickState m_tick;
+
+    // Telemetry out of the control thread
+    TelemetryChannel m_telemetry;
+
+    // Scheduler health of the control thread, checked on the GUI thread
+    TickMonitor m_tickMonitor;
+    QTimer *m_healthTimer;
+    int m_overrunWarnThreshold;
+    uint64_t m_checkedOverruns;
+    int64_t m_lastWarningNs;
+    uint64_t m_suppressedWarnings;
+
+    // Operation state. The mode is read by the control thread and written
+    // from the GUI thread without locking.
+    std::atomic<OperationMode> m_mode;
     bool m_isTrackingActive;
 
-    // Synchronization
+    // Mode the components were last switched to by the control tick, a
+    // request to switch them again for a configuration change, and the
+    // fade length, read by the tick without locking
+    OperationMode m_appliedMode;
+    std::atomic<bool> m_modeUpdatePending;
+    std::atomic<int> m_modeTransitionMs;
+
+    // Configuration of the state the control tick owns. The setters
+    // validate it and publish it here; the tick picks up a newer version
+    // at its start, or on a later tick if it catches a store in progress.
+    struct ServoConfig {
+        AxisCompensator::Config x;
+        AxisCompensator::Config y;
+    };
+    CommandSlot<ServoConfig> m_servoConfig;
+    CommandSlot<TrackEstimator::Config> m_trackEstimatorConfig;
+    CommandSlot<TrackLossPolicy::Config> m_trackLossConfig;
+    CommandSlot<GimbalOffload::Config> m_gimbalOffloadConfig;
+    uint32_t m_appliedServoConfig;
+    uint32_t m_appliedTrackEstimatorConfig;
+    uint32_t m_appliedTrackLossConfig;
+    uint32_t m_appliedGimbalOffloadConfig;
+
+    // FSM compensators, run by the control tick. Enabled is the requested
+    // state, written by any thread; engaged is the one the tick applied.
+    AxisCompensator m_servoX;
+    AxisCompensator m_servoY;
+    std::atomic<bool> m_servoEnabled;
+    bool m_servoEngaged;
+
+    // Tracker message last applied to the FSM by the control tick, and its
+    // age (arrival to FSM write) at the time it was applied
+    uint64_t m_appliedTrackFrame;
+    int64_t m_appliedTrackAgeNs;
+
+    // Track error estimator, fed every message while tracking in any mode
+    // so auto track starts from a settled state. Predicts to the tick plus
+    // the clocked output lead.
+    TrackEstimator m_trackEstimator;
+    uint64_t m_estimatedTrackFrame;
+    int64_t m_trackPredictionLeadNs;
+
+    // Track loss policy, run by the control tick. A hand-off to manual
+    // changes the mode on the control thread; the notify poll tells the
+    // GUI.
+    TrackLossPolicy m_trackLoss;
+    std::atomic<bool> m_trackLossHandoff;
+
+    // Polls what the control thread counted, flagged or switched and
+    // signals it from the GUI thread. DAC write failures are reported at
+    // once, then at most once per warning interval while they persist.
+    QTimer *m_notifyTimer;
+    FSMController::ControlMode m_reportedFsmMode;
+    bool m_reportedGimbalEnabled;
+    uint64_t m_reportedFsmFailures;
+    uint64_t m_reportedGimbalFailures;
+    int64_t m_lastFailureReportNs;
+
+    // Gimbal off-load, run by the control tick at the gimbal rate. Enabled
+    // is read by updateControlMode(), which runs on the control thread or,
+    // stopped, on the caller's; active is whether the tick has engaged it
+    // since auto track was entered.
+    GimbalOffload m_gimbalOffload;
+    std::atomic<bool> m_offloadEnabled;
+    bool m_offloadActive;
+    double m_offloadDt;
+
+    // Joystick axes last applied by the control tick, the aux elevation
+    // command derived from them, and the age of the event at that time
+    uint32_t m_appliedJoystickVersion;
+    JoystickAxes m_appliedJoystick;
+    uint32_t m_appliedManualVersion;
+    double m_joystickAux;
+    int64_t m_appliedJoystickAgeNs;
+
+    // Joystick drive configuration, written by any thread
+    CommandSlot<ManualInputConfig> m_manualConfig;
+
+    // Stages measured by the control tick, indexed by LatencyStage
+    LatencyHistogram m_latency[static_cast<int>(LatencyStage::COUNT)];
+
+    // Synchronization. m_mutex serializes configuration changes between
+    // the GUI and IPC callers; the control tick never takes it.
     mutable QMutex m_mutex;
     std::atomic<bool> m_running;
 
     // Control loop configuration
     int m_controlRateHz;
+    int m_aiSectionScans;
+    bool m_aiDriven;
+    bool m_fsmClockedOutput;
+    int m_fsmOutputLead;
+
+    // AI-driven ticks: sections skipped because the tick overran, and waits
+    // that saw no section at all
+    std::atomic<uint64_t> m_missedSections;
+    std::atomic<uint64_t> m_feedbackTimeouts;
 };
 
 #endif // CONTROL_LOOP_H
\ No newline at end of file
@@ -0,0 +1,107 @@
+#ifndef FEEDBACK_FILTER_H
+#define FEEDBACK_FILTER_H
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Decimating filter stage for buffered FSM feedback blocks.
+ *
+ * Every buffered AI block is reduced to one filtered value per channel, taken
+ * at the end of the block, plus min/max/mean/RMS statistics over the whole
+ * block. All filter types are realised as a single FIR dot product whose taps
+ * are computed in configure():
+ *
+ *  - MOVING_AVERAGE: boxcar of `length` samples
+ *  - CIC:            `stages` cascaded boxcars of `length` samples, i.e. the
+ *                    impulse response of a CIC decimator with R = length
+ *  - FIR:            Hamming-windowed sinc anti-alias low-pass with `length`
+ *                    taps and cutoff `cutoff` (fraction of the sample rate)
+ *
+ * processBlock() does not allocate. Its inner loops are plain contiguous
+ * loops so the compiler can vectorize them.
+ */
+class FeedbackFilter
+{
+public:
+    static const int MAX_CHANNELS = 4;
+
+    enum class Type {
+        MOVING_AVERAGE,
+        CIC,
+        FIR
+    };
+
+    struct Config {
+        Type type;
+        int length;     // Boxcar length, CIC decimation ratio or FIR tap count
+        int stages;     // CIC order (ignored otherwise)
+        double cutoff;  // FIR cutoff, fraction of the sample rate (0 - 0.5)
+
+        Config()
+            : type(Type::MOVING_AVERAGE)
+            , length(1)
+            , stages(3)
+            , cutoff(0.1)
+        {
+        }
+    };
+
+    struct ChannelStats {
+        double min;
+        double max;
+        double mean;
+        double rms;
+    };
+
+    struct BlockStats {
+        int32_t scans;  // Number of scans in the block
+        ChannelStats channel[MAX_CHANNELS];
+    };
+
+    FeedbackFilter();
+
+    /**
+     * @brief Configure the filter and precompute its taps
+     * @param config Filter type and parameters
+     * @param channels Number of interleaved channels (1 - MAX_CHANNELS)
+     * @return False if the parameters are invalid; the filter is unchanged
+     */
+    bool configure(const Config &config, int channels);
+
+    Config config() const { return m_config; }
+    int tapCount() const { return static_cast<int>(m_taps.size()); }
+
+    /**
+     * @brief Group delay of the filter in samples
+     */
+    double groupDelay() const { return 0.5 * (m_taps.size() - 1); }
+
+    /**
+     * @brief Clear the filter history
+     */
+    void reset();
+
+    /**
+     * @brief Filter one block of interleaved scans
+     * @param data Interleaved samples, scans * channels values
+     * @param scans Number of scans in the block
+     * @param output Filtered value per channel at the end of the block
+     * @param stats Per-channel statistics over the block
+     */
+    void processBlock(const double *data, int32_t scans, double *output, BlockStats &stats);
+
+private:
+    static std::vector<double> designTaps(const Config &config);
+
+    Config m_config;
+    int m_channels;
+
+    // Filter taps, oldest sample first
+    std::vector<double> m_taps;
+
+    // Last tapCount() samples of each channel, oldest first
+    std::vector<double> m_window[MAX_CHANNELS];
+};
+
+#endif // FEEDBACK_FILTER_H
@@ -3,10 +3,22 @@
 
 #include <QObject>
 #include <QMutex>
+#include <atomic>
 #include <memory>
-#include "bdaqctrl.h"
+#include <vector>
+#include "hardware_interfaces.h"
+#include "command_slot.h"
+#include "feedback_filter.h"
+#include "latency_histogram.h"
+#include "mode_blend.h"
+#include "output_limiter.h"
 
-using namespace Automation::BDaq;
+// Upper bound of the commits kept queued ahead of the clocked AO converter
+#define FSM_MAX_OUTPUT_LEAD 8
+
+// Upper bound of the AI scans per data ready event, and so of the clocked
+// AO scans queued by one commit
+#define FSM_MAX_SECTION_SCANS 16
 
 // Forward declaration of error string function
 QString getErrorString(ErrorCode errorCode);
@@ -31,7 +43,11 @@ public:
     bool reset();
     bool isInitialized() const;
 
-    void setControlMode(ControlMode mode);
+    // With blendCommits, the setpoint fades from the input of the old mode
+    // to that of the new one over that many commits. The fade is advanced
+    // by commitOutputs() and guarded by the output lock. Emits nothing, so
+    // the control thread can call it; getControlMode() tells the mode.
+    void setControlMode(ControlMode mode, int blendCommits = 0);
     ControlMode getControlMode() const;
 
     // Manual control inputs (-1.0 to 1.0 range)
@@ -43,44 +59,199 @@ public:
     // Get current FSM position feedback
     void getCurrentPosition(double &x, double &y);
 
+    // Position commanded by the active mode (manual or tracking input)
+    void getSetpoint(double &x, double &y);
+
+    // In closed-loop mode the control loop's compensator drives the DAC
+    // through setServoOutputs(); the mode inputs only move the setpoint
+    void setClosedLoop(bool enabled);
+    bool isClosedLoop() const;
+    void setServoOutputs(double x, double y);
+
+    // Configure the decimating filter applied to each feedback block
+    bool setFeedbackFilter(const FeedbackFilter::Config &config);
+
+    // Statistics of the last feedback block, normalized like the position
+    void getFeedbackStatistics(FeedbackFilter::BlockStats &stats);
+
+    // Feedback sampling rate and the scans per AI data ready event, so one
+    // filtered feedback sample is published every sectionScans scans.
+    // Call while stopped; an initialized acquisition is reopened.
+    bool setAcquisition(int sampleRate, int sectionScans);
+    int getSampleRate() const;
+    int getSectionScans() const;
+
+    // Read raw int16 counts from the driver and scale them here in one batch
+    // instead of letting the driver scale each sample. Applied on next start().
+    void setRawAcquisition(bool enabled);
+
+    // Retries on the lock-free command/feedback slots and waits for the
+    // DAC, summed since construction
+    uint64_t getContentionCount() const;
+
+    // Stream the command through a hardware-clocked AO buffer at scanRate
+    // instead of writing the DAC from whichever thread changes an input.
+    // Each commit queues scansPerCommit scans of the command, and leadScans
+    // commits are kept queued, adding that many periods of latency in
+    // exchange for output instants set by the card clock. Applied on next
+    // start().
+    void setClockedOutput(bool enabled, double scanRate, int leadScans = 2, int scansPerCommit = 1);
+    bool isClockedOutput() const;
+
+    // The setters only stage the command. The control thread calls this
+    // once per tick to send it: one DAC write, skipped if no channel moved
+    // by a DAC LSB, or one queued scan in clocked mode.
+    void commitOutputs();
+
+    // Driver writes issued by commitOutputs() and ticks it skipped
+    uint64_t getOutputWriteCount() const;
+    uint64_t getOutputSkipCount() const;
+
+    // Driver writes commitOutputs() saw fail, and the last error. The
+    // control thread only counts them; the caller reports them.
+    uint64_t getOutputFailureCount() const;
+    ErrorCode getLastOutputError() const;
+
+    // Slew limits of the X and Y outputs, applied by commitOutputs() at
+    // commitRateHz. reset() and starting the clocked output restart them
+    // at the command.
+    bool setOutputLimits(const OutputLimiter::Config &config, double commitRateHz);
+
+    // Commits the limiter held back from the command
+    uint64_t getOutputLimitedCount() const;
+
+    // Clocked output: scans the card converted with nothing queued, and
+    // ticks that padded or trimmed the queue to hold the lead
+    uint64_t getOutputUnderrunCount() const;
+    uint64_t getOutputSlipCount() const;
+
+    // CLOCK_MONOTONIC time the current feedback sample was published, 0
+    // before the first block
+    int64_t getFeedbackTime() const;
+
+    // CLOCK_MONOTONIC time of the AI data ready event behind the current
+    // feedback sample
+    int64_t getFeedbackReadyTime() const;
+
+    /**
+     * @brief Block until the feedback of a new AI section is published
+     *
+     * Lets the control thread run once per section on the acquisition
+     * clock instead of a timer. Meant for a single waiting thread.
+     * @param timeoutMs Longest wait
+     * @return Sections published since the previous call, 0 on timeout
+     */
+    int waitForFeedback(int timeoutMs);
+
+    // AI data-ready event to filtered feedback published, measured on the
+    // acquisition callback
+    LatencySummary getFeedbackLatency() const;
+    void resetFeedbackLatency();
+
+    // Replay for bc-trail-bench: acquire from input instead of the card,
+    // with the buffers and scaling start() sets up, and run the data ready
+    // handler or the feedback stage on the calling thread
+    int getChannelCount() const;
+    bool replayAcquisition(std::unique_ptr<BufferedAnalogIn> input, bool raw);
+    void replayDataReady(int32 count);
+    void replayFeedback(double *data, int32 scans);
+
 signals:
     void statusChanged(const QString &message);
     void errorOccurred(const QString &error);
     void feedbackUpdated(double x, double y);
 
-private slots:
-    void onAiDataReady(void *sender, BfdAiEventArgs *args);
-
 private:
+    void onAiDataReady(int32 count);
+
     // Helper methods
     bool setupAnalogInput();
     bool setupAnalogOutput();
-    void processAnalogInput(double *data, int32 count);
-    void updateOutputs();
+    bool startClockedOutput();
+    void stopClockedOutput();
+    void lockOutput();
+    AxisPair modeInput(ControlMode mode) const;
+    AxisPair blendedSetpoint() const;
+    AxisPair currentCommand() const;
+    AxisPair limitCommand(const AxisPair &command);
+    bool allocateAcquisitionBuffers();
+    void scaleRawSamples(int32 count);
+    void processAnalogInput(double *data, int32 scans);
+    bool writeOutputs(bool force);
+    void queueClockedOutput();
 
-    // Callback wrapper
-    static void BDAQCALL OnBfdAiEvent(void *sender, BfdAiEventArgs *args, void *userParam);
-    static void BDAQCALL OnBfdAiStopped(void *sender, BfdAiEventArgs *args, void *userParam);
+    // Callback wrappers
+    static void OnAiDataReady(void *userParam, int32 count);
+    static void OnAiStopped(void *userParam, int32 count);
+    static void OnAoUnderrun(void *userParam, int32 count);
 
     // DAQ device objects
-    InstantAoCtrl *m_aoCtrl;
-    BufferedAiCtrl *m_aiCtrl;
-
-    // Control state
-    ControlMode m_mode;
-    double m_manualX;
-    double m_manualY;
-    double m_trackX;
-    double m_trackY;
-    double m_feedbackX;
-    double m_feedbackY;
-
-    // Thread synchronization
+    std::unique_ptr<AnalogOut> m_analogOut;
+    std::unique_ptr<BufferedAnalogIn> m_analogIn;
+    std::unique_ptr<BufferedAnalogOut> m_clockedOut;
+
+    // Control state. Lock-free so that setters, the DAQ callback and the
+    // control thread never wait for each other, except for the mode fade,
+    // which is guarded by m_outputMutex.
+    std::atomic<ControlMode> m_mode;
+    ModeBlend m_blend;
+    ControlMode m_blendFrom;
+    CommandSlot<AxisPair> m_manual;
+    CommandSlot<AxisPair> m_track;
+    CommandSlot<AxisPair> m_servo;
+    CommandSlot<AxisPair> m_feedback;
+    std::atomic<int64_t> m_feedbackNs;
+    std::atomic<int64_t> m_feedbackReadyNs;
+
+    // Counts published sections for waitForFeedback()
+    int m_feedbackEventFd;
+    std::atomic<bool> m_closedLoop;
+
+    // Feedback pipeline stage
+    FeedbackFilter m_feedbackFilter;
+    CommandSlot<FeedbackFilter::BlockStats> m_feedbackStats;
+    LatencyHistogram m_feedbackLatency;
+
+    // Acquisition buffers, sized from the driver buffer capacity at start()
+    // and reused by every data ready callback
+    std::vector<double> m_aiBuffer;
+    std::vector<int16> m_aiRawBuffer;
+    bool m_rawAcquisition;
+    double m_rawGain;     // Volts per raw count, from the value range at start()
+    double m_rawOffset;   // Volts at raw count 0
+
+    // Guards the feedback filter and acquisition buffers
     mutable QMutex m_mutex;
 
+    // Serializes driver writes to the DAC
+    QMutex m_outputMutex;
+    std::atomic<uint64_t> m_outputContention;
+
+    // Volts last sent to the DAC, guarded by m_outputMutex
+    double m_lastOutput[2];
+    bool m_lastOutputValid;
+    std::atomic<uint64_t> m_outputWrites;
+    std::atomic<uint64_t> m_outputSkips;
+    std::atomic<uint64_t> m_outputFailures;
+    std::atomic<ErrorCode> m_lastOutputError;
+
+    // Output slew limiter, guarded by m_outputMutex
+    OutputLimiter m_limiter;
+    std::atomic<uint64_t> m_outputLimited;
+
+    // Hardware-clocked output, fed one scan per tick by commitOutputs()
+    bool m_clockedRequested;
+    double m_clockedRate;
+    int m_outputLeadScans;
+    int m_scansPerCommit;
+    std::atomic<bool> m_clockedActive;
+    std::atomic<uint64_t> m_outputUnderruns;
+    std::atomic<uint64_t> m_outputSlips;
+
     // Device configuration
     int m_deviceNumber;
     int m_samplingRate;
+    int m_sectionScans;
     int m_channelCount;
     int m_buffSize;
     double m_scaleFactor;
@@ -3,13 +3,25 @@
 
 #include <QObject>
 #include <QMutex>
-#include "bdaqctrl.h"
-
-using namespace Automation::BDaq;
+#include <atomic>
+#include <memory>
+#include "hardware_interfaces.h"
+#include "command_slot.h"
+#include "output_limiter.h"
+#include "mode_blend.h"
 
 // Forward declaration of error string function
 QString getErrorString(ErrorCode errorCode);
 
+/**
+ * @brief Normalized gimbal position command (-1.0 to 1.0 per axis)
+ */
+struct GimbalPosition {
+    double azimuth;
+    double elevation;
+    double auxElevation;
+};
+
 class GimbalController : public QObject
 {
     Q_OBJECT
@@ -34,6 +46,38 @@ public:
     void setEnabled(bool enabled);
     bool isEnabled() const;
 
+    // Enable or disable by fading the outputs between the position command
+    // and zero over `commits` output commits; the gimbal is disabled once
+    // the fade out ends. The fade is advanced by commitOutputs(), so call
+    // this from the committing thread. Emits nothing; isEnabled() tells
+    // when the gimbal is off.
+    void fadeEnabled(bool enabled, int commits);
+
+    // Retries on the position slot and waits for the DAC
+    uint64_t getContentionCount() const;
+
+    // setPosition() and enabling only stage the command. The control
+    // thread calls this once per tick to send it in one DAC write, skipped
+    // if no channel moved by a DAC LSB.
+    void commitOutputs();
+
+    // Driver writes issued by commitOutputs() and ticks it skipped
+    uint64_t getOutputWriteCount() const;
+    uint64_t getOutputSkipCount() const;
+
+    // Driver writes commitOutputs() saw fail, and the last error. The
+    // control thread only counts them; the caller reports them.
+    uint64_t getOutputFailureCount() const;
+    ErrorCode getLastOutputError() const;
+
+    // Slew limits of the azimuth, elevation and aux elevation outputs,
+    // applied by commitOutputs() at commitRateHz. A disabled gimbal is
+    // zeroed at once and ramps from zero when enabled again.
+    bool setOutputLimits(const OutputLimiter::Config &config, double commitRateHz);
+
+    // Commits the limiter held back from the command
+    uint64_t getOutputLimitedCount() const;
+
 signals:
     void statusChanged(const QString &message);
     void errorOccurred(const QString &error);
@@ -41,19 +85,37 @@ signals:
 private:
     // Helper methods
     bool setupAnalogOutput();
-    void updateOutputs();
+    bool switchEnabled(bool enabled);
+    void lockOutput();
+    bool zeroOutputs();
+    ErrorCode writeLocked(double *outputs);
 
     // DAQ device objects
-    InstantAoCtrl *m_aoCtrl;
+    std::unique_ptr<AnalogOut> m_analogOut;
 
-    // Control state
-    double m_azimuth;
-    double m_elevation;
-    double m_auxElevation;
-    bool m_enabled;
+    // Control state, written by setters from any thread without locking
+    CommandSlot<GimbalPosition> m_position;
+    std::atomic<bool> m_enabled;
 
-    // Thread synchronization
+    // Serializes driver writes to the DAC
     mutable QMutex m_mutex;
+    std::atomic<uint64_t> m_outputContention;
+
+    // Volts last sent to the DAC, guarded by m_mutex
+    double m_lastOutput[3];
+    bool m_lastOutputValid;
+    std::atomic<uint64_t> m_outputWrites;
+    std::atomic<uint64_t> m_outputSkips;
+    std::atomic<uint64_t> m_outputFailures;
+    std::atomic<ErrorCode> m_lastOutputError;
+
+    // Output slew limiter and mode fade, guarded by m_mutex. The fade
+    // starts from the outputs last committed.
+    OutputLimiter m_limiter;
+    ModeBlend m_blend;
+    double m_blendFrom[3];
+    bool m_fadingOut;
+    std::atomic<uint64_t> m_outputLimited;
 
     // Device configuration
     int m_deviceNumber;
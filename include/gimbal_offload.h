@@ -0,0 +1,74 @@
+#ifndef GIMBAL_OFFLOAD_H
+#define GIMBAL_OFFLOAD_H
+
+/**
+ * @brief Off-loads the FSM deflection into the gimbal.
+ *
+ * An integrator per axis turns the FSM position into a gimbal rate: the
+ * further the mirror sits from centre, the faster the gimbal moves the
+ * line of sight to bring it back. With the mirror loop much faster than
+ * the gimbal, the off-load loop gain is 2 pi crossoverHz / s, so it
+ * crosses over at crossoverHz. The rate is limited so a saturated FSM does
+ * not slew the gimbal harder than it can follow.
+ *
+ * scale maps FSM units to gimbal units of the same line-of-sight angle;
+ * its sign sets the direction of the off-load on each axis and depends on
+ * how the FSM and gimbal are mounted. Runs on the control thread.
+ */
+class GimbalOffload
+{
+public:
+    enum class Source {
+        FEEDBACK,   // Measured FSM position
+        COMMAND     // FSM command (setpoint), free of sensor noise
+    };
+
+    struct Config {
+        bool enabled;
+        Source source;
+        double crossoverHz;       // Off-load loop bandwidth
+        double rateLimit;         // Gimbal units per second
+        double azimuthScale;      // Gimbal azimuth per FSM X, signed
+        double elevationScale;    // Gimbal elevation per FSM Y, signed
+        double deadband;          // FSM deflection left to the mirror
+
+        Config();
+    };
+
+    GimbalOffload();
+
+    /**
+     * @brief Apply gains and limits
+     * @return False if the configuration is invalid; the previous one is kept
+     */
+    bool configure(const Config &config);
+    const Config &config() const { return m_config; }
+
+    // Start integrating from the current gimbal command
+    void reset(double azimuth, double elevation);
+
+    /**
+     * @brief Run one off-load step
+     * @param fsmX, fsmY FSM position (-1.0 to 1.0)
+     * @param dt Seconds since the previous step
+     * @param azimuth, elevation Gimbal command (-1.0 to 1.0)
+     */
+    void update(double fsmX, double fsmY, double dt, double &azimuth, double &elevation);
+
+    // Gimbal rate commanded by the last step, per second
+    void rate(double &azimuth, double &elevation) const
+    {
+        azimuth = m_rate[0];
+        elevation = m_rate[1];
+    }
+
+private:
+    double axisRate(double deflection, double scale) const;
+
+    Config m_config;
+    double m_gain;         // 2 pi crossoverHz
+    double m_command[2];
+    double m_rate[2];
+};
+
+#endif // GIMBAL_OFFLOAD_H
@@ -0,0 +1,135 @@
+#ifndef HARDWARE_ADVANTECH_H
+#define HARDWARE_ADVANTECH_H
+
+#include "hardware_interfaces.h"
+
+/**
+ * @brief AnalogOut on an Advantech card through InstantAoCtrl
+ */
+class AdvantechAnalogOut : public AnalogOut
+{
+public:
+    AdvantechAnalogOut();
+    ~AdvantechAnalogOut();
+
+    bool open(int deviceNumber, int channelCount, std::string &error) override;
+    void close() override;
+    bool isOpen() const override { return m_aoCtrl != nullptr; }
+
+    ErrorCode write(int32 startChannel, int32 count, double *volts) override
+    {
+        return m_aoCtrl->Write(startChannel, count, volts);
+    }
+
+private:
+    InstantAoCtrl *m_aoCtrl;
+};
+
+/**
+ * @brief BufferedAnalogIn on an Advantech card through BufferedAiCtrl
+ */
+class AdvantechBufferedAnalogIn : public BufferedAnalogIn
+{
+public:
+    AdvantechBufferedAnalogIn();
+    ~AdvantechBufferedAnalogIn();
+
+    bool open(int deviceNumber, int channelCount, double sampleRate,
+              int32 sectionScans, std::string &error) override;
+    void close() override;
+    bool isOpen() const override { return m_aiCtrl != nullptr; }
+
+    void setDataReadyHandler(EventProc proc, void *userParam) override;
+    void setStoppedHandler(EventProc proc, void *userParam) override;
+
+    int32 bufferCapacity() override { return m_aiCtrl->getBufferCapacity(); }
+
+    ErrorCode start() override { return m_aiCtrl->Start(); }
+    ErrorCode stop() override { return m_aiCtrl->Stop(); }
+
+    ErrorCode read(int32 count, double *volts) override { return m_aiCtrl->GetData(count, volts); }
+    ErrorCode readRaw(int32 count, int16 *raw) override { return m_aiCtrl->GetData(count, raw); }
+    bool rawScaling(double &voltsPerCount, double &voltsAtZero) override;
+
+private:
+    static void BDAQCALL OnBfdAiEvent(void *sender, BfdAiEventArgs *args, void *userParam);
+    static void BDAQCALL OnBfdAiStopped(void *sender, BfdAiEventArgs *args, void *userParam);
+
+    BufferedAiCtrl *m_aiCtrl;
+
+    EventProc m_dataReadyProc;
+    void *m_dataReadyParam;
+    EventProc m_stoppedProc;
+    void *m_stoppedParam;
+};
+
+/**
+ * @brief BufferedAnalogOut on an Advantech card through BufferedAoCtrl
+ *
+ * Runs in streaming mode; the ConvertClock is either the card's internal
+ * clock at the scan rate or the AI conversion clock (SigAiConvClock).
+ */
+class AdvantechBufferedAnalogOut : public BufferedAnalogOut
+{
+public:
+    AdvantechBufferedAnalogOut();
+    ~AdvantechBufferedAnalogOut();
+
+    bool open(int deviceNumber, int channelCount, double scanRate,
+              int32 bufferScans, bool syncToAi, std::string &error) override;
+    void close() override;
+    bool isOpen() const override { return m_aoCtrl != nullptr; }
+
+    void setUnderrunHandler(EventProc proc, void *userParam) override;
+
+    ErrorCode write(int32 scans, double *volts) override;
+    int32 queuedScans() override;
+
+    ErrorCode start() override { return m_aoCtrl->Start(); }
+
+    // Stop immediately; the channels hold the last converted scan
+    ErrorCode stop() override { return m_aoCtrl->Stop(0); }
+
+private:
+    static void BDAQCALL OnBfdAoUnderrun(void *sender, BfdAoEventArgs *args, void *userParam);
+
+    BufferedAoCtrl *m_aoCtrl;
+    int m_channelCount;
+    int32 m_bufferScans;
+
+    EventProc m_underrunProc;
+    void *m_underrunParam;
+};
+
+/**
+ * @brief TrackerSource mapping the 7007 card through /dev/mem
+ *
+ * When the card is bound to uio_pci_generic, its interrupt is available
+ * through the UIO node given in TrackerLocation::interruptDevice.
+ */
+class PciTrackerSource : public TrackerSource
+{
+public:
+    PciTrackerSource();
+    ~PciTrackerSource();
+
+    bool open(const TrackerLocation &location, std::string &error) override;
+    void close() override;
+
+    void *memory() const override { return m_mappedMem; }
+    size_t size() const override { return m_memSize; }
+
+    bool hasInterrupt() const override { return m_uioFd != -1; }
+    int waitForInterrupt(int timeoutMs) override;
+
+private:
+    bool configurePCIDevice(const TrackerLocation &location, std::string &error);
+    bool openInterrupt(const std::string &device, std::string &error);
+
+    int m_fd;
+    int m_uioFd;
+    void *m_mappedMem;
+    size_t m_memSize;
+};
+
+#endif // HARDWARE_ADVANTECH_H
@@ -0,0 +1,181 @@
+#ifndef HARDWARE_INTERFACES_H
+#define HARDWARE_INTERFACES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "bdaqctrl.h"
+
+using namespace Automation::BDaq;
+
+/**
+ * @brief Hardware abstraction for the DAQ cards and the tracker card.
+ *
+ * The controllers only talk to these interfaces. Two backends exist: the
+ * Advantech/mmap implementation for the rig and a deterministic simulated
+ * backend that lets the full control loop run on a workstation. The
+ * interfaces keep the Advantech ErrorCode so error reporting is unchanged.
+ */
+
+// One code of the 16-bit AO converters over the +/-10 V range
+#define AO_VOLTS_PER_LSB (20.0 / 65536.0)
+
+/**
+ * @brief Static analog output channels (InstantAoCtrl)
+ */
+class AnalogOut
+{
+public:
+    virtual ~AnalogOut() {}
+
+    /**
+     * @brief Select the device and configure channelCount channels for +/-10 V
+     * @param error Description of the failure when false is returned
+     */
+    virtual bool open(int deviceNumber, int channelCount, std::string &error) = 0;
+    virtual void close() = 0;
+    virtual bool isOpen() const = 0;
+
+    // Write scaled values (volts) to consecutive channels
+    virtual ErrorCode write(int32 startChannel, int32 count, double *volts) = 0;
+};
+
+/**
+ * @brief Buffered, hardware-clocked analog input (BufferedAiCtrl)
+ */
+class BufferedAnalogIn
+{
+public:
+    // Called on the acquisition thread; count is the number of new samples
+    // across all channels. Zero for the stopped event.
+    typedef void (*EventProc)(void *userParam, int32 count);
+
+    virtual ~BufferedAnalogIn() {}
+
+    /**
+     * @brief Configure channelCount channels for +/-10 V streaming input
+     * @param sampleRate Scans per second
+     * @param sectionScans Scans per data ready event
+     */
+    virtual bool open(int deviceNumber, int channelCount, double sampleRate,
+                      int32 sectionScans, std::string &error) = 0;
+    virtual void close() = 0;
+    virtual bool isOpen() const = 0;
+
+    // Register handlers before start()
+    virtual void setDataReadyHandler(EventProc proc, void *userParam) = 0;
+    virtual void setStoppedHandler(EventProc proc, void *userParam) = 0;
+
+    virtual int32 bufferCapacity() = 0;
+
+    virtual ErrorCode start() = 0;
+    virtual ErrorCode stop() = 0;
+
+    // Read the oldest count samples, interleaved by channel
+    virtual ErrorCode read(int32 count, double *volts) = 0;
+    virtual ErrorCode readRaw(int32 count, int16 *raw) = 0;
+
+    // Scaling of the offset binary counts from readRaw() for the value
+    // range and resolution of the open channels:
+    // volts = count * voltsPerCount + voltsAtZero
+    virtual bool rawScaling(double &voltsPerCount, double &voltsAtZero) = 0;
+};
+
+/**
+ * @brief Streaming, hardware-clocked analog output (BufferedAoCtrl)
+ *
+ * Scans are converted at a fixed rate from a ring buffer on the card, so the
+ * output instants do not depend on when the writer runs. The writer keeps a
+ * few scans queued ahead of the converter; when the queue runs dry the card
+ * holds the last value and the underrun handler is called.
+ */
+class BufferedAnalogOut
+{
+public:
+    typedef BufferedAnalogIn::EventProc EventProc;
+
+    virtual ~BufferedAnalogOut() {}
+
+    /**
+     * @brief Configure channelCount channels for +/-10 V streaming output
+     * @param scanRate Scans per second
+     * @param bufferScans Capacity of the output ring in scans
+     * @param syncToAi Clock conversions from the AI conversion clock of the
+     *        same card instead of a separate internal clock
+     */
+    virtual bool open(int deviceNumber, int channelCount, double scanRate,
+                      int32 bufferScans, bool syncToAi, std::string &error) = 0;
+    virtual void close() = 0;
+    virtual bool isOpen() const = 0;
+
+    // Register before start()
+    virtual void setUnderrunHandler(EventProc proc, void *userParam) = 0;
+
+    // Queue scans of scaled values (volts), interleaved by channel.
+    // At least one scan must be queued before start().
+    virtual ErrorCode write(int32 scans, double *volts) = 0;
+
+    // Scans queued and not yet converted
+    virtual int32 queuedScans() = 0;
+
+    virtual ErrorCode start() = 0;
+    virtual ErrorCode stop() = 0;
+};
+
+/**
+ * @brief Location of the 7007 tracker card memory window
+ */
+struct TrackerLocation {
+    uintptr_t baseAddress;
+    size_t memSize;
+    uint8_t pciBus;
+    uint8_t pciSlot;
+    uint8_t pciFunc;
+    std::string interruptDevice;  // UIO node of the card, empty for none
+};
+
+/**
+ * @brief Memory window of the 7007 tracker card (mailboxes and messages)
+ */
+class TrackerSource
+{
+public:
+    virtual ~TrackerSource() {}
+
+    virtual bool open(const TrackerLocation &location, std::string &error) = 0;
+    virtual void close() = 0;
+
+    // Mapped memory, nullptr when closed
+    virtual void *memory() const = 0;
+    virtual size_t size() const = 0;
+
+    // Whether the card raises an interrupt when it writes a mailbox
+    virtual bool hasInterrupt() const { return false; }
+
+    /**
+     * @brief Block until the card interrupts or the timeout expires
+     * @return 1 on interrupt, 0 on timeout, -1 on error or no interrupt
+     */
+    virtual int waitForInterrupt(int timeoutMs) { (void)timeoutMs; return -1; }
+};
+
+namespace Hardware {
+
+enum class Backend {
+    ADVANTECH,   // PCIE-1816/1824 cards and the tracker via /dev/mem
+    SIMULATED    // In-process plant model and synthetic tracker mailbox
+};
+
+// Select the backend before any controller is initialized
+void setBackend(Backend backend);
+Backend backend();
+
+std::unique_ptr<AnalogOut> createAnalogOut();
+std::unique_ptr<BufferedAnalogIn> createBufferedAnalogIn();
+std::unique_ptr<BufferedAnalogOut> createBufferedAnalogOut();
+std::unique_ptr<TrackerSource> createTrackerSource();
+
+} // namespace Hardware
+
+#endif // HARDWARE_INTERFACES_H
@@ -0,0 +1,248 @@
+#ifndef HARDWARE_SIMULATED_H
+#define HARDWARE_SIMULATED_H
+
+#include "hardware_interfaces.h"
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Parameters of the simulated backend.
+ *
+ * The FSM plant is a second-order low-pass from AO channel i to AI channel
+ * i of the same device number. With the same seed and the same sequence of
+ * AO writes the generated samples are identical from run to run.
+ */
+struct SimulationConfig {
+    uint32_t seed;
+    double plantNaturalHz;     // FSM mechanical resonance
+    double plantDamping;       // FSM damping ratio
+    double plantGain;          // AI volts per AO volt at DC
+    double noiseVolts;         // Gaussian sensor noise, 1 sigma
+
+    double trackerRateHz;      // Status message rate of the synthetic 7007
+    double targetAmplitude;    // Target motion amplitude in pixels
+    double targetFrequencyHz;  // Target motion frequency
+    double trackerNoise;       // Tracker error noise in pixels, 1 sigma
+    double dropoutIntervalS;   // Mean time between target losses, 0 for none
+    double dropoutLengthS;     // Mean length of a target loss
+    bool dropoutSilent;        // No messages during a loss instead of a lost state
+    const char *trackerShmName; // Prefix of the POSIX shm object backing the mailbox
+
+    SimulationConfig()
+        : seed(1)
+        , plantNaturalHz(300.0)
+        , plantDamping(0.4)
+        , plantGain(1.0)
+        , noiseVolts(0.002)
+        , trackerRateHz(250.0)
+        , targetAmplitude(4.0)
+        , targetFrequencyHz(0.5)
+        , trackerNoise(0.1)
+        , dropoutIntervalS(0.0)
+        , dropoutLengthS(0.2)
+        , dropoutSilent(false)
+        , trackerShmName("/bc-trail-7007")
+    {
+    }
+};
+
+#define SIM_MAX_DEVICES  4
+#define SIM_MAX_CHANNELS 8
+
+namespace Simulation {
+
+// Applies to devices opened after the call
+void setConfig(const SimulationConfig &config);
+SimulationConfig config();
+
+// Voltage last written to a simulated AO channel
+double analogOut(int device, int channel);
+void setAnalogOut(int device, int channel, double volts);
+
+} // namespace Simulation
+
+/**
+ * @brief AnalogOut that stores the written voltages for the plant model
+ */
+class SimulatedAnalogOut : public AnalogOut
+{
+public:
+    SimulatedAnalogOut();
+    ~SimulatedAnalogOut();
+
+    bool open(int deviceNumber, int channelCount, std::string &error) override;
+    void close() override;
+    bool isOpen() const override { return m_deviceNumber >= 0; }
+
+    ErrorCode write(int32 startChannel, int32 count, double *volts) override;
+
+private:
+    int m_deviceNumber;
+    int m_channelCount;
+};
+
+/**
+ * @brief BufferedAnalogIn producing FSM plant output at the configured rate
+ *
+ * A generator thread produces one section of sectionScans scans, paced with
+ * absolute sleeps, and raises the data ready handler for it. read() returns
+ * samples of the current section like BufferedAiCtrl::GetData().
+ */
+class SimulatedBufferedAnalogIn : public BufferedAnalogIn
+{
+public:
+    SimulatedBufferedAnalogIn();
+    ~SimulatedBufferedAnalogIn();
+
+    bool open(int deviceNumber, int channelCount, double sampleRate,
+              int32 sectionScans, std::string &error) override;
+    void close() override;
+    bool isOpen() const override { return m_deviceNumber >= 0; }
+
+    void setDataReadyHandler(EventProc proc, void *userParam) override;
+    void setStoppedHandler(EventProc proc, void *userParam) override;
+
+    int32 bufferCapacity() override { return static_cast<int32>(m_section.size()); }
+
+    ErrorCode start() override;
+    ErrorCode stop() override;
+
+    ErrorCode read(int32 count, double *volts) override;
+    ErrorCode readRaw(int32 count, int16 *raw) override;
+    bool rawScaling(double &voltsPerCount, double &voltsAtZero) override;
+
+private:
+    struct AxisState {
+        double position;
+        double velocity;
+    };
+
+    void run();
+    void generateSection();
+
+    int m_deviceNumber;
+    int m_channelCount;
+    double m_sampleRate;
+    int32 m_sectionScans;
+
+    SimulationConfig m_config;
+    std::vector<AxisState> m_axes;
+    int m_substeps;
+    std::mt19937 m_rng;
+    std::normal_distribution<double> m_noise;
+
+    // Current section, consumed by read()
+    std::mutex m_sectionMutex;
+    std::vector<double> m_section;
+    int32 m_sectionCount;
+    int32 m_readPos;
+
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+
+    EventProc m_dataReadyProc;
+    void *m_dataReadyParam;
+    EventProc m_stoppedProc;
+    void *m_stoppedParam;
+};
+
+/**
+ * @brief BufferedAnalogOut converting queued scans at the scan rate
+ *
+ * A converter thread paced with absolute sleeps moves one scan per period
+ * from the ring to the simulated AO channels, like the card's ConvertClock.
+ * syncToAi is accepted but has no effect; both simulated clocks run on
+ * CLOCK_MONOTONIC.
+ */
+class SimulatedBufferedAnalogOut : public BufferedAnalogOut
+{
+public:
+    SimulatedBufferedAnalogOut();
+    ~SimulatedBufferedAnalogOut();
+
+    bool open(int deviceNumber, int channelCount, double scanRate,
+              int32 bufferScans, bool syncToAi, std::string &error) override;
+    void close() override;
+    bool isOpen() const override { return m_deviceNumber >= 0; }
+
+    void setUnderrunHandler(EventProc proc, void *userParam) override;
+
+    ErrorCode write(int32 scans, double *volts) override;
+    int32 queuedScans() override;
+
+    ErrorCode start() override;
+    ErrorCode stop() override;
+
+private:
+    void run();
+
+    int m_deviceNumber;
+    int m_channelCount;
+    double m_scanRate;
+    int32 m_bufferScans;
+
+    // Output ring, in scans
+    std::mutex m_ringMutex;
+    std::vector<double> m_ring;
+    int64_t m_head;
+    int64_t m_tail;
+
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+
+    EventProc m_underrunProc;
+    void *m_underrunParam;
+};
+
+/**
+ * @brief TrackerSource backed by a POSIX shm object with a synthetic 7007
+ *
+ * A card thread writes status messages for a target moving on a circle and
+ * acknowledges commands, following the mailbox protocol of the real card.
+ * With a dropout interval the target is lost at random, exponentially
+ * distributed frames drawn from the seeded generator, so the losses repeat
+ * from run to run.
+ * Each status message is also signalled on an eventfd, standing in for the
+ * card interrupt.
+ * The shm object is named after the configured prefix and the process id,
+ * so parallel simulated runs each get their own mailbox. Other processes
+ * can open it to inspect or drive it.
+ */
+class SimulatedTrackerSource : public TrackerSource
+{
+public:
+    SimulatedTrackerSource();
+    ~SimulatedTrackerSource();
+
+    bool open(const TrackerLocation &location, std::string &error) override;
+    void close() override;
+
+    void *memory() const override { return m_mappedMem; }
+    size_t size() const override { return m_memSize; }
+
+    bool hasInterrupt() const override { return m_eventFd != -1; }
+    int waitForInterrupt(int timeoutMs) override;
+
+private:
+    void run();
+    uint16_t readWord(size_t offset) const;
+    void writeWord(size_t offset, uint16_t value);
+
+    int m_fd;
+    int m_eventFd;
+    void *m_mappedMem;
+    size_t m_memSize;
+    std::string m_shmName;
+
+    SimulationConfig m_config;
+    std::mt19937 m_rng;
+    std::normal_distribution<double> m_noise;
+
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+};
+
+#endif // HARDWARE_SIMULATED_H
@@ -0,0 +1,157 @@
+#ifndef IPC_CHANNEL_H
+#define IPC_CHANNEL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "manual_input.h"
+#include "mpsc_queue.h"
+#include "seqlock.h"
+#include "telemetry.h"
+
+// POSIX shared memory object the control process publishes
+#define IPC_DEFAULT_NAME       "/bc-trail"
+
+// Bumped whenever the layout of IpcSegment changes
+#define IPC_LAYOUT_VERSION     3
+#define IPC_MAGIC              0x4C545242u  // "BRTL"
+
+#define IPC_COMMAND_CAPACITY   256
+
+// A command claimed by a client but not written for this long is skipped,
+// so a client killed inside push() does not block the others
+#define IPC_COMMAND_STALL_TIMEOUT_MS 100
+
+/**
+ * @brief Requests from clients to the control process
+ */
+enum class IpcCommandType : uint32_t {
+    START = 1,
+    STOP,
+    SET_MODE,             // arg: ControlLoop::OperationMode
+    SET_SERVO,            // arg: enable
+    SET_FSM_OUTPUT,       // arg: enable
+    SET_GIMBAL_OUTPUT,    // arg: enable
+    SET_FSM_DEADZONE,     // value: fraction of full scale
+    SET_GIMBAL_DEADZONE,  // value: fraction of full scale
+    SET_INVERT,           // arg: MANUAL_INVERT_* bits, value: non-zero to invert
+    RESET_STATISTICS      // Latency histograms and scheduler statistics
+};
+
+struct IpcCommand {
+    uint32_t type;        // IpcCommandType
+    int32_t arg;
+    double value;
+    uint64_t sequence;    // Chosen by the client, reported back once applied
+};
+
+/**
+ * @brief State of the control process, republished by its service timer
+ */
+struct IpcStatus {
+    int64_t updatedNs;          // CLOCK_MONOTONIC time of this update
+    int32_t running;
+    int32_t mode;               // ControlLoop::OperationMode
+    int32_t servoEnabled;
+    int32_t controlRateHz;
+    uint64_t cycles;
+    uint64_t overruns;
+    uint64_t deadlineMisses;
+    uint64_t commandsApplied;
+    uint64_t commandsRejected;
+    uint64_t commandsSkipped;    // Left half-written by a stalled client
+    uint64_t lastCommandSequence;
+    ManualInputConfig manual;
+};
+
+/**
+ * @brief Layout of the shared memory segment.
+ *
+ * The control thread only writes the telemetry ring, with plain stores.
+ * Status and commands are handled by the service timer of the control
+ * process, off the control thread. Clients map the segment read-write to
+ * push commands; they never block the control process.
+ */
+struct IpcSegment {
+    std::atomic<uint32_t> magic;   // Written last, once the segment is ready
+    uint32_t layoutVersion;
+    uint64_t segmentSize;          // sizeof(IpcSegment) of the server
+    int64_t serverPid;
+    int64_t startedNs;
+
+    SeqLock<IpcStatus> status;
+    MpscQueue<IpcCommand, IPC_COMMAND_CAPACITY> commands;
+    TelemetryMirror telemetry;
+};
+
+namespace Ipc {
+
+/**
+ * @brief Create and initialize the segment, replacing a stale one.
+ *
+ * Refuses if another live process still serves the segment.
+ * @return Mapped segment, or nullptr with error set
+ */
+IpcSegment *createSegment(const std::string &name, std::string &error);
+
+// Unmap and unlink a segment returned by createSegment()
+void destroySegment(const std::string &name, IpcSegment *segment);
+
+} // namespace Ipc
+
+/**
+ * @brief Client side of the channel: status, commands and telemetry.
+ *
+ * Does not depend on Qt, so monitoring tools can use it without the core
+ * library. Every call is a few loads and stores on the mapping.
+ */
+class IpcClient
+{
+public:
+    IpcClient();
+    ~IpcClient();
+
+    IpcClient(const IpcClient &) = delete;
+    IpcClient &operator=(const IpcClient &) = delete;
+
+    /**
+     * @brief Map the segment of a running control process
+     * @return False if it does not exist or has another layout; see lastError()
+     */
+    bool open(const std::string &name = IPC_DEFAULT_NAME);
+    void close();
+    bool isOpen() const { return m_segment != nullptr; }
+    const std::string &lastError() const { return m_lastError; }
+
+    IpcStatus status() const;
+
+    /**
+     * @brief Queue a command
+     * @return Sequence number of the command, 0 if the queue was full
+     */
+    uint64_t send(IpcCommandType type, int32_t arg = 0, double value = 0.0);
+
+    // Newest telemetry snapshot; false before the first control tick
+    bool latest(TelemetrySnapshot &snapshot) const;
+
+    /**
+     * @brief Snapshots published since the previous call, oldest first.
+     *
+     * The first call starts at the newest snapshot. Snapshots overwritten
+     * before they were read are counted by lostCount().
+     */
+    size_t readTelemetry(TelemetrySnapshot *out, size_t maxCount);
+    uint64_t lostCount() const { return m_lost; }
+
+private:
+    IpcSegment *m_segment;
+    uint64_t m_cursor;
+    bool m_cursorValid;
+    uint64_t m_lost;
+    uint64_t m_nextSequence;
+    std::string m_lastError;
+};
+
+#endif // IPC_CHANNEL_H
@@ -0,0 +1,62 @@
+#ifndef IPC_SERVER_H
+#define IPC_SERVER_H
+
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <string>
+
+#include "ipc_channel.h"
+
+// Interval at which commands are applied and the status is republished
+#define IPC_SERVICE_INTERVAL_MS 10
+
+class ControlLoop;
+
+/**
+ * @brief Serves a ControlLoop to other processes through shared memory.
+ *
+ * The control thread mirrors its telemetry into the segment's ring with
+ * plain stores. Commands from clients are applied, and the status is
+ * republished, by a timer on the thread that owns the server. What a
+ * command changes in the running loop reaches the control thread through
+ * the atomics and CommandSlots it reads at the start of a tick, never
+ * through a lock or a syscall on its path.
+ */
+class IpcServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit IpcServer(ControlLoop *loop, QObject *parent = nullptr);
+    ~IpcServer();
+
+    bool open(const QString &name = IPC_DEFAULT_NAME);
+
+    // Detach from the control thread and remove the segment
+    void close();
+
+    bool isOpen() const { return m_segment != nullptr; }
+
+signals:
+    void statusChanged(const QString &message);
+    void errorOccurred(const QString &error);
+
+private slots:
+    void service();
+
+private:
+    bool apply(const IpcCommand &command);
+    void publishStatus();
+
+    ControlLoop *m_loop;
+    IpcSegment *m_segment;
+    std::string m_name;
+    QTimer *m_serviceTimer;
+
+    uint64_t m_commandsApplied;
+    uint64_t m_commandsRejected;
+    uint64_t m_lastCommandSequence;
+};
+
+#endif // IPC_SERVER_H
@@ -8,12 +8,38 @@
 #include <QMap>
 #include <QString>
 #include <SDL2/SDL.h>
+#include <atomic>
+#include <vector>
+#include "command_slot.h"
+#include "latency_histogram.h"
+#include "realtime_thread.h"
+
+// Longest blocking wait of the input thread, bounds the stop() latency
+#define JOYSTICK_WAIT_TIMEOUT_MS 20
+
+// Minimum interval between axis change signals to the GUI thread
+#define JOYSTICK_SIGNAL_INTERVAL_MS 16
+
+/**
+ * @brief Normalized joystick axes (-1.0 to 1.0)
+ */
+struct JoystickAxes {
+    double x, y, z;
+    double rx, ry, rz;
+    int64_t eventNs;   // CLOCK_MONOTONIC time of the latest axis event
+};
 
 /**
  * @brief Interface for joystick input and control.
  *
- * This class provides a unified interface for joystick control using SDL2,
- * supporting multiple devices, calibration, and comprehensive input mapping.
+ * This class provides a unified interface for joystick control, supporting
+ * multiple devices, calibration, and comprehensive input mapping.
+ *
+ * The default backend reads the Linux evdev node (/dev/input/event*) on a
+ * dedicated thread that blocks in epoll, so every axis event is published
+ * to the control thread as it arrives, stamped with its kernel time. SDL2
+ * polled from a GUI timer remains available as a fallback and is used
+ * automatically when no evdev joystick can be opened.
  */
 class JoystickInterface : public QObject
 {
@@ -31,6 +57,14 @@ public:
         // Add more buttons as needed
     };
 
+    /**
+     * @brief Source of joystick events
+     */
+    enum class Backend {
+        EVDEV,   // /dev/input/event* read on the input thread
+        SDL      // SDL2 event queue polled from a GUI timer
+    };
+
     /**
      * @brief Hat position constants from SDL
      */
@@ -58,6 +92,26 @@ public:
      */
     ~JoystickInterface();
 
+    /**
+     * @brief Select the preferred backend. Applied on the next initialize().
+     */
+    void setBackend(Backend backend);
+
+    /**
+     * @brief Default backend of instances constructed after the call
+     */
+    static void setPreferredBackend(Backend backend);
+
+    /**
+     * @brief Backend in use after initialize()
+     */
+    Backend getBackend() const;
+
+    /**
+     * @brief Scheduling of the evdev input thread. Applied on the next start().
+     */
+    void setRealtimeConfig(const RealtimeConfig &config);
+
     /**
      * @brief Initialize the joystick interface
      *
@@ -156,6 +210,16 @@ public:
      */
     void getJoystickRotation(double &rx, double &ry, double &rz);
 
+    /**
+     * @brief Get all axes with the time of the latest axis event
+     *
+     * Lock-free; intended for the control thread.
+     *
+     * @param axes Output parameter for the axes
+     * @return uint32_t Publication counter, changes whenever an axis moves
+     */
+    uint32_t getJoystickAxes(JoystickAxes &axes);
+
     /**
      * @brief Get the current hat position value
      *
@@ -195,6 +259,33 @@ public:
      */
     void calibrateAxes();
 
+    /**
+     * @brief Set the calibration of one axis instead of measuring it
+     */
+    void setAxisCalibration(int axis, int min, int max, int center);
+
+    /**
+     * @brief Convert raw axis value to normalized position
+     *
+     * Reads the calibration unlocked: call it from the thread applying the
+     * axis events, or while no joystick is open.
+     * @param axis Axis number
+     * @param value Raw axis value
+     * @return double Normalized value (-1.0 to 1.0)
+     */
+    double normalizeAxisValue(int axis, int value) const;
+
+    /**
+     * @brief Retries on the lock-free axis slot
+     */
+    uint64_t getContentionCount() const;
+
+    /**
+     * @brief Axis event to axes published, measured where they are published
+     */
+    LatencySummary getPublishLatency() const;
+    void resetPublishLatency();
+
 signals:
     /**
      * @brief Signal emitted when joystick position changes
@@ -265,22 +356,47 @@ private:
      */
     void scanJoysticks();
 
+    // Backend specific parts, called with m_mutex held
+    void scanEvdevJoysticks();
+    void scanSdlJoysticks();
+    bool openEvdevJoystick(int index);
+    void closeJoystickLocked();
+    void calibrateAxesLocked();
+
     /**
-     * @brief Convert raw axis value to normalized position
+     * @brief One iteration of the input thread: wait for and apply events
+     */
+    void readInputEvents();
+
+    /**
+     * @brief Apply one evdev event
+     */
+    void handleEvdevEvent(uint16_t type, uint16_t code, int32_t value, int64_t eventNs);
+
+    /**
+     * @brief Publish the staged axes and signal the GUI at a limited rate
      *
-     * @param axis Axis number
-     * @param value Raw axis value
-     * @return double Normalized value (-1.0 to 1.0)
+     * @param throttle Limit signals to JOYSTICK_SIGNAL_INTERVAL_MS
      */
-    double normalizeAxisValue(int axis, int value) const;
+    void publishAxes(bool throttle);
+
+    /**
+     * @brief Record a button transition and emit its signals
+     */
+    void setButton(int button, bool pressed);
 
     /**
      * @brief Map SDL axis numbers to our position/rotation structure
      *
      * @param axis SDL axis number
      * @param value Normalized axis value
+     * @return true If the axis is one of the six mapped axes
      */
-    void mapAxisToPositionOrRotation(int axis, double value);
+    bool mapAxisToPositionOrRotation(int axis, double value);
+
+    // Backend requested by setBackend() and backend in use
+    Backend m_requestedBackend;
+    Backend m_backend;
 
     // SDL joystick polling timer
     QTimer *m_pollTimer;
@@ -294,10 +410,30 @@ private:
     // SDL initialization state
     bool m_sdlInitialized;
 
+    // evdev device nodes of the available joysticks, by index
+    QMap<int, QString> m_evdevPaths;
+
+    // Open evdev device, and the epoll set the input thread waits on
+    int m_evdevFd;
+    int m_epollFd;
+    QString m_evdevName;
+
+    // evdev code to axis, button and hat index, -1 if unused
+    std::vector<int> m_absAxis;
+    std::vector<int> m_keyButton;
+    int m_evdevAxes;
+    int m_evdevButtons;
+    int m_evdevHats;
+
+    // Input thread for the evdev backend
+    RealtimeThread m_inputThread;
+    RealtimeConfig m_inputConfig;
+    int64_t m_lastSignalNs[2];   // Position and rotation signals
+
     // Axis calibration structure
     struct AxisCalibration {
-        int min;       // Minimum value
-        int max;       // Maximum value
+        int min;       // Minimum raw value
+        int max;       // Maximum raw value
         int center;    // Center value
         bool calibrated; // Whether calibration has been performed
     };
@@ -305,17 +441,19 @@ private:
     // Calibration data for each axis
     QVector<AxisCalibration> m_axisCalibration;
 
-    // Joystick state - position axes
-    double m_x, m_y, m_z;
-
-    // Joystick state - rotation axes
-    double m_rx, m_ry, m_rz;
+    // Joystick state, staged by the input thread (or the SDL timer) and
+    // published to the lock-free slot read by the control thread
+    JoystickAxes m_axes;
+    CommandSlot<JoystickAxes> m_axesSlot;
+    bool m_axesStaged;      // m_axes changed since the last publication
+    int m_signalPending;    // Bit 0 position, bit 1 rotation signal due
+    LatencyHistogram m_publishLatency;
 
     // Hat state - array of hat positions
     QVector<int> m_hatState;
 
     // Button state bitmap
-    uint32_t m_buttonState;
+    std::atomic<uint32_t> m_buttonState;
 
     // Mutex for thread safety
     mutable QMutex m_mutex;
@@ -323,7 +461,7 @@ private:
     // Running state
     bool m_running;
 
-    // Polling rate in milliseconds
+    // SDL polling rate in milliseconds
     static const int POLLING_RATE_MS = 16; // ~60Hz
 
     // Default axis mappings (can be overridden in configuration)
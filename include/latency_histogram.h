@@ -0,0 +1,151 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Percentiles of a LatencyHistogram, in nanoseconds
+ */
+struct LatencySummary {
+    uint64_t count;
+    int64_t p50Ns;
+    int64_t p99Ns;
+    int64_t p999Ns;
+    int64_t maxNs;
+};
+
+/**
+ * @brief Single-writer latency histogram with log-linear buckets.
+ *
+ * Like an HDR histogram, every power of two is split into SUB_BUCKETS
+ * linear buckets, so any value from 1 ns to about 18 minutes is kept to
+ * within 1/SUB_BUCKETS of itself in a fixed 9 KB table. record() is a
+ * couple of shifts and relaxed stores with no read-modify-write, so it
+ * costs a few nanoseconds on the hot path; only one thread may call it.
+ * Any thread may read summary() while it runs.
+ */
+class LatencyHistogram
+{
+public:
+    static const int SUB_BUCKET_BITS = 5;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int MAX_VALUE_BITS = 40;
+    static const int BUCKET_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    LatencyHistogram()
+        : m_count(0)
+        , m_max(0)
+        , m_resetRequested(false)
+    {
+        clear();
+    }
+
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+    // Writer side
+    void record(int64_t ns)
+    {
+        if (m_resetRequested.load(std::memory_order_relaxed)) {
+            clear();
+            m_resetRequested.store(false, std::memory_order_relaxed);
+        }
+
+        const uint64_t value = ns < 0 ? 0 : static_cast<uint64_t>(ns);
+        std::atomic<uint64_t> &bucket = m_buckets[bucketIndex(value)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        m_count.store(m_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (static_cast<int64_t>(value) > m_max.load(std::memory_order_relaxed)) {
+            m_max.store(static_cast<int64_t>(value), std::memory_order_relaxed);
+        }
+    }
+
+    // Reader side. The writer clears the table on its next record().
+    void reset() { m_resetRequested.store(true, std::memory_order_relaxed); }
+
+    uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+
+    LatencySummary summary() const
+    {
+        // Work on a copy so all percentiles come from the same counts
+        uint64_t counts[BUCKET_COUNT];
+        uint64_t total = 0;
+        for (int i = 0; i < BUCKET_COUNT; i++) {
+            counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+            total += counts[i];
+        }
+
+        LatencySummary result;
+        result.count = total;
+        result.maxNs = m_max.load(std::memory_order_relaxed);
+        result.p50Ns = percentile(counts, total, 0.5);
+        result.p99Ns = percentile(counts, total, 0.99);
+        result.p999Ns = percentile(counts, total, 0.999);
+        return result;
+    }
+
+    // Bucket holding a value, and the highest value that bucket holds
+    static int bucketIndex(uint64_t value)
+    {
+        if (value >= (1ULL << MAX_VALUE_BITS)) {
+            return BUCKET_COUNT - 1;
+        }
+        if (value < static_cast<uint64_t>(SUB_BUCKETS)) {
+            return static_cast<int>(value);
+        }
+
+        const int shift = (63 - __builtin_clzll(value)) - SUB_BUCKET_BITS;
+        return (shift + 1) * SUB_BUCKETS + static_cast<int>((value >> shift) - SUB_BUCKETS);
+    }
+
+    static int64_t bucketUpperBound(int index)
+    {
+        if (index < SUB_BUCKETS) {
+            return index;
+        }
+
+        const int shift = index / SUB_BUCKETS - 1;
+        const int64_t lower = static_cast<int64_t>(index % SUB_BUCKETS + SUB_BUCKETS) << shift;
+        return lower + (1LL << shift) - 1;
+    }
+
+private:
+    void clear()
+    {
+        for (int i = 0; i < BUCKET_COUNT; i++) {
+            m_buckets[i].store(0, std::memory_order_relaxed);
+        }
+        m_count.store(0, std::memory_order_relaxed);
+        m_max.store(0, std::memory_order_relaxed);
+    }
+
+    int64_t percentile(const uint64_t *counts, uint64_t total, double fraction) const
+    {
+        if (total == 0) {
+            return 0;
+        }
+
+        // Smallest bucket at or above the requested rank, reported as its
+        // upper bound but never above the exact maximum
+        const uint64_t rank = static_cast<uint64_t>(fraction * static_cast<double>(total - 1)) + 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKET_COUNT; i++) {
+            seen += counts[i];
+            if (seen >= rank) {
+                const int64_t bound = bucketUpperBound(i);
+                const int64_t max = m_max.load(std::memory_order_relaxed);
+                return bound < max ? bound : max;
+            }
+        }
+        return m_max.load(std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> m_buckets[BUCKET_COUNT];
+    std::atomic<uint64_t> m_count;
+    std::atomic<int64_t> m_max;
+    std::atomic<bool> m_resetRequested;
+};
+
+#endif // LATENCY_HISTOGRAM_H
@@ -0,0 +1,74 @@
+#ifndef LOOP_OPTIONS_H
+#define LOOP_OPTIONS_H
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+
+class ControlLoop;
+
+/**
+ * @brief Command line options of the control loop.
+ *
+ * Shared by the GUI and the headless daemon so both accept the same
+ * scheduling, tracker, output and backend options. addTo() registers them,
+ * applyBackends() must run before the loop is constructed, since the
+ * controllers open their hardware on construction, and applyTo()
+ * configures the constructed loop.
+ */
+class LoopOptions
+{
+public:
+    LoopOptions();
+
+    void addTo(QCommandLineParser &parser) const;
+
+    // Hardware and joystick backends, before any controller exists
+    void applyBackends(const QCommandLineParser &parser) const;
+
+    // Rate, scheduling and output configuration; also locks memory for
+    // --rt-priority. False if the loop rejected the configuration.
+    bool applyTo(const QCommandLineParser &parser, ControlLoop &loop) const;
+
+private:
+    QCommandLineOption m_controlRate;
+    QCommandLineOption m_aiSection;
+    QCommandLineOption m_aiDriven;
+    QCommandLineOption m_aiRaw;
+    QCommandLineOption m_feedbackFilter;
+    QCommandLineOption m_rtPriority;
+    QCommandLineOption m_rtCpu;
+    QCommandLineOption m_trackerIrq;
+    QCommandLineOption m_trackerPoll;
+    QCommandLineOption m_trackerScheduled;
+    QCommandLineOption m_trackerStale;
+    QCommandLineOption m_trackerDiv;
+    QCommandLineOption m_joystickDiv;
+    QCommandLineOption m_gimbalDiv;
+    QCommandLineOption m_trackEstimator;
+    QCommandLineOption m_trackLatency;
+    QCommandLineOption m_trackCoast;
+    QCommandLineOption m_trackHold;
+    QCommandLineOption m_trackFallback;
+    QCommandLineOption m_gimbalOffload;
+    QCommandLineOption m_offloadHz;
+    QCommandLineOption m_offloadRate;
+    QCommandLineOption m_offloadScale;
+    QCommandLineOption m_offloadSource;
+    QCommandLineOption m_modeBlend;
+    QCommandLineOption m_fsmSlew;
+    QCommandLineOption m_gimbalSlew;
+    QCommandLineOption m_noSlewLimit;
+    QCommandLineOption m_servoPid;
+    QCommandLineOption m_servoLead;
+    QCommandLineOption m_servoNotch;
+    QCommandLineOption m_clockedAo;
+    QCommandLineOption m_aoLead;
+    QCommandLineOption m_overrunWarn;
+    QCommandLineOption m_joystickSdl;
+    QCommandLineOption m_simulate;
+    QCommandLineOption m_simSeed;
+    QCommandLineOption m_simDropout;
+    QCommandLineOption m_simDropoutSilent;
+};
+
+#endif // LOOP_OPTIONS_H
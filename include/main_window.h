@@ -11,9 +11,6 @@
 #include <QSpinBox>
 #include <QLineEdit>
 #include <QPushButton>
-#include <QFile>
-#include <QTextStream>
-#include <QElapsedTimer>
 #include <QRadioButton>
 #include <QVBoxLayout>
 #include <QFont>
@@ -25,6 +22,7 @@
 #include "gimbal_controller.h"
 #include "tracker_interface.h"
 #include "control_loop.h"
+#include "telemetry_recorder.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -38,6 +36,12 @@ public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    ControlLoop *controlLoop() const { return m_controlLoop; }
+
+    // Write the latency histograms and scheduler health to the log and to
+    // stdout
+    void dumpLatency();
+
 private slots:
     // System control
     void onStartSystem();
@@ -84,11 +88,13 @@ private slots:
 
 private:
     Ui::MainWindow *ui;
+    ControlLoop *m_controlLoop;
+
+    // Components owned by the control loop
     JoystickInterface *m_joystickInterface;
     FSMController *m_fsmController;
     GimbalController *m_gimbalController;
     TrackerInterface *m_trackerInterface;
-    ControlLoop *m_controlLoop;
 
     // Joystick UI elements
     QVector<QLabel*> m_buttonLabels;
@@ -130,11 +136,8 @@ private:
     bool m_trackerAutoPoll;
     QTimer *m_trackerPollTimer;
 
-    // Data logging
-    QFile *m_logFile;
-    QTextStream *m_logStream;
-    bool m_loggingActive;
-    QElapsedTimer m_loggingTimer;
+    // Data logging, every control tick into a binary recording
+    TelemetryRecorder m_recorder;
 
     // Status update timer
     QTimer *m_statusUpdateTimer;
@@ -142,19 +145,8 @@ private:
     // Font for status bar
     QFont m_statusFont;
 
-    // Telemetry data structure 
-    struct Telemetry {
-        double fsmX;
-        double fsmY;
-        double gimbalAz;
-        double gimbalEl;
-        double gimbalAuxEl;
-        double joystickX;
-        double joystickY;
-        double joystickZ;
-        double trackErrorX;
-        double trackErrorY;
-    } m_telemetry;
+    // Latest telemetry pulled from the control loop
+    TelemetrySnapshot m_telemetry;
 
     // UI initialization methods
     void setupUi();
@@ -173,18 +165,16 @@ private:
     
     // Event handlers from other components
     void onClearLogsButtonClicked();
+    void onResetLatency();
     void onStatusChanged(const QString &message);
     void onErrorOccurred(const QString &error);
     void onOperationModeChanged(ControlLoop::OperationMode mode);
-    void onTelemetryUpdated(double fsmX, double fsmY, 
-                          double gimbalAz, double gimbalEl, double gimbalAuxEl,
-                          double joystickX, double joystickY, double joystickZ,
-                          double trackErrorX, double trackErrorY);
 
     // Helper methods
     QString hatValueToString(int value);
     double mapAxisToPosition(int axisValue, double deadzone, bool invert);
-    void logData(const QString &data);
+    // Hand the deadzones, inversions and enables to the control loop
+    void applyManualInputConfig();
     void updateUIForCurrentMode();
     void setStatusMessage(const QString &message);
 };
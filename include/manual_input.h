@@ -0,0 +1,52 @@
+#ifndef MANUAL_INPUT_H
+#define MANUAL_INPUT_H
+
+#include <cmath>
+#include <cstdint>
+
+// Joystick axes inverted before they drive an output
+#define MANUAL_INVERT_FSM_X       0x01u
+#define MANUAL_INVERT_FSM_Y       0x02u
+#define MANUAL_INVERT_GIMBAL_AZ   0x04u
+#define MANUAL_INVERT_GIMBAL_EL   0x08u
+#define MANUAL_INVERT_GIMBAL_AUX  0x10u
+
+/**
+ * @brief How the joystick drives the FSM and the gimbal.
+ *
+ * Applied by the control tick to every new joystick position. Plain data,
+ * so it can be held in a CommandSlot and sent through shared memory.
+ */
+struct ManualInputConfig {
+    double fsmDeadzone;          // Fraction of full scale around center
+    double gimbalDeadzone;
+    uint32_t invertMask;         // MANUAL_INVERT_* bits
+    int32_t fsmOutputEnabled;    // Joystick drives the FSM
+    int32_t gimbalOutputEnabled; // Joystick drives the gimbal in coarse track
+
+    ManualInputConfig()
+        : fsmDeadzone(0.0)
+        , gimbalDeadzone(0.0)
+        , invertMask(0)
+        , fsmOutputEnabled(1)
+        , gimbalOutputEnabled(1)
+    {
+    }
+};
+
+/**
+ * @brief Apply a deadzone and inversion to a normalized axis value.
+ *
+ * Values inside the deadzone read zero; the rest of the travel is rescaled
+ * so full deflection still reaches +/-1.
+ */
+inline double shapeManualAxis(double value, double deadzone, bool invert)
+{
+    double shaped = 0.0;
+    if (std::fabs(value) > deadzone && deadzone < 1.0) {
+        shaped = (std::fabs(value) - deadzone) / (1.0 - deadzone) * (value < 0.0 ? -1.0 : 1.0);
+    }
+    return invert ? -shaped : shaped;
+}
+
+#endif // MANUAL_INPUT_H
@@ -0,0 +1,49 @@
+#ifndef MODE_BLEND_H
+#define MODE_BLEND_H
+
+/**
+ * @brief Raised-cosine crossfade between two command sources.
+ *
+ * On a mode change the outputs fade from the source of the old mode to the
+ * source of the new one over a fixed number of output commits instead of
+ * switching in one DAC write. Both sources stay live during the fade, so
+ * the output keeps following whichever input still moves. The weight of
+ * the new source rises as 1/2 - 1/2 cos, with zero slope at both ends.
+ *
+ * Used by one committing thread; it never allocates.
+ */
+class ModeBlend
+{
+public:
+    ModeBlend();
+
+    // Start a fade over `commits` commits; 0 switches at once
+    void start(int commits);
+
+    // End any fade on the new source
+    void stop();
+
+    bool isActive() const { return m_step < m_commits; }
+
+    // Share of the new source in the current commit, 0 to 1
+    double weight() const;
+
+    double mix(double from, double to) const
+    {
+        return from + (to - from) * weight();
+    }
+
+    // Move on to the next commit
+    void advance()
+    {
+        if (m_step < m_commits) {
+            m_step++;
+        }
+    }
+
+private:
+    int m_commits;
+    int m_step;
+};
+
+#endif // MODE_BLEND_H
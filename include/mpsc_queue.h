@@ -0,0 +1,162 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * @brief Bounded multi-producer/single-consumer queue.
+ *
+ * Each cell carries a sequence number that tells producers and the consumer
+ * whose turn it is (Vyukov's bounded queue), so push() and pop() are lock-free
+ * and never allocate. The queue holds no pointers and only lock-free
+ * atomics, so it can live in memory shared between processes. When the
+ * queue is full push() drops the element and counts it.
+ *
+ * A producer stopped halfway through push() holds up the consumer at its
+ * cell. Popping with a stall timeout skips such a cell once it has been
+ * claimed but unpublished for that long; the producer, if it ever resumes,
+ * finds the cell gone and drops its element. Only a producer stopped inside
+ * its final copy can still race the next lap's producer for the cell.
+ */
+template <typename T, size_t Capacity>
+class MpscQueue
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "MpscQueue capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "MpscQueue requires a trivially copyable type");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "MpscQueue requires lock-free 64-bit atomics");
+
+public:
+    MpscQueue()
+        : m_enqueue(0)
+        , m_dequeue(0)
+        , m_dropped(0)
+        , m_skipped(0)
+        , m_stalledPos(NO_STALL)
+        , m_stalledSinceNs(0)
+    {
+        for (size_t i = 0; i < Capacity; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Producer side, any thread or process
+    bool push(const T &value)
+    {
+        uint64_t pos = m_enqueue.load(std::memory_order_relaxed);
+        Cell *cell;
+        for (;;) {
+            cell = &m_cells[pos & MASK];
+            const uint64_t seq = cell->sequence.load(std::memory_order_acquire);
+            const int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+            if (diff == 0) {
+                if (m_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = m_enqueue.load(std::memory_order_relaxed);
+            }
+        }
+
+        // Publish only if the consumer did not skip the cell meanwhile
+        if (cell->sequence.load(std::memory_order_acquire) != pos) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        cell->value = value;
+        uint64_t expected = pos;
+        if (!cell->sequence.compare_exchange_strong(expected, pos + 1, std::memory_order_release,
+                                                    std::memory_order_relaxed)) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    // Consumer side
+    bool pop(T &value)
+    {
+        const uint64_t pos = m_dequeue.load(std::memory_order_relaxed);
+        Cell &cell = m_cells[pos & MASK];
+        if (cell.sequence.load(std::memory_order_acquire) != pos + 1) {
+            return false;
+        }
+
+        value = cell.value;
+        cell.sequence.store(pos + Capacity, std::memory_order_release);
+        m_dequeue.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief Pop, skipping a cell a producer claimed but has not published
+     *        for stallTimeoutNs
+     * @param nowNs Current time of the consumer's clock
+     */
+    bool pop(T &value, int64_t nowNs, int64_t stallTimeoutNs)
+    {
+        for (;;) {
+            if (pop(value)) {
+                return true;
+            }
+
+            // Empty, or the producer of the next cell is still writing it
+            const uint64_t pos = m_dequeue.load(std::memory_order_relaxed);
+            if (m_enqueue.load(std::memory_order_acquire) == pos) {
+                return false;
+            }
+            if (m_stalledPos != pos) {
+                m_stalledPos = pos;
+                m_stalledSinceNs = nowNs;
+                return false;
+            }
+            if (nowNs - m_stalledSinceNs < stallTimeoutNs) {
+                return false;
+            }
+
+            // Hand the cell to the next lap; fails if it was just published
+            uint64_t expected = pos;
+            if (m_cells[pos & MASK].sequence.compare_exchange_strong(expected, pos + Capacity,
+                                                                     std::memory_order_acq_rel)) {
+                m_dequeue.store(pos + 1, std::memory_order_relaxed);
+                m_skipped.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+    uint64_t droppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    // Cells skipped by the consumer because their producer stalled
+    uint64_t skippedCount() const { return m_skipped.load(std::memory_order_relaxed); }
+
+private:
+    static const size_t MASK = Capacity - 1;
+    static const uint64_t NO_STALL = ~0ULL;
+
+    struct Cell {
+        std::atomic<uint64_t> sequence;
+        T value;
+    };
+
+    Cell m_cells[Capacity];
+
+    // Producer and consumer positions on separate cache lines
+    alignas(64) std::atomic<uint64_t> m_enqueue;
+    alignas(64) std::atomic<uint64_t> m_dequeue;
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<uint64_t> m_skipped;
+
+    // Cell the consumer found claimed but unpublished, and since when
+    uint64_t m_stalledPos;
+    int64_t m_stalledSinceNs;
+};
+
+#endif // MPSC_QUEUE_H
@@ -0,0 +1,89 @@
+#ifndef OUTPUT_LIMITER_H
+#define OUTPUT_LIMITER_H
+
+/**
+ * @brief Slew-rate, acceleration and jerk limiter for analog output commands.
+ *
+ * Runs in the output commit path so a mode switch or a joystick flick moves
+ * the outputs along a bounded trajectory instead of stepping the DAC in one
+ * sample. Per channel:
+ *
+ *  - rate/acceleration: the output moves towards the command no faster
+ *    than the slew rate, changing speed by at most the acceleration limit
+ *    and slowing down early enough to stop at the command without overshoot
+ *  - jerk:              the result is smoothed by a boxcar of
+ *                       acceleration / jerk seconds, which turns each
+ *                       acceleration step into a ramp (an S-curve), again
+ *                       without overshoot, at the cost of half the boxcar
+ *                       in delay. Needs an acceleration limit.
+ *
+ * A zero limit disables that stage. configure() converts the limits to
+ * steps and taps per commit at the commit rate, so apply() costs the same
+ * for every command. The state is kept in MAX_CHANNELS-wide arrays and the
+ * loops have no data-dependent branches, so the compiler can vectorize
+ * them. Runs on the committing thread and never allocates.
+ */
+class OutputLimiter
+{
+public:
+    static const int MAX_CHANNELS = 4;
+    static const int MAX_JERK_TAPS = 32;
+
+    struct ChannelLimits {
+        double rate;            // Output units per second
+        double acceleration;    // Per second squared
+        double jerk;            // Per second cubed
+    };
+
+    struct Config {
+        bool bypass;            // Pass commands through unchanged
+        ChannelLimits channel[MAX_CHANNELS];
+
+        Config();
+    };
+
+    OutputLimiter();
+
+    /**
+     * @brief Apply limits and precompute their steps per commit
+     * @param config Limits of each channel
+     * @param channels Number of channels (1 - MAX_CHANNELS)
+     * @param commitRateHz Rate apply() is called at
+     * @return False if the parameters are invalid, or a jerk limit needs
+     *         more than MAX_JERK_TAPS commits; the limiter is unchanged
+     */
+    bool configure(const Config &config, int channels, double commitRateHz);
+    const Config &config() const { return m_config; }
+
+    // Restart at the given outputs, at rest
+    void reset(const double *outputs);
+
+    /**
+     * @brief Move the outputs one commit towards the commands
+     * @param commands Commands of each channel, replaced by the outputs
+     * @return True if any output differs from its command
+     */
+    bool apply(double *commands);
+
+private:
+    Config m_config;
+    int m_channels;
+
+    // Limits in steps per commit; infinite where disabled
+    double m_rateStep[MAX_CHANNELS];
+    double m_accelStep[MAX_CHANNELS];
+    double m_invAccelStep[MAX_CHANNELS];
+
+    // Rate and acceleration limited trajectory and its last step
+    double m_position[MAX_CHANNELS];
+    double m_velocity[MAX_CHANNELS];
+
+    // Jerk boxcar over the trajectory, one tap per commit. Disabled
+    // channels have one tap, which passes the trajectory through.
+    double m_history[MAX_JERK_TAPS][MAX_CHANNELS];
+    double m_tapWeight[MAX_JERK_TAPS][MAX_CHANNELS];
+    int m_taps;
+    int m_head;
+};
+
+#endif // OUTPUT_LIMITER_H
@@ -0,0 +1,81 @@
+#ifndef RATE_GROUP_H
+#define RATE_GROUP_H
+
+#include <cstdint>
+#include <functional>
+
+#include "latency_histogram.h"
+
+/**
+ * @brief Runs tasks at integer sub-multiples of a base tick on one thread.
+ *
+ * Each task runs on the ticks where (tick + offset) is a multiple of its
+ * divisor. Within a tick the tasks run phase by phase, READ before COMPUTE
+ * before WRITE before PUBLISH, and in registration order within a phase,
+ * so the order between any two tasks is fixed whatever their rates. The
+ * time each task takes is kept in a histogram.
+ *
+ * Tasks are registered while the thread calling run() is stopped; run()
+ * itself never allocates or blocks.
+ */
+class RateGroupScheduler
+{
+public:
+    static const int MAX_TASKS = 16;
+
+    enum class Phase {
+        READ,      // Sample inputs
+        COMPUTE,   // Derive commands
+        WRITE,     // Commit outputs
+        PUBLISH    // Telemetry and bookkeeping
+    };
+
+    struct TaskInfo {
+        const char *name;
+        Phase phase;
+        int divisor;       // Runs every divisor base ticks
+        int offset;        // Tick within the divisor it runs on
+    };
+
+    RateGroupScheduler();
+
+    RateGroupScheduler(const RateGroupScheduler &) = delete;
+    RateGroupScheduler &operator=(const RateGroupScheduler &) = delete;
+
+    // Remove all tasks
+    void clear();
+
+    /**
+     * @brief Register a task
+     * @return False if the table is full or divisor/offset are invalid
+     */
+    bool addTask(const char *name, Phase phase, int divisor, int offset, std::function<void()> task);
+
+    /**
+     * @brief Run the tasks due on a base tick
+     * @return Bit i set if task i (registration order) ran
+     */
+    uint32_t run(uint64_t tick);
+
+    int taskCount() const { return m_count; }
+    TaskInfo taskInfo(int index) const { return m_tasks[index].info; }
+
+    // Execution time of a task, recorded on the scheduler thread
+    LatencySummary taskDuration(int index) const { return m_tasks[index].duration.summary(); }
+    void resetStatistics();
+
+    static const char *phaseName(Phase phase);
+
+private:
+    struct Task {
+        TaskInfo info;
+        std::function<void()> run;
+        LatencyHistogram duration;
+    };
+
+    Task m_tasks[MAX_TASKS];
+    int m_order[MAX_TASKS];   // Task indices sorted by phase
+    int m_count;
+};
+
+#endif // RATE_GROUP_H
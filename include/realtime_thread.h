@@ -0,0 +1,110 @@
+#ifndef REALTIME_THREAD_H
+#define REALTIME_THREAD_H
+
+#include <pthread.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Default SCHED_FIFO priority for the control thread. The DAQ and tracker
+// IRQ threads should be raised above this on the target system.
+#define DEFAULT_RT_PRIORITY 80
+
+/**
+ * @brief Scheduling parameters for a real-time thread
+ */
+struct RealtimeConfig {
+    bool fifo;       // Request SCHED_FIFO (otherwise SCHED_OTHER)
+    int priority;    // SCHED_FIFO priority (1-99)
+    int cpu;         // CPU to pin the thread to, -1 for no affinity
+
+    RealtimeConfig()
+        : fifo(false)
+        , priority(DEFAULT_RT_PRIORITY)
+        , cpu(-1)
+    {
+    }
+};
+
+/**
+ * @brief Periodic executor running on a dedicated pthread.
+ *
+ * The thread sleeps with clock_nanosleep(TIMER_ABSTIME) on CLOCK_MONOTONIC
+ * so the period does not drift with the time spent in the tick, and counts
+ * every deadline that the tick overruns. Scheduling is applied from inside
+ * the new thread, so a failure to get SCHED_FIFO (missing CAP_SYS_NICE)
+ * degrades to a normal thread and is reported through lastError().
+ *
+ * With a period of zero the thread runs free: the tick is called back to
+ * back and is expected to block on its own event source with a timeout.
+ */
+class RealtimeThread
+{
+public:
+    RealtimeThread();
+    ~RealtimeThread();
+
+    RealtimeThread(const RealtimeThread &) = delete;
+    RealtimeThread &operator=(const RealtimeThread &) = delete;
+
+    /**
+     * @brief Start the periodic thread
+     * @param config Scheduling policy, priority and CPU affinity
+     * @param periodNs Tick period in nanoseconds, 0 for an event-driven tick
+     * @param tick Function called once per period on the thread
+     * @return True if the thread was created. Returns once scheduling has
+     *         been applied, so lastError() is valid on return.
+     */
+    bool start(const RealtimeConfig &config, int64_t periodNs, std::function<void()> tick);
+
+    /**
+     * @brief Stop the thread and wait for the current tick to finish
+     */
+    void stop();
+
+    bool isRunning() const { return m_running.load(std::memory_order_acquire); }
+
+    // Statistics, safe to read from any thread
+    uint64_t cycleCount() const { return m_cycles.load(std::memory_order_relaxed); }
+    uint64_t overrunCount() const { return m_overruns.load(std::memory_order_relaxed); }
+
+    // CLOCK_MONOTONIC deadline the running tick was scheduled for. Only
+    // meaningful from inside the tick of a periodic thread.
+    int64_t scheduledWakeNs() const { return m_scheduledWakeNs; }
+
+    /**
+     * @brief Whether SCHED_FIFO was actually granted to the running thread
+     */
+    bool isRealtime() const { return m_isRealtime.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Description of the last scheduling error, empty if none
+     */
+    std::string lastError() const;
+
+private:
+    static void *threadEntry(void *arg);
+    void run();
+    void applyScheduling();
+
+    pthread_t m_thread;
+    bool m_threadCreated;
+
+    RealtimeConfig m_config;
+    int64_t m_periodNs;
+    std::function<void()> m_tick;
+
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_ready;
+    std::atomic<bool> m_isRealtime;
+    std::atomic<uint64_t> m_cycles;
+    std::atomic<uint64_t> m_overruns;
+    int64_t m_scheduledWakeNs;
+
+    // Written once by the thread during startup, read after start()
+    char m_lastError[128];
+    std::atomic<bool> m_hasError;
+};
+
+#endif // REALTIME_THREAD_H
@@ -0,0 +1,117 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * @brief Single-writer, multi-reader sequence lock for small POD values.
+ *
+ * The writer never blocks and never allocates. Readers retry if they race
+ * with a write. The payload is stored as relaxed atomic words so concurrent
+ * reads are well defined; T must be trivially copyable.
+ */
+template <typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock requires a trivially copyable type");
+
+public:
+    SeqLock()
+        : m_sequence(0)
+    {
+        for (size_t i = 0; i < WORDS; ++i) {
+            m_words[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    explicit SeqLock(const T &initial)
+        : SeqLock()
+    {
+        store(initial);
+    }
+
+    /**
+     * @brief Publish a new value. Must only be called from one thread.
+     */
+    void store(const T &value)
+    {
+        uint64_t buffer[WORDS] = {};
+        std::memcpy(buffer, &value, sizeof(T));
+
+        const uint32_t seq = m_sequence.load(std::memory_order_relaxed);
+        m_sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < WORDS; ++i) {
+            m_words[i].store(buffer[i], std::memory_order_relaxed);
+        }
+
+        m_sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Read a consistent copy of the latest value
+     */
+    T load() const
+    {
+        T value;
+        while (!tryLoad(value)) {
+        }
+        return value;
+    }
+
+    /**
+     * @brief Single read attempt
+     * @return False if a write was in progress; value is then unspecified
+     */
+    bool tryLoad(T &value) const
+    {
+        uint32_t version;
+        return tryLoad(value, version);
+    }
+
+    /**
+     * @brief Single read attempt that also returns the version read
+     */
+    bool tryLoad(T &value, uint32_t &version) const
+    {
+        uint64_t buffer[WORDS];
+
+        const uint32_t before = m_sequence.load(std::memory_order_acquire);
+        if (before & 1u) {
+            return false;
+        }
+
+        for (size_t i = 0; i < WORDS; ++i) {
+            buffer[i] = m_words[i].load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_sequence.load(std::memory_order_relaxed) != before) {
+            return false;
+        }
+
+        std::memcpy(&value, buffer, sizeof(T));
+        version = before >> 1;
+        return true;
+    }
+
+    /**
+     * @brief Number of completed writes, usable as a change counter
+     */
+    uint32_t version() const
+    {
+        return m_sequence.load(std::memory_order_acquire) >> 1;
+    }
+
+private:
+    static const size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint32_t> m_sequence;
+    std::atomic<uint64_t> m_words[WORDS];
+};
+
+#endif // SEQLOCK_H
@@ -0,0 +1,100 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Bounded single-producer/single-consumer ring buffer.
+ *
+ * Storage is fixed at compile time, so push() and pop() never allocate.
+ * When the ring is full push() drops the new element and counts it rather
+ * than blocking the producer.
+ */
+template <typename T, size_t Capacity>
+class SpscRing
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscRing capacity must be a power of two");
+
+public:
+    SpscRing()
+        : m_head(0)
+        , m_tail(0)
+        , m_dropped(0)
+    {
+    }
+
+    // Producer side
+    bool push(const T &value)
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) >= Capacity) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        m_buffer[head & MASK] = value;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool pop(T &value)
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        value = m_buffer[tail & MASK];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Pop up to maxCount elements into out
+     * @return Number of elements copied
+     */
+    size_t popBulk(T *out, size_t maxCount)
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        const size_t available = m_head.load(std::memory_order_acquire) - tail;
+        const size_t count = available < maxCount ? available : maxCount;
+
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = m_buffer[(tail + i) & MASK];
+        }
+
+        m_tail.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer side: discard everything currently queued
+    void clear()
+    {
+        m_tail.store(m_head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    size_t size() const
+    {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+    uint64_t droppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    static const size_t MASK = Capacity - 1;
+
+    T m_buffer[Capacity];
+
+    // Producer and consumer indices on separate cache lines
+    alignas(64) std::atomic<size_t> m_head;
+    alignas(64) std::atomic<size_t> m_tail;
+    std::atomic<uint64_t> m_dropped;
+};
+
+#endif // SPSC_RING_H
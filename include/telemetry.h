@@ -0,0 +1,132 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <atomic>
+#include <cstdint>
+#include <sched.h>
+
+#include "broadcast_ring.h"
+#include "seqlock.h"
+#include "spsc_ring.h"
+
+// Snapshots kept by a telemetry mirror, ~8 s at 1 kHz
+#define TELEMETRY_MIRROR_CAPACITY 8192
+
+/**
+ * @brief State of the control system captured once per control tick
+ */
+struct TelemetrySnapshot {
+    uint64_t cycle;        // Control tick counter
+    int64_t timestampNs;   // CLOCK_MONOTONIC time of the tick
+    int32_t mode;          // ControlLoop::OperationMode
+    int32_t tracking;      // Non-zero while the tracker reports a track
+
+    double fsmX;
+    double fsmY;
+    double fsmXMean;       // Over the last feedback block, before filtering
+    double fsmXMin;
+    double fsmXMax;
+    double fsmXRms;
+    double fsmYMean;
+    double fsmYMin;
+    double fsmYMax;
+    double fsmYRms;
+    double gimbalAz;
+    double gimbalEl;
+    double gimbalAuxEl;
+    double joystickX;
+    double joystickY;
+    double joystickZ;
+    double trackErrorX;
+    double trackErrorY;
+    uint64_t trackFrame;   // Tracker messages received since start
+    int64_t trackAgeNs;    // Arrival to FSM write of the last applied message
+    int64_t joystickAgeNs; // Event to control tick of the last applied axis change
+};
+
+// Ring that other processes tail, see IpcServer
+typedef BroadcastRing<TelemetrySnapshot, TELEMETRY_MIRROR_CAPACITY> TelemetryMirror;
+
+/**
+ * @brief Lock-free telemetry path out of the control loop.
+ *
+ * The control thread publishes one snapshot per tick with publish(); it
+ * never allocates, blocks or emits signals. Any number of consumers can
+ * poll the latest snapshot. A single consumer that needs every sample
+ * (e.g. a recorder) enables the history ring and drains it at its own pace;
+ * samples are dropped and counted if it falls behind. A mirror, typically
+ * in shared memory, additionally receives every snapshot for readers in
+ * other processes.
+ */
+class TelemetryChannel
+{
+public:
+    static const size_t HISTORY_CAPACITY = 4096;  // ~4 s at 1 kHz
+
+    TelemetryChannel()
+        : m_historyEnabled(false)
+        , m_mirror(nullptr)
+        , m_mirrorInUse(false)
+    {
+    }
+
+    // Producer side, called from the control thread only. The in-use flag
+    // and the mirror pointer are sequentially consistent, so setMirror()
+    // either sees the flag or this publish sees the new mirror.
+    void publish(const TelemetrySnapshot &snapshot)
+    {
+        m_mirrorInUse.store(true, std::memory_order_seq_cst);
+        TelemetryMirror *mirror = m_mirror.load(std::memory_order_seq_cst);
+        if (mirror) {
+            mirror->push(snapshot);
+        }
+        m_mirrorInUse.store(false, std::memory_order_release);
+
+        m_latest.store(snapshot);
+        if (m_historyEnabled.load(std::memory_order_relaxed)) {
+            m_history.push(snapshot);
+        }
+    }
+
+    // Consumer side, any thread
+    TelemetrySnapshot latest() const { return m_latest.load(); }
+    uint32_t version() const { return m_latest.version(); }
+
+    // History ring, owned by one consumer at a time
+    void setHistoryEnabled(bool enabled)
+    {
+        if (enabled) {
+            m_history.clear();
+        }
+        m_historyEnabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool isHistoryEnabled() const { return m_historyEnabled.load(std::memory_order_relaxed); }
+
+    size_t drainHistory(TelemetrySnapshot *out, size_t maxCount) { return m_history.popBulk(out, maxCount); }
+    uint64_t droppedHistoryCount() const { return m_history.droppedCount(); }
+
+    /**
+     * @brief Set the mirror receiving every snapshot, nullptr to detach
+     *
+     * Returns once no publish uses the previous mirror, so it can then be
+     * unmapped. It waits for a push in progress to finish, however long the
+     * control thread is preempted inside it, and never gives up.
+     */
+    void setMirror(TelemetryMirror *mirror)
+    {
+        m_mirror.store(mirror, std::memory_order_seq_cst);
+        while (m_mirrorInUse.load(std::memory_order_seq_cst)) {
+            sched_yield();
+        }
+    }
+
+private:
+    SeqLock<TelemetrySnapshot> m_latest;
+    std::atomic<bool> m_historyEnabled;
+    SpscRing<TelemetrySnapshot, HISTORY_CAPACITY> m_history;
+    std::atomic<TelemetryMirror *> m_mirror;
+    std::atomic<bool> m_mirrorInUse;
+};
+
+#endif // TELEMETRY_H
@@ -0,0 +1,155 @@
+#ifndef TELEMETRY_RECORDER_H
+#define TELEMETRY_RECORDER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "telemetry.h"
+
+// Recording file format
+#define RECORDING_MAGIC        "BCTRLREC"
+#define RECORDING_VERSION      1
+#define RECORDING_HEADER_SIZE  4096   // Records start page aligned
+#define RECORDING_MAX_FIELDS   64
+#define RECORDING_NAME_LENGTH  24
+
+// Default file size in seconds of control ticks
+#define RECORDING_DEFAULT_SECONDS 600
+
+/**
+ * @brief Scalar type of a recorded field
+ */
+enum RecordingFieldType : uint32_t {
+    FIELD_U64 = 1,
+    FIELD_I64 = 2,
+    FIELD_I32 = 3,
+    FIELD_F64 = 4
+};
+
+struct RecordingField {
+    char name[RECORDING_NAME_LENGTH];
+    uint32_t type;     // RecordingFieldType
+    uint32_t offset;   // Byte offset inside a record
+};
+
+/**
+ * @brief Header at the start of a recording file.
+ *
+ * The header describes every field of a record, so the converter reads
+ * files written by older builds without knowing their TelemetrySnapshot.
+ * recordCount is updated after every batch; a file from a crashed run is
+ * valid up to the last completed batch.
+ */
+struct RecordingHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t recordSize;
+    uint32_t fieldCount;
+    uint64_t capacity;          // Records preallocated in the file
+    uint64_t recordCount;       // Records written
+    uint64_t droppedRecords;    // Lost to a full ring or a full file
+    int64_t startRealtimeNs;    // CLOCK_REALTIME when the recording started
+    int64_t startMonotonicNs;   // CLOCK_MONOTONIC at the same instant
+    uint32_t controlRateHz;
+    uint32_t reserved;
+    RecordingField fields[RECORDING_MAX_FIELDS];
+};
+
+static_assert(sizeof(RecordingHeader) <= RECORDING_HEADER_SIZE, "recording header too large");
+
+/**
+ * @brief Records every control tick into a preallocated, memory-mapped file.
+ *
+ * The control thread only pushes into the telemetry history ring. A normal
+ * priority writer thread drains the ring in batches and copies the snapshots
+ * into the mapping, so nothing on the RT path formats, allocates or blocks
+ * on I/O. The file is sized for a fixed number of records up front; once it
+ * is full further records are counted as dropped.
+ */
+class TelemetryRecorder
+{
+public:
+    TelemetryRecorder();
+    ~TelemetryRecorder();
+
+    TelemetryRecorder(const TelemetryRecorder &) = delete;
+    TelemetryRecorder &operator=(const TelemetryRecorder &) = delete;
+
+    /**
+     * @brief Create the file, preallocate capacity records and start recording
+     * @param channel Telemetry source; its history ring is owned by the
+     *        recorder until stop()
+     */
+    bool start(const std::string &path, uint64_t capacity, uint32_t controlRateHz,
+               TelemetryChannel *channel, std::string &error);
+
+    /**
+     * @brief Flush the remaining history, finalize the header and close
+     */
+    void stop();
+
+    bool isRecording() const { return m_running.load(std::memory_order_acquire); }
+
+    uint64_t recordCount() const { return m_recordCount.load(std::memory_order_relaxed); }
+    uint64_t droppedCount() const;
+
+private:
+    void run();
+    void drain();
+    void updateHeader();
+
+    TelemetryChannel *m_channel;
+    int m_fd;
+    void *m_mapping;
+    size_t m_mappingSize;
+    RecordingHeader *m_header;
+    TelemetrySnapshot *m_records;
+    uint64_t m_capacity;
+
+    std::atomic<uint64_t> m_recordCount;
+    std::atomic<uint64_t> m_overflow;
+    uint64_t m_droppedBase;   // Ring drops before this recording
+
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+};
+
+/**
+ * @brief Read-only view of a recording file
+ */
+class RecordingReader
+{
+public:
+    RecordingReader();
+    ~RecordingReader();
+
+    RecordingReader(const RecordingReader &) = delete;
+    RecordingReader &operator=(const RecordingReader &) = delete;
+
+    bool open(const std::string &path, std::string &error);
+    void close();
+
+    const RecordingHeader &header() const { return *m_header; }
+    uint64_t recordCount() const { return m_header->recordCount; }
+
+    // Pointer to the start of a record, index < recordCount()
+    const unsigned char *record(uint64_t index) const
+    {
+        return m_data + RECORDING_HEADER_SIZE + index * m_header->recordSize;
+    }
+
+    // Value of a field in a record, converted to double
+    double value(uint64_t index, const RecordingField &field) const;
+
+private:
+    int m_fd;
+    const unsigned char *m_data;
+    size_t m_size;
+    const RecordingHeader *m_header;
+};
+
+#endif // TELEMETRY_RECORDER_H
@@ -0,0 +1,107 @@
+#ifndef TICK_MONITOR_H
+#define TICK_MONITOR_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "seqlock.h"
+
+// What a control tick did, for the context of the worst ticks
+#define TICK_TRACK_APPLIED     0x01u  // Applied a new tracker message
+#define TICK_JOYSTICK_APPLIED  0x02u  // Applied new joystick axes
+#define TICK_SERVO             0x04u  // Ran the FSM compensators
+#define TICK_CONTENDED         0x08u  // Deferred a configuration change caught mid-store
+#define TICK_MODE_CHANGE       0x10u  // Started a mode transition
+
+/**
+ * @brief Timing of one periodic tick, CLOCK_MONOTONIC nanoseconds
+ */
+struct TickRecord {
+    uint64_t cycle;
+    int64_t scheduledNs;   // Deadline the tick was scheduled to start at
+    int64_t wakeNs;        // Tick actually started
+    int64_t endNs;         // Tick finished
+    int64_t slackNs;       // Next deadline minus end, negative on an overrun
+    int32_t mode;          // ControlLoop::OperationMode
+    uint32_t flags;        // TICK_* bits
+};
+
+/**
+ * @brief Running count, mean, deviation and range of one quantity
+ */
+struct RunningStat {
+    uint64_t count;
+    double mean;
+    double m2;             // Sum of squared deviations (Welford)
+    int64_t min;
+    int64_t max;
+
+    void add(int64_t value);
+    double stddev() const;
+};
+
+/**
+ * @brief Scheduler health since the last reset
+ */
+struct TickStatistics {
+    uint64_t ticks;
+    uint64_t deadlineMisses;   // Ticks that ended after the next deadline
+    RunningStat period;        // Start to start
+    RunningStat lateness;      // Deadline to start
+    RunningStat duration;      // Start to end
+    RunningStat slack;         // End to next deadline
+};
+
+/**
+ * @brief Scheduler health of a periodic thread.
+ *
+ * The thread hands every tick to record(), which updates the running
+ * statistics and keeps the WORST_COUNT ticks with the least slack. Both are
+ * published through seqlocks, so record() never blocks or allocates and
+ * any thread can read them while the loop runs.
+ */
+class TickMonitor
+{
+public:
+    static const int WORST_COUNT = 16;
+
+    TickMonitor();
+
+    // Period the deadlines are spaced by. Call while no tick is recorded.
+    void configure(int64_t periodNs);
+    int64_t period() const { return m_periodNs; }
+
+    // Writer side, called by the periodic thread after each tick
+    void record(TickRecord tick);
+
+    // Reader side. reset() is applied by the writer on its next record().
+    void reset() { m_resetRequested.store(true, std::memory_order_relaxed); }
+    TickStatistics statistics() const { return m_publishedStats.load(); }
+
+    /**
+     * @brief Copy the worst ticks, least slack first
+     * @return Number of ticks copied, at most WORST_COUNT
+     */
+    int worstTicks(TickRecord *out) const;
+
+private:
+    struct WorstTicks {
+        int count;
+        TickRecord ticks[WORST_COUNT];
+    };
+
+    void clear();
+
+    int64_t m_periodNs;
+    int64_t m_lastWakeNs;
+
+    // Owned by the writer, published after each change
+    TickStatistics m_stats;
+    WorstTicks m_worst;
+    SeqLock<TickStatistics> m_publishedStats;
+    SeqLock<WorstTicks> m_publishedWorst;
+
+    std::atomic<bool> m_resetRequested;
+};
+
+#endif // TICK_MONITOR_H
@@ -0,0 +1,121 @@
+#ifndef TRACK_ESTIMATOR_H
+#define TRACK_ESTIMATOR_H
+
+#include <cstdint>
+
+/**
+ * @brief Alpha-beta(-gamma) estimator of the target's track error.
+ *
+ * The tracker reports the error of a camera frame that is already a frame
+ * period or more old, at the camera rate. update() folds each message into
+ * a position/velocity (and, for the constant-acceleration model,
+ * acceleration) state per axis, stamped with the time the frame was
+ * exposed rather than when it arrived. predict() extrapolates that state
+ * to any later instant, so the control tick can command the error expected
+ * at its own DAC write instead of holding the last report.
+ *
+ * Gains are fixed; the filter adapts to the measured interval between
+ * frames. Everything runs on the control thread and never allocates.
+ */
+class TrackEstimator
+{
+public:
+    enum class Model {
+        CONSTANT_VELOCITY,      // Alpha-beta
+        CONSTANT_ACCELERATION   // Alpha-beta-gamma
+    };
+
+    struct Config {
+        bool enabled;
+        Model model;
+        double alpha;             // Position correction gain (0, 1]
+        double beta;              // Velocity correction gain
+        double gamma;             // Acceleration correction gain (CA only)
+        int64_t frameLatencyNs;   // Frame exposure to message arrival
+        int64_t maxPredictionNs;  // Longest extrapolation past a frame
+        int64_t maxGapNs;         // Restart when frames are further apart
+
+        Config();
+    };
+
+    TrackEstimator();
+
+    /**
+     * @brief Apply gains and limits
+     * @return False if the configuration is invalid; the previous one is kept
+     */
+    bool configure(const Config &config);
+    const Config &config() const { return m_config; }
+
+    // Forget the target; the next measurement starts a new track
+    void reset();
+    bool hasTrack() const { return m_initialized; }
+
+    /**
+     * @brief Fold in one tracker message
+     * @param x, y Measured track errors
+     * @param arrivalNs CLOCK_MONOTONIC arrival time of the message
+     */
+    void update(double x, double y, int64_t arrivalNs);
+
+    /**
+     * @brief Estimated track errors at timeNs
+     *
+     * Extrapolation stops maxPredictionNs after the last frame, so a late
+     * or lost message holds the last prediction instead of running away.
+     */
+    void predict(int64_t timeNs, double &x, double &y) const
+    {
+        double dt = (timeNs - m_stateNs) * 1e-9;
+        if (dt < 0.0) {
+            dt = 0.0;
+        } else if (dt > m_maxPredictionS) {
+            dt = m_maxPredictionS;
+        }
+        const double half = 0.5 * dt * dt;
+        x = m_axis[0].position + m_axis[0].velocity * dt + m_axis[0].acceleration * half;
+        y = m_axis[1].position + m_axis[1].velocity * dt + m_axis[1].acceleration * half;
+    }
+
+    /**
+     * @brief Extrapolate through a track loss
+     *
+     * Like predict() up to maxPredictionNs after the last frame, then at
+     * the velocity reached there, without limit: the caller bounds how
+     * long it coasts. Acceleration is not extrapolated further, since a
+     * parabola leaves the scene quickly.
+     */
+    void coast(int64_t timeNs, double &x, double &y) const
+    {
+        predict(timeNs, x, y);
+        const double beyond = (timeNs - m_stateNs) * 1e-9 - m_maxPredictionS;
+        if (beyond > 0.0) {
+            x += (m_axis[0].velocity + m_axis[0].acceleration * m_maxPredictionS) * beyond;
+            y += (m_axis[1].velocity + m_axis[1].acceleration * m_maxPredictionS) * beyond;
+        }
+    }
+
+    // Estimated error rates, per second
+    void velocity(double &x, double &y) const
+    {
+        x = m_axis[0].velocity;
+        y = m_axis[1].velocity;
+    }
+
+private:
+    struct AxisState {
+        double position;
+        double velocity;
+        double acceleration;
+    };
+
+    void correct(AxisState &axis, double measurement, double dt);
+
+    Config m_config;
+    double m_maxPredictionS;
+    AxisState m_axis[2];
+    int64_t m_stateNs;      // Exposure time the state refers to
+    bool m_initialized;
+};
+
+#endif // TRACK_ESTIMATOR_H
@@ -0,0 +1,112 @@
+#ifndef TRACK_LOSS_H
+#define TRACK_LOSS_H
+
+#include <atomic>
+#include <cstdint>
+#include "latency_histogram.h"
+
+/**
+ * @brief Statistics of track losses in auto track
+ */
+struct TrackLossStatistics {
+    uint64_t losses;                // Tracking to not tracking
+    uint64_t reacquiredCoasting;    // Target back within the coast time
+    uint64_t reacquiredHolding;     // Back within the hold time
+    uint64_t reacquiredFallback;    // Back after the fallback action
+    uint64_t handedOff;             // Given to the operator instead
+    int64_t autoNs;                 // Time in auto track
+    int64_t trackedNs;              // Time in auto track with a target
+    LatencySummary reacquisition;   // Loss to reacquisition
+};
+
+/**
+ * @brief Time-bounded fallback policy for a lost target in auto track.
+ *
+ * update() is evaluated every control tick. When the tracker loses the
+ * target the policy coasts for coastNs, following the track estimator's
+ * prediction of where the target went; then holds the last command for
+ * holdNs; then takes the fallback action. A reacquired target ends the
+ * loss in any of these states and its duration goes into the
+ * reacquisition histogram, which together with the tracked share of auto
+ * track time gives the tracking availability.
+ *
+ * The state machine and statistics are written by the control thread
+ * only; statistics() and resetStatistics() may be called from any thread.
+ */
+class TrackLossPolicy
+{
+public:
+    enum class State {
+        IDLE,       // Not in auto track
+        ACQUIRING,  // In auto track, no target since entering it
+        TRACKING,
+        COASTING,   // Following the predicted target
+        HOLDING,    // Holding the last command
+        FALLBACK    // Fallback action taken
+    };
+
+    enum class Fallback {
+        HOLD,       // Keep holding until reacquired
+        CENTER,     // Return the FSM to centre and wait in auto track
+        MANUAL      // Hand off to the operator
+    };
+
+    struct Config {
+        int64_t coastNs;
+        int64_t holdNs;
+        Fallback fallback;
+
+        Config();
+    };
+
+    TrackLossPolicy();
+
+    /**
+     * @brief Apply the time limits and fallback
+     * @return False if the configuration is invalid; the previous one is kept
+     */
+    bool configure(const Config &config);
+    const Config &config() const { return m_config; }
+
+    /**
+     * @brief Run the state machine for one control tick
+     * @param autoTrack Whether the loop is in auto track
+     * @param tracking Whether the tracker reports a target
+     * @param nowNs CLOCK_MONOTONIC time of the tick
+     * @return True if the state changed
+     */
+    bool update(bool autoTrack, bool tracking, int64_t nowNs);
+
+    State state() const { return m_state; }
+
+    // Start over as if auto track had just been entered, e.g. when the
+    // control thread restarts; keeps the statistics
+    void restart();
+
+    TrackLossStatistics statistics() const;
+    void resetStatistics();
+
+    static const char *stateName(State state);
+
+private:
+    void endLoss(std::atomic<uint64_t> &counter, int64_t nowNs);
+
+    Config m_config;
+    State m_state;
+    int64_t m_lossNs;
+    int64_t m_lastNs;
+
+    // Written by the control thread; cleared on its next update() after a
+    // reset is requested
+    std::atomic<bool> m_resetRequested;
+    std::atomic<uint64_t> m_losses;
+    std::atomic<uint64_t> m_reacquiredCoasting;
+    std::atomic<uint64_t> m_reacquiredHolding;
+    std::atomic<uint64_t> m_reacquiredFallback;
+    std::atomic<uint64_t> m_handedOff;
+    std::atomic<int64_t> m_autoNs;
+    std::atomic<int64_t> m_trackedNs;
+    LatencyHistogram m_reacquisition;
+};
+
+#endif // TRACK_LOSS_H
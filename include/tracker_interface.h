@@ -2,35 +2,55 @@
 #define TRACKER_INTERFACE_H
 
 #include <QObject>
-#include <QThread>
 #include <QMutex>
 #include <QTimer>
 #include <atomic>
-#include <sys/mman.h>
-#include <fcntl.h>
-#include <unistd.h>
+#include <memory>
+#include <string>
+#include "hardware_interfaces.h"
+#include "realtime_thread.h"
+#include "command_slot.h"
+#include "latency_histogram.h"
+#include "tracker_status.h"
 
-// Memory offset definitions
-#define COMMAND_MAILBOX_OFFSET 0x000  // Command mailbox register
-#define STATUS_MAILBOX_OFFSET  0x002  // Status mailbox register
-#define COMMAND_MESSAGE_OFFSET 0x020  // Command message buffer start
-#define STATUS_MESSAGE_OFFSET  0x100  // Status message buffer start
+// Longest blocking wait of the ingest thread, bounds the stop() latency
+#define TRACKER_WAIT_TIMEOUT_MS 20
 
-// Polling rate in milliseconds (4ms = 250Hz)
-#define TRACKER_POLLING_RATE_MS 4
+// Interval at which messages polled by the control thread are signalled
+#define TRACKER_NOTIFY_INTERVAL_MS 20
 
 /**
- * @brief Structure to hold tracker data received from the EO Imaging 7007 tracker card
+ * @brief Latest tracking errors as published by the ingest thread
  */
-struct TrackData {
-    float rawErrorX;     // Raw X error from tracker (-1.0 to 1.0)
-    float rawErrorY;     // Raw Y error from tracker (-1.0 to 1.0)
-    uint16_t trackState; // Tracking state bits
-    uint16_t status;     // Status word
-
-    // Helper method to determine if currently tracking
-    bool isTracking() const {
-        return (trackState == 4); // Track state 4 = tracking active
+struct TrackSample {
+    double xError;       // Normalized X error (-1.0 to 1.0)
+    double yError;       // Normalized Y error (-1.0 to 1.0)
+    int64_t arrivalNs;   // Arrival time of the status message
+    uint64_t frame;      // Status messages received since start()
+};
+
+/**
+ * @brief How the ingest thread waits for status messages
+ */
+struct TrackerIngestConfig {
+    RealtimeConfig realtime;      // Scheduling of the ingest thread
+    bool useInterrupt;            // Block on the card interrupt instead of polling
+    std::string interruptDevice;  // UIO node of the card for interrupt mode
+    int spinUs;                   // Busy-wait on the mailbox before each sleep
+    int pollIntervalUs;           // Sleep between mailbox polls
+    bool scheduled;               // No ingest thread; the owner calls pollStatus()
+    double frameRateHz;           // Nominal status message rate of the card
+    int staleFrames;              // Frame periods without a valid message before
+                                  // the target counts as lost, 0 to wait forever
+
+    TrackerIngestConfig()
+        : useInterrupt(false)
+        , spinUs(0)
+        , pollIntervalUs(100)
+        , scheduled(false)
+        , frameRateHz(250.0)
+        , staleFrames(4)
+    {
     }
 };
 
@@ -38,7 +58,11 @@ struct TrackData {
  * @brief Interface for communicating with the EO Imaging 7007 Tracker card.
  *
  * This class provides memory-mapped I/O to interact with the 7007 tracker card.
- * It implements a thread-based polling architecture to read track data at 250Hz.
+ * The memory window comes from a TrackerSource, either the card itself or the
+ * simulated mailbox.
+ * A dedicated thread picks up each status message as soon as the card posts
+ * it, either by polling the status mailbox at a short interval or by waiting
+ * on the card interrupt, and stamps it with its arrival time.
  */
 class TrackerInterface : public QObject
 {
@@ -69,17 +93,34 @@ public:
                    uint8_t pciBus = 0x98, uint8_t pciSlot = 0x00, uint8_t pciFunc = 0x00);
 
     /**
-     * @brief Start the tracker polling thread
+     * @brief Configure the ingest thread. Applied on the next initialize()
+     *        (interrupt device) and start() (everything else).
+     */
+    void setIngestConfig(const TrackerIngestConfig &config);
+
+    /**
+     * @brief Start the tracker ingest thread
      * @return True if started successfully
      */
     bool start();
 
     /**
-     * @brief Stop the tracker polling thread
+     * @brief Stop the tracker ingest thread
      * @return True if stopped successfully
      */
     bool stop();
 
+    /**
+     * @brief Check the status mailbox once and ingest a waiting message.
+     *
+     * With a scheduled ingest config the owner calls this at the tracker's
+     * frame rate from its own thread instead of running the ingest thread.
+     * It only stores the message; the signals for it are emitted later by
+     * publishStatus() on the thread owning this object.
+     * @return True if a valid message was ingested
+     */
+    bool pollStatus();
+
     /**
      * @brief Get the current tracking errors
      * @param xError Output parameter for X tracking error
@@ -96,18 +137,56 @@ public:
      */
     bool getTrackingError(double &xError, double &yError, QString &state);
 
+    /**
+     * @brief Get the errors of the latest status message with its arrival time
+     * @param arrivalNs CLOCK_MONOTONIC time the message was picked up
+     * @return Number of status messages received since start(), 0 if none
+     */
+    uint64_t getLatestFrame(double &xError, double &yError, int64_t &arrivalNs);
+
     /**
      * @brief Check if target is being tracked
+     *
+     * False as well once no valid message arrived for the configured
+     * number of frame periods, whatever the last message reported.
      * @return True if the target is currently being tracked
      */
     bool isTargetTracked() const;
 
+    /**
+     * @brief Number of status messages rejected for a bad header or checksum
+     */
+    uint64_t getRejectedFrameCount() const;
+
+    /**
+     * @brief Retries on the lock-free tracking state slot
+     */
+    uint64_t getContentionCount() const;
+
+    /**
+     * @brief Mailbox seen to sample published, measured on the ingest thread
+     */
+    LatencySummary getIngestLatency() const;
+    void resetIngestLatency();
+
     /**
      * @brief Send a ping message to the tracker to verify communication
      * @return True if ping was successful
      */
     bool ping();
 
+    /**
+     * @brief Read the message in the status mailbox, without publishing it
+     * @return True if a valid message was read
+     */
+    bool readStatusData(TrackData &data);
+
+    /**
+     * @brief Post a status message to the card memory the way the card
+     *        does, for a simulated card (bc-trail-bench)
+     */
+    void postStatusMessage(const uint16_t *message);
+
 signals:
     /**
      * @brief Signal emitted when tracking errors are updated
@@ -135,11 +214,20 @@ signals:
     void errorOccurred(const QString &error);
 
 private:
-    // Thread function to poll the tracker at 250Hz
-    void trackerPollingThread();
+    // One iteration of the ingest thread: wait for a message and store it
+    void ingestStatus();
+    bool waitForStatus();
+
+    // Read, validate and publish the message in the mailbox
+    bool storeStatus();
 
-    // PCI configuration method
-    bool configurePCIDevice();
+    // Drop the track once the last valid message is older than the stale
+    // timeout; runs on the thread that stores the messages
+    void expireTrack();
+
+    // Signal the messages stored by pollStatus() since the last call, every
+    // TRACKER_NOTIFY_INTERVAL_MS while scheduled
+    void publishStatus();
 
     // Memory mapping methods
     bool setupMemoryMapping();
@@ -150,14 +238,13 @@ private:
     void writeWord(size_t offset, uint16_t value);
 
     // Tracker data methods
-    bool readStatusData(TrackData &data);
     bool isReadyForCommand();
 
     // Helper method to calculate checksum
     uint16_t calculateChecksum(const uint16_t* data, size_t words);
 
-    // File descriptor for memory mapping
-    int m_fd;
+    // Source of the tracker memory window
+    std::unique_ptr<TrackerSource> m_source;
 
     // Mapped memory pointer
     void* m_mappedMem;
@@ -171,19 +258,38 @@ private:
     uint8_t m_pciSlot;
     uint8_t m_pciFunc;
 
-    // Thread for polling the tracker
-    QThread m_pollingThread;
+    // Thread receiving status messages
+    RealtimeThread m_ingestThread;
+    TrackerIngestConfig m_ingestConfig;
+    bool m_interruptMode;
+    bool m_scheduled;          // Ingested by pollStatus(), no ingest thread
+
+    // Signals for scheduled ingest, on the thread owning this object
+    QTimer *m_notifyTimer;
+    uint64_t m_notifiedFrame;
+    bool m_notifiedTracking;
 
     // State variables
     bool m_initialized;
-    bool m_running;
-    bool m_isTracking;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_isTracking;
+
+    // Tracking errors, written only by the ingest thread and read
+    // lock-free by the control thread
+    CommandSlot<TrackSample> m_sample;
+    uint64_t m_frameCount;
+
+    // Arrival of the last valid message, and how old it may get
+    int64_t m_lastValidNs;
+    int64_t m_staleTimeoutNs;
+
+    // Status messages dropped by readStatusData()
+    std::atomic<uint64_t> m_rejectedFrames;
 
-    // Tracking error values
-    double m_xError;
-    double m_yError;
+    // Written only by the ingest thread
+    LatencyHistogram m_ingestLatency;
 
-    // Mutex for thread safety
+    // Guards setup, configuration and commands to the card
     mutable QMutex m_mutex;
 };
 
@@ -0,0 +1,26 @@
+#ifndef TRACKER_REGISTERS_H
+#define TRACKER_REGISTERS_H
+
+// Register layout of the EO Imaging/Moog 7007 tracker card shared memory
+
+// Memory offset definitions
+#define COMMAND_MAILBOX_OFFSET 0x000  // Command mailbox register
+#define STATUS_MAILBOX_OFFSET  0x002  // Status mailbox register
+#define COMMAND_MESSAGE_OFFSET 0x020  // Command message buffer start
+#define STATUS_MESSAGE_OFFSET  0x100  // Status message buffer start
+
+// Status message words, relative to STATUS_MESSAGE_OFFSET
+#define STATUS_SYNC_WORD       0x00   // 0xA5A5
+#define STATUS_MSG_TYPE        0x02   // 0xFFxx for status messages
+#define STATUS_ERROR_X         0x04   // Signed X error, 1/32 pixel
+#define STATUS_ERROR_Y         0x06   // Signed Y error, 1/32 pixel
+#define STATUS_STATUS_WORD     0x0A   // Track state in bits 3-5
+#define STATUS_STATUS          0x0C   // Status word
+#define STATUS_CHECKSUM        0x0E   // Two's complement byte-sum of words 0-6
+
+#define STATUS_MESSAGE_WORDS   8      // Including the checksum
+
+#define TRACKER_SYNC_WORD      0xA5A5
+#define TRACKER_STATE_TRACKING 4
+
+#endif // TRACKER_REGISTERS_H
@@ -0,0 +1,59 @@
+#ifndef TRACKER_STATUS_H
+#define TRACKER_STATUS_H
+
+#include <cstddef>
+#include <cstdint>
+#include "tracker_registers.h"
+
+/**
+ * @brief Structure to hold tracker data received from the EO Imaging 7007 tracker card
+ */
+struct TrackData {
+    float rawErrorX;     // Raw X error from tracker (-1.0 to 1.0)
+    float rawErrorY;     // Raw Y error from tracker (-1.0 to 1.0)
+    uint16_t trackState; // Tracking state bits
+    uint16_t status;     // Status word
+    int64_t arrivalNs;   // CLOCK_MONOTONIC time the mailbox was seen set
+
+    // Helper method to determine if currently tracking
+    bool isTracking() const {
+        return (trackState == TRACKER_STATE_TRACKING);
+    }
+};
+
+/**
+ * @brief Result of parsing a status message block
+ */
+enum class StatusParseResult {
+    OK,
+    BAD_HEADER,    // Wrong sync word or not a status message
+    BAD_CHECKSUM   // Message torn or corrupted
+};
+
+namespace TrackerStatus {
+
+/**
+ * @brief Two's complement of the byte sum, as used by 7007 messages
+ */
+uint16_t checksum(const uint16_t *data, size_t words);
+
+/**
+ * @brief Copy the status message block out of the card memory.
+ *
+ * Every access to the BAR is an uncached PCIe read, so the block is read
+ * with 64-bit loads (two round trips for the 16-byte block instead of one
+ * per field). Falls back to 16-bit loads if the block is not 8-byte aligned.
+ *
+ * @param base Start of the mapped card memory
+ * @param words Destination, STATUS_MESSAGE_WORDS long
+ */
+void copyBlock(const volatile void *base, uint16_t *words);
+
+/**
+ * @brief Parse and validate a status block copied with copyBlock()
+ */
+StatusParseResult parse(const uint16_t *words, TrackData &data);
+
+} // namespace TrackerStatus
+
+#endif // TRACKER_STATUS_H
@@ -0,0 +1,192 @@
+#include "compensator.h"
+#include <cmath>
+
+Biquad::Biquad()
+{
+    setIdentity();
+}
+
+void Biquad::setIdentity()
+{
+    m_b0 = 1.0;
+    m_b1 = m_b2 = 0.0;
+    m_a1 = m_a2 = 0.0;
+    m_z1 = m_z2 = 0.0;
+}
+
+void Biquad::setAnalog(double b2, double b1, double b0,
+                       double a2, double a1, double a0,
+                       double sampleRateHz, double prewarpHz)
+{
+    // Bilinear transform s = K (z - 1) / (z + 1)
+    double k = 2.0 * sampleRateHz;
+    if (prewarpHz > 0.0) {
+        const double w = 2.0 * M_PI * prewarpHz;
+        k = w / std::tan(w / (2.0 * sampleRateHz));
+    }
+    const double k2 = k * k;
+
+    const double nb0 = b2 * k2 + b1 * k + b0;
+    const double nb1 = 2.0 * b0 - 2.0 * b2 * k2;
+    const double nb2 = b2 * k2 - b1 * k + b0;
+    const double na0 = a2 * k2 + a1 * k + a0;
+    const double na1 = 2.0 * a0 - 2.0 * a2 * k2;
+    const double na2 = a2 * k2 - a1 * k + a0;
+
+    m_b0 = nb0 / na0;
+    m_b1 = nb1 / na0;
+    m_b2 = nb2 / na0;
+    m_a1 = na1 / na0;
+    m_a2 = na2 / na0;
+    reset();
+}
+
+void Biquad::reset(double steadyInput)
+{
+    // States for a steady input x with output dcGain() * x
+    const double y = dcGain() * steadyInput;
+    m_z2 = m_b2 * steadyInput - m_a2 * y;
+    m_z1 = m_b1 * steadyInput - m_a1 * y + m_z2;
+}
+
+double Biquad::dcGain() const
+{
+    return (m_b0 + m_b1 + m_b2) / (1.0 + m_a1 + m_a2);
+}
+
+AxisCompensator::Config::Config()
+    : sampleRateHz(1000.0)
+    , feedforward(1.0)
+    , kp(0.5)
+    , ki(50.0)
+    , kd(0.0)
+    , derivativeCutoffHz(200.0)
+    , outputLimit(1.0)
+    , leadLagEnabled(false)
+    , leadZeroHz(50.0)
+    , leadPoleHz(200.0)
+    , notchCount(0)
+    , notches()
+{
+}
+
+AxisCompensator::AxisCompensator()
+    : m_ff(1.0)
+    , m_kp(0.0)
+    , m_kiTs(0.0)
+    , m_dAlpha(0.0)
+    , m_dGain(0.0)
+    , m_limit(1.0)
+    , m_notchCount(0)
+    , m_integral(0.0)
+    , m_derivative(0.0)
+    , m_lastMeasurement(0.0)
+    , m_lastOutput(0.0)
+    , m_saturated(false)
+{
+    configure(Config());
+}
+
+bool AxisCompensator::configure(const Config &config)
+{
+    const double fs = config.sampleRateHz;
+    const double nyquist = 0.5 * fs;
+
+    if (fs <= 0.0 || config.outputLimit <= 0.0 ||
+        config.notchCount < 0 || config.notchCount > MAX_NOTCHES) {
+        return false;
+    }
+    if (config.kd > 0.0 && (config.derivativeCutoffHz <= 0.0 || config.derivativeCutoffHz >= nyquist)) {
+        return false;
+    }
+    if (config.leadLagEnabled &&
+        (config.leadZeroHz <= 0.0 || config.leadPoleHz <= 0.0 || config.leadPoleHz >= nyquist)) {
+        return false;
+    }
+    for (int i = 0; i < config.notchCount; ++i) {
+        const Notch &n = config.notches[i];
+        if (n.frequencyHz <= 0.0 || n.frequencyHz >= nyquist || n.q <= 0.0 || n.depthDb < 0.0) {
+            return false;
+        }
+    }
+
+    m_config = config;
+
+    const double ts = 1.0 / fs;
+    m_ff = config.feedforward;
+    m_kp = config.kp;
+    m_kiTs = config.ki * ts;
+    m_limit = config.outputLimit;
+
+    // Backward-Euler first-order filtered derivative
+    if (config.kd > 0.0) {
+        const double tau = 1.0 / (2.0 * M_PI * config.derivativeCutoffHz);
+        m_dAlpha = tau / (tau + ts);
+        m_dGain = config.kd / (tau + ts);
+    } else {
+        m_dAlpha = 0.0;
+        m_dGain = 0.0;
+    }
+
+    // Lead-lag: (s / wz + 1) / (s / wp + 1)
+    if (config.leadLagEnabled) {
+        const double wz = 2.0 * M_PI * config.leadZeroHz;
+        const double wp = 2.0 * M_PI * config.leadPoleHz;
+        m_leadLag.setAnalog(0.0, 1.0 / wz, 1.0, 0.0, 1.0 / wp, 1.0, fs, 0.0);
+    } else {
+        m_leadLag.setIdentity();
+    }
+
+    // Notch: (s^2 + 2 zz w s + w^2) / (s^2 + 2 zp w s + w^2), prewarped at w
+    m_notchCount = config.notchCount;
+    for (int i = 0; i < MAX_NOTCHES; ++i) {
+        if (i >= m_notchCount) {
+            m_notch[i].setIdentity();
+            continue;
+        }
+        const Notch &n = config.notches[i];
+        const double w = 2.0 * M_PI * n.frequencyHz;
+        const double zetaPole = 1.0 / (2.0 * n.q);
+        const double zetaZero = zetaPole * std::pow(10.0, -n.depthDb / 20.0);
+        m_notch[i].setAnalog(1.0, 2.0 * zetaZero * w, w * w,
+                             1.0, 2.0 * zetaPole * w, w * w,
+                             fs, n.frequencyHz);
+    }
+
+    reset();
+    return true;
+}
+
+void AxisCompensator::reset()
+{
+    m_integral = 0.0;
+    m_derivative = 0.0;
+    m_lastMeasurement = 0.0;
+    m_lastOutput = 0.0;
+    m_saturated = false;
+    m_leadLag.reset();
+    for (int i = 0; i < MAX_NOTCHES; ++i) {
+        m_notch[i].reset();
+    }
+}
+
+void AxisCompensator::initialize(double output, double setpoint, double measurement)
+{
+    // The filters all have unity DC gain, so in steady state the output is
+    // ff * r + kp * e + I. Solve for the integrator.
+    const double error = setpoint - measurement;
+    double integral = output - m_ff * setpoint - m_kp * error;
+    if (integral > m_limit) integral = m_limit;
+    else if (integral < -m_limit) integral = -m_limit;
+
+    const double pid = m_kp * error + integral;
+    m_integral = integral;
+    m_derivative = 0.0;
+    m_lastMeasurement = measurement;
+    m_leadLag.reset(pid);
+    for (int i = 0; i < MAX_NOTCHES; ++i) {
+        m_notch[i].reset(pid);
+    }
+    m_lastOutput = output;
+    m_saturated = false;
+}
@@ -1,6 +1,9 @@
 #include "control_loop.h"
+#include "hardware_interfaces.h"
 #include <QDebug>
+#include <algorithm>
 #include <cmath>
+#include <time.h>
 
 ControlLoop::ControlLoop(QObject *parent)
     : QObject(parent)
@@ -8,43 +11,84 @@ ControlLoop::ControlLoop(QObject *parent)
     , m_gimbalController(nullptr)
     , m_trackerInterface(nullptr)
     , m_joystickInterface(nullptr)
-    , m_controlTimer(nullptr)
+    , m_tickIndex(0)
+    , m_gimbalDivisor(1)
+    , m_trackerScheduled(false)
+    , m_tick()
+    , m_healthTimer(new QTimer(this))
+    , m_overrunWarnThreshold(TICK_OVERRUN_WARN_DEFAULT)
+    , m_checkedOverruns(0)
+    , m_lastWarningNs(0)
+    , m_suppressedWarnings(0)
     , m_mode(OperationMode::COARSE_TRACK)
     , m_isTrackingActive(false)
+    , m_appliedMode(OperationMode::COARSE_TRACK)
+    , m_modeUpdatePending(false)
+    , m_modeTransitionMs(MODE_TRANSITION_DEFAULT_MS)
+    , m_appliedServoConfig(0)
+    , m_appliedTrackEstimatorConfig(0)
+    , m_appliedTrackLossConfig(0)
+    , m_appliedGimbalOffloadConfig(0)
+    , m_servoEnabled(false)
+    , m_servoEngaged(false)
+    , m_appliedTrackFrame(0)
+    , m_appliedTrackAgeNs(0)
+    , m_estimatedTrackFrame(0)
+    , m_trackPredictionLeadNs(0)
+    , m_trackLossHandoff(false)
+    , m_notifyTimer(new QTimer(this))
+    , m_reportedFsmMode(FSMController::ControlMode::COARSE_TRACK)
+    , m_reportedGimbalEnabled(false)
+    , m_reportedFsmFailures(0)
+    , m_reportedGimbalFailures(0)
+    , m_lastFailureReportNs(0)
+    , m_offloadEnabled(false)
+    , m_offloadActive(false)
+    , m_offloadDt(0.0)
+    , m_appliedJoystickVersion(0)
+    , m_appliedJoystick{0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0}
+    , m_appliedManualVersion(0)
+    , m_joystickAux(0.0)
+    , m_appliedJoystickAgeNs(0)
+    , m_manualConfig(ManualInputConfig())
     , m_running(false)
     , m_controlRateHz(1000) // 1000 Hz control rate
+    , m_aiSectionScans(1)
+    , m_aiDriven(false)
+    , m_fsmClockedOutput(false)
+    , m_fsmOutputLead(2)
+    , m_missedSections(0)
+    , m_feedbackTimeouts(0)
 {
+    // Run the servo at the control rate with default gains. The tick state
+    // is configured from the slots when the loop starts.
+    ServoConfig servoConfig;
+    servoConfig.x.sampleRateHz = m_controlRateHz;
+    servoConfig.y.sampleRateHz = m_controlRateHz;
+    m_servoConfig.store(servoConfig);
+    m_trackEstimatorConfig.store(m_trackEstimator.config());
+    m_trackLossConfig.store(m_trackLoss.config());
+    m_gimbalOffloadConfig.store(m_gimbalOffload.config());
+    m_appliedManualVersion = m_manualConfig.version();
+
     // Create component instances
     m_fsmController = std::make_unique<FSMController>();
     m_gimbalController = std::make_unique<GimbalController>();
     m_trackerInterface = std::make_unique<TrackerInterface>();
     m_joystickInterface = std::make_unique<JoystickInterface>();
 
-    // Create control timer
-    m_controlTimer = new QTimer(this);
-    m_controlTimer->setTimerType(Qt::PreciseTimer);
-
     // Connect signals and slots
     connect(m_joystickInterface.get(), &JoystickInterface::modeButtonPressed,
             this, &ControlLoop::handleJoystickModeButtonPressed);
 
-    connect(m_joystickInterface.get(), &JoystickInterface::joystickPositionChanged,
-            this, &ControlLoop::handleJoystickPositionChanged);
-
-    connect(m_joystickInterface.get(), &JoystickInterface::joystickRotationChanged,
-            this, &ControlLoop::handleJoystickRotationChanged);
-
     connect(m_trackerInterface.get(), &TrackerInterface::trackingStatusChanged,
             this, &ControlLoop::handleTrackingStatusChanged);
 
-    connect(m_trackerInterface.get(), &TrackerInterface::trackingErrorsUpdated,
-            this, &ControlLoop::handleTrackingErrorsUpdated);
-
-    connect(m_fsmController.get(), &FSMController::feedbackUpdated,
-            this, &ControlLoop::handleFSMFeedbackUpdated);
+    m_healthTimer->setInterval(TICK_HEALTH_CHECK_MS);
+    connect(m_healthTimer, &QTimer::timeout, this, &ControlLoop::checkSchedulerHealth);
 
-    connect(m_controlTimer, &QTimer::timeout,
-            this, &ControlLoop::controlLoopTick);
+    m_notifyTimer->setInterval(CONTROL_NOTIFY_INTERVAL_MS);
+    connect(m_notifyTimer, &QTimer::timeout, this, &ControlLoop::deliverNotifications);
 
     // Forward error signals
     connect(m_fsmController.get(), &FSMController::errorOccurred,
@@ -73,6 +117,11 @@ bool ControlLoop::initialize()
         return false;
     }
 
+    // Before the acquisition starts, so the first block is filtered too
+    if (!m_fsmController->setFeedbackFilter(getFeedbackFilterConfig())) {
+        return false;
+    }
+
     if (!m_gimbalController->initialize()) {
         emit errorOccurred("Failed to initialize gimbal controller");
         return false;
@@ -84,12 +133,16 @@ bool ControlLoop::initialize()
     }
 
     if (!m_joystickInterface->initialize()) {
-        emit errorOccurred("Failed to initialize joystick interface");
-        return false;
+        // A workstation or CI run has no joystick; the loop runs without one
+        if (Hardware::backend() != Hardware::Backend::SIMULATED) {
+            emit errorOccurred("Failed to initialize joystick interface");
+            return false;
+        }
+        emit statusChanged("Simulation: continuing without joystick");
     }
 
     // Set initial control mode
-    updateControlMode();
+    updateControlMode(m_mode.load());
 
     emit statusChanged("Control system initialized");
     return true;
@@ -103,6 +156,11 @@ bool ControlLoop::start()
         return true; // Already running
     }
 
+    // The limiter steps depend on the commit rates of this run
+    if (!applyOutputLimits(m_outputLimits)) {
+        return false;
+    }
+
     // Start all components
     if (!m_fsmController->start()) {
         emit errorOccurred("Failed to start FSM controller");
@@ -120,28 +178,79 @@ bool ControlLoop::start()
     }
 
     if (!m_joystickInterface->start()) {
-        emit errorOccurred("Failed to start joystick interface");
+        if (Hardware::backend() != Hardware::Backend::SIMULATED) {
+            emit errorOccurred("Failed to start joystick interface");
+            return false;
+        }
+        emit statusChanged("Simulation: continuing without joystick");
+    }
+
+    // Configure the tick state from what was published while stopped, then
+    // start the control thread
+    m_appliedTrackFrame = 0;
+    m_estimatedTrackFrame = 0;
+    configureRateGroups();
+    m_servoEngaged = false;
+    applyConfigUpdates();
+    m_trackEstimator.reset();
+    m_tickIndex = 0;
+
+    // From here the control tick switches modes; start from the current one
+    m_trackLoss.restart();
+    m_appliedMode = m_mode.load();
+    m_modeUpdatePending.store(false);
+    updateControlMode(m_appliedMode);
+    m_running = true;
+    const int64_t periodNs = 1000000000LL / m_controlRateHz;
+    m_trackPredictionLeadNs = m_fsmClockedOutput ? m_fsmOutputLead * periodNs : 0;
+    m_tickMonitor.configure(periodNs);
+    m_checkedOverruns = 0;  // The thread restarts its counters
+    m_suppressedWarnings = 0;
+    m_missedSections.store(0, std::memory_order_relaxed);
+    m_feedbackTimeouts.store(0, std::memory_order_relaxed);
+
+    // AI driven, the thread has no period of its own: each tick blocks on
+    // the next section. Sections from before the start are not missed ones.
+    if (m_aiDriven) {
+        m_fsmController->waitForFeedback(0);
+    }
+    if (!m_rtThread.start(m_rtConfig, m_aiDriven ? 0 : periodNs, [this]() { controlLoopTick(); })) {
+        m_running = false;
+        emit errorOccurred("Failed to start control thread");
         return false;
     }
 
-    // Start control loop timer
-    m_controlTimer->start(1000 / m_controlRateHz);
+    std::string rtError = m_rtThread.lastError();
+    if (!rtError.empty()) {
+        emit errorOccurred(QString::fromStdString(rtError));
+    }
 
-    m_running = true;
-    emit statusChanged("Control system started");
+    m_healthTimer->start();
+    m_notifyTimer->start();
+
+    emit statusChanged(QString("Control system started at %1 Hz (%2, %3)")
+                      .arg(m_controlRateHz)
+                      .arg(m_aiDriven ? QString("woken by AI sections of %1 scans").arg(m_aiSectionScans)
+                                      : QString("timer"))
+                      .arg(m_rtThread.isRealtime() ? QString("SCHED_FIFO %1").arg(m_rtConfig.priority)
+                                                   : QString("SCHED_OTHER")));
     return true;
 }
 
 bool ControlLoop::stop()
 {
-    QMutexLocker locker(&m_mutex);
-
-    if (!m_running) {
+    if (!m_running.exchange(false)) {
         return true; // Already stopped
     }
 
-    // Stop control loop timer
-    m_controlTimer->stop();
+    // Join the control thread first; the components are stopped under
+    // the mutex so a configuration change does not run in between
+    m_rtThread.stop();
+    m_healthTimer->stop();
+    m_notifyTimer->stop();
+    deliverNotifications();
+
+    QMutexLocker locker(&m_mutex);
 
     // Stop all components
     m_fsmController->stop();
@@ -149,26 +258,26 @@ bool ControlLoop::stop()
     m_trackerInterface->stop();
     m_joystickInterface->stop();
 
-    m_running = false;
-    emit statusChanged("Control system stopped");
+    emit statusChanged(QString("Control system stopped (%1 cycles, %2 overruns, %3 contended accesses, %4 DAC writes, %5 slew limited)")
+                      .arg(m_rtThread.cycleCount())
+                      .arg(getOverrunCount())
+                      .arg(getContentionCount())
+                      .arg(m_fsmController->getOutputWriteCount() + m_gimbalController->getOutputWriteCount())
+                      .arg(m_fsmController->getOutputLimitedCount() + m_gimbalController->getOutputLimitedCount()));
     return true;
 }
 
 void ControlLoop::setOperationMode(OperationMode mode)
 {
-    QMutexLocker locker(&m_mutex);
-
-    if (m_mode == mode) {
+    if (m_mode.exchange(mode) == mode) {
         return; // No change
     }
 
-    m_mode = mode;
-
     // Update control mode for components
-    updateControlMode();
+    requestModeUpdate();
 
     // Emit mode changed signal
-    emit operationModeChanged(m_mode);
+    emit operationModeChanged(mode);
 
     emit statusChanged(QString("Operation mode changed to %1")
                       .arg(mode == OperationMode::COARSE_TRACK ? "Coarse Track" :
@@ -176,142 +285,1128 @@ void ControlLoop::setOperationMode(OperationMode mode)
 }
 
 ControlLoop::OperationMode ControlLoop::getOperationMode() const
+{
+    return m_mode.load();
+}
+
+bool ControlLoop::setControlRateConfig(const ControlRateConfig &config)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_running) {
+        locker.unlock();
+        emit errorOccurred("Cannot change the control rate while the control system is running");
+        return false;
+    }
+
+    if (config.rateHz < CONTROL_RATE_MIN_HZ || config.rateHz > CONTROL_RATE_MAX_HZ) {
+        locker.unlock();
+        emit errorOccurred(QString("Control rate must be %1 to %2 Hz")
+                          .arg(CONTROL_RATE_MIN_HZ).arg(CONTROL_RATE_MAX_HZ));
+        return false;
+    }
+
+    // The servo coefficients depend on the sample rate; recompute them
+    // with the current gains before committing to the new rate
+    ServoConfig servo = m_servoConfig.load();
+    servo.x.sampleRateHz = config.rateHz;
+    servo.y.sampleRateHz = config.rateHz;
+    AxisCompensator checkX, checkY;
+    if (!checkX.configure(servo.x) || !checkY.configure(servo.y)) {
+        locker.unlock();
+        emit errorOccurred(QString("FSM servo configuration is invalid at %1 Hz").arg(config.rateHz));
+        return false;
+    }
+
+    // The FSM controller reports its own errors through the forwarded
+    // signal, so it is called without the loop mutex
+    locker.unlock();
+    if (!m_fsmController->setAcquisition(config.rateHz * config.aiSectionScans, config.aiSectionScans)) {
+        return false;
+    }
+    locker.relock();
+
+    m_servoConfig.store(servo);
+    m_controlRateHz = config.rateHz;
+    m_aiSectionScans = config.aiSectionScans;
+    m_aiDriven = config.aiDriven;
+
+    // The clocked output follows the AI sample rate
+    m_fsmController->setClockedOutput(m_fsmClockedOutput, m_controlRateHz * m_aiSectionScans,
+                                      m_fsmOutputLead, m_aiSectionScans);
+    return true;
+}
+
+ControlRateConfig ControlLoop::getControlRateConfig() const
 {
     QMutexLocker locker(&m_mutex);
-    return m_mode;
+
+    ControlRateConfig config;
+    config.rateHz = m_controlRateHz;
+    config.aiSectionScans = m_aiSectionScans;
+    config.aiDriven = m_aiDriven;
+    return config;
 }
 
-void ControlLoop::handleJoystickModeButtonPressed()
+void ControlLoop::setRealtimeConfig(const RealtimeConfig &config)
 {
     QMutexLocker locker(&m_mutex);
+    m_rtConfig = config;
+}
 
-    // Cycle to the next mode
-    cycleOperationMode();
+RealtimeConfig ControlLoop::getRealtimeConfig() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_rtConfig;
 }
 
-void ControlLoop::handleJoystickPositionChanged(double x, double y, double z)
+void ControlLoop::setTrackerIngestConfig(const TrackerIngestConfig &config)
 {
     QMutexLocker locker(&m_mutex);
+    m_trackerInterface->setIngestConfig(config);
+    m_trackerScheduled = config.scheduled;
+}
 
-    // In all modes, joystick position controls FSM
-    m_fsmController->setManualInputs(x, y);
+void ControlLoop::setRateGroupConfig(const RateGroupConfig &config)
+{
+    QMutexLocker locker(&m_mutex);
+    m_rateConfig.trackerDivisor = std::max(1, config.trackerDivisor);
+    m_rateConfig.joystickDivisor = std::max(1, config.joystickDivisor);
+    m_rateConfig.gimbalDivisor = std::max(1, config.gimbalDivisor);
+}
+
+void ControlLoop::setModeTransitionTime(int ms)
+{
+    m_modeTransitionMs.store(std::max(0, ms));
+}
+
+int ControlLoop::getModeTransitionTime() const
+{
+    return m_modeTransitionMs.load();
+}
+
+bool ControlLoop::setOutputLimitConfig(const OutputLimitConfig &config)
+{
+    {
+        QMutexLocker locker(&m_mutex);
 
-    // In coarse track mode, also control gimbal
-    if (m_mode == OperationMode::COARSE_TRACK) {
-        // For gimbal control, use a reduced range for fine control
-        double scaleFactor = 0.2; // Scale down for more precise control
-        m_gimbalController->setPosition(x * scaleFactor, y * scaleFactor, z * scaleFactor);
+        if (!applyOutputLimits(config)) {
+            return false;
+        }
+        m_outputLimits = config;
     }
+
+    emit statusChanged(config.bypass ? QString("Output slew limits bypassed")
+                                     : QString("Output slew limits: FSM %1 /s, gimbal %2 /s")
+                                           .arg(std::max(config.fsmX.rate, config.fsmY.rate))
+                                           .arg(std::max(config.gimbalAz.rate, config.gimbalEl.rate)));
+    return true;
 }
 
-void ControlLoop::handleJoystickRotationChanged(double rx, double ry, double rz)
+OutputLimitConfig ControlLoop::getOutputLimitConfig() const
 {
     QMutexLocker locker(&m_mutex);
+    return m_outputLimits;
+}
 
-    // Only use rotation in coarse track mode for additional gimbal control
-    if (m_mode == OperationMode::COARSE_TRACK) {
-        double az, el, auxEl;
-        m_gimbalController->getCurrentPosition(az, el, auxEl);
+bool ControlLoop::applyOutputLimits(const OutputLimitConfig &config)
+{
+    // The FSM commits every tick, the gimbal once per gimbal group
+    OutputLimiter::Config fsm;
+    fsm.bypass = config.bypass;
+    fsm.channel[0] = config.fsmX;
+    fsm.channel[1] = config.fsmY;
+
+    OutputLimiter::Config gimbal;
+    gimbal.bypass = config.bypass;
+    gimbal.channel[0] = config.gimbalAz;
+    gimbal.channel[1] = config.gimbalEl;
+    gimbal.channel[2] = config.gimbalAuxEl;
+
+    const double fsmRateHz = m_controlRateHz;
+    const double gimbalRateHz = fsmRateHz / m_rateConfig.gimbalDivisor;
+    return m_fsmController->setOutputLimits(fsm, fsmRateHz)
+        && m_gimbalController->setOutputLimits(gimbal, gimbalRateHz);
+}
 
-        // Update auxiliary elevation using rotation input
-        double scaleFactor = 0.2; // Scale down for more precise control
-        m_gimbalController->setPosition(az, el, rz * scaleFactor);
+bool ControlLoop::setFeedbackFilterConfig(const FeedbackFilter::Config &config)
+{
+    // Validity does not depend on the channel count
+    FeedbackFilter check;
+    if (!check.configure(config, 1)) {
+        emit errorOccurred("Invalid FSM feedback filter configuration");
+        return false;
     }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_feedbackFilterConfig = config;
+    }
+
+    if (m_fsmController->isInitialized()) {
+        return m_fsmController->setFeedbackFilter(config);
+    }
+    return true;
 }
 
-void ControlLoop::handleTrackingStatusChanged(bool isTracking)
+FeedbackFilter::Config ControlLoop::getFeedbackFilterConfig() const
 {
     QMutexLocker locker(&m_mutex);
+    return m_feedbackFilterConfig;
+}
 
-    m_isTrackingActive = isTracking;
+RateGroupConfig ControlLoop::getRateGroupConfig() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_rateConfig;
+}
+
+void ControlLoop::setJoystickRealtimeConfig(const RealtimeConfig &config)
+{
+    m_joystickInterface->setRealtimeConfig(config);
+}
+
+void ControlLoop::setManualInputConfig(const ManualInputConfig &config)
+{
+    m_manualConfig.store(config);
+}
+
+ManualInputConfig ControlLoop::getManualInputConfig() const
+{
+    return m_manualConfig.load();
+}
 
-    // If in auto track mode, may need to adjust based on tracking status
-    if (m_mode == OperationMode::AUTO_TRACK) {
-        if (!m_isTrackingActive) {
-            // If tracking is lost, could switch to manual mode
-            // For now, just emit a status message
-            emit statusChanged("Warning: Tracking lost in auto track mode");
+bool ControlLoop::setServoConfig(const AxisCompensator::Config &xConfig,
+                                 const AxisCompensator::Config &yConfig)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+
+        ServoConfig servo;
+        servo.x = xConfig;
+        servo.y = yConfig;
+        servo.x.sampleRateHz = m_controlRateHz;
+        servo.y.sampleRateHz = m_controlRateHz;
+
+        // Validate both before the tick picks them up
+        AxisCompensator checkX, checkY;
+        if (!checkX.configure(servo.x) || !checkY.configure(servo.y)) {
+            locker.unlock();
+            emit errorOccurred("Invalid FSM servo configuration");
+            return false;
         }
+
+        m_servoConfig.store(servo);
     }
+
+    emit statusChanged("FSM servo configuration updated");
+    return true;
 }
 
-void ControlLoop::handleTrackingErrorsUpdated(double xError, double yError)
+bool ControlLoop::setTrackEstimatorConfig(const TrackEstimator::Config &config)
 {
-    QMutexLocker locker(&m_mutex);
+    TrackEstimator check;
+    if (!check.configure(config)) {
+        emit errorOccurred("Invalid track estimator configuration");
+        return false;
+    }
+    m_trackEstimatorConfig.store(config);
+
+    emit statusChanged(config.enabled ? QString("Track estimator: %1, %2 ms frame latency")
+                                            .arg(config.model == TrackEstimator::Model::CONSTANT_VELOCITY
+                                                 ? "constant velocity" : "constant acceleration")
+                                            .arg(config.frameLatencyNs / 1e6)
+                                      : QString("Track estimator disabled"));
+    return true;
+}
+
+TrackEstimator::Config ControlLoop::getTrackEstimatorConfig() const
+{
+    return m_trackEstimatorConfig.load();
+}
+
+bool ControlLoop::setTrackLossConfig(const TrackLossPolicy::Config &config)
+{
+    TrackLossPolicy check;
+    if (!check.configure(config)) {
+        emit errorOccurred("Invalid track loss configuration");
+        return false;
+    }
+    m_trackLossConfig.store(config);
+    return true;
+}
+
+TrackLossPolicy::Config ControlLoop::getTrackLossConfig() const
+{
+    return m_trackLossConfig.load();
+}
+
+TrackLossStatistics ControlLoop::getTrackLossStatistics() const
+{
+    return m_trackLoss.statistics();
+}
+
+bool ControlLoop::setGimbalOffloadConfig(const GimbalOffload::Config &config)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+
+        // The off-load runs at the gimbal rate; keep it a decade below
+        const double gimbalRateHz = static_cast<double>(m_controlRateHz) / m_rateConfig.gimbalDivisor;
+        GimbalOffload check;
+        if (config.crossoverHz > gimbalRateHz / 10.0 || !check.configure(config)) {
+            locker.unlock();
+            emit errorOccurred(QString("Invalid gimbal off-load configuration (crossover must be below %1 Hz)")
+                              .arg(gimbalRateHz / 10.0));
+            return false;
+        }
+        m_gimbalOffloadConfig.store(config);
+        m_offloadEnabled.store(config.enabled);
+    }
+
+    // Power the gimbal in auto track only while it is off-loading
+    requestModeUpdate();
+
+    emit statusChanged(config.enabled ? QString("Gimbal off-load: %1 Hz crossover, %2 /s rate limit")
+                                            .arg(config.crossoverHz).arg(config.rateLimit)
+                                      : QString("Gimbal off-load disabled"));
+    return true;
+}
+
+GimbalOffload::Config ControlLoop::getGimbalOffloadConfig() const
+{
+    return m_gimbalOffloadConfig.load();
+}
+
+void ControlLoop::setServoEnabled(bool enabled)
+{
+    if (m_servoEnabled.exchange(enabled) == enabled) {
+        return;
+    }
 
-    // In auto track mode, update FSM with tracking errors
-    if (m_mode == OperationMode::AUTO_TRACK && m_isTrackingActive) {
-        m_fsmController->setTrackingInputs(xError, yError);
+    // While running, the tick engages the compensators on its next run;
+    // stopped, start() does and only the FSM mode is switched here
+    if (!m_running) {
+        m_fsmController->setClosedLoop(enabled);
     }
+
+    emit statusChanged(enabled ? "FSM servo engaged" : "FSM servo disengaged");
+}
+
+bool ControlLoop::isServoEnabled() const
+{
+    return m_servoEnabled.load();
 }
 
-void ControlLoop::handleFSMFeedbackUpdated(double x, double y)
+void ControlLoop::setFsmClockedOutput(bool enabled, int leadScans)
 {
-    // This is called from the FSM controller thread, so need mutex
     QMutexLocker locker(&m_mutex);
+    m_fsmClockedOutput = enabled;
+    m_fsmOutputLead = leadScans;
+    m_fsmController->setClockedOutput(enabled, m_controlRateHz * m_aiSectionScans, leadScans, m_aiSectionScans);
+}
+
+void ControlLoop::setFsmRawAcquisition(bool enabled)
+{
+    m_fsmController->setRawAcquisition(enabled);
+}
+
+int ControlLoop::getControlRate() const
+{
+    return m_controlRateHz;
+}
+
+uint64_t ControlLoop::getCycleCount() const
+{
+    return m_rtThread.cycleCount();
+}
+
+uint64_t ControlLoop::getOverrunCount() const
+{
+    return m_rtThread.overrunCount() + m_missedSections.load(std::memory_order_relaxed);
+}
+
+uint64_t ControlLoop::getContentionCount() const
+{
+    return m_manualConfig.contentionCount() +
+           m_servoConfig.contentionCount() +
+           m_trackEstimatorConfig.contentionCount() +
+           m_trackLossConfig.contentionCount() +
+           m_gimbalOffloadConfig.contentionCount() +
+           m_fsmController->getContentionCount() +
+           m_gimbalController->getContentionCount() +
+           m_trackerInterface->getContentionCount() +
+           m_joystickInterface->getContentionCount();
+}
 
-    // Could implement additional logic based on FSM feedback
-    // For now, feedback is used primarily for telemetry/display
+LatencySummary ControlLoop::getLatency(LatencyStage stage) const
+{
+    // Stages measured off the control thread live with their component
+    switch (stage) {
+        case LatencyStage::TRACK_INGEST:
+            return m_trackerInterface->getIngestLatency();
+        case LatencyStage::JOYSTICK_PUBLISH:
+            return m_joystickInterface->getPublishLatency();
+        case LatencyStage::AI_TO_FEEDBACK:
+            return m_fsmController->getFeedbackLatency();
+        default:
+            return m_latency[static_cast<int>(stage)].summary();
+    }
+}
+
+QString ControlLoop::latencyStageName(LatencyStage stage)
+{
+    switch (stage) {
+        case LatencyStage::TRACK_INGEST: return "Tracker ingest";
+        case LatencyStage::TRACK_TO_COMMAND: return "Tracker to command";
+        case LatencyStage::TRACK_TO_DAC: return "Tracker to DAC";
+        case LatencyStage::JOYSTICK_PUBLISH: return "Joystick publish";
+        case LatencyStage::JOYSTICK_TO_DAC: return "Joystick to DAC";
+        case LatencyStage::AI_TO_FEEDBACK: return "AI to feedback";
+        case LatencyStage::FEEDBACK_TO_DAC: return "Feedback to DAC";
+        case LatencyStage::TICK_WAKEUP: return "Tick wake-up";
+        case LatencyStage::TICK_TO_DAC: return "Tick to DAC";
+        default: return "Unknown";
+    }
+}
+
+void ControlLoop::resetLatency()
+{
+    // Each writer clears its histogram on its next sample
+    m_trackerInterface->resetIngestLatency();
+    m_joystickInterface->resetPublishLatency();
+    m_fsmController->resetFeedbackLatency();
+    for (LatencyHistogram &histogram : m_latency) {
+        histogram.reset();
+    }
+    m_trackLoss.resetStatistics();
+}
+
+QStringList ControlLoop::latencyReport() const
+{
+    QStringList lines;
+    lines << QString("%1 %2 %3 %4 %5 %6")
+             .arg(QString("Stage"), -20).arg(QString("Count"), 10).arg(QString("p50 us"), 10)
+             .arg(QString("p99 us"), 10).arg(QString("p99.9 us"), 10).arg(QString("max us"), 10);
+
+    for (int i = 0; i < static_cast<int>(LatencyStage::COUNT); i++) {
+        const LatencyStage stage = static_cast<LatencyStage>(i);
+        const LatencySummary summary = getLatency(stage);
+        lines << QString("%1 %2 %3 %4 %5 %6")
+                 .arg(latencyStageName(stage), -20)
+                 .arg(summary.count, 10)
+                 .arg(summary.p50Ns / 1000.0, 10, 'f', 1)
+                 .arg(summary.p99Ns / 1000.0, 10, 'f', 1)
+                 .arg(summary.p999Ns / 1000.0, 10, 'f', 1)
+                 .arg(summary.maxNs / 1000.0, 10, 'f', 1);
+    }
+    return lines;
+}
+
+QStringList ControlLoop::trackLossReport() const
+{
+    const TrackLossStatistics stats = m_trackLoss.statistics();
+
+    QStringList lines;
+    lines << QString("Auto track: %1 s, target tracked %2%")
+             .arg(stats.autoNs / 1e9, 0, 'f', 1)
+             .arg(stats.autoNs > 0 ? 100.0 * stats.trackedNs / stats.autoNs : 0.0, 0, 'f', 2);
+    lines << QString("Track losses: %1, reacquired coasting %2, holding %3, after fallback %4, handed off %5")
+             .arg(stats.losses).arg(stats.reacquiredCoasting).arg(stats.reacquiredHolding)
+             .arg(stats.reacquiredFallback).arg(stats.handedOff);
+    lines << QString("Reacquisition (ms): count %1, p50 %2, p99 %3, max %4")
+             .arg(stats.reacquisition.count)
+             .arg(stats.reacquisition.p50Ns / 1e6, 0, 'f', 1)
+             .arg(stats.reacquisition.p99Ns / 1e6, 0, 'f', 1)
+             .arg(stats.reacquisition.maxNs / 1e6, 0, 'f', 1);
+    return lines;
+}
+
+TickStatistics ControlLoop::getTickStatistics() const
+{
+    return m_tickMonitor.statistics();
+}
+
+int ControlLoop::getWorstTicks(TickRecord *out) const
+{
+    return m_tickMonitor.worstTicks(out);
+}
+
+void ControlLoop::resetTickStatistics()
+{
+    m_tickMonitor.reset();
+    m_scheduler.resetStatistics();
+}
+
+QStringList ControlLoop::schedulerReport() const
+{
+    const TickStatistics stats = m_tickMonitor.statistics();
+
+    QStringList lines;
+    lines << QString("Control ticks: %1, deadline misses: %2, overruns: %3")
+             .arg(stats.ticks).arg(stats.deadlineMisses).arg(getOverrunCount());
+    if (m_aiDriven) {
+        lines << QString("Woken by AI sections: %1 missed, %2 waits timed out")
+                 .arg(m_missedSections.load(std::memory_order_relaxed))
+                 .arg(m_feedbackTimeouts.load(std::memory_order_relaxed));
+    }
+
+    lines << QString("%1 %2 %3 %4 %5")
+             .arg(QString("Tick (us)"), -12).arg(QString("mean"), 10).arg(QString("stddev"), 10)
+             .arg(QString("min"), 10).arg(QString("max"), 10);
+
+    const struct { const char *name; const RunningStat *stat; } rows[] = {
+        {"Period", &stats.period},
+        {"Lateness", &stats.lateness},
+        {"Duration", &stats.duration},
+        {"Slack", &stats.slack},
+    };
+    for (const auto &row : rows) {
+        lines << QString("%1 %2 %3 %4 %5")
+                 .arg(QString(row.name), -12)
+                 .arg(row.stat->mean / 1000.0, 10, 'f', 1)
+                 .arg(row.stat->stddev() / 1000.0, 10, 'f', 1)
+                 .arg(row.stat->min / 1000.0, 10, 'f', 1)
+                 .arg(row.stat->max / 1000.0, 10, 'f', 1);
+    }
+
+    TickRecord worst[TickMonitor::WORST_COUNT];
+    const int count = m_tickMonitor.worstTicks(worst);
+    lines << QString("Worst %1 ticks by slack (us):").arg(count);
+    for (int i = 0; i < count; i++) {
+        const TickRecord &tick = worst[i];
+        QStringList ran;
+        if (tick.flags & TICK_TRACK_APPLIED) ran << "track";
+        if (tick.flags & TICK_JOYSTICK_APPLIED) ran << "joystick";
+        if (tick.flags & TICK_SERVO) ran << "servo";
+        if (tick.flags & TICK_CONTENDED) ran << "contended";
+        if (tick.flags & TICK_MODE_CHANGE) ran << "mode";
+
+        lines << QString("  cycle %1: late %2, duration %3, slack %4, %5 [%6]")
+                 .arg(tick.cycle)
+                 .arg((tick.wakeNs - tick.scheduledNs) / 1000.0, 0, 'f', 1)
+                 .arg((tick.endNs - tick.wakeNs) / 1000.0, 0, 'f', 1)
+                 .arg(tick.slackNs / 1000.0, 0, 'f', 1)
+                 .arg(tick.mode == static_cast<int32_t>(OperationMode::COARSE_TRACK) ? "Coarse Track" :
+                      tick.mode == static_cast<int32_t>(OperationMode::FINE_TRACK) ? "Fine Track" : "Auto Track")
+                 .arg(ran.join(","));
+    }
+
+    lines << QString("%1 %2 %3 %4 %5 %6")
+             .arg(QString("Task"), -16).arg(QString("phase"), 8).arg(QString("rate Hz"), 8)
+             .arg(QString("p50 us"), 10).arg(QString("p99 us"), 10).arg(QString("max us"), 10);
+    for (int i = 0; i < m_scheduler.taskCount(); i++) {
+        const RateGroupScheduler::TaskInfo info = m_scheduler.taskInfo(i);
+        const LatencySummary duration = m_scheduler.taskDuration(i);
+        lines << QString("%1 %2 %3 %4 %5 %6")
+                 .arg(QString(info.name), -16)
+                 .arg(QString(RateGroupScheduler::phaseName(info.phase)), 8)
+                 .arg(static_cast<double>(m_controlRateHz) / info.divisor, 8, 'f', 0)
+                 .arg(duration.p50Ns / 1000.0, 10, 'f', 1)
+                 .arg(duration.p99Ns / 1000.0, 10, 'f', 1)
+                 .arg(duration.maxNs / 1000.0, 10, 'f', 1);
+    }
+    return lines;
+}
+
+void ControlLoop::setOverrunWarning(int threshold)
+{
+    m_overrunWarnThreshold = threshold;
+}
+
+void ControlLoop::detachControlThread()
+{
+    m_rtThread.stop();
+}
+
+void ControlLoop::runTick()
+{
+    controlLoopTick();
+}
+
+void ControlLoop::deliverNotifications()
+{
+    // Runs on the GUI thread. A queued invoke from the control thread
+    // would allocate there, so the tick only sets a flag.
+    if (m_trackLossHandoff.exchange(false)) {
+        const OperationMode mode = m_mode.load();
+        emit operationModeChanged(mode);
+        emit statusChanged(QString("Target not reacquired: auto track handed off to %1")
+                          .arg(mode == OperationMode::COARSE_TRACK ? "Coarse Track" : "Fine Track"));
+    }
+
+    // Output modes switched by the tick, and the end of a gimbal fade out
+    const FSMController::ControlMode fsmMode = m_fsmController->getControlMode();
+    if (fsmMode != m_reportedFsmMode) {
+        m_reportedFsmMode = fsmMode;
+        emit statusChanged(QString("FSM mode changed to %1")
+                          .arg(fsmMode == FSMController::ControlMode::COARSE_TRACK ? "Coarse Track" :
+                               fsmMode == FSMController::ControlMode::FINE_TRACK ? "Fine Track" : "Auto Track"));
+    }
+    const bool gimbalEnabled = m_gimbalController->isEnabled();
+    if (gimbalEnabled != m_reportedGimbalEnabled) {
+        m_reportedGimbalEnabled = gimbalEnabled;
+        emit statusChanged(gimbalEnabled ? "Gimbal control enabled" : "Gimbal control disabled");
+    }
+
+    const uint64_t fsmFailures = m_fsmController->getOutputFailureCount();
+    const uint64_t gimbalFailures = m_gimbalController->getOutputFailureCount();
+    if (fsmFailures == m_reportedFsmFailures && gimbalFailures == m_reportedGimbalFailures) {
+        return;
+    }
+
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    const int64_t nowNs = static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+    if (m_lastFailureReportNs != 0 && nowNs - m_lastFailureReportNs < TICK_WARNING_INTERVAL_MS * 1000000LL) {
+        return;
+    }
+    m_lastFailureReportNs = nowNs;
+
+    if (fsmFailures != m_reportedFsmFailures) {
+        emit errorOccurred(QString("Failed to write to FSM outputs: %1 (%2 failed commits)")
+                          .arg(getErrorString(m_fsmController->getLastOutputError()))
+                          .arg(fsmFailures - m_reportedFsmFailures));
+        m_reportedFsmFailures = fsmFailures;
+    }
+    if (gimbalFailures != m_reportedGimbalFailures) {
+        emit errorOccurred(QString("Failed to write to gimbal outputs: %1 (%2 failed commits)")
+                          .arg(getErrorString(m_gimbalController->getLastOutputError()))
+                          .arg(gimbalFailures - m_reportedGimbalFailures));
+        m_reportedGimbalFailures = gimbalFailures;
+    }
+}
+
+void ControlLoop::checkSchedulerHealth()
+{
+    // Runs on the GUI thread; the control thread never emits signals
+    const uint64_t overruns = getOverrunCount();
+    const uint64_t recent = overruns - m_checkedOverruns;
+    m_checkedOverruns = overruns;
+
+    if (m_overrunWarnThreshold <= 0 || recent <= static_cast<uint64_t>(m_overrunWarnThreshold)) {
+        return;
+    }
+
+    // At most one warning per interval; count the ones held back
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    const int64_t nowNs = static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+    if (m_lastWarningNs != 0 && nowNs - m_lastWarningNs < TICK_WARNING_INTERVAL_MS * 1000000LL) {
+        m_suppressedWarnings++;
+        return;
+    }
+    m_lastWarningNs = nowNs;
+
+    const TickStatistics stats = m_tickMonitor.statistics();
+    QString message = QString("Warning: %1 control tick overruns in the last %2 ms "
+                              "(worst lateness %3 us, worst duration %4 us)")
+                      .arg(recent)
+                      .arg(TICK_HEALTH_CHECK_MS)
+                      .arg(stats.lateness.max / 1000.0, 0, 'f', 1)
+                      .arg(stats.duration.max / 1000.0, 0, 'f', 1);
+    if (m_suppressedWarnings > 0) {
+        message += QString(", %1 similar warnings suppressed").arg(m_suppressedWarnings);
+        m_suppressedWarnings = 0;
+    }
+    emit errorOccurred(message);
+}
+
+void ControlLoop::handleJoystickModeButtonPressed()
+{
+    // Cycle to the next mode
+    cycleOperationMode();
+}
+
+void ControlLoop::handleTrackingStatusChanged(bool isTracking)
+{
+    m_isTrackingActive = isTracking;
+
+    // The control tick runs the track loss policy; only report it here
+    if (m_mode.load() == OperationMode::AUTO_TRACK && !m_isTrackingActive) {
+        emit statusChanged("Warning: Tracking lost in auto track mode");
+    }
+}
+
+void ControlLoop::configureRateGroups()
+{
+    typedef RateGroupScheduler::Phase Phase;
+
+    // The servo and FSM output run every tick; the slower groups are
+    // staggered so their work does not land on the same tick
+    const int tracker = m_rateConfig.trackerDivisor;
+    const int joystick = m_rateConfig.joystickDivisor;
+    const int gimbal = m_rateConfig.gimbalDivisor;
+
+    m_gimbalDivisor = gimbal;
+    m_offloadDt = static_cast<double>(gimbal) / m_controlRateHz;
+    m_offloadActive = false;
+
+    m_scheduler.clear();
+    m_scheduler.addTask("fsm-feedback", Phase::READ, 1, 0, [this]() { readFsmFeedback(); });
+    m_scheduler.addTask("tracker", Phase::READ, tracker, 0, [this]() { readTracker(); });
+    m_scheduler.addTask("joystick", Phase::READ, joystick, 1 % joystick, [this]() { readJoystick(); });
+    m_scheduler.addTask("gimbal-feedback", Phase::READ, gimbal, 2 % gimbal, [this]() { readGimbal(); });
+    m_scheduler.addTask("mode", Phase::COMPUTE, 1, 0, [this]() { transitionMode(); });
+    m_scheduler.addTask("manual", Phase::COMPUTE, joystick, 1 % joystick, [this]() { computeManual(); });
+    m_scheduler.addTask("track-loss", Phase::COMPUTE, 1, 0, [this]() { handleTrackLoss(); });
+    m_scheduler.addTask("track", Phase::COMPUTE, tracker, 0, [this]() { computeTracking(); });
+    m_scheduler.addTask("track-predict", Phase::COMPUTE, 1, 0, [this]() { predictTracking(); });
+    m_scheduler.addTask("gimbal-offload", Phase::COMPUTE, gimbal, 2 % gimbal, [this]() { computeOffload(); });
+    m_scheduler.addTask("servo", Phase::COMPUTE, 1, 0, [this]() { computeServo(); });
+    m_scheduler.addTask("fsm-output", Phase::WRITE, 1, 0, [this]() { writeFsm(); });
+    m_scheduler.addTask("gimbal-output", Phase::WRITE, gimbal, 2 % gimbal, [this]() { writeGimbal(); });
+    m_scheduler.addTask("telemetry", Phase::PUBLISH, 1, 0, [this]() { publishTick(); });
 }
 
 void ControlLoop::controlLoopTick()
 {
-    QMutexLocker locker(&m_mutex);
+    // AI driven: the section that just arrived is this tick's deadline.
+    // More than one means the previous tick overran into the next section.
+    if (m_aiDriven) {
+        const int sections = m_fsmController->waitForFeedback(CONTROL_AI_WAIT_TIMEOUT_MS);
+        if (sections == 0) {
+            m_feedbackTimeouts.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (sections > 1) {
+            m_missedSections.fetch_add(static_cast<uint64_t>(sections - 1), std::memory_order_relaxed);
+        }
+    }
+
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    const int64_t tickStartNs = static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
 
     if (!m_running) {
         return;
     }
 
-    // Get all current state for telemetry
-    double fsmX, fsmY;
-    m_fsmController->getCurrentPosition(fsmX, fsmY);
+    // What this tick did, kept with its timing by the scheduler monitor
+    uint32_t tickFlags = 0;
+    if (!applyConfigUpdates()) {
+        tickFlags |= TICK_CONTENDED;
+    }
+
+    m_tick.startNs = tickStartNs;
+    m_tick.wakeNs = m_aiDriven ? m_fsmController->getFeedbackReadyTime() : m_rtThread.scheduledWakeNs();
+    m_tick.commitNs = tickStartNs;
+    m_tick.mode = m_mode.load();
+    m_tick.flags = tickFlags;
+    m_tick.joystickApplied = false;
+    m_tick.trackApplied = false;
+
+    // Read, compute, write and publish whichever groups are due
+    m_scheduler.run(m_tickIndex++);
+
+    // Scheduler health: wake-up, duration and slack of this tick
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    TickRecord tick;
+    tick.cycle = m_rtThread.cycleCount();
+    tick.scheduledNs = m_tick.wakeNs;
+    tick.wakeNs = tickStartNs;
+    tick.endNs = static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+    tick.mode = static_cast<int32_t>(m_tick.mode);
+    tick.flags = m_tick.flags
+               | (m_tick.trackApplied ? TICK_TRACK_APPLIED : 0u)
+               | (m_tick.joystickApplied ? TICK_JOYSTICK_APPLIED : 0u);
+    m_tickMonitor.record(tick);
+}
+
+bool ControlLoop::applyConfigUpdates()
+{
+    bool current = true;
+
+    ServoConfig servo;
+    if (m_servoConfig.loadIfChanged(servo, m_appliedServoConfig)) {
+        m_servoX.configure(servo.x);
+        m_servoY.configure(servo.y);
+        m_servoEngaged = false; // Re-engage from the current command below
+    } else if (m_servoConfig.version() != m_appliedServoConfig) {
+        current = false;
+    }
 
-    double gimbalAz, gimbalEl, gimbalAuxEl;
-    m_gimbalController->getCurrentPosition(gimbalAz, gimbalEl, gimbalAuxEl);
+    // Engage from the current open-loop command so it is bumpless
+    const bool servoEnabled = m_servoEnabled.load(std::memory_order_relaxed);
+    if (servoEnabled && !m_servoEngaged) {
+        double spX, spY, fbX, fbY;
+        m_fsmController->getSetpoint(spX, spY);
+        m_fsmController->getCurrentPosition(fbX, fbY);
+        m_servoX.initialize(spX, spX, fbX);
+        m_servoY.initialize(spY, spY, fbY);
+    }
+    if (servoEnabled != m_fsmController->isClosedLoop()) {
+        m_fsmController->setClosedLoop(servoEnabled);
+    }
+    m_servoEngaged = servoEnabled;
+
+    TrackEstimator::Config estimator;
+    if (m_trackEstimatorConfig.loadIfChanged(estimator, m_appliedTrackEstimatorConfig)) {
+        m_trackEstimator.configure(estimator);
+    } else if (m_trackEstimatorConfig.version() != m_appliedTrackEstimatorConfig) {
+        current = false;
+    }
 
-    double joystickX, joystickY, joystickZ;
-    m_joystickInterface->getJoystickPosition(joystickX, joystickY, joystickZ);
+    TrackLossPolicy::Config trackLoss;
+    if (m_trackLossConfig.loadIfChanged(trackLoss, m_appliedTrackLossConfig)) {
+        m_trackLoss.configure(trackLoss);
+    } else if (m_trackLossConfig.version() != m_appliedTrackLossConfig) {
+        current = false;
+    }
 
-    double trackErrorX, trackErrorY;
-    m_trackerInterface->getTrackingErrors(trackErrorX, trackErrorY);
+    // A new off-load configuration engages again from the gimbal position
+    GimbalOffload::Config offload;
+    if (m_gimbalOffloadConfig.loadIfChanged(offload, m_appliedGimbalOffloadConfig)) {
+        m_gimbalOffload.configure(offload);
+        m_offloadActive = false;
+    } else if (m_gimbalOffloadConfig.version() != m_appliedGimbalOffloadConfig) {
+        current = false;
+    }
+
+    return current;
+}
+
+void ControlLoop::readFsmFeedback()
+{
+    m_tick.feedbackNs = m_fsmController->getFeedbackTime();
+    m_fsmController->getCurrentPosition(m_tick.fsmX, m_tick.fsmY);
+    m_fsmController->getFeedbackStatistics(m_tick.feedbackStats);
+}
+
+void ControlLoop::readGimbal()
+{
+    m_gimbalController->getCurrentPosition(m_tick.gimbalAz, m_tick.gimbalEl, m_tick.gimbalAuxEl);
+}
+
+void ControlLoop::readJoystick()
+{
+    m_tick.joystickVersion = m_joystickInterface->getJoystickAxes(m_tick.joystick);
+}
 
-    // Emit telemetry update
-    emit telemetryUpdated(
-        fsmX, fsmY,
-        gimbalAz, gimbalEl, gimbalAuxEl,
-        joystickX, joystickY, joystickZ,
-        trackErrorX, trackErrorY
-    );
+void ControlLoop::readTracker()
+{
+    // Without an ingest thread the mailbox is polled here, at the tracker rate
+    if (m_trackerScheduled.load(std::memory_order_relaxed)) {
+        m_trackerInterface->pollStatus();
+    }
+    m_tick.trackFrame = m_trackerInterface->getLatestFrame(m_tick.trackErrorX, m_tick.trackErrorY, m_tick.trackArrivalNs);
+    m_tick.isTracking = m_trackerInterface->isTargetTracked();
+}
+
+void ControlLoop::computeManual()
+{
+    // Manual input: stage a new joystick position once per joystick tick,
+    // however many events the input thread published since the last one.
+    // A change of the deadzones, inversions or enables restages the
+    // current one.
+    const JoystickAxes &joystick = m_tick.joystick;
+    const bool joystickApplied = m_tick.joystickVersion != m_appliedJoystickVersion;
+    const uint32_t manualVersion = m_manualConfig.version();
+    if (!joystickApplied && manualVersion == m_appliedManualVersion) {
+        return;
+    }
+
+    const ManualInputConfig manual = m_manualConfig.load();
+
+    // In all modes, joystick position controls FSM
+    if (manual.fsmOutputEnabled) {
+        m_fsmController->setManualInputs(
+            shapeManualAxis(joystick.x, manual.fsmDeadzone, manual.invertMask & MANUAL_INVERT_FSM_X),
+            shapeManualAxis(joystick.y, manual.fsmDeadzone, manual.invertMask & MANUAL_INVERT_FSM_Y));
+    } else {
+        m_fsmController->setManualInputs(0.0, 0.0);
+    }
+
+    // Aux elevation follows whichever of Z and RZ moved last
+    if (joystick.rz != m_appliedJoystick.rz) {
+        m_joystickAux = joystick.rz;
+    } else if (joystick.z != m_appliedJoystick.z) {
+        m_joystickAux = joystick.z;
+    }
+
+    // In coarse track mode, also control gimbal with a reduced range
+    // for fine control. The gimbal task commits it at the gimbal rate.
+    if (m_tick.mode == OperationMode::COARSE_TRACK && manual.gimbalOutputEnabled) {
+        const double scaleFactor = 0.2;
+        m_gimbalController->setPosition(
+            shapeManualAxis(joystick.x, manual.gimbalDeadzone, manual.invertMask & MANUAL_INVERT_GIMBAL_AZ) * scaleFactor,
+            shapeManualAxis(joystick.y, manual.gimbalDeadzone, manual.invertMask & MANUAL_INVERT_GIMBAL_EL) * scaleFactor,
+            shapeManualAxis(m_joystickAux, manual.gimbalDeadzone, manual.invertMask & MANUAL_INVERT_GIMBAL_AUX) * scaleFactor);
+    }
+
+    if (joystickApplied) {
+        m_appliedJoystickAgeNs = m_tick.startNs - joystick.eventNs;
+    }
+    m_appliedJoystick = joystick;
+    m_appliedJoystickVersion = m_tick.joystickVersion;
+    m_appliedManualVersion = manualVersion;
+    m_tick.joystickApplied = joystickApplied;
+}
+
+void ControlLoop::computeTracking()
+{
+    // A lost target starts a new track when it is reacquired, unless auto
+    // track is coasting on the estimate
+    if (!m_tick.isTracking) {
+        if (m_trackLoss.state() != TrackLossPolicy::State::COASTING) {
+            m_trackEstimator.reset();
+        }
+        return;
+    }
+
+    if (m_tick.trackFrame != m_estimatedTrackFrame) {
+        m_trackEstimator.update(m_tick.trackErrorX, m_tick.trackErrorY, m_tick.trackArrivalNs);
+        m_estimatedTrackFrame = m_tick.trackFrame;
+    }
+
+    // In auto track each new message reaches the FSM, through the
+    // estimator's predictions or, without it, as reported
+    if (m_tick.mode != OperationMode::AUTO_TRACK || m_tick.trackFrame == m_appliedTrackFrame) {
+        return;
+    }
+
+    if (!m_trackEstimator.config().enabled) {
+        m_fsmController->setTrackingInputs(m_tick.trackErrorX, m_tick.trackErrorY);
+    }
+    m_appliedTrackFrame = m_tick.trackFrame;
+    m_tick.trackApplied = true;
+
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    m_appliedTrackAgeNs = static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec - m_tick.trackArrivalNs;
+    m_latency[static_cast<int>(LatencyStage::TRACK_TO_COMMAND)].record(m_appliedTrackAgeNs);
+}
+
+void ControlLoop::predictTracking()
+{
+    // Every tick, not just every message: the FSM follows the error
+    // expected when this tick's command is converted
+    if (m_tick.mode != OperationMode::AUTO_TRACK ||
+        !m_trackEstimator.config().enabled || !m_trackEstimator.hasTrack()) {
+        return;
+    }
+
+    // Through a track loss, coast on the estimated target motion until
+    // the policy holds
+    double x, y;
+    const int64_t commitNs = m_tick.startNs + m_trackPredictionLeadNs;
+    if (m_trackLoss.state() == TrackLossPolicy::State::TRACKING) {
+        m_trackEstimator.predict(commitNs, x, y);
+    } else if (m_trackLoss.state() == TrackLossPolicy::State::COASTING) {
+        m_trackEstimator.coast(commitNs, x, y);
+    } else {
+        return;
+    }
+    m_fsmController->setTrackingInputs(x, y);
+}
+
+void ControlLoop::handleTrackLoss()
+{
+    if (!m_trackLoss.update(m_tick.mode == OperationMode::AUTO_TRACK, m_tick.isTracking, m_tick.startNs) ||
+        m_trackLoss.state() != TrackLossPolicy::State::FALLBACK) {
+        return;
+    }
+
+    // Coasting and holding need nothing here: the prediction task coasts,
+    // and a hold leaves the last tracking input staged
+    switch (m_trackLoss.config().fallback) {
+        case TrackLossPolicy::Fallback::HOLD:
+            break;
+
+        case TrackLossPolicy::Fallback::CENTER:
+            m_fsmController->setTrackingInputs(0.0, 0.0);
+            break;
+
+        case TrackLossPolicy::Fallback::MANUAL:
+            // The next tick fades to the joystick. With the off-load on,
+            // coarse track keeps the gimbal where it pointed.
+            m_mode.store(m_offloadEnabled.load(std::memory_order_relaxed) ? OperationMode::COARSE_TRACK
+                                                                          : OperationMode::FINE_TRACK);
+            m_trackLossHandoff.store(true);
+            break;
+    }
+}
+
+void ControlLoop::transitionMode()
+{
+    if (m_tick.mode == m_appliedMode && !m_modeUpdatePending.load(std::memory_order_relaxed)) {
+        return;
+    }
+    m_modeUpdatePending.store(false);
+    m_appliedMode = m_tick.mode;
+    m_tick.flags |= TICK_MODE_CHANGE;
+
+    // The servo continues from its last output on the setpoint the fade
+    // starts from, so its integrator does not carry the old mode's error
+    if (m_servoEngaged) {
+        double setpointX, setpointY;
+        m_fsmController->getSetpoint(setpointX, setpointY);
+        m_servoX.initialize(m_servoX.lastOutput(), setpointX, m_tick.fsmX);
+        m_servoY.initialize(m_servoY.lastOutput(), setpointY, m_tick.fsmY);
+    }
+
+    // The FSM commits every tick, the gimbal once per gimbal group
+    const int fsmCommits = static_cast<int>(static_cast<int64_t>(m_modeTransitionMs.load(std::memory_order_relaxed)) *
+                                            m_controlRateHz / 1000);
+    updateControlMode(m_appliedMode, fsmCommits, fsmCommits / m_gimbalDivisor);
+}
+
+void ControlLoop::computeOffload()
+{
+    if (m_tick.mode != OperationMode::AUTO_TRACK || !m_offloadEnabled.load(std::memory_order_relaxed)) {
+        m_offloadActive = false;
+        return;
+    }
+
+    // Engage from wherever the gimbal is commanded; aux elevation holds
+    double azimuth, elevation, auxElevation;
+    m_gimbalController->getCurrentPosition(azimuth, elevation, auxElevation);
+    if (!m_offloadActive) {
+        m_gimbalOffload.reset(azimuth, elevation);
+        m_offloadActive = true;
+    }
+
+    double x = m_tick.fsmX;
+    double y = m_tick.fsmY;
+    if (m_gimbalOffload.config().source == GimbalOffload::Source::COMMAND) {
+        m_fsmController->getSetpoint(x, y);
+    }
+
+    m_gimbalOffload.update(x, y, m_offloadDt, azimuth, elevation);
+    m_gimbalController->setPosition(azimuth, elevation, auxElevation);
+}
+
+void ControlLoop::computeServo()
+{
+    // Closed loop: drive the FSM from the compensators on the feedback
+    if (!m_servoEngaged) {
+        return;
+    }
+
+    m_tick.flags |= TICK_SERVO;
+    double setpointX, setpointY;
+    m_fsmController->getSetpoint(setpointX, setpointY);
+    m_fsmController->setServoOutputs(m_servoX.update(setpointX, m_tick.fsmX),
+                                     m_servoY.update(setpointY, m_tick.fsmY));
+}
+
+void ControlLoop::writeFsm()
+{
+    // Commit: the only place the FSM DACs are written while running. The
+    // staged command is sent once, if it changed.
+    m_fsmController->commitOutputs();
+
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    const int64_t commitNs = static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+    m_tick.commitNs = commitNs;
+
+    // Latency of every input that reached the DACs in this commit
+    m_latency[static_cast<int>(LatencyStage::TICK_TO_DAC)].record(commitNs - m_tick.wakeNs);
+    if (m_tick.trackApplied) {
+        m_latency[static_cast<int>(LatencyStage::TRACK_TO_DAC)].record(commitNs - m_tick.trackArrivalNs);
+    }
+    if (m_tick.joystickApplied && m_tick.joystick.eventNs != 0) {
+        m_latency[static_cast<int>(LatencyStage::JOYSTICK_TO_DAC)].record(commitNs - m_tick.joystick.eventNs);
+    }
+    if (m_tick.feedbackNs != 0) {
+        m_latency[static_cast<int>(LatencyStage::FEEDBACK_TO_DAC)].record(commitNs - m_tick.feedbackNs);
+    }
+}
+
+void ControlLoop::writeGimbal()
+{
+    // The gimbal servo amplifiers close their own loops; commanding them
+    // faster than the gimbal rate only adds bus traffic
+    m_gimbalController->commitOutputs();
+}
+
+void ControlLoop::publishTick()
+{
+    m_latency[static_cast<int>(LatencyStage::TICK_WAKEUP)].record(m_tick.startNs - m_tick.wakeNs);
+
+    // Publish telemetry without allocating or emitting signals. Values of
+    // the slower groups are the latest they read.
+    TelemetrySnapshot snapshot;
+    snapshot.cycle = m_rtThread.cycleCount();
+    snapshot.timestampNs = m_tick.commitNs;
+    snapshot.mode = static_cast<int32_t>(m_tick.mode);
+    snapshot.tracking = m_tick.isTracking ? 1 : 0;
+    snapshot.fsmX = m_tick.fsmX;
+    snapshot.fsmY = m_tick.fsmY;
+    snapshot.fsmXMean = m_tick.feedbackStats.channel[0].mean;
+    snapshot.fsmXMin = m_tick.feedbackStats.channel[0].min;
+    snapshot.fsmXMax = m_tick.feedbackStats.channel[0].max;
+    snapshot.fsmXRms = m_tick.feedbackStats.channel[0].rms;
+    snapshot.fsmYMean = m_tick.feedbackStats.channel[1].mean;
+    snapshot.fsmYMin = m_tick.feedbackStats.channel[1].min;
+    snapshot.fsmYMax = m_tick.feedbackStats.channel[1].max;
+    snapshot.fsmYRms = m_tick.feedbackStats.channel[1].rms;
+    snapshot.gimbalAz = m_tick.gimbalAz;
+    snapshot.gimbalEl = m_tick.gimbalEl;
+    snapshot.gimbalAuxEl = m_tick.gimbalAuxEl;
+    snapshot.joystickX = m_tick.joystick.x;
+    snapshot.joystickY = m_tick.joystick.y;
+    snapshot.joystickZ = m_tick.joystick.z;
+    snapshot.trackErrorX = m_tick.trackErrorX;
+    snapshot.trackErrorY = m_tick.trackErrorY;
+    snapshot.trackFrame = m_tick.trackFrame;
+    snapshot.trackAgeNs = m_appliedTrackAgeNs;
+    snapshot.joystickAgeNs = m_appliedJoystickAgeNs;
+    m_telemetry.publish(snapshot);
+}
+
+void ControlLoop::requestModeUpdate()
+{
+    // While running, the components belong to the control tick
+    if (m_running) {
+        m_modeUpdatePending.store(true);
+    } else {
+        updateControlMode(m_mode.load());
+        deliverNotifications();
+    }
 }
 
-void ControlLoop::updateControlMode()
+void ControlLoop::updateControlMode(OperationMode mode, int fsmCommits, int gimbalCommits)
 {
-    // Set FSM controller mode based on operation mode
+    // Set FSM controller mode based on operation mode, fading the outputs
+    // over the given number of commits of each
     FSMController::ControlMode fsmMode;
-    switch (m_mode) {
+    switch (mode) {
         case OperationMode::COARSE_TRACK:
             fsmMode = FSMController::ControlMode::COARSE_TRACK;
-            m_gimbalController->setEnabled(true);
+            m_gimbalController->fadeEnabled(true, gimbalCommits);
             break;
 
         case OperationMode::FINE_TRACK:
             fsmMode = FSMController::ControlMode::FINE_TRACK;
-            m_gimbalController->setEnabled(false);
+            m_gimbalController->fadeEnabled(false, gimbalCommits);
             break;
 
         case OperationMode::AUTO_TRACK:
             fsmMode = FSMController::ControlMode::AUTO_TRACK;
-            m_gimbalController->setEnabled(false);
+            if (m_offloadEnabled.load()) {
+                // A disabled gimbal is held at zero; stage that before
+                // enabling so the first commit does not step to a stale
+                // command
+                if (!m_gimbalController->isEnabled()) {
+                    m_gimbalController->setPosition(0.0, 0.0, 0.0);
+                }
+                m_gimbalController->fadeEnabled(true, gimbalCommits);
+            } else {
+                m_gimbalController->fadeEnabled(false, gimbalCommits);
+            }
             break;
     }
 
-    m_fsmController->setControlMode(fsmMode);
+    m_fsmController->setControlMode(fsmMode, fsmCommits);
 }
 
 void ControlLoop::cycleOperationMode()
 {
     // Cycle to the next operation mode
-    switch (m_mode) {
+    switch (m_mode.load()) {
         case OperationMode::COARSE_TRACK:
             setOperationMode(OperationMode::FINE_TRACK);
             break;
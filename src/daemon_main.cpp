@@ -0,0 +1,211 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTimer>
+#include <cmath>
+#include <csignal>
+#include <iostream>
+#include <time.h>
+#include <unistd.h>
+
+#include "control_loop.h"
+#include "ipc_server.h"
+#include "loop_options.h"
+
+// bc-traild runs the control loop without QtWidgets or a display, so it can
+// sit on an isolated core with a small footprint while clients run elsewhere
+
+// Time given to the loop to settle before a --validate-rate window
+#define VALIDATE_SETTLE_MS 1000
+
+// Set by the signal handlers, polled from the main thread
+static volatile sig_atomic_t g_latencyDumpRequested = 0;
+static volatile sig_atomic_t g_stopRequested = 0;
+
+static void requestLatencyDump(int)
+{
+    g_latencyDumpRequested = 1;
+}
+
+static void requestStop(int)
+{
+    g_stopRequested = 1;
+}
+
+// Achieved rate and jitter of the ticks since the statistics were reset.
+// Passes when the loop kept within 1% of its rate without overruns.
+static bool reportRateValidation(const ControlLoop &loop, int64_t elapsedNs, uint64_t overruns)
+{
+    const TickStatistics stats = loop.getTickStatistics();
+    const LatencySummary wakeup = loop.getLatency(ControlLoop::LatencyStage::TICK_WAKEUP);
+    const ControlRateConfig rate = loop.getControlRateConfig();
+    const double achievedHz = stats.ticks / (elapsedNs / 1e9);
+    const bool passed = std::abs(achievedHz - rate.rateHz) <= 0.01 * rate.rateHz && overruns == 0;
+
+    std::cout << "Rate validation (" << (rate.aiDriven ? "AI driven" : "timer driven")
+              << ", " << rate.aiSectionScans << " AI scans per tick)" << std::endl;
+    std::cout << "  target:          " << rate.rateHz << " Hz" << std::endl;
+    std::cout << "  achieved:        " << achievedHz << " Hz over " << stats.ticks << " ticks" << std::endl;
+    std::cout << "  period us:       mean " << stats.period.mean / 1000.0
+              << ", stddev " << stats.period.stddev() / 1000.0
+              << ", min " << stats.period.min / 1000.0
+              << ", max " << stats.period.max / 1000.0 << std::endl;
+    std::cout << "  wake-up us:      p50 " << wakeup.p50Ns / 1000.0
+              << ", p99 " << wakeup.p99Ns / 1000.0
+              << ", p99.9 " << wakeup.p999Ns / 1000.0
+              << ", max " << wakeup.maxNs / 1000.0 << std::endl;
+    std::cout << "  duration us:     mean " << stats.duration.mean / 1000.0
+              << ", max " << stats.duration.max / 1000.0 << std::endl;
+    std::cout << "  deadline misses: " << stats.deadlineMisses << ", overruns " << overruns << std::endl;
+    std::cout << "  result:          " << (passed ? "PASS" : "FAIL") << std::endl;
+    return passed;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCoreApplication::setApplicationName("bc-traild");
+    QCoreApplication::setApplicationVersion("1.0.0");
+    QCoreApplication::setOrganizationName("Leidos");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("BC-TRAIL headless control loop daemon");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    LoopOptions loopOptions;
+    loopOptions.addTo(parser);
+
+    QCommandLineOption modeOption("mode", "Initial operation mode: coarse, fine or auto", "mode", "coarse");
+    parser.addOption(modeOption);
+
+    QCommandLineOption ipcNameOption("ipc-name", "POSIX shared memory object serving clients", "name", IPC_DEFAULT_NAME);
+    parser.addOption(ipcNameOption);
+
+    QCommandLineOption noIpcOption("no-ipc", "Do not serve clients over shared memory");
+    parser.addOption(noIpcOption);
+
+    QCommandLineOption validateOption("validate-rate", "Run for <seconds>, report the achieved control rate and jitter, and exit", "seconds");
+    parser.addOption(validateOption);
+
+    parser.process(app);
+
+    ControlLoop::OperationMode mode;
+    const QString modeName = parser.value(modeOption);
+    if (modeName == "coarse") {
+        mode = ControlLoop::OperationMode::COARSE_TRACK;
+    } else if (modeName == "fine") {
+        mode = ControlLoop::OperationMode::FINE_TRACK;
+    } else if (modeName == "auto") {
+        mode = ControlLoop::OperationMode::AUTO_TRACK;
+    } else {
+        std::cerr << "Unknown mode: " << modeName.toStdString() << std::endl;
+        return 2;
+    }
+
+    // Serving replaces a stale segment of the same name, so an installed
+    // setuid daemon must not let the caller pick an object to unlink
+    const QString ipcName = parser.value(ipcNameOption);
+    if (ipcName != IPC_DEFAULT_NAME && (geteuid() != getuid() || getegid() != getgid())) {
+        std::cerr << "--ipc-name is not allowed when running setuid" << std::endl;
+        return 2;
+    }
+
+    // The backends must be chosen before the controllers are constructed
+    loopOptions.applyBackends(parser);
+
+    ControlLoop loop;
+    QObject::connect(&loop, &ControlLoop::statusChanged, [](const QString &message) {
+        std::cout << message.toStdString() << std::endl;
+    });
+    QObject::connect(&loop, &ControlLoop::errorOccurred, [](const QString &error) {
+        std::cerr << "Error: " << error.toStdString() << std::endl;
+    });
+
+    if (!loopOptions.applyTo(parser, loop)) {
+        return 1;
+    }
+
+    if (!loop.initialize()) {
+        std::cerr << "Failed to initialize the control system" << std::endl;
+        return 1;
+    }
+    loop.setOperationMode(mode);
+
+    // Clients attach through shared memory: status, commands and every
+    // telemetry snapshot
+    IpcServer server(&loop);
+    QObject::connect(&server, &IpcServer::statusChanged, [](const QString &message) {
+        std::cout << message.toStdString() << std::endl;
+    });
+    QObject::connect(&server, &IpcServer::errorOccurred, [](const QString &error) {
+        std::cerr << "Error: " << error.toStdString() << std::endl;
+    });
+    if (!parser.isSet(noIpcOption) && !server.open(ipcName)) {
+        return 1;
+    }
+
+    if (!loop.start()) {
+        std::cerr << "Failed to start the control system" << std::endl;
+        return 1;
+    }
+
+    // kill -USR1 <pid> prints the latency histograms and scheduler health;
+    // SIGINT and SIGTERM stop the loop and zero the outputs
+    struct sigaction action = {};
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    action.sa_handler = requestLatencyDump;
+    sigaction(SIGUSR1, &action, nullptr);
+    action.sa_handler = requestStop;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    QTimer signalTimer;
+    signalTimer.setInterval(200);
+    QObject::connect(&signalTimer, &QTimer::timeout, [&loop, &app]() {
+        if (g_latencyDumpRequested) {
+            g_latencyDumpRequested = 0;
+            const QStringList report = loop.latencyReport() + loop.schedulerReport() + loop.trackLossReport();
+            for (const QString &line : report) {
+                std::cout << line.toStdString() << std::endl;
+            }
+        }
+        if (g_stopRequested) {
+            app.quit();
+        }
+    });
+    signalTimer.start();
+
+    // Validation: measure a window after start-up has settled and exit
+    // with the verdict
+    int64_t validateStartNs = 0;
+    uint64_t validateOverruns = 0;
+    bool validated = true;
+    if (parser.isSet(validateOption)) {
+        const int windowMs = static_cast<int>(parser.value(validateOption).toDouble() * 1000.0);
+        QTimer::singleShot(VALIDATE_SETTLE_MS, [&]() {
+            loop.resetTickStatistics();
+            loop.resetLatency();
+            validateOverruns = loop.getOverrunCount();
+            timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            validateStartNs = static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+        });
+        QTimer::singleShot(VALIDATE_SETTLE_MS + windowMs, [&]() {
+            timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            const int64_t elapsedNs = static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec - validateStartNs;
+            validated = reportRateValidation(loop, elapsedNs, loop.getOverrunCount() - validateOverruns);
+            app.quit();
+        });
+    }
+
+    int result = app.exec();
+    loop.stop();
+    server.close();
+    if (result == 0 && !validated) {
+        result = 3;
+    }
+    return result;
+}
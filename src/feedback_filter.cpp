@@ -0,0 +1,145 @@
+#include "feedback_filter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+FeedbackFilter::FeedbackFilter()
+    : m_channels(0)
+{
+    configure(Config(), 1);
+}
+
+std::vector<double> FeedbackFilter::designTaps(const Config &config)
+{
+    std::vector<double> taps;
+
+    switch (config.type) {
+        case Type::MOVING_AVERAGE:
+            taps.assign(config.length, 1.0);
+            break;
+
+        case Type::CIC: {
+            // Impulse response of N cascaded boxcars of length R
+            taps.assign(1, 1.0);
+            for (int stage = 0; stage < config.stages; ++stage) {
+                std::vector<double> next(taps.size() + config.length - 1, 0.0);
+                for (size_t i = 0; i < taps.size(); ++i) {
+                    for (int k = 0; k < config.length; ++k) {
+                        next[i + k] += taps[i];
+                    }
+                }
+                taps.swap(next);
+            }
+            break;
+        }
+
+        case Type::FIR: {
+            // Hamming-windowed sinc low-pass
+            const int n = config.length;
+            const double center = 0.5 * (n - 1);
+            taps.resize(n);
+            for (int i = 0; i < n; ++i) {
+                const double t = i - center;
+                const double sinc = (t == 0.0) ? 2.0 * config.cutoff
+                                               : std::sin(2.0 * M_PI * config.cutoff * t) / (M_PI * t);
+                const double window = (n > 1) ? 0.54 - 0.46 * std::cos(2.0 * M_PI * i / (n - 1)) : 1.0;
+                taps[i] = sinc * window;
+            }
+            break;
+        }
+    }
+
+    // Unity DC gain
+    double sum = 0.0;
+    for (double tap : taps) {
+        sum += tap;
+    }
+    for (double &tap : taps) {
+        tap /= sum;
+    }
+
+    return taps;
+}
+
+bool FeedbackFilter::configure(const Config &config, int channels)
+{
+    if (channels < 1 || channels > MAX_CHANNELS || config.length < 1) {
+        return false;
+    }
+    if (config.type == Type::CIC && (config.stages < 1 || config.stages > 8)) {
+        return false;
+    }
+    if (config.type == Type::FIR && (config.cutoff <= 0.0 || config.cutoff > 0.5)) {
+        return false;
+    }
+
+    m_config = config;
+    m_channels = channels;
+    m_taps = designTaps(config);
+
+    for (int ch = 0; ch < MAX_CHANNELS; ++ch) {
+        m_window[ch].assign(ch < channels ? m_taps.size() : 0, 0.0);
+    }
+
+    return true;
+}
+
+void FeedbackFilter::reset()
+{
+    for (int ch = 0; ch < m_channels; ++ch) {
+        std::fill(m_window[ch].begin(), m_window[ch].end(), 0.0);
+    }
+}
+
+void FeedbackFilter::processBlock(const double *data, int32_t scans, double *output, BlockStats &stats)
+{
+    stats.scans = scans;
+    if (scans <= 0) {
+        return;
+    }
+
+    const int channels = m_channels;
+    const int32_t taps = static_cast<int32_t>(m_taps.size());
+    const double *h = m_taps.data();
+
+    for (int ch = 0; ch < channels; ++ch) {
+        // Block statistics
+        double minValue = std::numeric_limits<double>::max();
+        double maxValue = std::numeric_limits<double>::lowest();
+        double sum = 0.0;
+        double sumSquares = 0.0;
+        for (int32_t i = 0; i < scans; ++i) {
+            const double v = data[i * channels + ch];
+            minValue = std::min(minValue, v);
+            maxValue = std::max(maxValue, v);
+            sum += v;
+            sumSquares += v * v;
+        }
+
+        ChannelStats &cs = stats.channel[ch];
+        cs.min = minValue;
+        cs.max = maxValue;
+        cs.mean = sum / scans;
+        cs.rms = std::sqrt(sumSquares / scans);
+
+        // Slide the newest samples into the window
+        double *w = m_window[ch].data();
+        const int32_t fresh = std::min(scans, taps);
+        const int32_t kept = taps - fresh;
+        if (kept > 0) {
+            std::memmove(w, w + fresh, kept * sizeof(double));
+        }
+        const double *src = data + (scans - fresh) * channels + ch;
+        for (int32_t i = 0; i < fresh; ++i) {
+            w[kept + i] = src[i * channels];
+        }
+
+        // Decimate: one output at the end of the block
+        double acc = 0.0;
+        for (int32_t i = 0; i < taps; ++i) {
+            acc += h[i] * w[i];
+        }
+        output[ch] = acc;
+    }
+}
@@ -1,6 +1,11 @@
 #include "fsm_controller.h"
 #include <QDebug>
+#include <algorithm>
 #include <cmath>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
 
 // Error string helper function
 QString getErrorString(ErrorCode errorCode) {
@@ -16,37 +21,59 @@ QString getErrorString(ErrorCode errorCode) {
 
 FSMController::FSMController(QObject *parent)
     : QObject(parent)
-    , m_aoCtrl(nullptr)
-    , m_aiCtrl(nullptr)
+    , m_analogOut(Hardware::createAnalogOut())
+    , m_analogIn(Hardware::createBufferedAnalogIn())
+    , m_clockedOut(Hardware::createBufferedAnalogOut())
     , m_mode(ControlMode::COARSE_TRACK)
-    , m_manualX(0.0)
-    , m_manualY(0.0)
-    , m_trackX(0.0)
-    , m_trackY(0.0)
-    , m_feedbackX(0.0)
-    , m_feedbackY(0.0)
+    , m_blendFrom(ControlMode::COARSE_TRACK)
+    , m_manual(AxisPair{0.0, 0.0})
+    , m_track(AxisPair{0.0, 0.0})
+    , m_servo(AxisPair{0.0, 0.0})
+    , m_feedback(AxisPair{0.0, 0.0})
+    , m_feedbackNs(0)
+    , m_feedbackReadyNs(0)
+    , m_feedbackEventFd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+    , m_closedLoop(false)
+    , m_feedbackStats(FeedbackFilter::BlockStats())
+    , m_rawAcquisition(false)
+    , m_rawGain(0.0)
+    , m_rawOffset(0.0)
+    , m_outputContention(0)
+    , m_lastOutput{0.0, 0.0}
+    , m_lastOutputValid(false)
+    , m_outputWrites(0)
+    , m_outputSkips(0)
+    , m_outputFailures(0)
+    , m_lastOutputError(Success)
+    , m_outputLimited(0)
+    , m_clockedRequested(false)
+    , m_clockedRate(1000.0)
+    , m_outputLeadScans(2)
+    , m_scansPerCommit(1)
+    , m_clockedActive(false)
+    , m_outputUnderruns(0)
+    , m_outputSlips(0)
     , m_deviceNumber(0)
     , m_samplingRate(1000) // 1000 Hz
+    , m_sectionScans(1)    // One data ready event per scan
     , m_channelCount(2)    // X and Y channels
     , m_buffSize(1000)     // 1 second of data
     , m_scaleFactor(10.0)  // +/- 10V range
 {
+    // Default to the latest sample of each block until a filter is chosen
+    m_feedbackFilter.configure(FeedbackFilter::Config(), m_channelCount);
 }
 
 FSMController::~FSMController()
 {
     stop();
 
-    if (m_aoCtrl) {
-        m_aoCtrl->Dispose();
-        m_aoCtrl = nullptr;
-    }
+    m_clockedOut->close();
+    m_analogIn->close();
+    m_analogOut->close();
 
-    if (m_aiCtrl) {
-        m_aiCtrl->removeDataReadyHandler(OnBfdAiEvent, this);
-        m_aiCtrl->removeStoppedHandler(OnBfdAiStopped, this);
-        m_aiCtrl->Dispose();
-        m_aiCtrl = nullptr;
+    if (m_feedbackEventFd >= 0) {
+        ::close(m_feedbackEventFd);
     }
 }
 
@@ -72,9 +99,28 @@ bool FSMController::start()
 {
     QMutexLocker locker(&m_mutex);
 
+    // Size the acquisition buffers now so the callback never allocates
+    if (!allocateAcquisitionBuffers()) {
+        emit errorOccurred("Failed to allocate FSM feedback buffers");
+        return false;
+    }
+
+    // Raw counts are scaled for the value range the channels are open with
+    if (m_rawAcquisition && !m_analogIn->rawScaling(m_rawGain, m_rawOffset)) {
+        emit errorOccurred("FSM feedback channels report no raw data scaling");
+        return false;
+    }
+
+    // A clocked output synchronized to the AI conversion clock must be
+    // running before the acquisition starts that clock
+    if (m_clockedRequested && !startClockedOutput()) {
+        return false;
+    }
+
     // Start the analog input acquisition
-    ErrorCode ret = m_aiCtrl->Start();
+    ErrorCode ret = m_analogIn->start();
     if (BioFailed(ret)) {
+        stopClockedOutput();
         emit errorOccurred(QString("Failed to start FSM feedback acquisition: %1").arg(ret));
         return false;
     }
@@ -85,38 +131,36 @@ bool FSMController::start()
 
 bool FSMController::stop()
 {
-    QMutexLocker locker(&m_mutex);
-
-    // Stop the analog input acquisition
-    if (m_aiCtrl) {
-        ErrorCode ret = m_aiCtrl->Stop();
+    // Stop the analog input acquisition. Not under m_mutex: stopping waits
+    // for a data ready callback in progress, which takes the mutex itself.
+    if (m_analogIn->isOpen()) {
+        ErrorCode ret = m_analogIn->stop();
         if (BioFailed(ret)) {
             emit errorOccurred(QString("Failed to stop FSM feedback acquisition: %1").arg(ret));
             return false;
         }
     }
 
+    stopClockedOutput();
+
     emit statusChanged("FSM controller stopped");
     return true;
 }
 
 bool FSMController::reset()
 {
-    QMutexLocker locker(&m_mutex);
-    
     // Stop first
     stop();
-    
+
     // Reset all control values
-    m_manualX = 0.0;
-    m_manualY = 0.0;
-    m_trackX = 0.0;
-    m_trackY = 0.0;
-    m_feedbackX = 0.0;
-    m_feedbackY = 0.0;
-    
-    // Set outputs to zero
-    updateOutputs();
+    const AxisPair zero = {0.0, 0.0};
+    m_manual.store(zero);
+    m_track.store(zero);
+    m_feedback.store(zero);
+    m_servo.store(zero);
+
+    // Set outputs to zero now; the control loop may not be running
+    writeOutputs(true);
     
     emit statusChanged("FSM controller reset");
     return true;
@@ -124,247 +168,673 @@ bool FSMController::reset()
 
 bool FSMController::isInitialized() const
 {
-    return (m_aoCtrl != nullptr && m_aiCtrl != nullptr);
+    return m_analogOut->isOpen() && m_analogIn->isOpen();
 }
 
-void FSMController::setControlMode(ControlMode mode)
+void FSMController::setControlMode(ControlMode mode, int blendCommits)
 {
-    QMutexLocker locker(&m_mutex);
-    m_mode = mode;
-
-    // Update outputs based on new mode
-    updateOutputs();
-
-    emit statusChanged(QString("FSM mode changed to %1")
-                      .arg(mode == ControlMode::COARSE_TRACK ? "Coarse Track" :
-                           mode == ControlMode::FINE_TRACK ? "Fine Track" : "Auto Track"));
+    // Takes effect on the next output commit. A fade started while another
+    // runs starts from the pure input of the mode being left. Runs on the
+    // control thread, so it does not emit.
+    lockOutput();
+    const ControlMode previous = m_mode.exchange(mode);
+    if (previous != mode) {
+        m_blendFrom = previous;
+        m_blend.start(blendCommits);
+    }
+    m_outputMutex.unlock();
 }
 
 FSMController::ControlMode FSMController::getControlMode() const
 {
-    QMutexLocker locker(&m_mutex);
-    return m_mode;
+    return m_mode.load();
 }
 
 void FSMController::setManualInputs(double x, double y)
 {
-    QMutexLocker locker(&m_mutex);
-
     // Limit inputs to -1.0 to 1.0 range
-    m_manualX = std::max(-1.0, std::min(1.0, x));
-    m_manualY = std::max(-1.0, std::min(1.0, y));
-
-    // Update outputs based on new inputs
-    if (m_mode == ControlMode::COARSE_TRACK || m_mode == ControlMode::FINE_TRACK) {
-        updateOutputs();
-    }
+    m_manual.store(AxisPair{std::max(-1.0, std::min(1.0, x)), std::max(-1.0, std::min(1.0, y))});
 }
 
 void FSMController::setTrackingInputs(double x, double y)
 {
-    QMutexLocker locker(&m_mutex);
-
     // Limit inputs to -1.0 to 1.0 range
-    m_trackX = std::max(-1.0, std::min(1.0, x));
-    m_trackY = std::max(-1.0, std::min(1.0, y));
-
-    // Update outputs based on new inputs if in auto track mode
-    if (m_mode == ControlMode::AUTO_TRACK) {
-        updateOutputs();
-    }
+    m_track.store(AxisPair{std::max(-1.0, std::min(1.0, x)), std::max(-1.0, std::min(1.0, y))});
 }
 
 void FSMController::getCurrentPosition(double &x, double &y)
 {
-    QMutexLocker locker(&m_mutex);
-    x = m_feedbackX;
-    y = m_feedbackY;
+    const AxisPair feedback = m_feedback.load();
+    x = feedback.x;
+    y = feedback.y;
 }
 
-void FSMController::onAiDataReady(void *sender, BfdAiEventArgs *args)
+void FSMController::getSetpoint(double &x, double &y)
 {
-    // Get the data
-    int32 count = args->Count;
-    double *rawData = new double[count * m_channelCount];
+    lockOutput();
+    const AxisPair setpoint = blendedSetpoint();
+    m_outputMutex.unlock();
+    x = setpoint.x;
+    y = setpoint.y;
+}
 
-    ErrorCode ret = m_aiCtrl->GetData(count, rawData);
-    if (BioFailed(ret)) {
-        emit errorOccurred(QString("Failed to get FSM feedback data: %1").arg(ret));
-        delete[] rawData;
+void FSMController::setClosedLoop(bool enabled)
+{
+    if (m_closedLoop.load() == enabled) {
         return;
     }
 
-    // Process the data
-    processAnalogInput(rawData, count);
+    // Hand over from the current open-loop command without a step
+    if (enabled) {
+        lockOutput();
+        m_servo.store(blendedSetpoint());
+        m_outputMutex.unlock();
+    }
+
+    // Runs on the control thread; the control loop reports the switch
+    m_closedLoop.store(enabled);
+}
 
-    delete[] rawData;
+bool FSMController::isClosedLoop() const
+{
+    return m_closedLoop.load();
 }
 
-bool FSMController::setupAnalogOutput()
+void FSMController::setServoOutputs(double x, double y)
 {
-    // Create a new instance of analog output control
-    m_aoCtrl = InstantAoCtrl::Create();
-    if (!m_aoCtrl) {
-        emit errorOccurred("Failed to create Instant AO control");
+    if (!m_closedLoop.load()) {
+        return;
+    }
+
+    m_servo.store(AxisPair{std::max(-1.0, std::min(1.0, x)), std::max(-1.0, std::min(1.0, y))});
+}
+
+bool FSMController::setFeedbackFilter(const FeedbackFilter::Config &config)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_feedbackFilter.configure(config, m_channelCount)) {
+        locker.unlock();
+        emit errorOccurred("Invalid FSM feedback filter configuration");
         return false;
     }
 
-    // Set the device by enumeration
-    DeviceInformation devInfo;
-    devInfo.DeviceNumber = m_deviceNumber;
-    ErrorCode ret = m_aoCtrl->setSelectedDevice(devInfo);
-    if (BioFailed(ret)) {
-        emit errorOccurred(QString("Failed to set AO device: %1").arg(getErrorString(ret)));
+    const int taps = m_feedbackFilter.tapCount();
+    const double groupDelay = m_feedbackFilter.groupDelay();
+    locker.unlock();
+
+    emit statusChanged(QString("FSM feedback filter: %1 taps, %2 samples group delay")
+                      .arg(taps).arg(groupDelay));
+    return true;
+}
+
+void FSMController::getFeedbackStatistics(FeedbackFilter::BlockStats &stats)
+{
+    stats = m_feedbackStats.load();
+}
+
+bool FSMController::setAcquisition(int sampleRate, int sectionScans)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (sampleRate <= 0 || sectionScans < 1 || sectionScans > FSM_MAX_SECTION_SCANS) {
+        locker.unlock();
+        emit errorOccurred(QString("Invalid FSM acquisition: %1 Hz, %2 scans per section")
+                          .arg(sampleRate).arg(sectionScans));
         return false;
     }
 
-    // Check channels
-    int32 chCount = m_aoCtrl->getChannelCount();
-    if (chCount < m_channelCount) {
-        emit errorOccurred(QString("Not enough AO channels: %1 (needed: %2)").arg(chCount).arg(m_channelCount));
+    m_samplingRate = sampleRate;
+    m_sectionScans = sectionScans;
+
+    // Already initialized: reopen the stopped acquisition at the new rate
+    if (m_analogIn->isOpen()) {
+        locker.unlock();
+        if (!setupAnalogInput()) {
+            emit errorOccurred("Failed to reopen analog input for FSM feedback");
+            return false;
+        }
+    }
+    return true;
+}
+
+int FSMController::getSampleRate() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_samplingRate;
+}
+
+int FSMController::getSectionScans() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_sectionScans;
+}
+
+void FSMController::setRawAcquisition(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_rawAcquisition = enabled;
+}
+
+uint64_t FSMController::getContentionCount() const
+{
+    return m_manual.contentionCount() + m_track.contentionCount() + m_servo.contentionCount() +
+           m_feedback.contentionCount() + m_feedbackStats.contentionCount() +
+           m_outputContention.load(std::memory_order_relaxed);
+}
+
+bool FSMController::allocateAcquisitionBuffers()
+{
+    // The driver never reports more than its buffer capacity in one event
+    int32 capacity = m_analogIn->bufferCapacity();
+    if (capacity <= 0) {
+        capacity = m_buffSize * m_channelCount;
+    }
+
+    // Whole scans only
+    capacity -= capacity % m_channelCount;
+    if (capacity <= 0) {
         return false;
     }
 
-    // Set channel value ranges
-    for (int i = 0; i < m_channelCount; i++) {
-        m_aoCtrl->getChannels()->getItem(i).setValueRange(ValueRange::V_Neg10To10);
+    m_aiBuffer.assign(capacity, 0.0);
+    if (m_rawAcquisition) {
+        m_aiRawBuffer.assign(capacity, 0);
+    } else {
+        m_aiRawBuffer.clear();
+        m_aiRawBuffer.shrink_to_fit();
     }
 
     return true;
 }
 
-bool FSMController::setupAnalogInput()
+void FSMController::scaleRawSamples(int32 count)
 {
-    // Create a new instance of buffered analog input control
-    m_aiCtrl = BufferedAiCtrl::Create();
-    if (!m_aiCtrl) {
-        emit errorOccurred("Failed to create Buffered AI control");
-        return false;
+    // Offset binary counts to volts; a plain loop the compiler vectorizes
+    const int16 *raw = m_aiRawBuffer.data();
+    double *out = m_aiBuffer.data();
+    const double gain = m_rawGain;
+    const double offset = m_rawOffset;
+
+    for (int32 i = 0; i < count; ++i) {
+        out[i] = static_cast<uint16_t>(raw[i]) * gain + offset;
     }
+}
 
-    // Set the device by enumeration
-    DeviceInformation devInfo;
-    devInfo.DeviceNumber = m_deviceNumber;
-    ErrorCode ret = m_aiCtrl->setSelectedDevice(devInfo);
-    if (BioFailed(ret)) {
-        emit errorOccurred(QString("Failed to set AI device: %1").arg(getErrorString(ret)));
-        return false;
+void FSMController::onAiDataReady(int32 count)
+{
+    // count is the number of new samples across all channels. Read them
+    // into the preallocated buffer in whole-scan chunks.
+    const int32 capacity = static_cast<int32>(m_aiBuffer.size());
+    if (capacity == 0) {
+        return;
     }
 
-    // Configure the conversion clock
-    ConvertClock* convertClock = m_aiCtrl->getConvertClock();
-    ret = convertClock->setRate(m_samplingRate);
-    if (BioFailed(ret)) {
-        emit errorOccurred(QString("Failed to set AI sampling rate: %1").arg(getErrorString(ret)));
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    const int64_t readyNs = static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+
+    int32 remaining = count - count % m_channelCount;
+    while (remaining > 0) {
+        const int32 chunk = std::min(remaining, capacity);
+
+        ErrorCode ret;
+        if (m_rawAcquisition) {
+            ret = m_analogIn->readRaw(chunk, m_aiRawBuffer.data());
+            if (!BioFailed(ret)) {
+                scaleRawSamples(chunk);
+            }
+        } else {
+            ret = m_analogIn->read(chunk, m_aiBuffer.data());
+        }
+
+        if (BioFailed(ret)) {
+            emit errorOccurred(QString("Failed to get FSM feedback data: %1").arg(ret));
+            return;
+        }
+
+        // Process the data
+        processAnalogInput(m_aiBuffer.data(), chunk / m_channelCount);
+        remaining -= chunk;
+    }
+
+    // The feedback now reflects this block
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    const int64_t publishedNs = static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+    m_feedbackReadyNs.store(readyNs, std::memory_order_relaxed);
+    m_feedbackNs.store(publishedNs, std::memory_order_release);
+    m_feedbackLatency.record(publishedNs - readyNs);
+
+    // Wake a control thread running on the acquisition clock
+    if (m_feedbackEventFd >= 0) {
+        const uint64_t one = 1;
+        const ssize_t written = ::write(m_feedbackEventFd, &one, sizeof(one));
+        Q_UNUSED(written);
+    }
+}
+
+int FSMController::waitForFeedback(int timeoutMs)
+{
+    if (m_feedbackEventFd < 0) {
+        return 0;
+    }
+
+    pollfd pfd = {m_feedbackEventFd, POLLIN, 0};
+    if (poll(&pfd, 1, timeoutMs) <= 0) {
+        return 0;
+    }
+
+    // The counter holds every section published since the last read
+    uint64_t sections = 0;
+    if (::read(m_feedbackEventFd, &sections, sizeof(sections)) != sizeof(sections)) {
+        return 0;
+    }
+    return static_cast<int>(std::min<uint64_t>(sections, 1u << 30));
+}
+
+bool FSMController::setupAnalogOutput()
+{
+    std::string error;
+    if (!m_analogOut->open(m_deviceNumber, m_channelCount, error)) {
+        emit errorOccurred(QString::fromStdString(error));
         return false;
     }
 
-    // Get device name using device number
-    QString devName = QString("Device #%1").arg(m_deviceNumber);
-    emit statusChanged(QString("Using device: %1").arg(devName));
+    return true;
+}
 
-    // Set up the trigger
-    ScanChannel* scanChannel = m_aiCtrl->getScanChannel();
-    ret = scanChannel->setChannelCount(m_channelCount);
-    if (BioFailed(ret)) {
-        emit errorOccurred(QString("Failed to set AI scan channel count: %1").arg(getErrorString(ret)));
+void FSMController::setClockedOutput(bool enabled, double scanRate, int leadScans, int scansPerCommit)
+{
+    QMutexLocker locker(&m_mutex);
+    m_clockedRequested = enabled;
+    m_clockedRate = scanRate;
+    m_outputLeadScans = std::max(1, std::min(FSM_MAX_OUTPUT_LEAD, leadScans));
+    m_scansPerCommit = std::max(1, std::min(FSM_MAX_SECTION_SCANS, scansPerCommit));
+}
+
+bool FSMController::isClockedOutput() const
+{
+    return m_clockedActive.load(std::memory_order_acquire);
+}
+
+uint64_t FSMController::getOutputUnderrunCount() const
+{
+    return m_outputUnderruns.load(std::memory_order_relaxed);
+}
+
+uint64_t FSMController::getOutputSlipCount() const
+{
+    return m_outputSlips.load(std::memory_order_relaxed);
+}
+
+int64_t FSMController::getFeedbackTime() const
+{
+    return m_feedbackNs.load(std::memory_order_acquire);
+}
+
+int64_t FSMController::getFeedbackReadyTime() const
+{
+    return m_feedbackReadyNs.load(std::memory_order_relaxed);
+}
+
+LatencySummary FSMController::getFeedbackLatency() const
+{
+    return m_feedbackLatency.summary();
+}
+
+void FSMController::resetFeedbackLatency()
+{
+    m_feedbackLatency.reset();
+}
+
+int FSMController::getChannelCount() const
+{
+    return m_channelCount;
+}
+
+bool FSMController::replayAcquisition(std::unique_ptr<BufferedAnalogIn> input, bool raw)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_analogIn = std::move(input);
+    m_rawAcquisition = raw;
+    return allocateAcquisitionBuffers()
+        && (!raw || m_analogIn->rawScaling(m_rawGain, m_rawOffset));
+}
+
+void FSMController::replayDataReady(int32 count)
+{
+    onAiDataReady(count);
+}
+
+void FSMController::replayFeedback(double *data, int32 scans)
+{
+    processAnalogInput(data, scans);
+}
+
+bool FSMController::startClockedOutput()
+{
+    // Share the AI conversion clock when both run at the same rate, so the
+    // output and the feedback samples stay on one timebase
+    const bool syncToAi = (m_clockedRate == m_samplingRate);
+    const int32 bufferScans = 4 * (FSM_MAX_OUTPUT_LEAD + 1) * m_scansPerCommit;
+
+    std::string error;
+    if (!m_clockedOut->open(m_deviceNumber, m_channelCount, m_clockedRate, bufferScans, syncToAi, error)) {
+        emit errorOccurred(QString::fromStdString(error));
         return false;
     }
-    
-    // Set up the trigger
-    Trigger* trigger = m_aiCtrl->getTrigger();
-    ret = trigger->setSource(SignalNone); // Use 'None' from the library
+    m_clockedOut->setUnderrunHandler(OnAoUnderrun, this);
+
+    // Preload the lead with the current command so the first ticks do not
+    // start from an empty queue
+    const AxisPair command = currentCommand();
+    double scan[2] = {command.x * m_scaleFactor, command.y * m_scaleFactor};
+    {
+        QMutexLocker locker(&m_outputMutex);
+        const double outputs[2] = {command.x, command.y};
+        m_limiter.reset(outputs);
+    }
+    ErrorCode ret = Success;
+    for (int i = 0; i < m_outputLeadScans * m_scansPerCommit && !BioFailed(ret); i++) {
+        ret = m_clockedOut->write(1, scan);
+    }
+    if (!BioFailed(ret)) {
+        ret = m_clockedOut->start();
+    }
     if (BioFailed(ret)) {
-        emit errorOccurred(QString("Failed to set AI trigger source: %1").arg(getErrorString(ret)));
+        m_clockedOut->close();
+        emit errorOccurred(QString("Failed to start clocked FSM output: %1").arg(ret));
         return false;
     }
-    
-    ret = trigger->setAction(DelayToStart); // Use 'DelayToStart' from the library
-    if (BioFailed(ret)) {
-        emit errorOccurred(QString("Failed to set AI trigger action: %1").arg(getErrorString(ret)));
+
+    m_outputUnderruns.store(0, std::memory_order_relaxed);
+    m_outputSlips.store(0, std::memory_order_relaxed);
+    m_clockedActive.store(true, std::memory_order_release);
+
+    emit statusChanged(QString("FSM output clocked at %1 Hz (%2, %3 scans per commit, %4 commits lead)")
+                      .arg(m_clockedRate)
+                      .arg(syncToAi ? "AI conversion clock" : "internal clock")
+                      .arg(m_scansPerCommit)
+                      .arg(m_outputLeadScans));
+    return true;
+}
+
+void FSMController::stopClockedOutput()
+{
+    if (!m_clockedActive.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    m_clockedOut->stop();
+    m_clockedOut->close();
+
+    // The card holds the last converted scan, not what was last written
+    m_outputMutex.lock();
+    m_lastOutputValid = false;
+    m_outputMutex.unlock();
+
+    emit statusChanged(QString("Clocked FSM output stopped (%1 underruns, %2 slips)")
+                      .arg(m_outputUnderruns.load(std::memory_order_relaxed))
+                      .arg(m_outputSlips.load(std::memory_order_relaxed)));
+}
+
+uint64_t FSMController::getOutputWriteCount() const
+{
+    return m_outputWrites.load(std::memory_order_relaxed);
+}
+
+uint64_t FSMController::getOutputSkipCount() const
+{
+    return m_outputSkips.load(std::memory_order_relaxed);
+}
+
+uint64_t FSMController::getOutputFailureCount() const
+{
+    return m_outputFailures.load(std::memory_order_relaxed);
+}
+
+ErrorCode FSMController::getLastOutputError() const
+{
+    return m_lastOutputError.load(std::memory_order_relaxed);
+}
+
+bool FSMController::setOutputLimits(const OutputLimiter::Config &config, double commitRateHz)
+{
+    QMutexLocker locker(&m_outputMutex);
+
+    if (!m_limiter.configure(config, m_channelCount, commitRateHz)) {
+        emit errorOccurred("Invalid FSM output limits");
         return false;
     }
-    
-    ret = trigger->setDelayCount(0);
+    return true;
+}
+
+uint64_t FSMController::getOutputLimitedCount() const
+{
+    return m_outputLimited.load(std::memory_order_relaxed);
+}
+
+void FSMController::commitOutputs()
+{
+    if (m_clockedActive.load(std::memory_order_acquire)) {
+        queueClockedOutput();
+    } else {
+        writeOutputs(false);
+    }
+
+    lockOutput();
+    m_blend.advance();
+    m_outputMutex.unlock();
+}
+
+void FSMController::queueClockedOutput()
+{
+    // The control thread and the card clock drift apart slowly. Hold the
+    // queue at the lead: skip this tick when it is long, repeat the command
+    // when it is short (or after an underrun). Each commit covers
+    // m_scansPerCommit scans of the converter.
+    const int32 lead = m_outputLeadScans * m_scansPerCommit;
+    const int32 queued = m_clockedOut->queuedScans();
+    if (queued > lead) {
+        m_outputSlips.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    int32 scans = m_scansPerCommit;
+    if (queued < lead) {
+        scans = lead + m_scansPerCommit - queued;
+        m_outputSlips.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Only ticks that queue a command advance the limiter
+    lockOutput();
+    const AxisPair limited = limitCommand(currentCommand());
+    m_outputMutex.unlock();
+
+    double data[(FSM_MAX_OUTPUT_LEAD + 1) * FSM_MAX_SECTION_SCANS * 2];
+    for (int32 i = 0; i < scans; i++) {
+        data[2 * i] = limited.x * m_scaleFactor;
+        data[2 * i + 1] = limited.y * m_scaleFactor;
+    }
+
+    ErrorCode ret = m_clockedOut->write(scans, data);
+    m_outputWrites.fetch_add(1, std::memory_order_relaxed);
     if (BioFailed(ret)) {
-        emit errorOccurred(QString("Failed to set AI trigger delay: %1").arg(getErrorString(ret)));
+        m_lastOutputError.store(ret, std::memory_order_relaxed);
+        m_outputFailures.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool FSMController::setupAnalogInput()
+{
+    std::string error;
+    if (!m_analogIn->open(m_deviceNumber, m_channelCount, m_samplingRate, m_sectionScans, error)) {
+        emit errorOccurred(QString::fromStdString(error));
         return false;
     }
 
-    // Set up event handlers
-    m_aiCtrl->addDataReadyHandler(OnBfdAiEvent, this);
-    emit statusChanged("AI data ready handler registered");
-    
-    m_aiCtrl->addStoppedHandler(OnBfdAiStopped, this);
-    emit statusChanged("AI stopped handler registered");
+    emit statusChanged(QString("Using device: Device #%1").arg(m_deviceNumber));
+    emit statusChanged(QString("FSM feedback sampled at %1 Hz, %2 scans per section")
+                      .arg(m_samplingRate).arg(m_sectionScans));
 
-    // Set up the channels
-    for (int i = 0; i < m_channelCount; i++) {
-        m_aiCtrl->getChannels()->getItem(i).setValueRange(ValueRange::V_Neg10To10);
-    }
+    // Set up event handlers
+    m_analogIn->setDataReadyHandler(OnAiDataReady, this);
+    m_analogIn->setStoppedHandler(OnAiStopped, this);
 
     return true;
 }
 
-void FSMController::processAnalogInput(double *data, int32 count)
+void FSMController::processAnalogInput(double *data, int32 scans)
 {
     QMutexLocker locker(&m_mutex);
 
-    // We just process the latest sample in the buffer
-    if (count > 0) {
-        int lastIdx = (count - 1) * m_channelCount;
+    // Decimate the whole block to one filtered sample per channel
+    if (scans > 0) {
+        double filtered[FeedbackFilter::MAX_CHANNELS];
+        FeedbackFilter::BlockStats stats;
+        m_feedbackFilter.processBlock(data, scans, filtered, stats);
 
         // Scale data from voltage to normalized -1.0 to 1.0
-        m_feedbackX = data[lastIdx] / m_scaleFactor;
-        m_feedbackY = data[lastIdx + 1] / m_scaleFactor;
+        const AxisPair feedback = {filtered[0] / m_scaleFactor, filtered[1] / m_scaleFactor};
+        m_feedback.store(feedback);
+
+        for (int i = 0; i < m_channelCount; i++) {
+            FeedbackFilter::ChannelStats &cs = stats.channel[i];
+            cs.min /= m_scaleFactor;
+            cs.max /= m_scaleFactor;
+            cs.mean /= m_scaleFactor;
+            cs.rms /= m_scaleFactor;
+        }
+        m_feedbackStats.store(stats);
 
         // Emit the feedback updated signal
-        emit feedbackUpdated(m_feedbackX, m_feedbackY);
+        emit feedbackUpdated(feedback.x, feedback.y);
     }
 }
 
-void FSMController::updateOutputs()
+AxisPair FSMController::modeInput(ControlMode mode) const
 {
-    if (!m_aoCtrl) {
-        return;
+    // Manual modes follow the joystick, auto track the tracker
+    return (mode == ControlMode::AUTO_TRACK) ? m_track.load() : m_manual.load();
+}
+
+AxisPair FSMController::blendedSetpoint() const
+{
+    // With m_outputMutex held, which guards the fade
+    const AxisPair to = modeInput(m_mode.load());
+    if (!m_blend.isActive()) {
+        return to;
+    }
+
+    // Both inputs stay live while the fade runs
+    const AxisPair from = modeInput(m_blendFrom);
+    return AxisPair{m_blend.mix(from.x, to.x), m_blend.mix(from.y, to.y)};
+}
+
+AxisPair FSMController::currentCommand() const
+{
+    // Closed loop, the compensator output computed by the control loop;
+    // open loop, the input of the mode
+    if (m_closedLoop.load()) {
+        return m_servo.load();
     }
+    return blendedSetpoint();
+}
 
-    double outputs[2] = {0.0, 0.0};
+void FSMController::lockOutput()
+{
+    if (!m_outputMutex.tryLock()) {
+        m_outputContention.fetch_add(1, std::memory_order_relaxed);
+        m_outputMutex.lock();
+    }
+}
 
-    // Calculate outputs based on mode
-    switch (m_mode) {
-        case ControlMode::COARSE_TRACK:
-        case ControlMode::FINE_TRACK:
-            // In manual modes, use joystick input
-            outputs[0] = m_manualX * m_scaleFactor;
-            outputs[1] = m_manualY * m_scaleFactor;
-            break;
+AxisPair FSMController::limitCommand(const AxisPair &command)
+{
+    // With m_outputMutex held
+    double outputs[2] = {command.x, command.y};
+    if (m_limiter.apply(outputs)) {
+        m_outputLimited.fetch_add(1, std::memory_order_relaxed);
+    }
+    return AxisPair{outputs[0], outputs[1]};
+}
 
-        case ControlMode::AUTO_TRACK:
-            // In auto mode, use tracking input
-            outputs[0] = m_trackX * m_scaleFactor;
-            outputs[1] = m_trackY * m_scaleFactor;
-            break;
+bool FSMController::writeOutputs(bool force)
+{
+    // The clocked output is fed by the control thread only
+    if (!m_analogOut->isOpen() || m_clockedActive.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    // Serializes the commit with a reset from the GUI thread
+    lockOutput();
+
+    // A forced write sets the outputs outright and restarts the limiter
+    AxisPair command = currentCommand();
+    if (force) {
+        const double position[2] = {command.x, command.y};
+        m_limiter.reset(position);
+    } else {
+        command = limitCommand(command);
+    }
+    double outputs[2] = {command.x * m_scaleFactor, command.y * m_scaleFactor};
+
+    // Skip the driver call when no channel would move by a code
+    if (!force && m_lastOutputValid
+        && std::abs(outputs[0] - m_lastOutput[0]) < AO_VOLTS_PER_LSB
+        && std::abs(outputs[1] - m_lastOutput[1]) < AO_VOLTS_PER_LSB) {
+        m_outputMutex.unlock();
+        m_outputSkips.fetch_add(1, std::memory_order_relaxed);
+        return true;
     }
 
     // Write values to the AO channels
-    ErrorCode ret = m_aoCtrl->Write(0, m_channelCount, outputs);
+    ErrorCode ret = m_analogOut->write(0, m_channelCount, outputs);
+    m_lastOutputValid = !BioFailed(ret);
+    m_lastOutput[0] = outputs[0];
+    m_lastOutput[1] = outputs[1];
+    m_outputMutex.unlock();
+    m_outputWrites.fetch_add(1, std::memory_order_relaxed);
+
+    // A commit runs on the control thread, which only counts the failure;
+    // a forced write comes from the caller's thread and reports it
     if (BioFailed(ret)) {
-        emit errorOccurred(QString("Failed to write to FSM outputs: %1").arg(ret));
+        if (force) {
+            emit errorOccurred(QString("Failed to write to FSM outputs: %1").arg(getErrorString(ret)));
+        } else {
+            m_lastOutputError.store(ret, std::memory_order_relaxed);
+            m_outputFailures.fetch_add(1, std::memory_order_relaxed);
+        }
+        return false;
     }
+    return true;
 }
 
-void BDAQCALL FSMController::OnBfdAiEvent(void *sender, BfdAiEventArgs *args, void *userParam)
+void FSMController::OnAiDataReady(void *userParam, int32 count)
 {
     // Forward the callback to the instance method
     if (userParam) {
         FSMController *instance = static_cast<FSMController*>(userParam);
-        instance->onAiDataReady(sender, args);
+        instance->onAiDataReady(count);
     }
 }
 
-void BDAQCALL FSMController::OnBfdAiStopped(void *sender, BfdAiEventArgs *args, void *userParam)
+void FSMController::OnAoUnderrun(void *userParam, int32 count)
 {
+    Q_UNUSED(count);
+
+    // Called on the driver thread; just count, the stop message reports it
+    if (userParam) {
+        FSMController *instance = static_cast<FSMController*>(userParam);
+        instance->m_outputUnderruns.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void FSMController::OnAiStopped(void *userParam, int32 count)
+{
+    Q_UNUSED(count);
+
     // When the AI acquisition is stopped, notify the FSMController
     if (userParam) {
         FSMController *instance = static_cast<FSMController*>(userParam);
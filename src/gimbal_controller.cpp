@@ -4,11 +4,19 @@
 
 GimbalController::GimbalController(QObject *parent)
     : QObject(parent)
-    , m_aoCtrl(nullptr)
-    , m_azimuth(0.0)
-    , m_elevation(0.0)
-    , m_auxElevation(0.0)
+    , m_analogOut(Hardware::createAnalogOut())
+    , m_position(GimbalPosition{0.0, 0.0, 0.0})
     , m_enabled(false)
+    , m_outputContention(0)
+    , m_lastOutput{0.0, 0.0, 0.0}
+    , m_lastOutputValid(false)
+    , m_outputWrites(0)
+    , m_outputSkips(0)
+    , m_outputFailures(0)
+    , m_lastOutputError(Success)
+    , m_blendFrom{0.0, 0.0, 0.0}
+    , m_fadingOut(false)
+    , m_outputLimited(0)
     , m_deviceNumber(1)  // Assuming device 1 for PCIE-1824
     , m_scaleFactor(10.0)  // +/- 10V range
 {
@@ -17,11 +25,7 @@ GimbalController::GimbalController(QObject *parent)
 GimbalController::~GimbalController()
 {
     stop();
-
-    if (m_aoCtrl) {
-        m_aoCtrl->Dispose();
-        m_aoCtrl = nullptr;
-    }
+    m_analogOut->close();
 }
 
 bool GimbalController::initialize()
@@ -38,9 +42,8 @@ bool GimbalController::initialize()
 
 bool GimbalController::start()
 {
-    QMutexLocker locker(&m_mutex);
-    m_enabled = true;
-    updateOutputs();
+    // The first output commit sends the current position
+    m_enabled.store(true);
 
     emit statusChanged("Gimbal controller started");
     return true;
@@ -48,17 +51,11 @@ bool GimbalController::start()
 
 bool GimbalController::stop()
 {
-    QMutexLocker locker(&m_mutex);
-    m_enabled = false;
+    m_enabled.store(false);
 
     // Set all outputs to zero
-    if (m_aoCtrl) {
-        double outputs[3] = {0.0, 0.0, 0.0};
-        ErrorCode ret = m_aoCtrl->Write(0, 3, outputs);
-        if (BioFailed(ret)) {
-            emit errorOccurred(QString("Failed to zero gimbal outputs: %1").arg(getErrorString(ret)));
-            return false;
-        }
+    if (!zeroOutputs()) {
+        return false;
     }
 
     emit statusChanged("Gimbal controller stopped");
@@ -67,140 +64,265 @@ bool GimbalController::stop()
 
 bool GimbalController::reset()
 {
-    QMutexLocker locker(&m_mutex);
-    
     // Stop first
     stop();
-    
+
     // Reset all position values
-    m_azimuth = 0.0;
-    m_elevation = 0.0;
-    m_auxElevation = 0.0;
-    
+    m_position.store(GimbalPosition{0.0, 0.0, 0.0});
+
     // Set outputs to zero again to be sure
-    if (m_aoCtrl) {
-        double outputs[3] = {0.0, 0.0, 0.0};
-        ErrorCode ret = m_aoCtrl->Write(0, 3, outputs);
-        if (BioFailed(ret)) {
-            emit errorOccurred(QString("Failed to zero gimbal outputs: %1").arg(getErrorString(ret)));
-            return false;
-        }
+    if (!zeroOutputs()) {
+        return false;
     }
-    
+
     emit statusChanged("Gimbal controller reset");
     return true;
 }
 
 bool GimbalController::isInitialized() const
 {
-    return (m_aoCtrl != nullptr);
+    return m_analogOut->isOpen();
 }
 
 void GimbalController::setPosition(double azimuth, double elevation, double auxElevation)
 {
-    QMutexLocker locker(&m_mutex);
-
     // Limit inputs to -1.0 to 1.0 range
-    m_azimuth = std::max(-1.0, std::min(1.0, azimuth));
-    m_elevation = std::max(-1.0, std::min(1.0, elevation));
-    m_auxElevation = std::max(-1.0, std::min(1.0, auxElevation));
-
-    // Update outputs if enabled
-    if (m_enabled) {
-        updateOutputs();
-    }
+    m_position.store(GimbalPosition{std::max(-1.0, std::min(1.0, azimuth)),
+                                    std::max(-1.0, std::min(1.0, elevation)),
+                                    std::max(-1.0, std::min(1.0, auxElevation))});
 }
 
 void GimbalController::getCurrentPosition(double &azimuth, double &elevation, double &auxElevation)
 {
-    QMutexLocker locker(&m_mutex);
-    azimuth = m_azimuth;
-    elevation = m_elevation;
-    auxElevation = m_auxElevation;
+    const GimbalPosition position = m_position.load();
+    azimuth = position.azimuth;
+    elevation = position.elevation;
+    auxElevation = position.auxElevation;
 }
 
 void GimbalController::setEnabled(bool enabled)
 {
-    QMutexLocker locker(&m_mutex);
-
-    if (m_enabled == enabled) {
-        return;  // No change
+    if (switchEnabled(enabled)) {
+        emit statusChanged(enabled ? "Gimbal control enabled" : "Gimbal control disabled");
     }
+}
 
-    m_enabled = enabled;
+bool GimbalController::switchEnabled(bool enabled)
+{
+    // Overrides a fade in progress
+    lockOutput();
+    m_blend.stop();
+    m_fadingOut = false;
+    m_mutex.unlock();
 
-    if (m_enabled) {
-        // Update outputs with current position
-        updateOutputs();
-        emit statusChanged("Gimbal control enabled");
-    } else {
-        // Set all outputs to zero
-        if (m_aoCtrl) {
-            double outputs[3] = {0.0, 0.0, 0.0};
-            ErrorCode ret = m_aoCtrl->Write(0, 3, outputs);
-            if (BioFailed(ret)) {
-                emit errorOccurred(QString("Failed to zero gimbal outputs: %1").arg(getErrorString(ret)));
-            }
+    if (m_enabled.exchange(enabled) == enabled) {
+        return false;  // No change
+    }
+
+    // Enabled, the next output commit sends the current position; disabled,
+    // zero right away rather than waiting for a commit. A failure is counted
+    // like one of a commit.
+    if (!enabled && m_analogOut->isOpen()) {
+        double outputs[3] = {0.0, 0.0, 0.0};
+        lockOutput();
+        m_limiter.reset(outputs);
+        const ErrorCode ret = writeLocked(outputs);
+        m_mutex.unlock();
+        if (BioFailed(ret)) {
+            m_lastOutputError.store(ret, std::memory_order_relaxed);
+            m_outputFailures.fetch_add(1, std::memory_order_relaxed);
         }
-        emit statusChanged("Gimbal control disabled");
     }
+    return true;
 }
 
 bool GimbalController::isEnabled() const
 {
-    QMutexLocker locker(&m_mutex);
-    return m_enabled;
+    return m_enabled.load();
+}
+
+void GimbalController::fadeEnabled(bool enabled, int commits)
+{
+    if (commits <= 0 || !m_analogOut->isOpen()) {
+        switchEnabled(enabled);
+        return;
+    }
+
+    lockOutput();
+    const bool wasEnabled = m_enabled.load() && !m_fadingOut;
+    if (wasEnabled == enabled) {
+        m_mutex.unlock();
+        return;  // No change
+    }
+
+    // Fade from what the DACs hold now: zero when disabled
+    for (int i = 0; i < 3; i++) {
+        m_blendFrom[i] = m_lastOutputValid ? m_lastOutput[i] / m_scaleFactor : 0.0;
+    }
+    m_blend.start(commits);
+    m_fadingOut = !enabled;
+    m_enabled.store(true);
+    m_mutex.unlock();
+}
+
+uint64_t GimbalController::getContentionCount() const
+{
+    return m_position.contentionCount() + m_outputContention.load(std::memory_order_relaxed);
+}
+
+uint64_t GimbalController::getOutputWriteCount() const
+{
+    return m_outputWrites.load(std::memory_order_relaxed);
+}
+
+uint64_t GimbalController::getOutputSkipCount() const
+{
+    return m_outputSkips.load(std::memory_order_relaxed);
+}
+
+uint64_t GimbalController::getOutputFailureCount() const
+{
+    return m_outputFailures.load(std::memory_order_relaxed);
+}
+
+ErrorCode GimbalController::getLastOutputError() const
+{
+    return m_lastOutputError.load(std::memory_order_relaxed);
+}
+
+bool GimbalController::setOutputLimits(const OutputLimiter::Config &config, double commitRateHz)
+{
+    lockOutput();
+    const bool configured = m_limiter.configure(config, 3, commitRateHz);
+    m_mutex.unlock();
+
+    if (!configured) {
+        emit errorOccurred("Invalid gimbal output limits");
+    }
+    return configured;
+}
+
+uint64_t GimbalController::getOutputLimitedCount() const
+{
+    return m_outputLimited.load(std::memory_order_relaxed);
 }
 
 bool GimbalController::setupAnalogOutput()
 {
-    // Create a new instance of analog output control
-    m_aoCtrl = InstantAoCtrl::Create();
-    if (!m_aoCtrl) {
-        emit errorOccurred("Failed to create Instant AO control for gimbal");
+    // Need 3 channels for azimuth, elevation, aux elevation
+    std::string error;
+    if (!m_analogOut->open(m_deviceNumber, 3, error)) {
+        emit errorOccurred(QString("Gimbal AO: %1").arg(QString::fromStdString(error)));
         return false;
     }
 
-    // Set the device by enumeration
-    DeviceInformation devInfo;
-    devInfo.DeviceNumber = m_deviceNumber;
-    ErrorCode ret = m_aoCtrl->setSelectedDevice(devInfo);
-    if (BioFailed(ret)) {
-        emit errorOccurred(QString("Failed to set gimbal AO device: %1").arg(getErrorString(ret)));
-        return false;
+    return true;
+}
+
+void GimbalController::lockOutput()
+{
+    if (!m_mutex.tryLock()) {
+        m_outputContention.fetch_add(1, std::memory_order_relaxed);
+        m_mutex.lock();
     }
+}
 
-    // Check channels (need 3 for azimuth, elevation, aux elevation)
-    int32 chCount = m_aoCtrl->getChannelCount();
-    if (chCount < 3) {
-        emit errorOccurred(QString("Not enough gimbal AO channels: %1 (needed: 3)").arg(chCount));
-        return false;
+bool GimbalController::zeroOutputs()
+{
+    if (!m_analogOut->isOpen()) {
+        return true;
     }
 
-    // Set channel value ranges
-    for (int i = 0; i < 3; i++) {
-        m_aoCtrl->getChannels()->getItem(i).setValueRange(ValueRange::V_Neg10To10);
+    double outputs[3] = {0.0, 0.0, 0.0};
+
+    lockOutput();
+    m_limiter.reset(outputs);
+    ErrorCode ret = writeLocked(outputs);
+    m_mutex.unlock();
+
+    if (BioFailed(ret)) {
+        emit errorOccurred(QString("Failed to zero gimbal outputs: %1").arg(getErrorString(ret)));
+        return false;
     }
 
     return true;
 }
 
-void GimbalController::updateOutputs()
+void GimbalController::commitOutputs()
 {
-    if (!m_aoCtrl || !m_enabled) {
+    if (!m_analogOut->isOpen()) {
         return;
     }
 
-    // Scale normalized inputs to voltage
-    double outputs[3] = {
-        m_azimuth * m_scaleFactor,
-        m_elevation * m_scaleFactor,
-        m_auxElevation * m_scaleFactor
-    };
+    // Read the state under the output lock so a concurrent disable is not
+    // overwritten with a stale position
+    lockOutput();
 
-    // Write values to the AO channels
-    ErrorCode ret = m_aoCtrl->Write(0, 3, outputs);
-    if (BioFailed(ret)) {
-        emit errorOccurred(QString("Failed to write to gimbal outputs: %1").arg(getErrorString(ret)));
+    // A disabled gimbal is held at zero; an enabled one moves towards its
+    // command within the slew limits
+    double outputs[3] = {0.0, 0.0, 0.0};
+    if (m_enabled.load()) {
+        // Fading out, the target is zero rather than the command
+        if (!m_fadingOut) {
+            const GimbalPosition position = m_position.load();
+            outputs[0] = position.azimuth;
+            outputs[1] = position.elevation;
+            outputs[2] = position.auxElevation;
+        }
+        if (m_blend.isActive()) {
+            for (int i = 0; i < 3; i++) {
+                outputs[i] = m_blend.mix(m_blendFrom[i], outputs[i]);
+            }
+            m_blend.advance();
+        }
+        const bool limited = m_limiter.apply(outputs);
+        if (limited) {
+            m_outputLimited.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Disable once the outputs have reached zero, so it does not step
+        if (m_fadingOut && !m_blend.isActive() && !limited) {
+            m_fadingOut = false;
+            m_enabled.store(false);
+        }
+    } else {
+        m_limiter.reset(outputs);
+    }
+
+    // Scale normalized outputs to voltage
+    for (int i = 0; i < 3; i++) {
+        outputs[i] *= m_scaleFactor;
     }
-}
\ No newline at end of file
+
+    // Skip the driver call when no channel would move by a code
+    if (m_lastOutputValid
+        && std::abs(outputs[0] - m_lastOutput[0]) < AO_VOLTS_PER_LSB
+        && std::abs(outputs[1] - m_lastOutput[1]) < AO_VOLTS_PER_LSB
+        && std::abs(outputs[2] - m_lastOutput[2]) < AO_VOLTS_PER_LSB) {
+        m_mutex.unlock();
+        m_outputSkips.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        ErrorCode ret = writeLocked(outputs);
+        m_mutex.unlock();
+
+        // Counted only; the control thread does not emit
+        if (BioFailed(ret)) {
+            m_lastOutputError.store(ret, std::memory_order_relaxed);
+            m_outputFailures.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+ErrorCode GimbalController::writeLocked(double *outputs)
+{
+    // Write values to the AO channels, with m_mutex held
+    ErrorCode ret = m_analogOut->write(0, 3, outputs);
+    m_outputWrites.fetch_add(1, std::memory_order_relaxed);
+
+    m_lastOutputValid = !BioFailed(ret);
+    for (int i = 0; i < 3; i++) {
+        m_lastOutput[i] = outputs[i];
+    }
+
+    return ret;
+}
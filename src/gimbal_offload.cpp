@@ -0,0 +1,71 @@
+#include "gimbal_offload.h"
+#include <algorithm>
+#include <cmath>
+
+GimbalOffload::Config::Config()
+    : enabled(false)
+    , source(Source::FEEDBACK)
+    , crossoverHz(1.0)
+    , rateLimit(0.5)
+    , azimuthScale(0.1)
+    , elevationScale(0.1)
+    , deadband(0.0)
+{
+}
+
+GimbalOffload::GimbalOffload()
+    : m_gain(0.0)
+    , m_command{0.0, 0.0}
+    , m_rate{0.0, 0.0}
+{
+    configure(Config());
+}
+
+bool GimbalOffload::configure(const Config &config)
+{
+    if (!(config.crossoverHz > 0.0) || !(config.rateLimit > 0.0) ||
+        !std::isfinite(config.azimuthScale) || !std::isfinite(config.elevationScale) ||
+        !(config.deadband >= 0.0 && config.deadband < 1.0)) {
+        return false;
+    }
+
+    m_config = config;
+    m_gain = 2.0 * M_PI * config.crossoverHz;
+    return true;
+}
+
+void GimbalOffload::reset(double azimuth, double elevation)
+{
+    m_command[0] = azimuth;
+    m_command[1] = elevation;
+    m_rate[0] = 0.0;
+    m_rate[1] = 0.0;
+}
+
+double GimbalOffload::axisRate(double deflection, double scale) const
+{
+    // Leave small deflections to the mirror
+    double error = 0.0;
+    if (deflection > m_config.deadband) {
+        error = deflection - m_config.deadband;
+    } else if (deflection < -m_config.deadband) {
+        error = deflection + m_config.deadband;
+    }
+
+    const double rate = m_gain * scale * error;
+    return std::max(-m_config.rateLimit, std::min(m_config.rateLimit, rate));
+}
+
+void GimbalOffload::update(double fsmX, double fsmY, double dt, double &azimuth, double &elevation)
+{
+    m_rate[0] = axisRate(fsmX, m_config.azimuthScale);
+    m_rate[1] = axisRate(fsmY, m_config.elevationScale);
+
+    // At the gimbal's travel the integrator stops; the FSM keeps the rest
+    for (int i = 0; i < 2; i++) {
+        m_command[i] = std::max(-1.0, std::min(1.0, m_command[i] + m_rate[i] * dt));
+    }
+
+    azimuth = m_command[0];
+    elevation = m_command[1];
+}
@@ -0,0 +1,523 @@
+#include "hardware_advantech.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+std::string describe(const char *what, ErrorCode errorCode)
+{
+    char buffer[160];
+    snprintf(buffer, sizeof(buffer), "%s: error code 0x%X", what, static_cast<unsigned>(errorCode));
+    return std::string(buffer);
+}
+
+} // namespace
+
+AdvantechAnalogOut::AdvantechAnalogOut()
+    : m_aoCtrl(nullptr)
+{
+}
+
+AdvantechAnalogOut::~AdvantechAnalogOut()
+{
+    close();
+}
+
+bool AdvantechAnalogOut::open(int deviceNumber, int channelCount, std::string &error)
+{
+    close();
+
+    // Create a new instance of analog output control
+    m_aoCtrl = InstantAoCtrl::Create();
+    if (!m_aoCtrl) {
+        error = "Failed to create Instant AO control";
+        return false;
+    }
+
+    // Set the device by enumeration
+    DeviceInformation devInfo;
+    devInfo.DeviceNumber = deviceNumber;
+    ErrorCode ret = m_aoCtrl->setSelectedDevice(devInfo);
+    if (BioFailed(ret)) {
+        error = describe("Failed to set AO device", ret);
+        close();
+        return false;
+    }
+
+    // Check channels
+    int32 chCount = m_aoCtrl->getChannelCount();
+    if (chCount < channelCount) {
+        char buffer[96];
+        snprintf(buffer, sizeof(buffer), "Not enough AO channels: %d (needed: %d)",
+                 static_cast<int>(chCount), channelCount);
+        error = buffer;
+        close();
+        return false;
+    }
+
+    // Set channel value ranges
+    for (int i = 0; i < channelCount; i++) {
+        m_aoCtrl->getChannels()->getItem(i).setValueRange(ValueRange::V_Neg10To10);
+    }
+
+    return true;
+}
+
+void AdvantechAnalogOut::close()
+{
+    if (m_aoCtrl) {
+        m_aoCtrl->Dispose();
+        m_aoCtrl = nullptr;
+    }
+}
+
+AdvantechBufferedAnalogIn::AdvantechBufferedAnalogIn()
+    : m_aiCtrl(nullptr)
+    , m_dataReadyProc(nullptr)
+    , m_dataReadyParam(nullptr)
+    , m_stoppedProc(nullptr)
+    , m_stoppedParam(nullptr)
+{
+}
+
+AdvantechBufferedAnalogIn::~AdvantechBufferedAnalogIn()
+{
+    close();
+}
+
+bool AdvantechBufferedAnalogIn::open(int deviceNumber, int channelCount, double sampleRate,
+                                     int32 sectionScans, std::string &error)
+{
+    close();
+
+    // Create a new instance of buffered analog input control
+    m_aiCtrl = BufferedAiCtrl::Create();
+    if (!m_aiCtrl) {
+        error = "Failed to create Buffered AI control";
+        return false;
+    }
+
+    // Set the device by enumeration
+    DeviceInformation devInfo;
+    devInfo.DeviceNumber = deviceNumber;
+    ErrorCode ret = m_aiCtrl->setSelectedDevice(devInfo);
+    if (BioFailed(ret)) {
+        error = describe("Failed to set AI device", ret);
+        close();
+        return false;
+    }
+
+    // Configure the conversion clock
+    ret = m_aiCtrl->getConvertClock()->setRate(sampleRate);
+    if (BioFailed(ret)) {
+        error = describe("Failed to set AI sampling rate", ret);
+        close();
+        return false;
+    }
+
+    // Set up the scan channels. Stream continuously, raising data ready
+    // every sectionScans scans, into a ring holding about 100 ms
+    ScanChannel *scanChannel = m_aiCtrl->getScanChannel();
+    const int32 bufferScans = std::max<int32>(8 * sectionScans, static_cast<int32>(sampleRate / 10.0));
+    ret = scanChannel->setChannelCount(channelCount);
+    if (!BioFailed(ret)) {
+        ret = scanChannel->setIntervalCount(sectionScans);
+    }
+    if (!BioFailed(ret)) {
+        ret = scanChannel->setSamples(bufferScans);
+    }
+    if (!BioFailed(ret)) {
+        ret = m_aiCtrl->setStreaming(true);
+    }
+    if (BioFailed(ret)) {
+        error = describe("Failed to configure AI scan channels", ret);
+        close();
+        return false;
+    }
+
+    // Set up the trigger
+    Trigger *trigger = m_aiCtrl->getTrigger();
+    ret = trigger->setSource(SignalNone);
+    if (!BioFailed(ret)) {
+        ret = trigger->setAction(DelayToStart);
+    }
+    if (!BioFailed(ret)) {
+        ret = trigger->setDelayCount(0);
+    }
+    if (BioFailed(ret)) {
+        error = describe("Failed to configure AI trigger", ret);
+        close();
+        return false;
+    }
+
+    // Set up event handlers
+    m_aiCtrl->addDataReadyHandler(OnBfdAiEvent, this);
+    m_aiCtrl->addStoppedHandler(OnBfdAiStopped, this);
+
+    // Set up the channels
+    for (int i = 0; i < channelCount; i++) {
+        m_aiCtrl->getChannels()->getItem(i).setValueRange(ValueRange::V_Neg10To10);
+    }
+
+    return true;
+}
+
+void AdvantechBufferedAnalogIn::close()
+{
+    if (m_aiCtrl) {
+        m_aiCtrl->removeDataReadyHandler(OnBfdAiEvent, this);
+        m_aiCtrl->removeStoppedHandler(OnBfdAiStopped, this);
+        m_aiCtrl->Dispose();
+        m_aiCtrl = nullptr;
+    }
+}
+
+void AdvantechBufferedAnalogIn::setDataReadyHandler(EventProc proc, void *userParam)
+{
+    m_dataReadyProc = proc;
+    m_dataReadyParam = userParam;
+}
+
+void AdvantechBufferedAnalogIn::setStoppedHandler(EventProc proc, void *userParam)
+{
+    m_stoppedProc = proc;
+    m_stoppedParam = userParam;
+}
+
+bool AdvantechBufferedAnalogIn::rawScaling(double &voltsPerCount, double &voltsAtZero)
+{
+    if (!m_aiCtrl) {
+        return false;
+    }
+
+    // All channels are opened with the same value range
+    MathInterval range;
+    ValueUnit unit;
+    const ValueRange valueRange = m_aiCtrl->getChannels()->getItem(0).getValueRange();
+    if (BioFailed(AdxGetValueRangeInformation(valueRange, 0, nullptr, &range, &unit))) {
+        return false;
+    }
+
+    double unitVolts;
+    switch (unit) {
+        case Kilovolt:   unitVolts = 1e3;  break;
+        case Volt:       unitVolts = 1.0;  break;
+        case Millivolt:  unitVolts = 1e-3; break;
+        case Microvolt:  unitVolts = 1e-6; break;
+        default:
+            return false;
+    }
+
+    // The counts span the range in 2^resolution steps
+    const int32 resolution = m_aiCtrl->getFeatures()->getResolution();
+    if (resolution <= 0 || resolution > 16) {
+        return false;
+    }
+    voltsPerCount = (range.Max - range.Min) * unitVolts / static_cast<double>(1 << resolution);
+    voltsAtZero = range.Min * unitVolts;
+    return true;
+}
+
+void BDAQCALL AdvantechBufferedAnalogIn::OnBfdAiEvent(void *sender, BfdAiEventArgs *args, void *userParam)
+{
+    (void)sender;
+    AdvantechBufferedAnalogIn *instance = static_cast<AdvantechBufferedAnalogIn *>(userParam);
+    if (instance && instance->m_dataReadyProc) {
+        instance->m_dataReadyProc(instance->m_dataReadyParam, args->Count);
+    }
+}
+
+void BDAQCALL AdvantechBufferedAnalogIn::OnBfdAiStopped(void *sender, BfdAiEventArgs *args, void *userParam)
+{
+    (void)sender;
+    AdvantechBufferedAnalogIn *instance = static_cast<AdvantechBufferedAnalogIn *>(userParam);
+    if (instance && instance->m_stoppedProc) {
+        instance->m_stoppedProc(instance->m_stoppedParam, args->Count);
+    }
+}
+
+AdvantechBufferedAnalogOut::AdvantechBufferedAnalogOut()
+    : m_aoCtrl(nullptr)
+    , m_channelCount(0)
+    , m_bufferScans(0)
+    , m_underrunProc(nullptr)
+    , m_underrunParam(nullptr)
+{
+}
+
+AdvantechBufferedAnalogOut::~AdvantechBufferedAnalogOut()
+{
+    close();
+}
+
+bool AdvantechBufferedAnalogOut::open(int deviceNumber, int channelCount, double scanRate,
+                                      int32 bufferScans, bool syncToAi, std::string &error)
+{
+    close();
+
+    // Create a new instance of buffered analog output control
+    m_aoCtrl = BufferedAoCtrl::Create();
+    if (!m_aoCtrl) {
+        error = "Failed to create Buffered AO control";
+        return false;
+    }
+
+    // Set the device by enumeration
+    DeviceInformation devInfo;
+    devInfo.DeviceNumber = deviceNumber;
+    ErrorCode ret = m_aoCtrl->setSelectedDevice(devInfo);
+    if (BioFailed(ret)) {
+        error = describe("Failed to set buffered AO device", ret);
+        close();
+        return false;
+    }
+
+    // Set up the scan channels and the ring size
+    ScanChannel *scanChannel = m_aoCtrl->getScanChannel();
+    ret = scanChannel->setChannelStart(0);
+    if (!BioFailed(ret)) {
+        ret = scanChannel->setChannelCount(channelCount);
+    }
+    if (!BioFailed(ret)) {
+        ret = scanChannel->setSamples(bufferScans);
+    }
+    if (!BioFailed(ret)) {
+        ret = scanChannel->setIntervalCount(1);
+    }
+    if (BioFailed(ret)) {
+        error = describe("Failed to configure buffered AO channels", ret);
+        close();
+        return false;
+    }
+
+    // Configure the conversion clock, either shared with the AI or internal
+    ConvertClock *clock = m_aoCtrl->getConvertClock();
+    ret = clock->setSource(syncToAi ? SigAiConvClock : SigInternalClock);
+    if (!BioFailed(ret)) {
+        ret = clock->setRate(scanRate);
+    }
+    if (BioFailed(ret)) {
+        error = describe("Failed to configure buffered AO clock", ret);
+        close();
+        return false;
+    }
+
+    // Set channel value ranges
+    for (int i = 0; i < channelCount; i++) {
+        m_aoCtrl->getChannels()->getItem(i).setValueRange(ValueRange::V_Neg10To10);
+    }
+
+    ret = m_aoCtrl->setStreaming(true);
+    if (!BioFailed(ret)) {
+        ret = m_aoCtrl->Prepare();
+    }
+    if (BioFailed(ret)) {
+        error = describe("Failed to prepare buffered AO", ret);
+        close();
+        return false;
+    }
+
+    m_aoCtrl->addUnderrunHandler(OnBfdAoUnderrun, this);
+
+    m_channelCount = channelCount;
+    m_bufferScans = bufferScans;
+    return true;
+}
+
+void AdvantechBufferedAnalogOut::close()
+{
+    if (m_aoCtrl) {
+        m_aoCtrl->removeUnderrunHandler(OnBfdAoUnderrun, this);
+        m_aoCtrl->Dispose();
+        m_aoCtrl = nullptr;
+    }
+}
+
+void AdvantechBufferedAnalogOut::setUnderrunHandler(EventProc proc, void *userParam)
+{
+    m_underrunProc = proc;
+    m_underrunParam = userParam;
+}
+
+ErrorCode AdvantechBufferedAnalogOut::write(int32 scans, double *volts)
+{
+    return m_aoCtrl->SetData(scans * m_channelCount, volts);
+}
+
+int32 AdvantechBufferedAnalogOut::queuedScans()
+{
+    // The driver reports the blank (writable) part of the ring
+    int32 blank = 0;
+    int32 offset = 0;
+    if (!m_aoCtrl->GetBufferStatus(&blank, &offset)) {
+        return 0;
+    }
+    return m_bufferScans - blank / m_channelCount;
+}
+
+void BDAQCALL AdvantechBufferedAnalogOut::OnBfdAoUnderrun(void *sender, BfdAoEventArgs *args, void *userParam)
+{
+    (void)sender;
+    AdvantechBufferedAnalogOut *instance = static_cast<AdvantechBufferedAnalogOut *>(userParam);
+    if (instance && instance->m_underrunProc) {
+        instance->m_underrunProc(instance->m_underrunParam, args->Count);
+    }
+}
+
+PciTrackerSource::PciTrackerSource()
+    : m_fd(-1)
+    , m_uioFd(-1)
+    , m_mappedMem(nullptr)
+    , m_memSize(0)
+{
+}
+
+PciTrackerSource::~PciTrackerSource()
+{
+    close();
+}
+
+bool PciTrackerSource::configurePCIDevice(const TrackerLocation &location, std::string &error)
+{
+    // Enable memory space and bus mastering on the card
+    char cmd[96];
+    snprintf(cmd, sizeof(cmd), "setpci -s %02x:%02x.%x 04.w=0142",
+             location.pciBus, location.pciSlot, location.pciFunc);
+
+    int result = system(cmd);
+    if (result != 0) {
+        error = std::string("Failed to execute setpci command: ") + cmd;
+        return false;
+    }
+
+    return true;
+}
+
+bool PciTrackerSource::open(const TrackerLocation &location, std::string &error)
+{
+    close();
+
+    // First configure the PCI device
+    if (!configurePCIDevice(location, error)) {
+        return false;
+    }
+
+    // Open /dev/mem for physical memory access
+    m_fd = ::open("/dev/mem", O_RDWR | O_SYNC);
+    if (m_fd == -1) {
+        error = "Failed to open /dev/mem";
+        return false;
+    }
+
+    // Map the physical memory
+    m_mappedMem = mmap(nullptr, location.memSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd,
+                       static_cast<off_t>(location.baseAddress));
+    if (m_mappedMem == MAP_FAILED) {
+        error = "Failed to map physical memory for tracker card";
+        m_mappedMem = nullptr;
+        ::close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+
+    m_memSize = location.memSize;
+
+    if (!location.interruptDevice.empty() && !openInterrupt(location.interruptDevice, error)) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool PciTrackerSource::openInterrupt(const std::string &device, std::string &error)
+{
+    // Only a UIO node is written to, never a file or a link to one
+    const std::string uioPrefix = "/dev/uio";
+    if (device.size() <= uioPrefix.size() || device.compare(0, uioPrefix.size(), uioPrefix) != 0 ||
+        device.find_first_not_of("0123456789", uioPrefix.size()) != std::string::npos) {
+        error = "Tracker interrupt device is not a /dev/uio<n> node: " + device;
+        return false;
+    }
+
+    m_uioFd = ::open(device.c_str(), O_RDWR | O_NOFOLLOW | O_CLOEXEC);
+    if (m_uioFd == -1) {
+        error = "Failed to open tracker interrupt device " + device;
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(m_uioFd, &info) != 0 || !S_ISCHR(info.st_mode)) {
+        error = "Tracker interrupt device is not a character device: " + device;
+        ::close(m_uioFd);
+        m_uioFd = -1;
+        return false;
+    }
+
+    // Unmask the interrupt (uio_pci_generic masks it after every event)
+    int32_t enable = 1;
+    if (::write(m_uioFd, &enable, sizeof(enable)) != static_cast<ssize_t>(sizeof(enable))) {
+        error = "Failed to enable tracker interrupt on " + device;
+        ::close(m_uioFd);
+        m_uioFd = -1;
+        return false;
+    }
+
+    return true;
+}
+
+int PciTrackerSource::waitForInterrupt(int timeoutMs)
+{
+    if (m_uioFd == -1) {
+        return -1;
+    }
+
+    pollfd pfd;
+    pfd.fd = m_uioFd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    int ret = poll(&pfd, 1, timeoutMs);
+    if (ret <= 0) {
+        return ret;
+    }
+
+    // Consume the event count and unmask for the next one
+    uint32_t events;
+    if (::read(m_uioFd, &events, sizeof(events)) != static_cast<ssize_t>(sizeof(events))) {
+        return -1;
+    }
+
+    int32_t enable = 1;
+    if (::write(m_uioFd, &enable, sizeof(enable)) != static_cast<ssize_t>(sizeof(enable))) {
+        return -1;
+    }
+
+    return 1;
+}
+
+void PciTrackerSource::close()
+{
+    if (m_uioFd != -1) {
+        ::close(m_uioFd);
+        m_uioFd = -1;
+    }
+
+    if (m_mappedMem != nullptr) {
+        munmap(m_mappedMem, m_memSize);
+        m_mappedMem = nullptr;
+    }
+
+    if (m_fd != -1) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+
+    m_memSize = 0;
+}
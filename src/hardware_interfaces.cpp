@@ -0,0 +1,56 @@
+#include "hardware_interfaces.h"
+#include "hardware_advantech.h"
+#include "hardware_simulated.h"
+#include <atomic>
+
+namespace {
+
+std::atomic<Hardware::Backend> g_backend(Hardware::Backend::ADVANTECH);
+
+} // namespace
+
+namespace Hardware {
+
+void setBackend(Backend backend)
+{
+    g_backend.store(backend, std::memory_order_relaxed);
+}
+
+Backend backend()
+{
+    return g_backend.load(std::memory_order_relaxed);
+}
+
+std::unique_ptr<AnalogOut> createAnalogOut()
+{
+    if (backend() == Backend::SIMULATED) {
+        return std::unique_ptr<AnalogOut>(new SimulatedAnalogOut());
+    }
+    return std::unique_ptr<AnalogOut>(new AdvantechAnalogOut());
+}
+
+std::unique_ptr<BufferedAnalogIn> createBufferedAnalogIn()
+{
+    if (backend() == Backend::SIMULATED) {
+        return std::unique_ptr<BufferedAnalogIn>(new SimulatedBufferedAnalogIn());
+    }
+    return std::unique_ptr<BufferedAnalogIn>(new AdvantechBufferedAnalogIn());
+}
+
+std::unique_ptr<BufferedAnalogOut> createBufferedAnalogOut()
+{
+    if (backend() == Backend::SIMULATED) {
+        return std::unique_ptr<BufferedAnalogOut>(new SimulatedBufferedAnalogOut());
+    }
+    return std::unique_ptr<BufferedAnalogOut>(new AdvantechBufferedAnalogOut());
+}
+
+std::unique_ptr<TrackerSource> createTrackerSource()
+{
+    if (backend() == Backend::SIMULATED) {
+        return std::unique_ptr<TrackerSource>(new SimulatedTrackerSource());
+    }
+    return std::unique_ptr<TrackerSource>(new PciTrackerSource());
+}
+
+} // namespace Hardware
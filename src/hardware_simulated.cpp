@@ -0,0 +1,685 @@
+#include "hardware_simulated.h"
+#include "tracker_registers.h"
+#include "tracker_status.h"
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+const int64_t NSEC_PER_SEC = 1000000000LL;
+
+std::mutex g_configMutex;
+SimulationConfig g_config;
+
+std::atomic<double> g_analogOut[SIM_MAX_DEVICES][SIM_MAX_CHANNELS];
+
+inline int64_t monotonicNs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+inline void sleepUntil(int64_t ns)
+{
+    timespec wake;
+    wake.tv_sec = static_cast<time_t>(ns / NSEC_PER_SEC);
+    wake.tv_nsec = static_cast<long>(ns % NSEC_PER_SEC);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, nullptr) == EINTR) {
+    }
+}
+
+} // namespace
+
+namespace Simulation {
+
+void setConfig(const SimulationConfig &config)
+{
+    std::lock_guard<std::mutex> lock(g_configMutex);
+    g_config = config;
+}
+
+SimulationConfig config()
+{
+    std::lock_guard<std::mutex> lock(g_configMutex);
+    return g_config;
+}
+
+double analogOut(int device, int channel)
+{
+    if (device < 0 || device >= SIM_MAX_DEVICES || channel < 0 || channel >= SIM_MAX_CHANNELS) {
+        return 0.0;
+    }
+    return g_analogOut[device][channel].load(std::memory_order_relaxed);
+}
+
+void setAnalogOut(int device, int channel, double volts)
+{
+    if (device < 0 || device >= SIM_MAX_DEVICES || channel < 0 || channel >= SIM_MAX_CHANNELS) {
+        return;
+    }
+    g_analogOut[device][channel].store(volts, std::memory_order_relaxed);
+}
+
+} // namespace Simulation
+
+SimulatedAnalogOut::SimulatedAnalogOut()
+    : m_deviceNumber(-1)
+    , m_channelCount(0)
+{
+}
+
+SimulatedAnalogOut::~SimulatedAnalogOut()
+{
+    close();
+}
+
+bool SimulatedAnalogOut::open(int deviceNumber, int channelCount, std::string &error)
+{
+    if (deviceNumber < 0 || deviceNumber >= SIM_MAX_DEVICES) {
+        error = "Simulated AO device does not exist";
+        return false;
+    }
+
+    if (channelCount <= 0 || channelCount > SIM_MAX_CHANNELS) {
+        error = "Not enough simulated AO channels";
+        return false;
+    }
+
+    m_deviceNumber = deviceNumber;
+    m_channelCount = channelCount;
+    return true;
+}
+
+void SimulatedAnalogOut::close()
+{
+    m_deviceNumber = -1;
+    m_channelCount = 0;
+}
+
+ErrorCode SimulatedAnalogOut::write(int32 startChannel, int32 count, double *volts)
+{
+    if (m_deviceNumber < 0) {
+        return ErrorFuncNotInited;
+    }
+
+    if (startChannel < 0 || count < 0 || startChannel + count > m_channelCount) {
+        return ErrorParamOutOfRange;
+    }
+
+    // Same output range as the V_Neg10To10 setting on the cards
+    for (int32 i = 0; i < count; i++) {
+        Simulation::setAnalogOut(m_deviceNumber, startChannel + i, std::max(-10.0, std::min(10.0, volts[i])));
+    }
+
+    return Success;
+}
+
+SimulatedBufferedAnalogIn::SimulatedBufferedAnalogIn()
+    : m_deviceNumber(-1)
+    , m_channelCount(0)
+    , m_sampleRate(0.0)
+    , m_sectionScans(0)
+    , m_substeps(1)
+    , m_sectionCount(0)
+    , m_readPos(0)
+    , m_running(false)
+    , m_dataReadyProc(nullptr)
+    , m_dataReadyParam(nullptr)
+    , m_stoppedProc(nullptr)
+    , m_stoppedParam(nullptr)
+{
+}
+
+SimulatedBufferedAnalogIn::~SimulatedBufferedAnalogIn()
+{
+    close();
+}
+
+bool SimulatedBufferedAnalogIn::open(int deviceNumber, int channelCount, double sampleRate,
+                                     int32 sectionScans, std::string &error)
+{
+    close();
+
+    if (deviceNumber < 0 || deviceNumber >= SIM_MAX_DEVICES) {
+        error = "Simulated AI device does not exist";
+        return false;
+    }
+
+    if (channelCount <= 0 || channelCount > SIM_MAX_CHANNELS || sampleRate <= 0.0 || sectionScans <= 0) {
+        error = "Invalid simulated AI configuration";
+        return false;
+    }
+
+    m_config = Simulation::config();
+    m_deviceNumber = deviceNumber;
+    m_channelCount = channelCount;
+    m_sampleRate = sampleRate;
+
+    m_sectionScans = sectionScans;
+    m_section.assign(static_cast<size_t>(m_sectionScans) * channelCount, 0.0);
+
+    // Keep the explicit integration step well below the plant period
+    const double dt = 1.0 / sampleRate;
+    m_substeps = std::max(1, static_cast<int>(std::ceil(20.0 * m_config.plantNaturalHz * dt)));
+
+    return true;
+}
+
+void SimulatedBufferedAnalogIn::close()
+{
+    stop();
+    m_deviceNumber = -1;
+    m_section.clear();
+}
+
+void SimulatedBufferedAnalogIn::setDataReadyHandler(EventProc proc, void *userParam)
+{
+    m_dataReadyProc = proc;
+    m_dataReadyParam = userParam;
+}
+
+void SimulatedBufferedAnalogIn::setStoppedHandler(EventProc proc, void *userParam)
+{
+    m_stoppedProc = proc;
+    m_stoppedParam = userParam;
+}
+
+ErrorCode SimulatedBufferedAnalogIn::start()
+{
+    if (m_deviceNumber < 0) {
+        return ErrorFuncNotInited;
+    }
+
+    if (m_running.load(std::memory_order_acquire)) {
+        return ErrorFuncBusy;
+    }
+
+    // Restart from rest with the same noise sequence every time
+    m_axes.assign(m_channelCount, AxisState{0.0, 0.0});
+    m_rng.seed(m_config.seed + static_cast<uint32_t>(m_deviceNumber));
+    m_noise = std::normal_distribution<double>(0.0, m_config.noiseVolts);
+    m_sectionCount = 0;
+    m_readPos = 0;
+
+    m_running.store(true, std::memory_order_release);
+    m_thread = std::thread(&SimulatedBufferedAnalogIn::run, this);
+    return Success;
+}
+
+ErrorCode SimulatedBufferedAnalogIn::stop()
+{
+    if (!m_running.exchange(false)) {
+        return Success;
+    }
+
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    if (m_stoppedProc) {
+        m_stoppedProc(m_stoppedParam, 0);
+    }
+
+    return Success;
+}
+
+ErrorCode SimulatedBufferedAnalogIn::read(int32 count, double *volts)
+{
+    std::lock_guard<std::mutex> lock(m_sectionMutex);
+
+    if (count < 0 || count > m_sectionCount - m_readPos) {
+        return ErrorParamOutOfRange;
+    }
+
+    std::memcpy(volts, m_section.data() + m_readPos, sizeof(double) * count);
+    m_readPos += count;
+    return Success;
+}
+
+ErrorCode SimulatedBufferedAnalogIn::readRaw(int32 count, int16 *raw)
+{
+    std::lock_guard<std::mutex> lock(m_sectionMutex);
+
+    if (count < 0 || count > m_sectionCount - m_readPos) {
+        return ErrorParamOutOfRange;
+    }
+
+    // 16-bit offset binary over +/- 10V, like the PCIE-1816
+    const double *volts = m_section.data() + m_readPos;
+    for (int32 i = 0; i < count; i++) {
+        double code = std::floor((volts[i] + 10.0) * (65536.0 / 20.0));
+        code = std::max(0.0, std::min(65535.0, code));
+        raw[i] = static_cast<int16>(static_cast<uint16_t>(code));
+    }
+    m_readPos += count;
+    return Success;
+}
+
+bool SimulatedBufferedAnalogIn::rawScaling(double &voltsPerCount, double &voltsAtZero)
+{
+    if (m_deviceNumber < 0) {
+        return false;
+    }
+
+    // Inverse of readRaw()
+    voltsPerCount = 20.0 / 65536.0;
+    voltsAtZero = -10.0;
+    return true;
+}
+
+void SimulatedBufferedAnalogIn::generateSection()
+{
+    const double wn = 2.0 * M_PI * m_config.plantNaturalHz;
+    const double zeta = m_config.plantDamping;
+    const double h = 1.0 / (m_sampleRate * m_substeps);
+
+    std::lock_guard<std::mutex> lock(m_sectionMutex);
+
+    double *out = m_section.data();
+    for (int32 scan = 0; scan < m_sectionScans; scan++) {
+        for (int ch = 0; ch < m_channelCount; ch++) {
+            AxisState &axis = m_axes[ch];
+            const double u = m_config.plantGain * Simulation::analogOut(m_deviceNumber, ch);
+
+            // Semi-implicit Euler on x'' = wn^2 (u - x) - 2 zeta wn x'
+            for (int i = 0; i < m_substeps; i++) {
+                const double accel = wn * wn * (u - axis.position) - 2.0 * zeta * wn * axis.velocity;
+                axis.velocity += accel * h;
+                axis.position += axis.velocity * h;
+            }
+
+            const double sample = axis.position + m_noise(m_rng);
+            *out++ = std::max(-10.0, std::min(10.0, sample));
+        }
+    }
+
+    m_sectionCount = m_sectionScans * m_channelCount;
+    m_readPos = 0;
+}
+
+void SimulatedBufferedAnalogIn::run()
+{
+    const int64_t periodNs = static_cast<int64_t>(1e9 * m_sectionScans / m_sampleRate);
+    int64_t nextWake = monotonicNs();
+
+    while (m_running.load(std::memory_order_acquire)) {
+        nextWake += periodNs;
+        sleepUntil(nextWake);
+
+        if (!m_running.load(std::memory_order_acquire)) {
+            break;
+        }
+
+        generateSection();
+
+        if (m_dataReadyProc) {
+            m_dataReadyProc(m_dataReadyParam, m_sectionScans * m_channelCount);
+        }
+    }
+}
+
+SimulatedBufferedAnalogOut::SimulatedBufferedAnalogOut()
+    : m_deviceNumber(-1)
+    , m_channelCount(0)
+    , m_scanRate(0.0)
+    , m_bufferScans(0)
+    , m_head(0)
+    , m_tail(0)
+    , m_running(false)
+    , m_underrunProc(nullptr)
+    , m_underrunParam(nullptr)
+{
+}
+
+SimulatedBufferedAnalogOut::~SimulatedBufferedAnalogOut()
+{
+    close();
+}
+
+bool SimulatedBufferedAnalogOut::open(int deviceNumber, int channelCount, double scanRate,
+                                      int32 bufferScans, bool syncToAi, std::string &error)
+{
+    (void)syncToAi;
+    close();
+
+    if (deviceNumber < 0 || deviceNumber >= SIM_MAX_DEVICES) {
+        error = "Simulated buffered AO device does not exist";
+        return false;
+    }
+
+    if (channelCount <= 0 || channelCount > SIM_MAX_CHANNELS) {
+        error = "Not enough simulated buffered AO channels";
+        return false;
+    }
+
+    if (scanRate <= 0.0 || bufferScans <= 0) {
+        error = "Invalid simulated buffered AO rate or buffer size";
+        return false;
+    }
+
+    m_deviceNumber = deviceNumber;
+    m_channelCount = channelCount;
+    m_scanRate = scanRate;
+    m_bufferScans = bufferScans;
+    m_ring.assign(static_cast<size_t>(bufferScans) * channelCount, 0.0);
+    m_head = 0;
+    m_tail = 0;
+    return true;
+}
+
+void SimulatedBufferedAnalogOut::close()
+{
+    stop();
+    m_deviceNumber = -1;
+    m_channelCount = 0;
+}
+
+void SimulatedBufferedAnalogOut::setUnderrunHandler(EventProc proc, void *userParam)
+{
+    m_underrunProc = proc;
+    m_underrunParam = userParam;
+}
+
+ErrorCode SimulatedBufferedAnalogOut::write(int32 scans, double *volts)
+{
+    if (m_deviceNumber < 0) {
+        return ErrorFuncNotInited;
+    }
+
+    std::lock_guard<std::mutex> lock(m_ringMutex);
+
+    if (scans < 0 || m_head - m_tail + scans > m_bufferScans) {
+        return ErrorFuncBusy;
+    }
+
+    for (int32 i = 0; i < scans; i++) {
+        double *slot = m_ring.data() + (m_head % m_bufferScans) * m_channelCount;
+        for (int ch = 0; ch < m_channelCount; ch++) {
+            slot[ch] = std::max(-10.0, std::min(10.0, *volts++));
+        }
+        m_head++;
+    }
+    return Success;
+}
+
+int32 SimulatedBufferedAnalogOut::queuedScans()
+{
+    std::lock_guard<std::mutex> lock(m_ringMutex);
+    return static_cast<int32>(m_head - m_tail);
+}
+
+ErrorCode SimulatedBufferedAnalogOut::start()
+{
+    if (m_deviceNumber < 0) {
+        return ErrorFuncNotInited;
+    }
+
+    if (m_running.load(std::memory_order_acquire)) {
+        return ErrorFuncBusy;
+    }
+
+    m_running.store(true, std::memory_order_release);
+    m_thread = std::thread(&SimulatedBufferedAnalogOut::run, this);
+    return Success;
+}
+
+ErrorCode SimulatedBufferedAnalogOut::stop()
+{
+    if (!m_running.exchange(false)) {
+        return Success;
+    }
+
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    // Drop what was not converted, like BufferedAoCtrl::Stop(0)
+    std::lock_guard<std::mutex> lock(m_ringMutex);
+    m_tail = m_head;
+    return Success;
+}
+
+void SimulatedBufferedAnalogOut::run()
+{
+    const int64_t periodNs = static_cast<int64_t>(1e9 / m_scanRate);
+    int64_t nextWake = monotonicNs();
+
+    while (m_running.load(std::memory_order_acquire)) {
+        nextWake += periodNs;
+        sleepUntil(nextWake);
+
+        bool underrun = false;
+        {
+            std::lock_guard<std::mutex> lock(m_ringMutex);
+            if (m_tail < m_head) {
+                const double *slot = m_ring.data() + (m_tail % m_bufferScans) * m_channelCount;
+                for (int ch = 0; ch < m_channelCount; ch++) {
+                    Simulation::setAnalogOut(m_deviceNumber, ch, slot[ch]);
+                }
+                m_tail++;
+            } else {
+                // Nothing queued: the outputs hold their last value
+                underrun = true;
+            }
+        }
+
+        if (underrun && m_underrunProc) {
+            m_underrunProc(m_underrunParam, 0);
+        }
+    }
+}
+
+SimulatedTrackerSource::SimulatedTrackerSource()
+    : m_fd(-1)
+    , m_eventFd(-1)
+    , m_mappedMem(nullptr)
+    , m_memSize(0)
+    , m_running(false)
+{
+}
+
+SimulatedTrackerSource::~SimulatedTrackerSource()
+{
+    close();
+}
+
+bool SimulatedTrackerSource::open(const TrackerLocation &location, std::string &error)
+{
+    close();
+
+    if (location.memSize < STATUS_MESSAGE_OFFSET + STATUS_MESSAGE_WORDS * sizeof(uint16_t)) {
+        error = "Simulated tracker memory window too small";
+        return false;
+    }
+
+    m_config = Simulation::config();
+
+    // Created exclusively: another run, or an object of another user, is
+    // never shared or unlinked. Only a leftover of a dead process that had
+    // this pid is replaced.
+    m_shmName = std::string(m_config.trackerShmName) + "-" + std::to_string(getpid());
+    shm_unlink(m_shmName.c_str());
+    m_fd = shm_open(m_shmName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (m_fd == -1) {
+        error = "Failed to create tracker shm object " + m_shmName + ": " + strerror(errno);
+        return false;
+    }
+
+    if (ftruncate(m_fd, static_cast<off_t>(location.memSize)) != 0) {
+        error = std::string("Failed to size tracker shm object: ") + strerror(errno);
+        close();
+        return false;
+    }
+
+    m_mappedMem = mmap(nullptr, location.memSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (m_mappedMem == MAP_FAILED) {
+        error = "Failed to map tracker shm object";
+        m_mappedMem = nullptr;
+        close();
+        return false;
+    }
+
+    m_memSize = location.memSize;
+    std::memset(m_mappedMem, 0, m_memSize);
+
+    m_eventFd = eventfd(0, EFD_CLOEXEC);
+    if (m_eventFd == -1) {
+        error = std::string("Failed to create tracker eventfd: ") + strerror(errno);
+        close();
+        return false;
+    }
+
+    m_rng.seed(m_config.seed ^ 0x7007u);
+    m_noise = std::normal_distribution<double>(0.0, m_config.trackerNoise);
+
+    m_running.store(true, std::memory_order_release);
+    m_thread = std::thread(&SimulatedTrackerSource::run, this);
+    return true;
+}
+
+void SimulatedTrackerSource::close()
+{
+    if (m_running.exchange(false) && m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    if (m_eventFd != -1) {
+        ::close(m_eventFd);
+        m_eventFd = -1;
+    }
+
+    if (m_mappedMem != nullptr) {
+        munmap(m_mappedMem, m_memSize);
+        m_mappedMem = nullptr;
+    }
+
+    if (m_fd != -1) {
+        ::close(m_fd);
+        m_fd = -1;
+        shm_unlink(m_shmName.c_str());
+    }
+
+    m_memSize = 0;
+}
+
+int SimulatedTrackerSource::waitForInterrupt(int timeoutMs)
+{
+    if (m_eventFd == -1) {
+        return -1;
+    }
+
+    pollfd pfd;
+    pfd.fd = m_eventFd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    int ret = poll(&pfd, 1, timeoutMs);
+    if (ret <= 0) {
+        return ret;
+    }
+
+    uint64_t events;
+    if (::read(m_eventFd, &events, sizeof(events)) != static_cast<ssize_t>(sizeof(events))) {
+        return -1;
+    }
+
+    return 1;
+}
+
+uint16_t SimulatedTrackerSource::readWord(size_t offset) const
+{
+    return *reinterpret_cast<volatile uint16_t *>(static_cast<char *>(m_mappedMem) + offset);
+}
+
+void SimulatedTrackerSource::writeWord(size_t offset, uint16_t value)
+{
+    *reinterpret_cast<volatile uint16_t *>(static_cast<char *>(m_mappedMem) + offset) = value;
+}
+
+void SimulatedTrackerSource::run()
+{
+    const int64_t periodNs = static_cast<int64_t>(1e9 / m_config.trackerRateHz);
+    int64_t nextWake = monotonicNs();
+    uint64_t frame = 0;
+
+    // Frames of the next target loss, [lossStart, lossEnd)
+    const bool dropouts = m_config.dropoutIntervalS > 0.0 && m_config.dropoutLengthS > 0.0;
+    uint64_t lossStart = 0;
+    uint64_t lossEnd = 0;
+    const auto scheduleLoss = [&](uint64_t after) {
+        std::exponential_distribution<double> interval(1.0 / (m_config.dropoutIntervalS * m_config.trackerRateHz));
+        std::exponential_distribution<double> length(1.0 / (m_config.dropoutLengthS * m_config.trackerRateHz));
+        lossStart = after + static_cast<uint64_t>(std::llround(interval(m_rng)));
+        lossEnd = lossStart + std::max<uint64_t>(1, static_cast<uint64_t>(std::llround(length(m_rng))));
+    };
+    if (dropouts) {
+        scheduleLoss(0);
+    }
+
+    while (m_running.load(std::memory_order_acquire)) {
+        nextWake += periodNs;
+        sleepUntil(nextWake);
+
+        // Acknowledge commands the way the card does, by clearing the mailbox
+        if (readWord(COMMAND_MAILBOX_OFFSET) != 0) {
+            writeWord(COMMAND_MAILBOX_OFFSET, 0);
+        }
+
+        bool lost = false;
+        if (dropouts) {
+            if (frame >= lossEnd) {
+                scheduleLoss(frame);
+            }
+            lost = frame >= lossStart;
+        }
+
+        // Target position is a function of the frame number so runs repeat
+        const double t = static_cast<double>(frame++) / m_config.trackerRateHz;
+        const double phase = 2.0 * M_PI * m_config.targetFrequencyHz * t;
+        const double errX = lost ? 0.0 : m_config.targetAmplitude * std::sin(phase) + m_noise(m_rng);
+        const double errY = lost ? 0.0 : m_config.targetAmplitude * std::cos(phase) + m_noise(m_rng);
+
+        // A card that lost the video sends nothing at all
+        if (lost && m_config.dropoutSilent) {
+            continue;
+        }
+
+        // Like the card, drop the frame while the last one is unread
+        if (readWord(STATUS_MAILBOX_OFFSET) != 0) {
+            continue;
+        }
+
+        uint16_t message[STATUS_MESSAGE_WORDS];
+        message[0] = TRACKER_SYNC_WORD;
+        message[1] = 0xFF01;
+        message[2] = static_cast<uint16_t>(static_cast<int16_t>(std::max(-32768.0, std::min(32767.0, std::round(errX * 32.0)))));
+        message[3] = static_cast<uint16_t>(static_cast<int16_t>(std::max(-32768.0, std::min(32767.0, std::round(errY * 32.0)))));
+        message[4] = 0;
+        message[5] = lost ? 0 : TRACKER_STATE_TRACKING << 3;
+        message[6] = 0;
+
+        message[STATUS_MESSAGE_WORDS - 1] = TrackerStatus::checksum(message, STATUS_MESSAGE_WORDS - 1);
+
+        for (int i = 0; i < STATUS_MESSAGE_WORDS; i++) {
+            writeWord(STATUS_MESSAGE_OFFSET + i * 2, message[i]);
+        }
+
+        // Publish the message before raising the mailbox
+        std::atomic_thread_fence(std::memory_order_release);
+        writeWord(STATUS_MAILBOX_OFFSET, 1);
+
+        uint64_t event = 1;
+        if (::write(m_eventFd, &event, sizeof(event)) != static_cast<ssize_t>(sizeof(event))) {
+            // Consumers that poll the mailbox do not need the event
+        }
+    }
+}
@@ -0,0 +1,211 @@
+#include "ipc_channel.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+// Whether an existing segment is still served by a live process
+bool segmentInUse(const std::string &name)
+{
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+
+    bool inUse = false;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(IpcSegment)) {
+        void *mem = mmap(nullptr, sizeof(IpcSegment), PROT_READ, MAP_SHARED, fd, 0);
+        if (mem != MAP_FAILED) {
+            const IpcSegment *segment = static_cast<const IpcSegment *>(mem);
+            if (segment->magic.load(std::memory_order_acquire) == IPC_MAGIC) {
+                const pid_t pid = static_cast<pid_t>(segment->serverPid);
+                inUse = kill(pid, 0) == 0 || errno == EPERM;
+            }
+            munmap(mem, sizeof(IpcSegment));
+        }
+    }
+    ::close(fd);
+    return inUse;
+}
+
+} // namespace
+
+namespace Ipc {
+
+IpcSegment *createSegment(const std::string &name, std::string &error)
+{
+    if (segmentInUse(name)) {
+        error = "Shared memory " + name + " is served by another running process";
+        return nullptr;
+    }
+
+    // A segment left by a process that died is replaced, never reused:
+    // clients still mapping it keep the old, consistent copy
+    shm_unlink(name.c_str());
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0660);
+    if (fd < 0) {
+        error = "shm_open " + name + ": " + std::strerror(errno);
+        return nullptr;
+    }
+
+    if (ftruncate(fd, sizeof(IpcSegment)) != 0) {
+        error = "ftruncate " + name + ": " + std::strerror(errno);
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+
+    void *mem = mmap(nullptr, sizeof(IpcSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED) {
+        error = "mmap " + name + ": " + std::strerror(errno);
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+
+    // Fault the pages in now rather than on the control thread's first
+    // pushes; a locked process keeps them resident
+    mlock(mem, sizeof(IpcSegment));
+
+    IpcSegment *segment = new (mem) IpcSegment();
+
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    segment->layoutVersion = IPC_LAYOUT_VERSION;
+    segment->segmentSize = sizeof(IpcSegment);
+    segment->serverPid = getpid();
+    segment->startedNs = static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+    segment->magic.store(IPC_MAGIC, std::memory_order_release);
+    return segment;
+}
+
+void destroySegment(const std::string &name, IpcSegment *segment)
+{
+    if (!segment) {
+        return;
+    }
+
+    // Clients still mapping it see it go stale rather than vanish
+    segment->magic.store(0, std::memory_order_release);
+    segment->~IpcSegment();
+    munmap(segment, sizeof(IpcSegment));
+    shm_unlink(name.c_str());
+}
+
+} // namespace Ipc
+
+IpcClient::IpcClient()
+    : m_segment(nullptr)
+    , m_cursor(0)
+    , m_cursorValid(false)
+    , m_lost(0)
+    , m_nextSequence(1)
+{
+}
+
+IpcClient::~IpcClient()
+{
+    close();
+}
+
+bool IpcClient::open(const std::string &name)
+{
+    close();
+
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        m_lastError = "shm_open " + name + ": " + std::strerror(errno);
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) != sizeof(IpcSegment)) {
+        m_lastError = "Shared memory " + name + " has an unexpected size";
+        ::close(fd);
+        return false;
+    }
+
+    void *mem = mmap(nullptr, sizeof(IpcSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED) {
+        m_lastError = "mmap " + name + ": " + std::strerror(errno);
+        return false;
+    }
+
+    IpcSegment *segment = static_cast<IpcSegment *>(mem);
+    if (segment->magic.load(std::memory_order_acquire) != IPC_MAGIC
+        || segment->layoutVersion != IPC_LAYOUT_VERSION
+        || segment->segmentSize != sizeof(IpcSegment)) {
+        m_lastError = "Shared memory " + name + " is not ready or has another layout version";
+        munmap(mem, sizeof(IpcSegment));
+        return false;
+    }
+
+    m_segment = segment;
+    m_cursorValid = false;
+    m_lost = 0;
+    m_lastError.clear();
+    return true;
+}
+
+void IpcClient::close()
+{
+    if (m_segment) {
+        munmap(m_segment, sizeof(IpcSegment));
+        m_segment = nullptr;
+    }
+}
+
+IpcStatus IpcClient::status() const
+{
+    return m_segment ? m_segment->status.load() : IpcStatus();
+}
+
+uint64_t IpcClient::send(IpcCommandType type, int32_t arg, double value)
+{
+    if (!m_segment) {
+        return 0;
+    }
+
+    // Sequence numbers are unique across clients: pid in the upper half
+    IpcCommand command;
+    command.type = static_cast<uint32_t>(type);
+    command.arg = arg;
+    command.value = value;
+    command.sequence = (static_cast<uint64_t>(getpid()) << 32) | (m_nextSequence & 0xFFFFFFFFu);
+    if (!m_segment->commands.push(command)) {
+        return 0;
+    }
+
+    m_nextSequence++;
+    return command.sequence;
+}
+
+bool IpcClient::latest(TelemetrySnapshot &snapshot) const
+{
+    return m_segment && m_segment->telemetry.latest(snapshot);
+}
+
+size_t IpcClient::readTelemetry(TelemetrySnapshot *out, size_t maxCount)
+{
+    if (!m_segment) {
+        return 0;
+    }
+
+    if (!m_cursorValid) {
+        const uint64_t head = m_segment->telemetry.head();
+        m_cursor = head > 0 ? head - 1 : 0;
+        m_cursorValid = true;
+    }
+    return m_segment->telemetry.readFrom(m_cursor, out, maxCount, m_lost);
+}
@@ -0,0 +1,168 @@
+#include "ipc_server.h"
+#include "control_loop.h"
+
+#include <time.h>
+
+IpcServer::IpcServer(ControlLoop *loop, QObject *parent)
+    : QObject(parent)
+    , m_loop(loop)
+    , m_segment(nullptr)
+    , m_serviceTimer(new QTimer(this))
+    , m_commandsApplied(0)
+    , m_commandsRejected(0)
+    , m_lastCommandSequence(0)
+{
+    m_serviceTimer->setInterval(IPC_SERVICE_INTERVAL_MS);
+    connect(m_serviceTimer, &QTimer::timeout, this, &IpcServer::service);
+}
+
+IpcServer::~IpcServer()
+{
+    close();
+}
+
+bool IpcServer::open(const QString &name)
+{
+    close();
+
+    std::string error;
+    m_name = name.toStdString();
+    m_segment = Ipc::createSegment(m_name, error);
+    if (!m_segment) {
+        emit errorOccurred(QString::fromStdString(error));
+        return false;
+    }
+
+    publishStatus();
+    m_loop->telemetry()->setMirror(&m_segment->telemetry);
+    m_serviceTimer->start();
+
+    emit statusChanged(QString("Serving clients on shared memory %1").arg(name));
+    return true;
+}
+
+void IpcServer::close()
+{
+    if (!m_segment) {
+        return;
+    }
+
+    m_serviceTimer->stop();
+
+    // The control thread may be inside a push to the ring; the detach
+    // returns once it is out, so the segment can be unmapped
+    m_loop->telemetry()->setMirror(nullptr);
+
+    Ipc::destroySegment(m_name, m_segment);
+    m_segment = nullptr;
+}
+
+void IpcServer::service()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    const int64_t nowNs = static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+
+    IpcCommand command;
+    while (m_segment->commands.pop(command, nowNs, IPC_COMMAND_STALL_TIMEOUT_MS * 1000000LL)) {
+        if (apply(command)) {
+            m_commandsApplied++;
+        } else {
+            m_commandsRejected++;
+        }
+        m_lastCommandSequence = command.sequence;
+    }
+
+    publishStatus();
+}
+
+bool IpcServer::apply(const IpcCommand &command)
+{
+    ManualInputConfig manual = m_loop->getManualInputConfig();
+
+    switch (static_cast<IpcCommandType>(command.type)) {
+        case IpcCommandType::START:
+            return m_loop->start();
+
+        case IpcCommandType::STOP:
+            return m_loop->stop();
+
+        case IpcCommandType::SET_MODE:
+            if (command.arg < static_cast<int32_t>(ControlLoop::OperationMode::COARSE_TRACK) ||
+                command.arg > static_cast<int32_t>(ControlLoop::OperationMode::AUTO_TRACK)) {
+                return false;
+            }
+            m_loop->setOperationMode(static_cast<ControlLoop::OperationMode>(command.arg));
+            return true;
+
+        case IpcCommandType::SET_SERVO:
+            // A request the next control tick engages
+            m_loop->setServoEnabled(command.arg != 0);
+            return true;
+
+        case IpcCommandType::SET_FSM_OUTPUT:
+            manual.fsmOutputEnabled = command.arg != 0;
+            break;
+
+        case IpcCommandType::SET_GIMBAL_OUTPUT:
+            manual.gimbalOutputEnabled = command.arg != 0;
+            break;
+
+        case IpcCommandType::SET_FSM_DEADZONE:
+            if (!(command.value >= 0.0 && command.value < 1.0)) {
+                return false;
+            }
+            manual.fsmDeadzone = command.value;
+            break;
+
+        case IpcCommandType::SET_GIMBAL_DEADZONE:
+            if (!(command.value >= 0.0 && command.value < 1.0)) {
+                return false;
+            }
+            manual.gimbalDeadzone = command.value;
+            break;
+
+        case IpcCommandType::SET_INVERT:
+            if (command.value != 0.0) {
+                manual.invertMask |= static_cast<uint32_t>(command.arg);
+            } else {
+                manual.invertMask &= ~static_cast<uint32_t>(command.arg);
+            }
+            break;
+
+        case IpcCommandType::RESET_STATISTICS:
+            m_loop->resetLatency();
+            m_loop->resetTickStatistics();
+            return true;
+
+        default:
+            return false;
+    }
+
+    m_loop->setManualInputConfig(manual);
+    return true;
+}
+
+void IpcServer::publishStatus()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    const TickStatistics ticks = m_loop->getTickStatistics();
+
+    IpcStatus status;
+    status.updatedNs = static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+    status.running = m_loop->isRunning() ? 1 : 0;
+    status.mode = static_cast<int32_t>(m_loop->getOperationMode());
+    status.servoEnabled = m_loop->isServoEnabled() ? 1 : 0; // Requested state, lock-free
+    status.controlRateHz = m_loop->getControlRate();
+    status.cycles = m_loop->getCycleCount();
+    status.overruns = m_loop->getOverrunCount();
+    status.deadlineMisses = ticks.deadlineMisses;
+    status.commandsApplied = m_commandsApplied;
+    status.commandsRejected = m_commandsRejected;
+    status.commandsSkipped = m_segment->commands.skippedCount();
+    status.lastCommandSequence = m_lastCommandSequence;
+    status.manual = m_loop->getManualInputConfig();
+    m_segment->status.store(status);
+}
@@ -1,27 +1,96 @@
 #include "joystick_interface.h"
 #include <QDebug>
+#include <QDir>
 #include <QEventLoop>
 #include <QTimer>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
 #include <fcntl.h>
 #include <unistd.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <linux/input.h>
 #include <linux/joystick.h>
 #include <SDL2/SDL.h>
 
+namespace {
+
+const int64_t NSEC_PER_MSEC = 1000000LL;
+
+// Backend used by instances initialized after the call
+std::atomic<JoystickInterface::Backend> g_preferredBackend(JoystickInterface::Backend::EVDEV);
+
+#define BITS_PER_LONG (8 * sizeof(unsigned long))
+#define NBITS(x) ((((x) - 1) / BITS_PER_LONG) + 1)
+
+inline bool testBit(const unsigned long *bits, int bit)
+{
+    return (bits[bit / BITS_PER_LONG] >> (bit % BITS_PER_LONG)) & 1UL;
+}
+
+inline int64_t monotonicNs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+inline int64_t eventTimeNs(const input_event &event)
+{
+    return static_cast<int64_t>(event.input_event_sec) * 1000000000LL
+         + static_cast<int64_t>(event.input_event_usec) * 1000LL;
+}
+
+// A joystick or gamepad has an X axis and at least one joystick button
+bool isEvdevJoystick(int fd)
+{
+    unsigned long absBits[NBITS(ABS_CNT)] = {0};
+    unsigned long keyBits[NBITS(KEY_CNT)] = {0};
+    if (ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(absBits)), absBits) < 0 ||
+        ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keyBits)), keyBits) < 0) {
+        return false;
+    }
+
+    if (!testBit(absBits, ABS_X)) {
+        return false;
+    }
+
+    for (int code = BTN_JOYSTICK; code < BTN_DIGI; code++) {
+        if (testBit(keyBits, code)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
 JoystickInterface::JoystickInterface(QObject *parent)
     : QObject(parent)
+    , m_requestedBackend(Backend::EVDEV)
+    , m_backend(Backend::EVDEV)
     , m_pollTimer(new QTimer(this))
     , m_currentJoystick(nullptr)
     , m_sdlInitialized(false)
-    , m_x(0.0)
-    , m_y(0.0)
-    , m_z(0.0)
-    , m_rx(0.0)
-    , m_ry(0.0)
-    , m_rz(0.0)
+    , m_evdevFd(-1)
+    , m_epollFd(-1)
+    , m_evdevAxes(0)
+    , m_evdevButtons(0)
+    , m_evdevHats(0)
+    , m_lastSignalNs{0, 0}
+    , m_axes{0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0}
+    , m_axesSlot(m_axes)
+    , m_axesStaged(false)
+    , m_signalPending(0)
     , m_buttonState(0)
     , m_running(false)
 {
-    // Set up poll timer with 60Hz rate
+    m_requestedBackend = g_preferredBackend.load();
+
+    // Set up poll timer with 60Hz rate for the SDL backend
     m_pollTimer->setInterval(POLLING_RATE_MS);
     connect(m_pollTimer, &QTimer::timeout, this, &JoystickInterface::pollEvents);
 }
@@ -30,16 +99,61 @@ JoystickInterface::~JoystickInterface()
 {
     stop();
 
+    {
+        QMutexLocker locker(&m_mutex);
+        closeJoystickLocked();
+    }
+
     if (m_sdlInitialized) {
         // Ensure SDL is properly shut down
-        closeJoystick();
         SDL_Quit();
         m_sdlInitialized = false;
     }
 }
 
+void JoystickInterface::setPreferredBackend(Backend backend)
+{
+    g_preferredBackend.store(backend);
+}
+
+void JoystickInterface::setBackend(Backend backend)
+{
+    QMutexLocker locker(&m_mutex);
+    m_requestedBackend = backend;
+}
+
+JoystickInterface::Backend JoystickInterface::getBackend() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_backend;
+}
+
+void JoystickInterface::setRealtimeConfig(const RealtimeConfig &config)
+{
+    QMutexLocker locker(&m_mutex);
+    m_inputConfig = config;
+}
+
 bool JoystickInterface::initialize()
 {
+    // Prefer evdev; fall back to SDL when no joystick node can be opened
+    // (missing permissions on /dev/input, or a device evdev does not expose)
+    if (m_requestedBackend == Backend::EVDEV) {
+        {
+            QMutexLocker locker(&m_mutex);
+            m_backend = Backend::EVDEV;
+            scanEvdevJoysticks();
+        }
+
+        if (!m_availableJoysticks.isEmpty()) {
+            emit joysticksChanged();
+            emit errorOccurred("Joystick interface initialized (evdev)");
+            return true;
+        }
+
+        emit errorOccurred("No evdev joystick found, falling back to SDL");
+    }
+
     // Initialize SDL for joystick subsystem
     if (SDL_Init(SDL_INIT_JOYSTICK) < 0) {
         emit errorOccurred(QString("SDL could not initialize! Error: %1").arg(SDL_GetError()));
@@ -47,6 +161,7 @@ bool JoystickInterface::initialize()
     }
 
     m_sdlInitialized = true;
+    m_backend = Backend::SDL;
 
     // Enable joystick events
     SDL_JoystickEventState(SDL_ENABLE);
@@ -54,13 +169,26 @@ bool JoystickInterface::initialize()
     // Scan for available joysticks
     scanJoysticks();
 
-    emit errorOccurred("Joystick interface initialized");
+    emit errorOccurred("Joystick interface initialized (SDL)");
     return true;
 }
 
 void JoystickInterface::scanJoysticks()
 {
-    QMutexLocker locker(&m_mutex);
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_backend == Backend::EVDEV) {
+            scanEvdevJoysticks();
+        } else {
+            scanSdlJoysticks();
+        }
+    }
+
+    emit joysticksChanged();
+}
+
+void JoystickInterface::scanSdlJoysticks()
+{
     m_availableJoysticks.clear();
 
     int numJoysticks = SDL_NumJoysticks();
@@ -72,8 +200,39 @@ void JoystickInterface::scanJoysticks()
             m_availableJoysticks[i] = QString("Joystick %1").arg(i);
         }
     }
+}
 
-    emit joysticksChanged();
+void JoystickInterface::scanEvdevJoysticks()
+{
+    m_availableJoysticks.clear();
+    m_evdevPaths.clear();
+
+    // Visit event nodes in numeric order so indices are stable
+    QStringList nodes = QDir("/dev/input").entryList(QStringList() << "event*", QDir::System);
+    std::sort(nodes.begin(), nodes.end(), [](const QString &a, const QString &b) {
+        return a.mid(5).toInt() < b.mid(5).toInt();
+    });
+
+    for (const QString &node : nodes) {
+        const QString path = "/dev/input/" + node;
+        int fd = ::open(path.toLocal8Bit().constData(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+
+        if (isEvdevJoystick(fd)) {
+            char name[256] = {0};
+            if (ioctl(fd, EVIOCGNAME(sizeof(name) - 1), name) < 0) {
+                snprintf(name, sizeof(name), "Joystick %s", node.toLocal8Bit().constData());
+            }
+
+            const int index = m_availableJoysticks.size();
+            m_availableJoysticks[index] = QString::fromUtf8(name);
+            m_evdevPaths[index] = path;
+        }
+
+        ::close(fd);
+    }
 }
 
 QStringList JoystickInterface::getAvailableJoysticks() const
@@ -90,38 +249,158 @@ int JoystickInterface::openJoystick(int index)
 {
     QMutexLocker locker(&m_mutex);
 
+    // The input thread reads the open device
+    if (m_inputThread.isRunning()) {
+        emit errorOccurred("Stop the joystick interface before changing joysticks");
+        return -1;
+    }
+
     // Close any existing joystick first
-    closeJoystick();
+    closeJoystickLocked();
 
-    m_currentJoystick = SDL_JoystickOpen(index);
-    if (!m_currentJoystick) {
-        emit errorOccurred(QString("Couldn't open joystick %1: %2").arg(index).arg(SDL_GetError()));
-        return -1;
+    if (m_backend == Backend::EVDEV) {
+        if (!openEvdevJoystick(index)) {
+            return -1;
+        }
+    } else {
+        m_currentJoystick = SDL_JoystickOpen(index);
+        if (!m_currentJoystick) {
+            emit errorOccurred(QString("Couldn't open joystick %1: %2").arg(index).arg(SDL_GetError()));
+            return -1;
+        }
+
+        // Initialize hat state array
+        int numHats = SDL_JoystickNumHats(m_currentJoystick);
+        m_hatState.resize(numHats);
+        for (int i = 0; i < numHats; ++i) {
+            m_hatState[i] = SDL_HAT_CENTERED;
+        }
     }
 
     // Initialize calibration for this joystick
-    calibrateAxes();
+    calibrateAxesLocked();
 
-    // Initialize hat state array
-    int numHats = SDL_JoystickNumHats(m_currentJoystick);
-    m_hatState.resize(numHats);
-    for (int i = 0; i < numHats; ++i) {
-        m_hatState[i] = SDL_HAT_CENTERED;
+    emit errorOccurred(QString("Opened joystick: %1").arg(m_availableJoysticks.value(index)));
+    return index;
+}
+
+bool JoystickInterface::openEvdevJoystick(int index)
+{
+    const QString path = m_evdevPaths.value(index);
+    if (path.isEmpty()) {
+        emit errorOccurred(QString("Couldn't open joystick %1: no such device").arg(index));
+        return false;
     }
 
-    emit errorOccurred(QString("Opened joystick: %1").arg(getJoystickName()));
-    return index;
+    int fd = ::open(path.toLocal8Bit().constData(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        emit errorOccurred(QString("Couldn't open joystick %1: %2").arg(path).arg(strerror(errno)));
+        return false;
+    }
+
+    // Stamp events on the same clock as the control loop. Older kernels
+    // keep CLOCK_REALTIME, which only affects the reported event age.
+    int clockId = CLOCK_MONOTONIC;
+    if (ioctl(fd, EVIOCSCLOCKID, &clockId) < 0) {
+        qDebug() << "Joystick: EVIOCSCLOCKID not supported, event times use CLOCK_REALTIME";
+    }
+
+    unsigned long absBits[NBITS(ABS_CNT)] = {0};
+    unsigned long keyBits[NBITS(KEY_CNT)] = {0};
+    ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(absBits)), absBits);
+    ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keyBits)), keyBits);
+
+    // Axes: X..RZ keep their usual numbers 0-5, any other absolute axis
+    // follows. Hats are handled separately.
+    m_absAxis.assign(ABS_CNT, -1);
+    m_evdevAxes = 0;
+    for (int code = ABS_X; code <= ABS_RZ; code++) {
+        if (testBit(absBits, code)) {
+            m_absAxis[code] = code - ABS_X;
+            m_evdevAxes = code - ABS_X + 1;
+        }
+    }
+    for (int code = ABS_RZ + 1; code < ABS_CNT; code++) {
+        if (testBit(absBits, code) && (code < ABS_HAT0X || code > ABS_HAT3Y)) {
+            m_absAxis[code] = std::max(m_evdevAxes, ABS_RZ - ABS_X + 1);
+            m_evdevAxes = m_absAxis[code] + 1;
+        }
+    }
+
+    m_evdevHats = 0;
+    for (int code = ABS_HAT0X; code <= ABS_HAT3Y; code++) {
+        if (testBit(absBits, code)) {
+            m_evdevHats = (code - ABS_HAT0X) / 2 + 1;
+        }
+    }
+    m_hatState.fill(SDL_HAT_CENTERED, m_evdevHats);
+
+    // Buttons in joydev order: joystick/gamepad buttons first, then the
+    // miscellaneous ones
+    m_keyButton.assign(KEY_CNT, -1);
+    m_evdevButtons = 0;
+    for (int code = BTN_JOYSTICK; code < KEY_CNT; code++) {
+        if (testBit(keyBits, code)) {
+            m_keyButton[code] = m_evdevButtons++;
+        }
+    }
+    for (int code = BTN_MISC; code < BTN_JOYSTICK; code++) {
+        if (testBit(keyBits, code)) {
+            m_keyButton[code] = m_evdevButtons++;
+        }
+    }
+
+    m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (m_epollFd < 0 || epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        emit errorOccurred(QString("Couldn't watch joystick %1: %2").arg(path).arg(strerror(errno)));
+        if (m_epollFd >= 0) {
+            ::close(m_epollFd);
+            m_epollFd = -1;
+        }
+        ::close(fd);
+        return false;
+    }
+
+    m_evdevFd = fd;
+    m_evdevName = m_availableJoysticks.value(index);
+    return true;
 }
 
 void JoystickInterface::closeJoystick()
 {
     QMutexLocker locker(&m_mutex);
 
+    if (m_inputThread.isRunning()) {
+        emit errorOccurred("Stop the joystick interface before closing the joystick");
+        return;
+    }
+
+    closeJoystickLocked();
+}
+
+void JoystickInterface::closeJoystickLocked()
+{
     if (m_currentJoystick) {
         SDL_JoystickClose(m_currentJoystick);
         m_currentJoystick = nullptr;
     }
 
+    if (m_epollFd >= 0) {
+        ::close(m_epollFd);
+        m_epollFd = -1;
+    }
+    if (m_evdevFd >= 0) {
+        ::close(m_evdevFd);
+        m_evdevFd = -1;
+    }
+    m_evdevName.clear();
+    m_evdevAxes = 0;
+    m_evdevButtons = 0;
+    m_evdevHats = 0;
+
     // Clear calibration data
     m_axisCalibration.clear();
 
@@ -132,12 +411,13 @@ void JoystickInterface::closeJoystick()
 bool JoystickInterface::isJoystickOpen() const
 {
     QMutexLocker locker(&m_mutex);
-    return m_currentJoystick != nullptr;
+    return m_currentJoystick != nullptr || m_evdevFd >= 0;
 }
 
 int JoystickInterface::getNumAxes() const
 {
     QMutexLocker locker(&m_mutex);
+    if (m_evdevFd >= 0) return m_evdevAxes;
     if (!m_currentJoystick) return 0;
     return SDL_JoystickNumAxes(m_currentJoystick);
 }
@@ -145,6 +425,7 @@ int JoystickInterface::getNumAxes() const
 int JoystickInterface::getNumButtons() const
 {
     QMutexLocker locker(&m_mutex);
+    if (m_evdevFd >= 0) return m_evdevButtons;
     if (!m_currentJoystick) return 0;
     return SDL_JoystickNumButtons(m_currentJoystick);
 }
@@ -152,6 +433,7 @@ int JoystickInterface::getNumButtons() const
 int JoystickInterface::getNumHats() const
 {
     QMutexLocker locker(&m_mutex);
+    if (m_evdevFd >= 0) return m_evdevHats;
     if (!m_currentJoystick) return 0;
     return SDL_JoystickNumHats(m_currentJoystick);
 }
@@ -159,6 +441,7 @@ int JoystickInterface::getNumHats() const
 QString JoystickInterface::getJoystickName() const
 {
     QMutexLocker locker(&m_mutex);
+    if (m_evdevFd >= 0) return m_evdevName;
     if (!m_currentJoystick) return QString();
 
     const char* name = SDL_JoystickName(m_currentJoystick);
@@ -176,24 +459,48 @@ bool JoystickInterface::start()
         return true; // Already running
     }
 
-    if (!m_sdlInitialized) {
+    if (m_backend == Backend::SDL && !m_sdlInitialized) {
         emit errorOccurred("Cannot start joystick interface: not initialized");
         return false;
     }
 
-    if (!m_currentJoystick) {
+    if (!m_currentJoystick && m_evdevFd < 0) {
         // Try to open the first available joystick if none is open
-        if (!m_availableJoysticks.isEmpty()) {
-            openJoystick(m_availableJoysticks.firstKey());
-        } else {
+        if (m_availableJoysticks.isEmpty()) {
             emit errorOccurred("Cannot start joystick interface: no joysticks available");
             return false;
         }
+
+        locker.unlock();
+        if (openJoystick(m_availableJoysticks.firstKey()) < 0) {
+            return false;
+        }
+        locker.relock();
+    }
+
+    m_lastSignalNs[0] = 0;
+    m_lastSignalNs[1] = 0;
+
+    if (m_backend == Backend::EVDEV) {
+        // The input thread takes m_mutex for each batch of events
+        const RealtimeConfig config = m_inputConfig;
+        locker.unlock();
+        if (!m_inputThread.start(config, 0, [this]() { readInputEvents(); })) {
+            emit errorOccurred("Failed to start joystick input thread");
+            return false;
+        }
+
+        std::string rtError = m_inputThread.lastError();
+        if (!rtError.empty()) {
+            emit errorOccurred(QString("Joystick input thread: %1").arg(QString::fromStdString(rtError)));
+        }
+        locker.relock();
+    } else {
+        // Start the polling timer
+        m_pollTimer->start();
     }
 
-    // Start the polling timer
     m_running = true;
-    m_pollTimer->start();
 
     emit errorOccurred("Joystick interface started");
     return true;
@@ -207,9 +514,12 @@ bool JoystickInterface::stop()
         return true; // Already stopped
     }
 
-    // Stop the polling timer
+    // Stop the polling timer or input thread. The thread takes m_mutex
+    // itself, so join it unlocked.
     m_pollTimer->stop();
     m_running = false;
+    locker.unlock();
+    m_inputThread.stop();
 
     emit errorOccurred("Joystick interface stopped");
     return true;
@@ -221,6 +531,98 @@ void JoystickInterface::refreshJoysticks()
     scanJoysticks();
 }
 
+void JoystickInterface::readInputEvents()
+{
+    epoll_event ready;
+    int n = epoll_wait(m_epollFd, &ready, 1, JOYSTICK_WAIT_TIMEOUT_MS);
+    if (n <= 0) {
+        // Idle: make sure the GUI has seen the final position
+        QMutexLocker locker(&m_mutex);
+        publishAxes(false);
+        return;
+    }
+
+    input_event events[64];
+    ssize_t bytes = ::read(m_evdevFd, events, sizeof(events));
+    if (bytes < 0) {
+        if (errno == ENODEV) {
+            // Unplugged: stop watching it, a rescan finds it again
+            epoll_ctl(m_epollFd, EPOLL_CTL_DEL, m_evdevFd, nullptr);
+            emit errorOccurred("Joystick disconnected");
+        }
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    const size_t count = static_cast<size_t>(bytes) / sizeof(input_event);
+    for (size_t i = 0; i < count; i++) {
+        handleEvdevEvent(events[i].type, events[i].code, events[i].value, eventTimeNs(events[i]));
+    }
+}
+
+void JoystickInterface::handleEvdevEvent(uint16_t type, uint16_t code, int32_t value, int64_t eventNs)
+{
+    switch (type) {
+        case EV_ABS: {
+            if (code >= ABS_HAT0X && code <= ABS_HAT3Y) {
+                // Combine the X/Y hat axes into an SDL style hat value
+                const int hat = (code - ABS_HAT0X) / 2;
+                if (hat >= m_hatState.size()) {
+                    break;
+                }
+                int state = m_hatState[hat];
+                if ((code - ABS_HAT0X) % 2 == 0) {
+                    state &= ~(SDL_HAT_LEFT | SDL_HAT_RIGHT);
+                    state |= value < 0 ? SDL_HAT_LEFT : value > 0 ? SDL_HAT_RIGHT : 0;
+                } else {
+                    state &= ~(SDL_HAT_UP | SDL_HAT_DOWN);
+                    state |= value < 0 ? SDL_HAT_UP : value > 0 ? SDL_HAT_DOWN : 0;
+                }
+                if (state != m_hatState[hat]) {
+                    m_hatState[hat] = state;
+                    emit hatStateChanged(hat, state);
+                }
+                break;
+            }
+
+            const int axis = code < m_absAxis.size() ? m_absAxis[code] : -1;
+            if (axis >= 0) {
+                // Staged until the end of the event frame
+                mapAxisToPositionOrRotation(axis, normalizeAxisValue(axis, value));
+                m_axes.eventNs = eventNs;
+            }
+            break;
+        }
+
+        case EV_KEY: {
+            const int button = code < m_keyButton.size() ? m_keyButton[code] : -1;
+            if (button >= 0 && value != 2) {  // Ignore autorepeat
+                setButton(button, value != 0);
+            }
+            break;
+        }
+
+        case EV_SYN:
+            if (code == SYN_REPORT) {
+                // One publication per frame, however many axes moved
+                publishAxes(true);
+            } else if (code == SYN_DROPPED) {
+                // The kernel buffer overflowed; resynchronize from the
+                // device's current state
+                for (int c = 0; c < static_cast<int>(m_absAxis.size()); c++) {
+                    if (m_absAxis[c] >= 0) {
+                        input_absinfo info;
+                        if (ioctl(m_evdevFd, EVIOCGABS(c), &info) == 0) {
+                            mapAxisToPositionOrRotation(m_absAxis[c], normalizeAxisValue(m_absAxis[c], info.value));
+                        }
+                    }
+                }
+                m_axes.eventNs = eventNs;
+            }
+            break;
+    }
+}
+
 void JoystickInterface::pollEvents()
 {
     if (!m_sdlInitialized || !m_running) {
@@ -238,39 +640,21 @@ void JoystickInterface::pollEvents()
                 // Apply calibration and normalization
                 double normalizedValue = normalizeAxisValue(axis, rawValue);
 
-                // Map to our position/rotation structure
-                mapAxisToPositionOrRotation(axis, normalizedValue);
-                break;
-            }
-
-            case SDL_JOYBUTTONDOWN: {
-                QMutexLocker locker(&m_mutex);
-                int button = event.jbutton.button;
-
-                // Update button state
-                m_buttonState |= (1 << button);
-
-                // Emit signals
-                emit buttonStateChanged(button, true);
-
-                // Special handling for mode button
-                if (button == static_cast<int>(Button::MODE_SWITCH)) {
-                    emit modeButtonPressed();
+                // Map to our position/rotation structure and publish
+                if (mapAxisToPositionOrRotation(axis, normalizedValue)) {
+                    m_axes.eventNs = monotonicNs();
+                    publishAxes(false);
                 }
                 break;
             }
 
-            case SDL_JOYBUTTONUP: {
-                QMutexLocker locker(&m_mutex);
-                int button = event.jbutton.button;
-
-                // Update button state
-                m_buttonState &= ~(1 << button);
+            case SDL_JOYBUTTONDOWN:
+                setButton(event.jbutton.button, true);
+                break;
 
-                // Emit signal
-                emit buttonStateChanged(button, false);
+            case SDL_JOYBUTTONUP:
+                setButton(event.jbutton.button, false);
                 break;
-            }
 
             case SDL_JOYHATMOTION: {
                 QMutexLocker locker(&m_mutex);
@@ -296,16 +680,66 @@ void JoystickInterface::pollEvents()
     }
 }
 
+void JoystickInterface::setButton(int button, bool pressed)
+{
+    // Update button state
+    if (button < 32) {
+        if (pressed) {
+            m_buttonState.fetch_or(1u << button);
+        } else {
+            m_buttonState.fetch_and(~(1u << button));
+        }
+    }
+
+    // Emit signals
+    emit buttonStateChanged(button, pressed);
+
+    // Special handling for mode button
+    if (pressed && button == static_cast<int>(Button::MODE_SWITCH)) {
+        emit modeButtonPressed();
+    }
+}
+
 void JoystickInterface::calibrateAxes()
 {
     QMutexLocker locker(&m_mutex);
+    calibrateAxesLocked();
+}
+
+void JoystickInterface::calibrateAxesLocked()
+{
+    m_axisCalibration.clear();
+
+    if (m_evdevFd >= 0) {
+        // Use the driver's range and the current value as center
+        m_axisCalibration.resize(m_evdevAxes);
+        for (int code = 0; code < static_cast<int>(m_absAxis.size()); code++) {
+            const int axis = m_absAxis[code];
+            if (axis < 0) {
+                continue;
+            }
+
+            input_absinfo info;
+            if (ioctl(m_evdevFd, EVIOCGABS(code), &info) < 0 || info.maximum <= info.minimum) {
+                continue;
+            }
+
+            AxisCalibration &cal = m_axisCalibration[axis];
+            cal.min = info.minimum;
+            cal.max = info.maximum;
+            cal.center = std::max(info.minimum + 1, std::min(info.maximum - 1, info.value));
+            cal.calibrated = true;
+
+            qDebug() << "Calibrated axis" << axis << "center:" << cal.center;
+        }
+        return;
+    }
 
     if (!m_currentJoystick) {
         return;
     }
 
     int numAxes = SDL_JoystickNumAxes(m_currentJoystick);
-    m_axisCalibration.clear();
 
     // Initialize calibration with current values as center
     for (int i = 0; i < numAxes; ++i) {
@@ -321,78 +755,152 @@ void JoystickInterface::calibrateAxes()
     }
 }
 
+void JoystickInterface::setAxisCalibration(int axis, int min, int max, int center)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (axis < 0 || min >= max) {
+        return;
+    }
+    while (axis >= m_axisCalibration.size()) {
+        AxisCalibration none;
+        none.min = -32768;
+        none.max = 32767;
+        none.center = 0;
+        none.calibrated = false;
+        m_axisCalibration.append(none);
+    }
+
+    AxisCalibration &cal = m_axisCalibration[axis];
+    cal.min = min;
+    cal.max = max;
+    cal.center = std::max(min + 1, std::min(max - 1, center));
+    cal.calibrated = true;
+}
+
 double JoystickInterface::normalizeAxisValue(int axis, int value) const
 {
     // Apply calibration if available
     if (axis < m_axisCalibration.size() && m_axisCalibration[axis].calibrated) {
+        const AxisCalibration &cal = m_axisCalibration[axis];
+
         // Subtract center value to adjust for drift
-        int adjustedValue = value - m_axisCalibration[axis].center;
+        int adjustedValue = value - cal.center;
 
         // Normalize to -1.0 to 1.0 range
+        double normalized;
         if (adjustedValue > 0) {
-            return static_cast<double>(adjustedValue) / (32767 - m_axisCalibration[axis].center);
+            normalized = static_cast<double>(adjustedValue) / (cal.max - cal.center);
         } else {
-            return static_cast<double>(adjustedValue) / (32768 + m_axisCalibration[axis].center);
+            normalized = static_cast<double>(adjustedValue) / (cal.center - cal.min);
         }
+        return std::max(-1.0, std::min(1.0, normalized));
     }
 
     // Default normalization if no calibration
     return static_cast<double>(value) / 32767.0;
 }
 
-void JoystickInterface::mapAxisToPositionOrRotation(int axis, double value)
+bool JoystickInterface::mapAxisToPositionOrRotation(int axis, double value)
 {
     // Map axis to appropriate position or rotation variable
     // We use a simple default mapping based on common joystick layouts
     switch (axis) {
         case DEFAULT_X_AXIS: // X axis
-            m_x = value;
+            m_axes.x = value;
             break;
         case DEFAULT_Y_AXIS: // Y axis
-            m_y = value;
+            m_axes.y = value;
             break;
         case DEFAULT_Z_AXIS: // Z axis
-            m_z = value;
+            m_axes.z = value;
             break;
         case DEFAULT_RX_AXIS: // RX axis
-            m_rx = value;
+            m_axes.rx = value;
             break;
         case DEFAULT_RY_AXIS: // RY axis
-            m_ry = value;
+            m_axes.ry = value;
             break;
         case DEFAULT_RZ_AXIS: // RZ axis
-            m_rz = value;
+            m_axes.rz = value;
             break;
+        default:
+            return false;
     }
 
-    // Emit the appropriate signals based on which axis changed
-    if (axis <= DEFAULT_Z_AXIS) {
-        emit joystickPositionChanged(m_x, m_y, m_z);
-    } else {
-        emit joystickRotationChanged(m_rx, m_ry, m_rz);
+    m_axesStaged = true;
+    m_signalPending |= (axis <= DEFAULT_Z_AXIS) ? 1 : 2;
+    return true;
+}
+
+void JoystickInterface::publishAxes(bool throttle)
+{
+    const int64_t now = monotonicNs();
+
+    // The control thread sees every frame as soon as it is complete
+    if (m_axesStaged) {
+        m_axesSlot.store(m_axes);
+        m_axesStaged = false;
+        m_publishLatency.record(now - m_axes.eventNs);
+    }
+
+    // The GUI gets at most one signal per interval; the idle path of the
+    // input thread flushes the last one
+    const int64_t interval = JOYSTICK_SIGNAL_INTERVAL_MS * NSEC_PER_MSEC;
+
+    if ((m_signalPending & 1) && (!throttle || now - m_lastSignalNs[0] >= interval)) {
+        m_lastSignalNs[0] = now;
+        m_signalPending &= ~1;
+        emit joystickPositionChanged(m_axes.x, m_axes.y, m_axes.z);
+    }
+    if ((m_signalPending & 2) && (!throttle || now - m_lastSignalNs[1] >= interval)) {
+        m_lastSignalNs[1] = now;
+        m_signalPending &= ~2;
+        emit joystickRotationChanged(m_axes.rx, m_axes.ry, m_axes.rz);
     }
 }
 
 void JoystickInterface::getJoystickPosition(double &x, double &y, double &z)
 {
-    QMutexLocker locker(&m_mutex);
-    x = m_x;
-    y = m_y;
-    z = m_z;
+    const JoystickAxes axes = m_axesSlot.load();
+    x = axes.x;
+    y = axes.y;
+    z = axes.z;
 }
 
 void JoystickInterface::getJoystickRotation(double &rx, double &ry, double &rz)
 {
-    QMutexLocker locker(&m_mutex);
-    rx = m_rx;
-    ry = m_ry;
-    rz = m_rz;
+    const JoystickAxes axes = m_axesSlot.load();
+    rx = axes.rx;
+    ry = axes.ry;
+    rz = axes.rz;
+}
+
+uint32_t JoystickInterface::getJoystickAxes(JoystickAxes &axes)
+{
+    axes = m_axesSlot.load();
+    return m_axesSlot.version();
+}
+
+uint64_t JoystickInterface::getContentionCount() const
+{
+    return m_axesSlot.contentionCount();
+}
+
+LatencySummary JoystickInterface::getPublishLatency() const
+{
+    return m_publishLatency.summary();
+}
+
+void JoystickInterface::resetPublishLatency()
+{
+    m_publishLatency.reset();
 }
 
 int JoystickInterface::getHatPosition(int hat) const
 {
     QMutexLocker locker(&m_mutex);
-    if (!m_currentJoystick || hat >= m_hatState.size()) return HAT_CENTERED;
+    if ((!m_currentJoystick && m_evdevFd < 0) || hat >= m_hatState.size()) return HAT_CENTERED;
     return m_hatState[hat];
 }
 
@@ -414,7 +922,6 @@ QString JoystickInterface::hatPositionToString(int value)
 
 bool JoystickInterface::isButtonPressed(int button) const
 {
-    QMutexLocker locker(&m_mutex);
-    uint32_t mask = 1 << button;
-    return (m_buttonState & mask) != 0;
-}
\ No newline at end of file
+    uint32_t mask = 1u << button;
+    return (m_buttonState.load() & mask) != 0;
+}
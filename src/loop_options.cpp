@@ -0,0 +1,372 @@
+#include "loop_options.h"
+#include "control_loop.h"
+#include "hardware_simulated.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <sys/mman.h>
+#include <unistd.h>
+
+LoopOptions::LoopOptions()
+    : m_controlRate("control-rate", "Control loop rate in Hz", "hz", QString::number(ControlRateConfig().rateHz))
+    , m_aiSection("ai-section", "FSM feedback scans per control tick; the AI samples at the control rate times <scans>", "scans", QString::number(ControlRateConfig().aiSectionScans))
+    , m_aiDriven("ai-driven", "Wake the control thread on each AI section instead of a timer")
+    , m_aiRaw("ai-raw", "Read the FSM feedback as raw counts and scale them per section instead of in the driver")
+    , m_feedbackFilter("feedback-filter", "Filter decimating each AI section to one FSM feedback sample: average, cic or fir, "
+                       "over <length> samples (default: the section scans), with <stages> for cic or <cutoff> for fir",
+                       "type[,length[,stages|cutoff]]")
+    , m_rtPriority("rt-priority", "Run the control loop with SCHED_FIFO realtime priority")
+    , m_rtCpu("rt-cpu", "Pin the control loop thread to <cpu>", "cpu", "-1")
+    , m_trackerIrq("tracker-irq", "Wait for tracker messages on the card interrupt at <uio> instead of polling", "uio")
+    , m_trackerPoll("tracker-poll-us", "Tracker mailbox poll interval in microseconds", "us", "100")
+    , m_trackerScheduled("tracker-scheduled", "Poll the tracker mailbox from the control thread instead of an ingest thread")
+    , m_trackerStale("tracker-stale-frames", "Count the target as lost after <n> 250 Hz frame periods without a valid message, 0 to wait forever", "n",
+                     QString::number(TrackerIngestConfig().staleFrames))
+    , m_trackerDiv("tracker-div", "Take tracker frames every <n> control ticks (default: every 1 ms)", "n")
+    , m_joystickDiv("joystick-div", "Apply joystick positions every <n> control ticks (default: every 4 ms)", "n")
+    , m_gimbalDiv("gimbal-div", "Read and command the gimbal every <n> control ticks (default: every 10 ms)", "n")
+    , m_trackEstimator("track-estimator", "Track error estimator in auto track: cv (constant velocity), ca (constant acceleration) or off", "model", "cv")
+    , m_trackLatency("track-frame-latency-us", "Camera frame exposure to tracker message latency in microseconds", "us", QString::number(TrackEstimator::Config().frameLatencyNs / 1000))
+    , m_trackCoast("track-coast-ms", "Coast on the track estimate for <ms> after the target is lost in auto track", "ms",
+                   QString::number(TrackLossPolicy::Config().coastNs / 1000000))
+    , m_trackHold("track-hold-ms", "Then hold the last command for <ms> before the fallback", "ms",
+                  QString::number(TrackLossPolicy::Config().holdNs / 1000000))
+    , m_trackFallback("track-loss-fallback", "Fallback when the target is not reacquired: hold, center or manual", "action", "center")
+    , m_gimbalOffload("gimbal-offload", "Drive the gimbal in auto track to keep the FSM centred")
+    , m_offloadHz("offload-hz", "Gimbal off-load crossover in Hz", "hz", QString::number(GimbalOffload::Config().crossoverHz))
+    , m_offloadRate("offload-rate", "Gimbal off-load rate limit in gimbal units per second", "rate", QString::number(GimbalOffload::Config().rateLimit))
+    , m_offloadScale("offload-scale", "Gimbal azimuth and elevation per unit of FSM X and Y, signed", "az,el",
+                     QString("%1,%2").arg(GimbalOffload::Config().azimuthScale).arg(GimbalOffload::Config().elevationScale))
+    , m_offloadSource("offload-source", "FSM position the gimbal off-loads: feedback or command", "source", "feedback")
+    , m_modeBlend("mode-blend-ms", "Fade the outputs between operation modes over <ms>, 0 to switch at once", "ms", QString::number(MODE_TRANSITION_DEFAULT_MS))
+    , m_fsmSlew("fsm-slew", "FSM output rate, acceleration and jerk limits per second, 0 for none", "rate[,accel[,jerk]]")
+    , m_gimbalSlew("gimbal-slew", "Gimbal output rate, acceleration and jerk limits per second, 0 for none", "rate[,accel[,jerk]]")
+    , m_noSlewLimit("no-slew-limit", "Commit output commands without slew limiting")
+    , m_servoPid("servo-pid", "FSM servo gains: proportional, integral per second, derivative in seconds", "kp,ki[,kd]",
+                 QString("%1,%2,%3").arg(AxisCompensator::Config().kp).arg(AxisCompensator::Config().ki).arg(AxisCompensator::Config().kd))
+    , m_servoLead("servo-lead", "FSM servo lead-lag zero and pole in Hz", "zero,pole")
+    , m_servoNotch("servo-notch", "FSM servo notch at a mirror resonance; repeat for up to 3", "hz,q,depth-db")
+    , m_clockedAo("fsm-clocked-ao", "Stream FSM outputs through the hardware-clocked AO buffer")
+    , m_aoLead("fsm-ao-lead", "Scans queued ahead of the clocked FSM output", "scans", "2")
+    , m_overrunWarn("overrun-warn", "Warn when more than <count> control ticks overrun within a second, 0 to disable", "count", QString::number(TICK_OVERRUN_WARN_DEFAULT))
+    , m_joystickSdl("joystick-sdl", "Read the joystick through SDL on the main thread instead of evdev")
+    , m_simulate("simulate", "Use the simulated DAQ and tracker backend instead of the cards")
+    , m_simSeed("sim-seed", "Noise seed of the simulated backend", "seed", "1")
+    , m_simDropout("sim-dropout", "Simulated tracker loses the target every <interval> seconds for <length> seconds, on average",
+                   "interval,length")
+    , m_simDropoutSilent("sim-dropout-silent", "Simulated tracker sends no messages while the target is lost")
+{
+}
+
+void LoopOptions::addTo(QCommandLineParser &parser) const
+{
+    parser.addOption(m_controlRate);
+    parser.addOption(m_aiSection);
+    parser.addOption(m_aiDriven);
+    parser.addOption(m_aiRaw);
+    parser.addOption(m_feedbackFilter);
+    parser.addOption(m_rtPriority);
+    parser.addOption(m_rtCpu);
+    parser.addOption(m_trackerIrq);
+    parser.addOption(m_trackerPoll);
+    parser.addOption(m_trackerScheduled);
+    parser.addOption(m_trackerStale);
+    parser.addOption(m_trackerDiv);
+    parser.addOption(m_joystickDiv);
+    parser.addOption(m_gimbalDiv);
+    parser.addOption(m_trackEstimator);
+    parser.addOption(m_trackLatency);
+    parser.addOption(m_trackCoast);
+    parser.addOption(m_trackHold);
+    parser.addOption(m_trackFallback);
+    parser.addOption(m_gimbalOffload);
+    parser.addOption(m_offloadHz);
+    parser.addOption(m_offloadRate);
+    parser.addOption(m_offloadScale);
+    parser.addOption(m_offloadSource);
+    parser.addOption(m_modeBlend);
+    parser.addOption(m_fsmSlew);
+    parser.addOption(m_gimbalSlew);
+    parser.addOption(m_noSlewLimit);
+    parser.addOption(m_servoPid);
+    parser.addOption(m_servoLead);
+    parser.addOption(m_servoNotch);
+    parser.addOption(m_clockedAo);
+    parser.addOption(m_aoLead);
+    parser.addOption(m_overrunWarn);
+    parser.addOption(m_joystickSdl);
+    parser.addOption(m_simulate);
+    parser.addOption(m_simSeed);
+    parser.addOption(m_simDropout);
+    parser.addOption(m_simDropoutSilent);
+}
+
+void LoopOptions::applyBackends(const QCommandLineParser &parser) const
+{
+    if (parser.isSet(m_simulate)) {
+        SimulationConfig simConfig;
+        simConfig.seed = parser.value(m_simSeed).toUInt();
+        if (parser.isSet(m_simDropout)) {
+            const QStringList dropout = parser.value(m_simDropout).split(',');
+            if (dropout.size() == 2) {
+                simConfig.dropoutIntervalS = dropout[0].toDouble();
+                simConfig.dropoutLengthS = dropout[1].toDouble();
+            } else {
+                std::cerr << "Ignoring invalid simulated dropouts: " << parser.value(m_simDropout).toStdString() << std::endl;
+            }
+        }
+        simConfig.dropoutSilent = parser.isSet(m_simDropoutSilent);
+        Simulation::setConfig(simConfig);
+        Hardware::setBackend(Hardware::Backend::SIMULATED);
+        std::cout << "Using the simulated hardware backend (seed " << simConfig.seed << ")" << std::endl;
+    }
+
+    // Likewise the joystick backend, since the joysticks are opened as
+    // soon as they are constructed
+    if (parser.isSet(m_joystickSdl)) {
+        JoystickInterface::setPreferredBackend(JoystickInterface::Backend::SDL);
+    }
+}
+
+bool LoopOptions::applyTo(const QCommandLineParser &parser, ControlLoop &loop) const
+{
+    ControlRateConfig rate;
+    rate.rateHz = parser.value(m_controlRate).toInt();
+    rate.aiSectionScans = parser.value(m_aiSection).toInt();
+    rate.aiDriven = parser.isSet(m_aiDriven);
+    if (!loop.setControlRateConfig(rate)) {
+        return false;
+    }
+
+    // The filter decimates one AI section per tick, so by default it spans
+    // exactly one section
+    if (parser.isSet(m_feedbackFilter)) {
+        FeedbackFilter::Config filter;
+        const QStringList values = parser.value(m_feedbackFilter).split(',');
+        if (values.size() > 3) {
+            std::cerr << "Invalid feedback filter: " << parser.value(m_feedbackFilter).toStdString() << std::endl;
+            return false;
+        }
+        if (values[0] == "cic") {
+            filter.type = FeedbackFilter::Type::CIC;
+        } else if (values[0] == "fir") {
+            filter.type = FeedbackFilter::Type::FIR;
+        } else if (values[0] != "average") {
+            std::cerr << "Unknown feedback filter type: " << values[0].toStdString() << std::endl;
+            return false;
+        }
+        filter.length = values.size() > 1 ? values[1].toInt() : rate.aiSectionScans;
+        if (values.size() > 2) {
+            if (filter.type == FeedbackFilter::Type::CIC) {
+                filter.stages = values[2].toInt();
+            } else if (filter.type == FeedbackFilter::Type::FIR) {
+                filter.cutoff = values[2].toDouble();
+            } else {
+                std::cerr << "A moving average takes no third parameter" << std::endl;
+                return false;
+            }
+        }
+        if (!loop.setFeedbackFilterConfig(filter)) {
+            return false;
+        }
+    }
+
+    RealtimeConfig rtConfig;
+    rtConfig.cpu = parser.value(m_rtCpu).toInt();
+
+    // If realtime priority requested, lock memory so the control thread
+    // never takes a page fault, and run the loop under SCHED_FIFO
+    if (parser.isSet(m_rtPriority)) {
+        rtConfig.fifo = true;
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+            std::cerr << "Warning: mlockall failed, control thread may page fault" << std::endl;
+        }
+        std::cout << "Using SCHED_FIFO priority " << rtConfig.priority << " for the control thread" << std::endl;
+    }
+
+    // The tracker ingest thread produces the inputs of the control thread,
+    // so it runs one priority level above it
+    TrackerIngestConfig trackerConfig;
+    trackerConfig.realtime.fifo = rtConfig.fifo;
+    trackerConfig.realtime.priority = rtConfig.priority + 1;
+    trackerConfig.pollIntervalUs = parser.value(m_trackerPoll).toInt();
+    if (parser.isSet(m_trackerIrq)) {
+        // The device is opened for writing, so a setuid install must not
+        // let the caller pick the path
+        if (geteuid() != getuid() || getegid() != getgid()) {
+            std::cerr << "--tracker-irq is not allowed when running setuid" << std::endl;
+            return false;
+        }
+        trackerConfig.useInterrupt = true;
+        trackerConfig.interruptDevice = parser.value(m_trackerIrq).toStdString();
+    }
+    trackerConfig.scheduled = parser.isSet(m_trackerScheduled);
+    trackerConfig.staleFrames = parser.value(m_trackerStale).toInt();
+
+    // Each group runs at a sub-multiple of the control rate. The default
+    // divisors are for 1 kHz; scale them so the groups keep their rate in
+    // Hz at other control rates.
+    const auto divisor = [&parser, &rate](const QCommandLineOption &option, int defaultDivisor) {
+        if (parser.isSet(option)) {
+            return parser.value(option).toInt();
+        }
+        return std::max(1, static_cast<int>(std::lround(defaultDivisor * rate.rateHz / 1000.0)));
+    };
+    const RateGroupConfig defaults;
+    RateGroupConfig rateConfig;
+    rateConfig.trackerDivisor = divisor(m_trackerDiv, defaults.trackerDivisor);
+    rateConfig.joystickDivisor = divisor(m_joystickDiv, defaults.joystickDivisor);
+    rateConfig.gimbalDivisor = divisor(m_gimbalDiv, defaults.gimbalDivisor);
+
+    // Joystick events feed the control thread too, but a late one only
+    // delays a manual command, so it runs one level below it
+    RealtimeConfig joystickConfig;
+    joystickConfig.fifo = rtConfig.fifo;
+    joystickConfig.priority = rtConfig.priority - 1;
+
+    // The estimator predicts the track error to each tick from the frame
+    // time, the message arrival less the camera latency
+    TrackEstimator::Config estimator;
+    const QString model = parser.value(m_trackEstimator);
+    if (model == "off") {
+        estimator.enabled = false;
+    } else if (model == "ca") {
+        estimator.model = TrackEstimator::Model::CONSTANT_ACCELERATION;
+    } else if (model != "cv") {
+        std::cerr << "Unknown track estimator model: " << model.toStdString() << std::endl;
+        return false;
+    }
+    estimator.frameLatencyNs = parser.value(m_trackLatency).toLongLong() * 1000;
+    if (!loop.setTrackEstimatorConfig(estimator)) {
+        return false;
+    }
+
+    TrackLossPolicy::Config trackLoss;
+    trackLoss.coastNs = parser.value(m_trackCoast).toLongLong() * 1000000;
+    trackLoss.holdNs = parser.value(m_trackHold).toLongLong() * 1000000;
+    const QString fallback = parser.value(m_trackFallback);
+    if (fallback == "hold") {
+        trackLoss.fallback = TrackLossPolicy::Fallback::HOLD;
+    } else if (fallback == "manual") {
+        trackLoss.fallback = TrackLossPolicy::Fallback::MANUAL;
+    } else if (fallback != "center") {
+        std::cerr << "Unknown track loss fallback: " << fallback.toStdString() << std::endl;
+        return false;
+    }
+    if (!loop.setTrackLossConfig(trackLoss)) {
+        return false;
+    }
+
+    loop.setRealtimeConfig(rtConfig);
+    loop.setTrackerIngestConfig(trackerConfig);
+    loop.setRateGroupConfig(rateConfig);
+
+    // The off-load runs in the gimbal group, so it is validated against
+    // the divisor set above
+    if (parser.isSet(m_gimbalOffload)) {
+        GimbalOffload::Config offload;
+        offload.enabled = true;
+        offload.crossoverHz = parser.value(m_offloadHz).toDouble();
+        offload.rateLimit = parser.value(m_offloadRate).toDouble();
+        const QStringList scale = parser.value(m_offloadScale).split(',');
+        if (scale.size() != 2) {
+            std::cerr << "Invalid gimbal off-load scale: " << parser.value(m_offloadScale).toStdString() << std::endl;
+            return false;
+        }
+        offload.azimuthScale = scale[0].toDouble();
+        offload.elevationScale = scale[1].toDouble();
+        const QString source = parser.value(m_offloadSource);
+        if (source == "command") {
+            offload.source = GimbalOffload::Source::COMMAND;
+        } else if (source != "feedback") {
+            std::cerr << "Unknown gimbal off-load source: " << source.toStdString() << std::endl;
+            return false;
+        }
+        if (!loop.setGimbalOffloadConfig(offload)) {
+            return false;
+        }
+    }
+
+    loop.setModeTransitionTime(parser.value(m_modeBlend).toInt());
+
+    // Slew limits apply to every axis of a device; unset stages keep
+    // their defaults
+    OutputLimitConfig limits;
+    limits.bypass = parser.isSet(m_noSlewLimit);
+    const auto slew = [&parser](const QCommandLineOption &option, OutputLimiter::ChannelLimits &channel) {
+        if (!parser.isSet(option)) {
+            return true;
+        }
+        const QStringList values = parser.value(option).split(',');
+        if (values.size() > 3) {
+            std::cerr << "Invalid slew limits: " << parser.value(option).toStdString() << std::endl;
+            return false;
+        }
+        double *stage[3] = {&channel.rate, &channel.acceleration, &channel.jerk};
+        for (int i = 0; i < values.size(); i++) {
+            *stage[i] = values[i].toDouble();
+        }
+        return true;
+    };
+    if (!slew(m_fsmSlew, limits.fsmX) || !slew(m_gimbalSlew, limits.gimbalAz)) {
+        return false;
+    }
+    limits.fsmY = limits.fsmX;
+    limits.gimbalEl = limits.gimbalAz;
+    limits.gimbalAuxEl = limits.gimbalAz;
+    if (!loop.setOutputLimitConfig(limits)) {
+        return false;
+    }
+
+    // The servo gains are validated at the control rate set above; both
+    // axes share them
+    if (parser.isSet(m_servoPid) || parser.isSet(m_servoLead) || parser.isSet(m_servoNotch)) {
+        AxisCompensator::Config servo;
+        const QStringList pid = parser.value(m_servoPid).split(',');
+        if (pid.size() < 2 || pid.size() > 3) {
+            std::cerr << "Invalid servo gains: " << parser.value(m_servoPid).toStdString() << std::endl;
+            return false;
+        }
+        servo.kp = pid[0].toDouble();
+        servo.ki = pid[1].toDouble();
+        servo.kd = pid.size() > 2 ? pid[2].toDouble() : 0.0;
+        if (parser.isSet(m_servoLead)) {
+            const QStringList lead = parser.value(m_servoLead).split(',');
+            if (lead.size() != 2) {
+                std::cerr << "Invalid servo lead-lag: " << parser.value(m_servoLead).toStdString() << std::endl;
+                return false;
+            }
+            servo.leadLagEnabled = true;
+            servo.leadZeroHz = lead[0].toDouble();
+            servo.leadPoleHz = lead[1].toDouble();
+        }
+        const QStringList notches = parser.values(m_servoNotch);
+        if (notches.size() > AxisCompensator::MAX_NOTCHES) {
+            std::cerr << "At most " << AxisCompensator::MAX_NOTCHES << " servo notches" << std::endl;
+            return false;
+        }
+        for (const QString &notch : notches) {
+            const QStringList values = notch.split(',');
+            if (values.size() != 3) {
+                std::cerr << "Invalid servo notch: " << notch.toStdString() << std::endl;
+                return false;
+            }
+            AxisCompensator::Notch &n = servo.notches[servo.notchCount++];
+            n.frequencyHz = values[0].toDouble();
+            n.q = values[1].toDouble();
+            n.depthDb = values[2].toDouble();
+        }
+        if (!loop.setServoConfig(servo, servo)) {
+            return false;
+        }
+    }
+
+    loop.setJoystickRealtimeConfig(joystickConfig);
+    loop.setOverrunWarning(parser.value(m_overrunWarn).toInt());
+    loop.setFsmRawAcquisition(parser.isSet(m_aiRaw));
+    if (parser.isSet(m_clockedAo)) {
+        loop.setFsmClockedOutput(true, parser.value(m_aoLead).toInt());
+    }
+    return true;
+}
@@ -3,9 +3,19 @@
 #include <QStyleFactory>
 #include <QCommandLineParser>
 #include <QThread>
-#include <iostream>
+#include <QTimer>
+#include <csignal>
 
 #include "main_window.h"
+#include "loop_options.h"
+
+// Set by SIGUSR1, polled from the GUI thread
+static volatile sig_atomic_t g_latencyDumpRequested = 0;
+
+static void requestLatencyDump(int)
+{
+    g_latencyDumpRequested = 1;
+}
 
 int main(int argc, char *argv[])
 {
@@ -53,23 +63,39 @@ int main(int argc, char *argv[])
     parser.addHelpOption();
     parser.addVersionOption();
 
-    // Add command line options
-    QCommandLineOption rtPriorityOption("rt-priority", "Set realtime thread priority");
-    parser.addOption(rtPriorityOption);
+    // Control loop options, shared with bc-traild
+    LoopOptions loopOptions;
+    loopOptions.addTo(parser);
 
     // Process the command line
     parser.process(app);
 
-    // If realtime priority requested, try to set process priority
-    if (parser.isSet(rtPriorityOption)) {
-        // This is just a placeholder - actual priority setting would be
-        // done with platform-specific code (pthread_setschedparam on Linux)
-        std::cout << "Attempting to set realtime thread priority" << std::endl;
-    }
+    // The backends must be chosen before the controllers are constructed
+    loopOptions.applyBackends(parser);
 
     // Create and show main window
     MainWindow mainWindow;
+    if (!loopOptions.applyTo(parser, *mainWindow.controlLoop())) {
+        return 1;
+    }
     mainWindow.show();
 
+    // kill -USR1 <pid> prints the latency histograms and scheduler health
+    struct sigaction action = {};
+    action.sa_handler = requestLatencyDump;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &action, nullptr);
+
+    QTimer latencyDumpTimer;
+    latencyDumpTimer.setInterval(200);
+    QObject::connect(&latencyDumpTimer, &QTimer::timeout, [&mainWindow]() {
+        if (g_latencyDumpRequested) {
+            g_latencyDumpRequested = 0;
+            mainWindow.dumpLatency();
+        }
+    });
+    latencyDumpTimer.start();
+
     return app.exec();
 }
\ No newline at end of file
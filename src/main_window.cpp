@@ -4,7 +4,6 @@
 #include <QMessageBox>
 #include <QDebug>
 #include <QFileDialog>
-#include <QTextStream>
 #include <QVBoxLayout>
 #include <QGroupBox>
 #include <QGridLayout>
@@ -14,15 +13,16 @@
 #include <QSpinBox>
 #include <QDir>
 #include <QTimer>
+#include <iostream>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
-    , m_joystickInterface(new JoystickInterface(this))
-    , m_fsmController(new FSMController(this))
-    , m_gimbalController(new GimbalController(this))
-    , m_trackerInterface(new TrackerInterface(this))
     , m_controlLoop(new ControlLoop(this))
+    , m_joystickInterface(m_controlLoop->joystickInterface())
+    , m_fsmController(m_controlLoop->fsmController())
+    , m_gimbalController(m_controlLoop->gimbalController())
+    , m_trackerInterface(m_controlLoop->trackerInterface())
     , m_systemRunning(false)
     , m_currentMode(MainWindow::ControlMode::CoarseTrack)
     , m_selectedJoystickIndex(-1)
@@ -43,10 +43,8 @@ MainWindow::MainWindow(QWidget *parent)
     , m_trackerInitialized(false)
     , m_trackerAutoPoll(false)
     , m_trackerPollTimer(new QTimer(this))
-    , m_logFile(nullptr)
-    , m_logStream(nullptr)
-    , m_loggingActive(false)
     , m_statusUpdateTimer(new QTimer(this))
+    , m_telemetry()
 {
     ui->setupUi(this);
 
@@ -61,6 +59,11 @@ MainWindow::MainWindow(QWidget *parent)
     updateJoystickList();
     updateUIForCurrentMode();
 
+    // The loop drives the outputs from the joystick as the panel shows
+    m_fsmDeadzone = ui->fsmDeadzoneSpinBox->value() / 100.0;
+    m_gimbalDeadzone = ui->gimbalDeadzoneSpinBox->value() / 100.0;
+    applyManualInputConfig();
+
     // Set up status update timer (5 Hz)
     m_statusUpdateTimer->setInterval(200);
     connect(m_statusUpdateTimer, &QTimer::timeout, this, &MainWindow::updateSystemStatus);
@@ -83,14 +86,10 @@ MainWindow::~MainWindow()
     }
 
     // Stop logging if active
-    if (m_loggingActive) {
+    if (m_recorder.isRecording()) {
         onStartStopLogging();
     }
 
-    // Clean up resources
-    delete m_logStream;
-    delete m_logFile;
-
     delete ui;
 }
 
@@ -176,6 +175,23 @@ void MainWindow::onClearLogsButtonClicked()
     }
 }
 
+void MainWindow::onResetLatency()
+{
+    m_controlLoop->resetLatency();
+    m_controlLoop->resetTickStatistics();
+    logMessage("Latency histograms and scheduler statistics reset");
+}
+
+void MainWindow::dumpLatency()
+{
+    const QStringList report = m_controlLoop->latencyReport() + m_controlLoop->schedulerReport()
+                                + m_controlLoop->trackLossReport();
+    for (const QString &line : report) {
+        logMessage(line);
+        std::cout << line.toStdString() << std::endl;
+    }
+}
+
 void MainWindow::onStatusChanged(const QString &message)
 {
     logMessage(message);
@@ -200,27 +216,6 @@ void MainWindow::onOperationModeChanged(ControlLoop::OperationMode mode)
     updateModeDisplay(mode);
 }
 
-void MainWindow::onTelemetryUpdated(double fsmX, double fsmY,
-                                   double gimbalAz, double gimbalEl, double gimbalAuxEl,
-                                   double joystickX, double joystickY, double joystickZ,
-                                   double trackErrorX, double trackErrorY)
-{
-    // Update telemetry data
-    m_telemetry.fsmX = fsmX;
-    m_telemetry.fsmY = fsmY;
-    m_telemetry.gimbalAz = gimbalAz;
-    m_telemetry.gimbalEl = gimbalEl;
-    m_telemetry.gimbalAuxEl = gimbalAuxEl;
-    m_telemetry.joystickX = joystickX;
-    m_telemetry.joystickY = joystickY;
-    m_telemetry.joystickZ = joystickZ;
-    m_telemetry.trackErrorX = trackErrorX;
-    m_telemetry.trackErrorY = trackErrorY;
-
-    // Update the graphs (this would be implemented depending on the graphing library used)
-    // For now, we just update the text display in updateStatusDisplay()
-}
-
 void MainWindow::updateStatusDisplay()
 {
     // Update system running status
@@ -258,9 +253,41 @@ void MainWindow::updateStatusDisplay()
     // Update tracking error display
     QLabel* valueTrackError = findChild<QLabel*>("valueTrackError");
     if (valueTrackError) {
-        valueTrackError->setText(QString("X: %1, Y: %2")
+        valueTrackError->setText(QString("X: %1, Y: %2 (age %3 us)")
                                 .arg(m_telemetry.trackErrorX, 0, 'f', 3)
-                                .arg(m_telemetry.trackErrorY, 0, 'f', 3));
+                                .arg(m_telemetry.trackErrorY, 0, 'f', 3)
+                                .arg(m_telemetry.trackAgeNs / 1000));
+    }
+
+    // Update scheduler health display
+    QLabel* valueScheduler = findChild<QLabel*>("valueScheduler");
+    if (valueScheduler) {
+        const TickStatistics ticks = m_controlLoop->getTickStatistics();
+        valueScheduler->setText(QString("Period %1 +/- %2 us, max late %3 us, max duration %4 us, %5 misses")
+                               .arg(ticks.period.mean / 1000.0, 0, 'f', 1)
+                               .arg(ticks.period.stddev() / 1000.0, 0, 'f', 1)
+                               .arg(ticks.lateness.max / 1000.0, 0, 'f', 1)
+                               .arg(ticks.duration.max / 1000.0, 0, 'f', 1)
+                               .arg(ticks.deadlineMisses));
+    }
+
+    // Update latency display
+    for (int i = 0; i < static_cast<int>(ControlLoop::LatencyStage::COUNT); i++) {
+        QLabel* valueLatency = findChild<QLabel*>(QString("latencyStage%1").arg(i));
+        if (!valueLatency) {
+            continue;
+        }
+
+        const LatencySummary summary = m_controlLoop->getLatency(static_cast<ControlLoop::LatencyStage>(i));
+        if (summary.count == 0) {
+            valueLatency->setText("-");
+            continue;
+        }
+        valueLatency->setText(QString("%1 / %2 / %3 / %4")
+                             .arg(summary.p50Ns / 1000.0, 0, 'f', 1)
+                             .arg(summary.p99Ns / 1000.0, 0, 'f', 1)
+                             .arg(summary.p999Ns / 1000.0, 0, 'f', 1)
+                             .arg(summary.maxNs / 1000.0, 0, 'f', 1));
     }
 }
 
@@ -291,6 +318,7 @@ void MainWindow::setupUi()
     QLabel* gimbalLabel = new QLabel("Gimbal:", statusGroup);
     QLabel* joystickLabel = new QLabel("Joystick:", statusGroup);
     QLabel* trackErrorLabel = new QLabel("Track Error:", statusGroup);
+    QLabel* schedulerLabel = new QLabel("Scheduler:", statusGroup);
     
     QLabel* valueRunning = new QLabel("No", statusGroup);
     QLabel* valueMode = new QLabel("Coarse Track", statusGroup);
@@ -299,6 +327,7 @@ void MainWindow::setupUi()
     QLabel* valueGimbal = new QLabel("Az: 0.000, El: 0.000, Aux: 0.000", statusGroup);
     QLabel* valueJoystick = new QLabel("X: 0.000, Y: 0.000, Z: 0.000", statusGroup);
     QLabel* valueTrackError = new QLabel("X: 0.000, Y: 0.000", statusGroup);
+    QLabel* valueScheduler = new QLabel("-", statusGroup);
     
     statusLayout->addWidget(runningLabel, 0, 0);
     statusLayout->addWidget(valueRunning, 0, 1);
@@ -314,8 +343,31 @@ void MainWindow::setupUi()
     statusLayout->addWidget(valueJoystick, 5, 1);
     statusLayout->addWidget(trackErrorLabel, 6, 0);
     statusLayout->addWidget(valueTrackError, 6, 1);
+    statusLayout->addWidget(schedulerLabel, 7, 0);
+    statusLayout->addWidget(valueScheduler, 7, 1);
     
     controlLayout->addWidget(statusGroup);
+
+    // Latency histograms, one row per stage
+    QGroupBox* latencyGroup = new QGroupBox("Latency (us): p50 / p99 / p99.9 / max", controlPanel);
+    QGridLayout* latencyLayout = new QGridLayout(latencyGroup);
+    for (int i = 0; i < static_cast<int>(ControlLoop::LatencyStage::COUNT); i++) {
+        const ControlLoop::LatencyStage stage = static_cast<ControlLoop::LatencyStage>(i);
+        QLabel* stageLabel = new QLabel(ControlLoop::latencyStageName(stage) + ":", latencyGroup);
+        QLabel* valueLabel = new QLabel("-", latencyGroup);
+        valueLabel->setObjectName(QString("latencyStage%1").arg(i));
+        latencyLayout->addWidget(stageLabel, i, 0);
+        latencyLayout->addWidget(valueLabel, i, 1);
+    }
+
+    QHBoxLayout* latencyButtonLayout = new QHBoxLayout();
+    QPushButton* resetLatencyButton = new QPushButton("Reset", latencyGroup);
+    QPushButton* dumpLatencyButton = new QPushButton("Dump to Log", latencyGroup);
+    latencyButtonLayout->addWidget(resetLatencyButton);
+    latencyButtonLayout->addWidget(dumpLatencyButton);
+    latencyLayout->addLayout(latencyButtonLayout, static_cast<int>(ControlLoop::LatencyStage::COUNT), 0, 1, 2);
+
+    controlLayout->addWidget(latencyGroup);
     
     // Logs
     QGroupBox* logsGroup = new QGroupBox("System Logs", controlPanel);
@@ -342,6 +394,7 @@ void MainWindow::setupUi()
     valueGimbal->setObjectName("valueGimbal");
     valueJoystick->setObjectName("valueJoystick");
     valueTrackError->setObjectName("valueTrackError");
+    valueScheduler->setObjectName("valueScheduler");
     logTextEdit->setObjectName("logTextEdit");
     clearLogsButton->setObjectName("clearLogsButton");
     
@@ -364,6 +417,8 @@ void MainWindow::setupUi()
     connect(stopButton, &QPushButton::clicked, this, &MainWindow::onStopSystem);
     connect(modeButton, &QPushButton::clicked, this, &MainWindow::onModeChanged);
     connect(clearLogsButton, &QPushButton::clicked, this, &MainWindow::onClearLogsButtonClicked);
+    connect(resetLatencyButton, &QPushButton::clicked, this, &MainWindow::onResetLatency);
+    connect(dumpLatencyButton, &QPushButton::clicked, this, &MainWindow::dumpLatency);
 }
 
 void MainWindow::setupSignals()
@@ -372,7 +427,6 @@ void MainWindow::setupSignals()
     connect(m_controlLoop, &ControlLoop::statusChanged, this, &MainWindow::onStatusChanged);
     connect(m_controlLoop, &ControlLoop::errorOccurred, this, &MainWindow::onErrorOccurred);
     connect(m_controlLoop, &ControlLoop::operationModeChanged, this, &MainWindow::onOperationModeChanged);
-    connect(m_controlLoop, &ControlLoop::telemetryUpdated, this, &MainWindow::onTelemetryUpdated);
 }
 
 void MainWindow::setupGraphs()
@@ -798,6 +852,7 @@ void MainWindow::updateUIForCurrentMode()
 void MainWindow::onFsmDeadzoneChanged(int value)
 {
     m_fsmDeadzone = value / 100.0;
+    applyManualInputConfig();
 }
 
 void MainWindow::onFsmAxisMappingChanged()
@@ -813,6 +868,7 @@ void MainWindow::onFsmInvertAxisToggled(bool checked)
     } else if (sender() == ui->fsmInvertYCheckbox) {
         m_invertFsmYAxis = checked;
     }
+    applyManualInputConfig();
 }
 
 void MainWindow::onEnableFsmOutput(bool enabled)
@@ -823,11 +879,13 @@ void MainWindow::onEnableFsmOutput(bool enabled)
     } else {
         setStatusMessage("FSM output disabled");
     }
+    applyManualInputConfig();
 }
 
 void MainWindow::onGimbalDeadzoneChanged(int value)
 {
     m_gimbalDeadzone = value / 100.0;
+    applyManualInputConfig();
 }
 
 void MainWindow::onGimbalAxisMappingChanged()
@@ -846,6 +904,7 @@ void MainWindow::onGimbalInvertAxisToggled(bool checked)
     } else if (sender() == ui->invertAuxElevationCheckbox) {
         m_invertAuxElevationAxis = checked;
     }
+    applyManualInputConfig();
 }
 
 void MainWindow::onEnableGimbalOutput(bool enabled)
@@ -856,10 +915,18 @@ void MainWindow::onEnableGimbalOutput(bool enabled)
     } else {
         setStatusMessage("Gimbal output disabled");
     }
+    applyManualInputConfig();
 }
 
 void MainWindow::onTrackerInitialize()
 {
+    // The tracker is the control loop's; remapping it would pull the card
+    // memory from under the running ingest thread
+    if (m_systemRunning) {
+        setStatusMessage("Stop the system before initializing the tracker");
+        return;
+    }
+
     if (m_trackerInterface->initialize()) {
         m_trackerInitialized = true;
         ui->trackerInitButton->setEnabled(false);
@@ -924,7 +991,7 @@ void MainWindow::onBrowseLogFile()
 {
     QString fileName = QFileDialog::getSaveFileName(this, "Select Log File",
                                                    QDir::homePath(),
-                                                   "Log Files (*.csv)");
+                                                   "Recordings (*.bctr)");
     if (!fileName.isEmpty()) {
         ui->logFileEdit->setText(fileName);
     }
@@ -932,23 +999,13 @@ void MainWindow::onBrowseLogFile()
 
 void MainWindow::onStartStopLogging()
 {
-    if (m_loggingActive) {
+    if (m_recorder.isRecording()) {
         // Stop logging
-        m_loggingActive = false;
+        m_recorder.stop();
         ui->startStopLoggingButton->setText("Start Logging");
-        setStatusMessage("Data logging stopped");
-
-        // Close log file
-        if (m_logStream) {
-            delete m_logStream;
-            m_logStream = nullptr;
-        }
-
-        if (m_logFile) {
-            m_logFile->close();
-            delete m_logFile;
-            m_logFile = nullptr;
-        }
+        setStatusMessage(QString("Data logging stopped: %1 records, %2 dropped")
+                         .arg(m_recorder.recordCount())
+                         .arg(m_recorder.droppedCount()));
     } else {
         // Start logging
         QString fileName = ui->logFileEdit->text();
@@ -957,34 +1014,22 @@ void MainWindow::onStartStopLogging()
             return;
         }
 
-        m_logFile = new QFile(fileName);
-        if (!m_logFile->open(QIODevice::WriteOnly | QIODevice::Text)) {
-            QMessageBox::critical(this, "Logging Error", "Could not open log file for writing");
-            delete m_logFile;
-            m_logFile = nullptr;
+        // Preallocate the file for a fixed recording length
+        const int rateHz = m_controlLoop->getControlRate();
+        const uint64_t capacity = static_cast<uint64_t>(rateHz) * RECORDING_DEFAULT_SECONDS;
+
+        std::string error;
+        if (!m_recorder.start(fileName.toStdString(), capacity, rateHz,
+                              m_controlLoop->telemetry(), error)) {
+            QMessageBox::critical(this, "Logging Error", QString::fromStdString(error));
             return;
         }
 
-        m_logStream = new QTextStream(m_logFile);
-
-        // Write header row
-        *m_logStream << "Timestamp,FSM_X,FSM_Y,Gimbal_Az,Gimbal_El,Gimbal_AuxEl,Track_Error_X,Track_Error_Y\n";
-
-        m_loggingActive = true;
-        m_loggingTimer.start();
         ui->startStopLoggingButton->setText("Stop Logging");
         setStatusMessage("Data logging started");
     }
 }
 
-void MainWindow::logData(const QString &data)
-{
-    if (m_loggingActive && m_logStream) {
-        *m_logStream << data << '\n';
-        m_logStream->flush();
-    }
-}
-
 void MainWindow::onResetSystem()
 {
     // First stop if running
@@ -996,10 +1041,9 @@ void MainWindow::onResetSystem()
     m_fsmController->reset();
     m_gimbalController->reset();
 
-    // Reset joystick if open
+    // Reset joystick if open; the next start of the loop restarts it
     if (m_joystickInterface->isJoystickOpen()) {
         m_joystickInterface->stop();
-        m_joystickInterface->start();
     }
 
     // Reset tracker if initialized
@@ -1020,39 +1064,18 @@ void MainWindow::onResetSystem()
 
 void MainWindow::updateSystemStatus()
 {
-    // Update FSM and gimbal positions from controllers
-    if (m_fsmController->isInitialized()) {
-        double fsmX, fsmY;
-        m_fsmController->getCurrentPosition(fsmX, fsmY);
-        updateFsmPosition(fsmX, fsmY);
-    }
-
-    if (m_gimbalController->isInitialized()) {
-        double az, el, auxEl;
-        m_gimbalController->getCurrentPosition(az, el, auxEl);
-        updateGimbalPosition(az, el, auxEl);
-    }
-
-    // If we're logging data, write a record
-    if (m_loggingActive) {
-        QString timestamp = QString::number(m_loggingTimer.elapsed());
-        double fsmX, fsmY;
-        double gimbalAz, gimbalEl, gimbalAuxEl;
-        double trackErrorX, trackErrorY;
-
-        m_fsmController->getCurrentPosition(fsmX, fsmY);
-        m_gimbalController->getCurrentPosition(gimbalAz, gimbalEl, gimbalAuxEl);
-
-        QString trackState;
-        m_trackerInterface->getTrackingError(trackErrorX, trackErrorY, trackState);
-
-        QString record = QString("%1,%2,%3,%4,%5,%6,%7,%8")
-                          .arg(timestamp)
-                          .arg(fsmX).arg(fsmY)
-                          .arg(gimbalAz).arg(gimbalEl).arg(gimbalAuxEl)
-                          .arg(trackErrorX).arg(trackErrorY);
-
-        logData(record);
+    // Pull the latest snapshot published by the control thread
+    m_telemetry = m_controlLoop->telemetry()->latest();
+
+    // Update FSM and gimbal positions
+    updateFsmPosition(m_telemetry.fsmX, m_telemetry.fsmY);
+    updateGimbalPosition(m_telemetry.gimbalAz, m_telemetry.gimbalEl, m_telemetry.gimbalAuxEl);
+    updateStatusDisplay();
+
+    // The recorder captures every tick on its own thread; only report progress
+    if (m_recorder.isRecording()) {
+        ui->startStopLoggingButton->setText(QString("Stop Logging (%1 s)")
+                                            .arg(m_recorder.recordCount() / m_controlLoop->getControlRate()));
     }
 }
 
@@ -1071,6 +1094,21 @@ void MainWindow::updateGimbalPosition(double azimuth, double elevation, double a
     ui->auxElevationProgressBar->setValue(static_cast<int>(auxElevation * 100));
 }
 
+void MainWindow::applyManualInputConfig()
+{
+    ManualInputConfig config;
+    config.fsmDeadzone = m_fsmDeadzone;
+    config.gimbalDeadzone = m_gimbalDeadzone;
+    config.invertMask = (m_invertFsmXAxis ? MANUAL_INVERT_FSM_X : 0u)
+                      | (m_invertFsmYAxis ? MANUAL_INVERT_FSM_Y : 0u)
+                      | (m_invertAzimuthAxis ? MANUAL_INVERT_GIMBAL_AZ : 0u)
+                      | (m_invertElevationAxis ? MANUAL_INVERT_GIMBAL_EL : 0u)
+                      | (m_invertAuxElevationAxis ? MANUAL_INVERT_GIMBAL_AUX : 0u);
+    config.fsmOutputEnabled = m_fsmOutputEnabled ? 1 : 0;
+    config.gimbalOutputEnabled = m_gimbalOutputEnabled ? 1 : 0;
+    m_controlLoop->setManualInputConfig(config);
+}
+
 double MainWindow::mapAxisToPosition(int axisValue, double deadzone, bool invert)
 {
     // Normalize to -1.0...1.0 range
@@ -0,0 +1,29 @@
+#include "mode_blend.h"
+#include <cmath>
+
+ModeBlend::ModeBlend()
+    : m_commits(0)
+    , m_step(0)
+{
+}
+
+void ModeBlend::start(int commits)
+{
+    m_commits = commits > 0 ? commits : 0;
+    m_step = 0;
+}
+
+void ModeBlend::stop()
+{
+    m_step = m_commits;
+}
+
+double ModeBlend::weight() const
+{
+    if (m_step >= m_commits) {
+        return 1.0;
+    }
+
+    // The first commit of the fade already moves; the last reaches 1
+    return 0.5 - 0.5 * std::cos(M_PI * (m_step + 1) / m_commits);
+}
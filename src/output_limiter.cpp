@@ -0,0 +1,140 @@
+#include "output_limiter.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+OutputLimiter::Config::Config()
+    : bypass(false)
+{
+    for (ChannelLimits &limits : channel) {
+        limits = ChannelLimits{0.0, 0.0, 0.0};
+    }
+}
+
+OutputLimiter::OutputLimiter()
+    : m_channels(0)
+    , m_position{}
+    , m_velocity{}
+    , m_taps(1)
+    , m_head(0)
+{
+    configure(Config(), MAX_CHANNELS, 1000.0);
+}
+
+bool OutputLimiter::configure(const Config &config, int channels, double commitRateHz)
+{
+    if (channels < 1 || channels > MAX_CHANNELS || !(commitRateHz > 0.0)) {
+        return false;
+    }
+
+    // Boxcar length per channel: the time to ramp to full acceleration
+    int taps[MAX_CHANNELS];
+    for (int i = 0; i < MAX_CHANNELS; i++) {
+        taps[i] = 1;
+        if (i >= channels) {
+            continue;
+        }
+        const ChannelLimits &limits = config.channel[i];
+        if (!(limits.rate >= 0.0) || !(limits.acceleration >= 0.0) || !(limits.jerk >= 0.0)) {
+            return false;
+        }
+        if (limits.jerk > 0.0) {
+            const double rampCommits = limits.acceleration / limits.jerk * commitRateHz;
+            if (limits.acceleration == 0.0 || rampCommits > MAX_JERK_TAPS) {
+                return false;
+            }
+            taps[i] = std::max(1, static_cast<int>(std::ceil(rampCommits - 1e-9)));
+        }
+    }
+
+    m_config = config;
+    m_channels = channels;
+
+    // Unused channels get no limits so the loops can run over all of them
+    const double infinity = std::numeric_limits<double>::infinity();
+    const double dt = 1.0 / commitRateHz;
+    m_taps = 1;
+    for (int i = 0; i < MAX_CHANNELS; i++) {
+        const ChannelLimits limits = i < channels ? config.channel[i] : ChannelLimits{0.0, 0.0, 0.0};
+        m_rateStep[i] = limits.rate > 0.0 ? limits.rate * dt : infinity;
+        m_accelStep[i] = limits.acceleration > 0.0 ? limits.acceleration * dt * dt : infinity;
+        m_invAccelStep[i] = 1.0 / m_accelStep[i];
+        m_taps = std::max(m_taps, taps[i]);
+    }
+
+    // Every channel sums m_taps taps; the weights make each its own length
+    for (int k = 0; k < MAX_JERK_TAPS; k++) {
+        for (int i = 0; i < MAX_CHANNELS; i++) {
+            m_tapWeight[k][i] = k < taps[i] ? 1.0 / taps[i] : 0.0;
+        }
+    }
+
+    double outputs[MAX_CHANNELS];
+    for (int i = 0; i < MAX_CHANNELS; i++) {
+        outputs[i] = m_position[i];
+    }
+    reset(outputs);
+    return true;
+}
+
+void OutputLimiter::reset(const double *outputs)
+{
+    for (int i = 0; i < MAX_CHANNELS; i++) {
+        m_position[i] = i < m_channels ? outputs[i] : 0.0;
+        m_velocity[i] = 0.0;
+    }
+    for (int k = 0; k < MAX_JERK_TAPS; k++) {
+        for (int i = 0; i < MAX_CHANNELS; i++) {
+            m_history[k][i] = m_position[i];
+        }
+    }
+    m_head = 0;
+}
+
+bool OutputLimiter::apply(double *commands)
+{
+    double target[MAX_CHANNELS] = {};
+    for (int i = 0; i < m_channels; i++) {
+        target[i] = commands[i];
+    }
+
+    // Bypassed, follow the commands so leaving bypass does not jump
+    if (m_config.bypass) {
+        reset(target);
+        return false;
+    }
+
+    for (int i = 0; i < MAX_CHANNELS; i++) {
+        const double distance = target[i] - m_position[i];
+        const double remaining = std::abs(distance);
+
+        // Fastest step from which decelerating at the limit stops within
+        // the remaining distance, a (sqrt(1/4 + 2 d / a) - 1/2), written
+        // so an infinite limit gives 2 d instead of infinity times zero
+        const double stopping = 2.0 * remaining / (std::sqrt(0.25 + 2.0 * remaining * m_invAccelStep[i]) + 0.5);
+        const double maxStep = std::min(m_rateStep[i], stopping);
+        const double step = std::max(-maxStep, std::min(maxStep, distance));
+
+        m_velocity[i] += std::max(-m_accelStep[i], std::min(m_accelStep[i], step - m_velocity[i]));
+        m_position[i] += m_velocity[i];
+        m_history[m_head][i] = m_position[i];
+    }
+
+    // Jerk boxcar, newest tap first
+    double output[MAX_CHANNELS] = {};
+    for (int k = 0; k < m_taps; k++) {
+        const int index = (m_head + MAX_JERK_TAPS - k) % MAX_JERK_TAPS;
+        for (int i = 0; i < MAX_CHANNELS; i++) {
+            output[i] += m_tapWeight[k][i] * m_history[index][i];
+        }
+    }
+    m_head = (m_head + 1) % MAX_JERK_TAPS;
+
+    // Rounding in the boxcar is far below a DAC code
+    bool limited = false;
+    for (int i = 0; i < m_channels; i++) {
+        limited |= std::abs(output[i] - target[i]) > 1e-9;
+        commands[i] = output[i];
+    }
+    return limited;
+}
@@ -0,0 +1,79 @@
+#include "rate_group.h"
+#include <time.h>
+
+RateGroupScheduler::RateGroupScheduler()
+    : m_count(0)
+{
+}
+
+void RateGroupScheduler::clear()
+{
+    for (int i = 0; i < m_count; i++) {
+        m_tasks[i].run = nullptr;
+        m_tasks[i].duration.reset();
+    }
+    m_count = 0;
+}
+
+bool RateGroupScheduler::addTask(const char *name, Phase phase, int divisor, int offset, std::function<void()> task)
+{
+    if (m_count == MAX_TASKS || divisor < 1 || offset < 0 || offset >= divisor || !task) {
+        return false;
+    }
+
+    const int index = m_count++;
+    m_tasks[index].info = TaskInfo{name, phase, divisor, offset};
+    m_tasks[index].run = std::move(task);
+    m_tasks[index].duration.reset();
+
+    // Insert after every task of the same or an earlier phase
+    int pos = index;
+    while (pos > 0 && m_tasks[m_order[pos - 1]].info.phase > phase) {
+        m_order[pos] = m_order[pos - 1];
+        pos--;
+    }
+    m_order[pos] = index;
+    return true;
+}
+
+uint32_t RateGroupScheduler::run(uint64_t tick)
+{
+    uint32_t ran = 0;
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t startNs = static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+
+    for (int i = 0; i < m_count; i++) {
+        Task &task = m_tasks[m_order[i]];
+        if ((tick + static_cast<uint64_t>(task.info.offset)) % static_cast<uint64_t>(task.info.divisor) != 0) {
+            continue;
+        }
+
+        task.run();
+        ran |= 1u << m_order[i];
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        const int64_t endNs = static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+        task.duration.record(endNs - startNs);
+        startNs = endNs;
+    }
+    return ran;
+}
+
+void RateGroupScheduler::resetStatistics()
+{
+    for (int i = 0; i < m_count; i++) {
+        m_tasks[i].duration.reset();
+    }
+}
+
+const char *RateGroupScheduler::phaseName(Phase phase)
+{
+    switch (phase) {
+        case Phase::READ: return "read";
+        case Phase::COMPUTE: return "compute";
+        case Phase::WRITE: return "write";
+        case Phase::PUBLISH: return "publish";
+    }
+    return "unknown";
+}
@@ -0,0 +1,178 @@
+#include "realtime_thread.h"
+#include <sched.h>
+#include <time.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+const int64_t NSEC_PER_SEC = 1000000000LL;
+
+inline int64_t toNs(const timespec &ts)
+{
+    return static_cast<int64_t>(ts.tv_sec) * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+inline timespec fromNs(int64_t ns)
+{
+    timespec ts;
+    ts.tv_sec = static_cast<time_t>(ns / NSEC_PER_SEC);
+    ts.tv_nsec = static_cast<long>(ns % NSEC_PER_SEC);
+    return ts;
+}
+
+} // namespace
+
+RealtimeThread::RealtimeThread()
+    : m_thread()
+    , m_threadCreated(false)
+    , m_periodNs(0)
+    , m_running(false)
+    , m_ready(false)
+    , m_isRealtime(false)
+    , m_cycles(0)
+    , m_overruns(0)
+    , m_scheduledWakeNs(0)
+    , m_hasError(false)
+{
+    m_lastError[0] = '\0';
+}
+
+RealtimeThread::~RealtimeThread()
+{
+    stop();
+}
+
+bool RealtimeThread::start(const RealtimeConfig &config, int64_t periodNs, std::function<void()> tick)
+{
+    if (m_threadCreated || periodNs < 0 || !tick) {
+        return false;
+    }
+
+    m_config = config;
+    m_periodNs = periodNs;
+    m_tick = std::move(tick);
+    m_cycles.store(0, std::memory_order_relaxed);
+    m_overruns.store(0, std::memory_order_relaxed);
+    m_isRealtime.store(false, std::memory_order_relaxed);
+    m_hasError.store(false, std::memory_order_relaxed);
+    m_lastError[0] = '\0';
+
+    m_ready.store(false, std::memory_order_relaxed);
+    m_running.store(true, std::memory_order_release);
+    if (pthread_create(&m_thread, nullptr, &RealtimeThread::threadEntry, this) != 0) {
+        m_running.store(false, std::memory_order_release);
+        return false;
+    }
+
+    m_threadCreated = true;
+
+    // Wait until the thread has applied its scheduling parameters
+    while (!m_ready.load(std::memory_order_acquire)) {
+        sched_yield();
+    }
+
+    return true;
+}
+
+void RealtimeThread::stop()
+{
+    m_running.store(false, std::memory_order_release);
+
+    if (m_threadCreated) {
+        pthread_join(m_thread, nullptr);
+        m_threadCreated = false;
+    }
+}
+
+std::string RealtimeThread::lastError() const
+{
+    if (!m_hasError.load(std::memory_order_acquire)) {
+        return std::string();
+    }
+    return std::string(m_lastError);
+}
+
+void *RealtimeThread::threadEntry(void *arg)
+{
+    static_cast<RealtimeThread *>(arg)->run();
+    return nullptr;
+}
+
+void RealtimeThread::applyScheduling()
+{
+    // Pin to the requested CPU first so the thread never runs elsewhere
+    // once it has real-time priority
+    if (m_config.cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(m_config.cpu, &cpus);
+        int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (ret != 0) {
+            snprintf(m_lastError, sizeof(m_lastError), "Failed to pin control thread to CPU %d: %s",
+                     m_config.cpu, strerror(ret));
+            m_hasError.store(true, std::memory_order_release);
+        }
+    }
+
+    if (m_config.fifo) {
+        sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = m_config.priority;
+        int ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (ret == 0) {
+            m_isRealtime.store(true, std::memory_order_relaxed);
+        } else {
+            snprintf(m_lastError, sizeof(m_lastError), "Failed to set SCHED_FIFO priority %d: %s",
+                     m_config.priority, strerror(ret));
+            m_hasError.store(true, std::memory_order_release);
+        }
+    }
+}
+
+void RealtimeThread::run()
+{
+    applyScheduling();
+    m_ready.store(true, std::memory_order_release);
+
+    // Event-driven: the tick blocks on its own source
+    if (m_periodNs == 0) {
+        while (m_running.load(std::memory_order_acquire)) {
+            m_tick();
+            m_cycles.fetch_add(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t nextWake = toNs(now);
+
+    while (m_running.load(std::memory_order_acquire)) {
+        nextWake += m_periodNs;
+
+        // Absolute sleep so the period does not accumulate tick duration
+        timespec wake = fromNs(nextWake);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, nullptr) == EINTR) {
+        }
+
+        if (!m_running.load(std::memory_order_acquire)) {
+            break;
+        }
+
+        m_scheduledWakeNs = nextWake;
+        m_tick();
+        m_cycles.fetch_add(1, std::memory_order_relaxed);
+
+        // The tick overran if it finished after the next wake-up; skip the
+        // missed periods instead of running them back to back
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int64_t late = toNs(now) - (nextWake + m_periodNs);
+        if (late > 0) {
+            int64_t missed = late / m_periodNs + 1;
+            m_overruns.fetch_add(static_cast<uint64_t>(missed), std::memory_order_relaxed);
+            nextWake += missed * m_periodNs;
+        }
+    }
+}
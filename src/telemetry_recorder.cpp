@@ -0,0 +1,336 @@
+#include "telemetry_recorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Writer wakeup interval. The history ring holds ~4 s at 1 kHz, so this
+// leaves a wide margin for a slow disk or a busy machine.
+const auto DRAIN_INTERVAL = std::chrono::milliseconds(10);
+
+int64_t clockNs(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// Every TelemetrySnapshot member must be listed here to be recorded
+void describeFields(RecordingHeader &header)
+{
+#define RECORD_FIELD(member, fieldType) \
+    do { \
+        RecordingField &f = header.fields[header.fieldCount++]; \
+        std::strncpy(f.name, #member, RECORDING_NAME_LENGTH - 1); \
+        f.type = fieldType; \
+        f.offset = offsetof(TelemetrySnapshot, member); \
+    } while (0)
+
+    RECORD_FIELD(cycle, FIELD_U64);
+    RECORD_FIELD(timestampNs, FIELD_I64);
+    RECORD_FIELD(mode, FIELD_I32);
+    RECORD_FIELD(tracking, FIELD_I32);
+    RECORD_FIELD(fsmX, FIELD_F64);
+    RECORD_FIELD(fsmY, FIELD_F64);
+    RECORD_FIELD(fsmXMean, FIELD_F64);
+    RECORD_FIELD(fsmXMin, FIELD_F64);
+    RECORD_FIELD(fsmXMax, FIELD_F64);
+    RECORD_FIELD(fsmXRms, FIELD_F64);
+    RECORD_FIELD(fsmYMean, FIELD_F64);
+    RECORD_FIELD(fsmYMin, FIELD_F64);
+    RECORD_FIELD(fsmYMax, FIELD_F64);
+    RECORD_FIELD(fsmYRms, FIELD_F64);
+    RECORD_FIELD(gimbalAz, FIELD_F64);
+    RECORD_FIELD(gimbalEl, FIELD_F64);
+    RECORD_FIELD(gimbalAuxEl, FIELD_F64);
+    RECORD_FIELD(joystickX, FIELD_F64);
+    RECORD_FIELD(joystickY, FIELD_F64);
+    RECORD_FIELD(joystickZ, FIELD_F64);
+    RECORD_FIELD(trackErrorX, FIELD_F64);
+    RECORD_FIELD(trackErrorY, FIELD_F64);
+    RECORD_FIELD(trackFrame, FIELD_U64);
+    RECORD_FIELD(trackAgeNs, FIELD_I64);
+    RECORD_FIELD(joystickAgeNs, FIELD_I64);
+
+#undef RECORD_FIELD
+}
+
+} // namespace
+
+TelemetryRecorder::TelemetryRecorder()
+    : m_channel(nullptr)
+    , m_fd(-1)
+    , m_mapping(nullptr)
+    , m_mappingSize(0)
+    , m_header(nullptr)
+    , m_records(nullptr)
+    , m_capacity(0)
+    , m_recordCount(0)
+    , m_overflow(0)
+    , m_droppedBase(0)
+    , m_running(false)
+{
+}
+
+TelemetryRecorder::~TelemetryRecorder()
+{
+    stop();
+}
+
+bool TelemetryRecorder::start(const std::string &path, uint64_t capacity, uint32_t controlRateHz,
+                              TelemetryChannel *channel, std::string &error)
+{
+    if (m_running.load(std::memory_order_acquire)) {
+        error = "Recording already active";
+        return false;
+    }
+    if (!channel || capacity == 0) {
+        error = "Invalid recording parameters";
+        return false;
+    }
+
+    m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (m_fd < 0) {
+        error = "Failed to create " + path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    // Reserve the whole file now so the writer never extends it
+    m_mappingSize = RECORDING_HEADER_SIZE + capacity * sizeof(TelemetrySnapshot);
+    int rc = posix_fallocate(m_fd, 0, static_cast<off_t>(m_mappingSize));
+    if (rc != 0) {
+        error = "Failed to preallocate " + path + ": " + std::strerror(rc);
+        ::close(m_fd);
+        m_fd = -1;
+        ::unlink(path.c_str());
+        return false;
+    }
+
+    m_mapping = mmap(nullptr, m_mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (m_mapping == MAP_FAILED) {
+        error = "Failed to map " + path + ": " + std::strerror(errno);
+        m_mapping = nullptr;
+        ::close(m_fd);
+        m_fd = -1;
+        ::unlink(path.c_str());
+        return false;
+    }
+
+    m_header = static_cast<RecordingHeader *>(m_mapping);
+    m_records = reinterpret_cast<TelemetrySnapshot *>(static_cast<char *>(m_mapping) + RECORDING_HEADER_SIZE);
+    m_capacity = capacity;
+
+    std::memset(m_header, 0, RECORDING_HEADER_SIZE);
+    std::memcpy(m_header->magic, RECORDING_MAGIC, sizeof(m_header->magic));
+    m_header->version = RECORDING_VERSION;
+    m_header->headerSize = RECORDING_HEADER_SIZE;
+    m_header->recordSize = sizeof(TelemetrySnapshot);
+    m_header->capacity = capacity;
+    m_header->startRealtimeNs = clockNs(CLOCK_REALTIME);
+    m_header->startMonotonicNs = clockNs(CLOCK_MONOTONIC);
+    m_header->controlRateHz = controlRateHz;
+    describeFields(*m_header);
+
+    m_recordCount.store(0, std::memory_order_relaxed);
+    m_overflow.store(0, std::memory_order_relaxed);
+
+    m_channel = channel;
+    m_droppedBase = channel->droppedHistoryCount();
+    channel->setHistoryEnabled(true);
+
+    m_running.store(true, std::memory_order_release);
+    m_thread = std::thread(&TelemetryRecorder::run, this);
+    return true;
+}
+
+void TelemetryRecorder::stop()
+{
+    if (!m_running.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    m_channel->setHistoryEnabled(false);
+    drain();
+    updateHeader();
+
+    // Give back the unused part of the preallocation
+    msync(m_mapping, m_mappingSize, MS_SYNC);
+    munmap(m_mapping, m_mappingSize);
+    if (ftruncate(m_fd, static_cast<off_t>(RECORDING_HEADER_SIZE + recordCount() * sizeof(TelemetrySnapshot))) != 0) {
+        // The header still bounds the valid records
+    }
+    ::close(m_fd);
+
+    // Keep the final drop count once the channel is released
+    m_overflow.fetch_add(m_channel->droppedHistoryCount() - m_droppedBase, std::memory_order_relaxed);
+
+    m_fd = -1;
+    m_mapping = nullptr;
+    m_header = nullptr;
+    m_records = nullptr;
+    m_channel = nullptr;
+}
+
+uint64_t TelemetryRecorder::droppedCount() const
+{
+    uint64_t dropped = m_overflow.load(std::memory_order_relaxed);
+    if (m_channel) {
+        dropped += m_channel->droppedHistoryCount() - m_droppedBase;
+    }
+    return dropped;
+}
+
+void TelemetryRecorder::run()
+{
+    while (m_running.load(std::memory_order_acquire)) {
+        drain();
+        updateHeader();
+        std::this_thread::sleep_for(DRAIN_INTERVAL);
+    }
+}
+
+void TelemetryRecorder::drain()
+{
+    uint64_t count = m_recordCount.load(std::memory_order_relaxed);
+
+    // Snapshots go straight from the ring into the mapping
+    while (count < m_capacity) {
+        size_t n = m_channel->drainHistory(m_records + count, static_cast<size_t>(m_capacity - count));
+        if (n == 0) {
+            break;
+        }
+        count += n;
+    }
+    m_recordCount.store(count, std::memory_order_relaxed);
+
+    // File full: keep the ring empty and count what is lost
+    if (count == m_capacity) {
+        TelemetrySnapshot discard[64];
+        size_t n;
+        while ((n = m_channel->drainHistory(discard, 64)) > 0) {
+            m_overflow.fetch_add(n, std::memory_order_relaxed);
+        }
+    }
+}
+
+void TelemetryRecorder::updateHeader()
+{
+    // Records become visible to readers only after their data
+    std::atomic_thread_fence(std::memory_order_release);
+    m_header->recordCount = m_recordCount.load(std::memory_order_relaxed);
+    m_header->droppedRecords = droppedCount();
+}
+
+RecordingReader::RecordingReader()
+    : m_fd(-1)
+    , m_data(nullptr)
+    , m_size(0)
+    , m_header(nullptr)
+{
+}
+
+RecordingReader::~RecordingReader()
+{
+    close();
+}
+
+bool RecordingReader::open(const std::string &path, std::string &error)
+{
+    close();
+
+    m_fd = ::open(path.c_str(), O_RDONLY);
+    if (m_fd < 0) {
+        error = "Failed to open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(m_fd, &st) != 0 || static_cast<size_t>(st.st_size) < RECORDING_HEADER_SIZE) {
+        error = path + " is not a recording";
+        close();
+        return false;
+    }
+
+    m_size = static_cast<size_t>(st.st_size);
+    void *mapping = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+    if (mapping == MAP_FAILED) {
+        error = "Failed to map " + path + ": " + std::strerror(errno);
+        close();
+        return false;
+    }
+    m_data = static_cast<const unsigned char *>(mapping);
+    m_header = reinterpret_cast<const RecordingHeader *>(m_data);
+
+    if (std::memcmp(m_header->magic, RECORDING_MAGIC, sizeof(m_header->magic)) != 0) {
+        error = path + " is not a recording";
+        close();
+        return false;
+    }
+    if (m_header->version != RECORDING_VERSION || m_header->headerSize != RECORDING_HEADER_SIZE) {
+        error = path + " has unsupported format version " + std::to_string(m_header->version);
+        close();
+        return false;
+    }
+    if (m_header->fieldCount > RECORDING_MAX_FIELDS
+        || RECORDING_HEADER_SIZE + m_header->recordCount * m_header->recordSize > m_size) {
+        error = path + " is truncated or corrupt";
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void RecordingReader::close()
+{
+    if (m_data) {
+        munmap(const_cast<unsigned char *>(m_data), m_size);
+        m_data = nullptr;
+        m_header = nullptr;
+        m_size = 0;
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+double RecordingReader::value(uint64_t index, const RecordingField &field) const
+{
+    const unsigned char *p = record(index) + field.offset;
+    switch (field.type) {
+    case FIELD_U64: {
+        uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return static_cast<double>(v);
+    }
+    case FIELD_I64: {
+        int64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return static_cast<double>(v);
+    }
+    case FIELD_I32: {
+        int32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    case FIELD_F64: {
+        double v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    default:
+        return 0.0;
+    }
+}
@@ -0,0 +1,92 @@
+#include "tick_monitor.h"
+#include <cmath>
+
+void RunningStat::add(int64_t value)
+{
+    if (count == 0) {
+        min = value;
+        max = value;
+    } else {
+        min = value < min ? value : min;
+        max = value > max ? value : max;
+    }
+
+    count++;
+    const double delta = static_cast<double>(value) - mean;
+    mean += delta / static_cast<double>(count);
+    m2 += delta * (static_cast<double>(value) - mean);
+}
+
+double RunningStat::stddev() const
+{
+    return count > 1 ? std::sqrt(m2 / static_cast<double>(count - 1)) : 0.0;
+}
+
+TickMonitor::TickMonitor()
+    : m_periodNs(0)
+    , m_lastWakeNs(0)
+    , m_resetRequested(false)
+{
+    clear();
+}
+
+void TickMonitor::configure(int64_t periodNs)
+{
+    m_periodNs = periodNs;
+    clear();
+}
+
+void TickMonitor::clear()
+{
+    m_lastWakeNs = 0;
+    m_stats = TickStatistics();
+    m_worst.count = 0;
+    m_publishedStats.store(m_stats);
+    m_publishedWorst.store(m_worst);
+}
+
+void TickMonitor::record(TickRecord tick)
+{
+    if (m_resetRequested.load(std::memory_order_relaxed)) {
+        clear();
+        m_resetRequested.store(false, std::memory_order_relaxed);
+    }
+
+    tick.slackNs = tick.scheduledNs + m_periodNs - tick.endNs;
+
+    m_stats.ticks++;
+    if (tick.slackNs < 0) {
+        m_stats.deadlineMisses++;
+    }
+    if (m_lastWakeNs != 0) {
+        m_stats.period.add(tick.wakeNs - m_lastWakeNs);
+    }
+    m_lastWakeNs = tick.wakeNs;
+    m_stats.lateness.add(tick.wakeNs - tick.scheduledNs);
+    m_stats.duration.add(tick.endNs - tick.wakeNs);
+    m_stats.slack.add(tick.slackNs);
+    m_publishedStats.store(m_stats);
+
+    // Keep the worst ticks sorted by slack, least first. Once the list is
+    // full only a tick worse than the last entry touches it.
+    if (m_worst.count == WORST_COUNT && tick.slackNs >= m_worst.ticks[WORST_COUNT - 1].slackNs) {
+        return;
+    }
+
+    int i = m_worst.count < WORST_COUNT ? m_worst.count++ : WORST_COUNT - 1;
+    while (i > 0 && m_worst.ticks[i - 1].slackNs > tick.slackNs) {
+        m_worst.ticks[i] = m_worst.ticks[i - 1];
+        i--;
+    }
+    m_worst.ticks[i] = tick;
+    m_publishedWorst.store(m_worst);
+}
+
+int TickMonitor::worstTicks(TickRecord *out) const
+{
+    const WorstTicks worst = m_publishedWorst.load();
+    for (int i = 0; i < worst.count; i++) {
+        out[i] = worst.ticks[i];
+    }
+    return worst.count;
+}
@@ -0,0 +1,81 @@
+#include "track_estimator.h"
+
+TrackEstimator::Config::Config()
+    : enabled(true)
+    , model(Model::CONSTANT_VELOCITY)
+    , alpha(0.5)
+    , beta(0.1667)              // alpha^2 / (2 - alpha), critically damped
+    , gamma(0.0278)             // beta^2 / (2 alpha)
+    , frameLatencyNs(4000000)   // One frame of the 250 Hz camera
+    , maxPredictionNs(20000000)
+    , maxGapNs(100000000)
+{
+}
+
+TrackEstimator::TrackEstimator()
+    : m_maxPredictionS(0.0)
+    , m_stateNs(0)
+    , m_initialized(false)
+{
+    configure(Config());
+}
+
+bool TrackEstimator::configure(const Config &config)
+{
+    // Stability region of the alpha-beta recursion
+    if (!(config.alpha > 0.0 && config.alpha <= 1.0) ||
+        !(config.beta >= 0.0 && config.beta < 4.0 - 2.0 * config.alpha) ||
+        !(config.gamma >= 0.0) ||
+        config.frameLatencyNs < 0 || config.maxPredictionNs < 0 || config.maxGapNs <= 0) {
+        return false;
+    }
+
+    m_config = config;
+    m_maxPredictionS = config.maxPredictionNs * 1e-9;
+    reset();
+    return true;
+}
+
+void TrackEstimator::reset()
+{
+    for (AxisState &axis : m_axis) {
+        axis = AxisState{0.0, 0.0, 0.0};
+    }
+    m_stateNs = 0;
+    m_initialized = false;
+}
+
+void TrackEstimator::update(double x, double y, int64_t arrivalNs)
+{
+    // The error describes the scene when the frame was exposed
+    const int64_t frameNs = arrivalNs - m_config.frameLatencyNs;
+    const int64_t gapNs = frameNs - m_stateNs;
+
+    // First frame, a gap or a clock step: start over from this measurement
+    if (!m_initialized || gapNs <= 0 || gapNs > m_config.maxGapNs) {
+        m_axis[0] = AxisState{x, 0.0, 0.0};
+        m_axis[1] = AxisState{y, 0.0, 0.0};
+        m_stateNs = frameNs;
+        m_initialized = true;
+        return;
+    }
+
+    const double dt = gapNs * 1e-9;
+    correct(m_axis[0], x, dt);
+    correct(m_axis[1], y, dt);
+    m_stateNs = frameNs;
+}
+
+void TrackEstimator::correct(AxisState &axis, double measurement, double dt)
+{
+    // Predict to the frame, then correct by the residual
+    const bool accel = m_config.model == Model::CONSTANT_ACCELERATION;
+    const double a = accel ? axis.acceleration : 0.0;
+    const double position = axis.position + axis.velocity * dt + 0.5 * a * dt * dt;
+    const double velocity = axis.velocity + a * dt;
+    const double residual = measurement - position;
+
+    axis.position = position + m_config.alpha * residual;
+    axis.velocity = velocity + m_config.beta * residual / dt;
+    axis.acceleration = accel ? a + 2.0 * m_config.gamma * residual / (dt * dt) : 0.0;
+}
@@ -0,0 +1,146 @@
+#include "track_loss.h"
+
+TrackLossPolicy::Config::Config()
+    : coastNs(100000000)    // A few tracker frames of occlusion
+    , holdNs(500000000)
+    , fallback(Fallback::CENTER)
+{
+}
+
+TrackLossPolicy::TrackLossPolicy()
+    : m_state(State::IDLE)
+    , m_lossNs(0)
+    , m_lastNs(0)
+    , m_resetRequested(false)
+    , m_losses(0)
+    , m_reacquiredCoasting(0)
+    , m_reacquiredHolding(0)
+    , m_reacquiredFallback(0)
+    , m_handedOff(0)
+    , m_autoNs(0)
+    , m_trackedNs(0)
+{
+}
+
+bool TrackLossPolicy::configure(const Config &config)
+{
+    if (config.coastNs < 0 || config.holdNs < 0) {
+        return false;
+    }
+    m_config = config;
+    return true;
+}
+
+bool TrackLossPolicy::update(bool autoTrack, bool tracking, int64_t nowNs)
+{
+    if (m_resetRequested.load(std::memory_order_relaxed)) {
+        m_losses.store(0, std::memory_order_relaxed);
+        m_reacquiredCoasting.store(0, std::memory_order_relaxed);
+        m_reacquiredHolding.store(0, std::memory_order_relaxed);
+        m_reacquiredFallback.store(0, std::memory_order_relaxed);
+        m_handedOff.store(0, std::memory_order_relaxed);
+        m_autoNs.store(0, std::memory_order_relaxed);
+        m_trackedNs.store(0, std::memory_order_relaxed);
+        m_resetRequested.store(false, std::memory_order_relaxed);
+    }
+
+    // Availability: the share of auto track time with a target, counted
+    // over the tick that just ended
+    const State previous = m_state;
+    if (previous != State::IDLE) {
+        const int64_t elapsed = nowNs - m_lastNs;
+        m_autoNs.store(m_autoNs.load(std::memory_order_relaxed) + elapsed, std::memory_order_relaxed);
+        if (previous == State::TRACKING) {
+            m_trackedNs.store(m_trackedNs.load(std::memory_order_relaxed) + elapsed, std::memory_order_relaxed);
+        }
+    }
+    m_lastNs = nowNs;
+
+    // Leaving auto track ends any loss without an outcome
+    if (!autoTrack) {
+        m_state = State::IDLE;
+        return m_state != previous;
+    }
+
+    if (tracking) {
+        switch (m_state) {
+            case State::COASTING: endLoss(m_reacquiredCoasting, nowNs); break;
+            case State::HOLDING: endLoss(m_reacquiredHolding, nowNs); break;
+            case State::FALLBACK: endLoss(m_reacquiredFallback, nowNs); break;
+            case State::IDLE:
+            case State::ACQUIRING:
+            case State::TRACKING:
+                break;
+        }
+        m_state = State::TRACKING;
+        return m_state != previous;
+    }
+
+    // Not tracking. Without a target since entering auto track there is
+    // nothing to coast on; otherwise each limit is checked in turn so a
+    // zero coast or hold time passes straight through it.
+    if (m_state == State::IDLE) {
+        m_state = State::ACQUIRING;
+    }
+    if (m_state == State::TRACKING) {
+        m_lossNs = nowNs;
+        m_losses.store(m_losses.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        m_state = State::COASTING;
+    }
+    if (m_state == State::COASTING && nowNs - m_lossNs >= m_config.coastNs) {
+        m_state = State::HOLDING;
+    }
+    if (m_state == State::HOLDING && nowNs - m_lossNs >= m_config.coastNs + m_config.holdNs) {
+        m_state = State::FALLBACK;
+        if (m_config.fallback == Fallback::MANUAL) {
+            m_handedOff.store(m_handedOff.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+    }
+    return m_state != previous;
+}
+
+void TrackLossPolicy::restart()
+{
+    m_state = State::IDLE;
+    m_lossNs = 0;
+    m_lastNs = 0;
+}
+
+TrackLossStatistics TrackLossPolicy::statistics() const
+{
+    TrackLossStatistics stats;
+    stats.losses = m_losses.load(std::memory_order_relaxed);
+    stats.reacquiredCoasting = m_reacquiredCoasting.load(std::memory_order_relaxed);
+    stats.reacquiredHolding = m_reacquiredHolding.load(std::memory_order_relaxed);
+    stats.reacquiredFallback = m_reacquiredFallback.load(std::memory_order_relaxed);
+    stats.handedOff = m_handedOff.load(std::memory_order_relaxed);
+    stats.autoNs = m_autoNs.load(std::memory_order_relaxed);
+    stats.trackedNs = m_trackedNs.load(std::memory_order_relaxed);
+    stats.reacquisition = m_reacquisition.summary();
+    return stats;
+}
+
+void TrackLossPolicy::resetStatistics()
+{
+    m_resetRequested.store(true, std::memory_order_relaxed);
+    m_reacquisition.reset();
+}
+
+const char *TrackLossPolicy::stateName(State state)
+{
+    switch (state) {
+        case State::IDLE: return "idle";
+        case State::ACQUIRING: return "acquiring";
+        case State::TRACKING: return "tracking";
+        case State::COASTING: return "coasting";
+        case State::HOLDING: return "holding";
+        case State::FALLBACK: return "fallback";
+    }
+    return "unknown";
+}
+
+void TrackLossPolicy::endLoss(std::atomic<uint64_t> &counter, int64_t nowNs)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    m_reacquisition.record(nowNs - m_lossNs);
+}
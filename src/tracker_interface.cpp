@@ -1,14 +1,11 @@
 #include "tracker_interface.h"
 #include <QDebug>
 #include <QObject>
-#include <QEventLoop>
-#include <QTimer>
 #include <unistd.h>
-#include <fcntl.h>
 #include <sys/ioctl.h>
+#include <time.h>
 #include <cstring>
 #include <cmath>
-#include <cstdlib>   // For system()
 
 // Dummy definitions for the tracker card interface
 // These would be replaced with actual definitions from the Moog 7007 API
@@ -19,7 +16,7 @@
 
 TrackerInterface::TrackerInterface(QObject *parent)
     : QObject(parent)
-    , m_fd(-1)
+    , m_source(Hardware::createTrackerSource())
     , m_mappedMem(nullptr)
     , m_memSize(0)
     , m_baseAddress(0)
@@ -27,15 +24,21 @@ TrackerInterface::TrackerInterface(QObject *parent)
     , m_pciBus(0x98)
     , m_pciSlot(0x00)
     , m_pciFunc(0x00)
+    , m_interruptMode(false)
+    , m_scheduled(false)
+    , m_notifyTimer(new QTimer(this))
+    , m_notifiedFrame(0)
+    , m_notifiedTracking(false)
     , m_running(false)
     , m_isTracking(false)
-    , m_xError(0.0)
-    , m_yError(0.0)
+    , m_sample(TrackSample{0.0, 0.0, 0, 0})
+    , m_frameCount(0)
+    , m_lastValidNs(0)
+    , m_staleTimeoutNs(0)
+    , m_rejectedFrames(0)
 {
-    // Connect the thread finished signal
-    connect(&m_pollingThread, &QThread::finished, this, [this]() {
-        m_running = false;
-    });
+    m_notifyTimer->setInterval(TRACKER_NOTIFY_INTERVAL_MS);
+    connect(m_notifyTimer, &QTimer::timeout, this, &TrackerInterface::publishStatus);
 }
 
 TrackerInterface::~TrackerInterface()
@@ -44,35 +47,6 @@ TrackerInterface::~TrackerInterface()
     cleanupMemoryMapping();
 }
 
-bool TrackerInterface::configurePCIDevice()
-{
-    qDebug() << QString("Attempting to configure PCI device at %1:%2.%3")
-        .arg(m_pciBus, 2, 16, QChar('0'))
-        .arg(m_pciSlot, 2, 16, QChar('0'))
-        .arg(m_pciFunc);
-
-    // Format the command string
-    QString pciDeviceAddress = QString("%1:%2.%3")
-        .arg(m_pciBus, 2, 16, QChar('0'))
-        .arg(m_pciSlot, 2, 16, QChar('0'))
-        .arg(m_pciFunc);
-
-    QString cmd = QString("setpci -s %1 04.w=0142").arg(pciDeviceAddress);
-
-    qDebug() << "Executing command:" << cmd;
-
-    // Execute the command
-    int result = system(cmd.toStdString().c_str());
-
-    if (result != 0) {
-        emit errorOccurred(QString("Failed to execute setpci command: %1").arg(cmd));
-        return false;
-    }
-
-    qDebug() << "Successfully executed:" << cmd;
-    return true;
-}
-
 bool TrackerInterface::initialize(uintptr_t baseAddress, size_t memSize,
                                  uint8_t pciBus, uint8_t pciSlot, uint8_t pciFunc)
 {
@@ -90,12 +64,6 @@ bool TrackerInterface::initialize(uintptr_t baseAddress, size_t memSize,
     m_baseAddress = baseAddress;
     m_memSize = memSize;
 
-    // First configure the PCI device
-    if (!configurePCIDevice()) {
-        emit errorOccurred("Failed to configure PCI device");
-        return false;
-    }
-
     // Set up memory mapping to access the tracker card
     if (!setupMemoryMapping()) {
         emit errorOccurred("Failed to initialize tracker interface");
@@ -111,7 +79,8 @@ bool TrackerInterface::initialize(uintptr_t baseAddress, size_t memSize,
     m_initialized = true;
     emit statusChanged("Tracker interface initialized");
 
-    // Send a ping to verify communication
+    // Send a ping to verify communication; ping() takes the mutex itself
+    locker.unlock();
     if (!ping()) {
         emit errorOccurred("Tracker initialization completed but ping failed");
         // Continue anyway as initialization was successful
@@ -120,6 +89,12 @@ bool TrackerInterface::initialize(uintptr_t baseAddress, size_t memSize,
     return true;
 }
 
+void TrackerInterface::setIngestConfig(const TrackerIngestConfig &config)
+{
+    QMutexLocker locker(&m_mutex);
+    m_ingestConfig = config;
+}
+
 bool TrackerInterface::start()
 {
     QMutexLocker locker(&m_mutex);
@@ -133,38 +108,67 @@ bool TrackerInterface::start()
         return true; // Already running
     }
 
-    // Start the polling thread
+    // Fall back to polling when the source has no interrupt
+    m_interruptMode = m_ingestConfig.useInterrupt && m_source->hasInterrupt();
+    if (m_ingestConfig.useInterrupt && !m_interruptMode) {
+        emit errorOccurred("Tracker interrupt not available, polling the status mailbox");
+    }
+
+    m_frameCount = 0;
+    m_sample.store(TrackSample{0.0, 0.0, 0, 0});
+
+    // Give the first message the stale timeout to arrive
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    m_lastValidNs = static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+    m_staleTimeoutNs = 0;
+    if (m_ingestConfig.staleFrames > 0 && m_ingestConfig.frameRateHz > 0.0) {
+        m_staleTimeoutNs = static_cast<int64_t>(1e9 * m_ingestConfig.staleFrames / m_ingestConfig.frameRateHz);
+    }
+    m_rejectedFrames.store(0, std::memory_order_relaxed);
+    m_scheduled = m_ingestConfig.scheduled;
     m_running = true;
 
-    // Move this object to the polling thread
-    moveToThread(&m_pollingThread);
+    if (m_scheduled) {
+        // The control thread stores the messages; they are signalled from here
+        m_notifiedFrame = 0;
+        m_notifiedTracking = m_isTracking.load();
+        m_notifyTimer->start();
+        emit statusChanged("Tracker interface started (polled by the control thread)");
+        return true;
+    }
 
-    // Connect thread started signal to the polling function
-    connect(&m_pollingThread, &QThread::started, this, &TrackerInterface::trackerPollingThread);
+    // The ingest thread takes m_mutex to store each message
+    locker.unlock();
 
-    // Start the thread
-    m_pollingThread.start(QThread::HighPriority);  // Use high priority for real-time operation
+    if (!m_ingestThread.start(m_ingestConfig.realtime, 0, [this]() { ingestStatus(); })) {
+        m_running = false;
+        emit errorOccurred("Failed to start tracker ingest thread");
+        return false;
+    }
 
-    emit statusChanged("Tracker interface started");
+    std::string rtError = m_ingestThread.lastError();
+    if (!rtError.empty()) {
+        emit errorOccurred(QString::fromStdString(rtError));
+    }
+
+    emit statusChanged(QString("Tracker interface started (%1)")
+                      .arg(m_interruptMode ? "interrupt" : QString("polling every %1 us").arg(m_ingestConfig.pollIntervalUs)));
     return true;
 }
 
 bool TrackerInterface::stop()
 {
-    QMutexLocker locker(&m_mutex);
-
     if (!m_running) {
         return true; // Already stopped
     }
 
-    // Signal the thread to stop
-    m_running = false;
+    // Join the ingest thread before taking the mutex it uses
+    m_ingestThread.stop();
+    m_notifyTimer->stop();
 
-    // Wait for thread to finish
-    if (m_pollingThread.isRunning()) {
-        m_pollingThread.quit();
-        m_pollingThread.wait();
-    }
+    QMutexLocker locker(&m_mutex);
+    m_running = false;
 
     emit statusChanged("Tracker interface stopped");
     return true;
@@ -172,19 +176,19 @@ bool TrackerInterface::stop()
 
 void TrackerInterface::getTrackingErrors(double &xError, double &yError)
 {
-    QMutexLocker locker(&m_mutex);
-    xError = m_xError;
-    yError = m_yError;
+    const TrackSample sample = m_sample.load();
+    xError = sample.xError;
+    yError = sample.yError;
 }
 
 bool TrackerInterface::getTrackingError(double &xError, double &yError, QString &state)
 {
+    getTrackingErrors(xError, yError);
+
     QMutexLocker locker(&m_mutex);
-    xError = m_xError;
-    yError = m_yError;
     
     // Set the state string based on current tracking status
-    if (m_isTracking) {
+    if (m_isTracking.load()) {
         state = "Tracking";
     } else {
         state = "Not Tracking";
@@ -193,10 +197,38 @@ bool TrackerInterface::getTrackingError(double &xError, double &yError, QString
     return m_initialized; // Return true if tracker is initialized
 }
 
+uint64_t TrackerInterface::getRejectedFrameCount() const
+{
+    return m_rejectedFrames.load(std::memory_order_relaxed);
+}
+
+LatencySummary TrackerInterface::getIngestLatency() const
+{
+    return m_ingestLatency.summary();
+}
+
+void TrackerInterface::resetIngestLatency()
+{
+    m_ingestLatency.reset();
+}
+
+uint64_t TrackerInterface::getContentionCount() const
+{
+    return m_sample.contentionCount();
+}
+
+uint64_t TrackerInterface::getLatestFrame(double &xError, double &yError, int64_t &arrivalNs)
+{
+    const TrackSample sample = m_sample.load();
+    xError = sample.xError;
+    yError = sample.yError;
+    arrivalNs = sample.arrivalNs;
+    return sample.frame;
+}
+
 bool TrackerInterface::isTargetTracked() const
 {
-    QMutexLocker locker(&m_mutex);
-    return m_isTracking;
+    return m_isTracking.load();
 }
 
 bool TrackerInterface::ping()
@@ -218,7 +250,7 @@ bool TrackerInterface::ping()
 
     // Construct ping message (message type 0)
     uint16_t pingMessage[3];
-    pingMessage[0] = 0xA5A5; // Sync word
+    pingMessage[0] = TRACKER_SYNC_WORD; // Sync word
     pingMessage[1] = 0x0000; // Message Type 0 (Ping)
 
     // Calculate checksum - two's complement of the sum
@@ -248,88 +280,165 @@ bool TrackerInterface::ping()
     return true;
 }
 
-void TrackerInterface::trackerPollingThread()
+bool TrackerInterface::waitForStatus()
 {
-    // Create a high-precision timer for consistent timing
-    QTimer timer;
-    timer.setTimerType(Qt::PreciseTimer);
-    timer.setInterval(TRACKER_POLLING_RATE_MS);  // 4ms = 250Hz
-
-    // Use a lambda to poll the tracker at the desired rate
-    QObject::connect(&timer, &QTimer::timeout, [this]() {
-        if (!m_running) {
-            return;
-        }
-
-        // Read tracker data
-        TrackData data;
-        if (readStatusData(data)) {
-            QMutexLocker locker(&m_mutex);
-
-            // Update tracking status if changed
-            bool newTrackingState = data.isTracking();
-            if (m_isTracking != newTrackingState) {
-                m_isTracking = newTrackingState;
-                emit trackingStatusChanged(m_isTracking);
-            }
+    if (readWord(STATUS_MAILBOX_OFFSET) != 0) {
+        return true;
+    }
+
+    if (m_interruptMode) {
+        // The interrupt may also be a command acknowledge, so check again
+        return m_source->waitForInterrupt(TRACKER_WAIT_TIMEOUT_MS) > 0 &&
+               readWord(STATUS_MAILBOX_OFFSET) != 0;
+    }
 
-            // Update tracking errors and scale to -1.0 to 1.0 range
-            // Raw error values from the tracker card are already scaled by 32
-            m_xError = data.rawErrorX / 10.0; // Scale to appropriate range for our system
-            m_yError = data.rawErrorY / 10.0;
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
 
-            // Emit signal with new tracking errors
-            emit trackingErrorsUpdated(m_xError, m_yError);
-        }
-    });
+    // Spin briefly for a message that is about to arrive
+    if (m_ingestConfig.spinUs > 0) {
+        const int64_t deadline = static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec +
+                                 static_cast<int64_t>(m_ingestConfig.spinUs) * 1000;
+        do {
+            if (readWord(STATUS_MAILBOX_OFFSET) != 0) {
+                return true;
+            }
+            clock_gettime(CLOCK_MONOTONIC, &now);
+        } while (static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec < deadline);
+    }
 
-    // Start the timer
-    timer.start();
+    timespec interval;
+    interval.tv_sec = m_ingestConfig.pollIntervalUs / 1000000;
+    interval.tv_nsec = static_cast<long>(m_ingestConfig.pollIntervalUs % 1000000) * 1000;
+    clock_nanosleep(CLOCK_MONOTONIC, 0, &interval, nullptr);
 
-    // Event loop to keep the thread running
-    QEventLoop loop;
-    QObject::connect(this, &TrackerInterface::destroyed, &loop, &QEventLoop::quit);
-    QObject::connect(&m_pollingThread, &QThread::finished, &loop, &QEventLoop::quit);
-    loop.exec();
+    return readWord(STATUS_MAILBOX_OFFSET) != 0;
+}
 
-    // Stop the timer when the event loop exits
-    timer.stop();
+void TrackerInterface::ingestStatus()
+{
+    if (!waitForStatus() || !storeStatus()) {
+        expireTrack();
+    }
 }
 
-bool TrackerInterface::setupMemoryMapping()
+bool TrackerInterface::pollStatus()
 {
-    // Open /dev/mem for physical memory access
-    m_fd = open("/dev/mem", O_RDWR | O_SYNC);
-    if (m_fd == -1) {
-        emit errorOccurred("Failed to open /dev/mem");
+    if (!m_running.load() || !m_scheduled) {
         return false;
     }
+    if (readWord(STATUS_MAILBOX_OFFSET) != 0 && storeStatus()) {
+        return true;
+    }
+    expireTrack();
+    return false;
+}
 
-    // Map the physical memory
-    m_mappedMem = mmap(nullptr, m_memSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, m_baseAddress);
-    if (m_mappedMem == MAP_FAILED) {
-        emit errorOccurred("Failed to map physical memory for tracker card");
-        close(m_fd);
-        m_fd = -1;
+void TrackerInterface::expireTrack()
+{
+    if (m_staleTimeoutNs <= 0 || !m_isTracking.load()) {
+        return;
+    }
+
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec - m_lastValidNs <= m_staleTimeoutNs) {
+        return;
+    }
+
+    // A lost card or video sends nothing, so the last message may still
+    // say tracking
+    m_isTracking.store(false);
+    if (!m_scheduled) {
+        emit trackingStatusChanged(false);
+    }
+}
+
+bool TrackerInterface::storeStatus()
+{
+    // Read tracker data
+    TrackData data;
+    if (!readStatusData(data)) {
         return false;
     }
 
-    qDebug() << "Memory mapped successfully at" << QString::number(m_baseAddress, 16);
+    // Update tracking errors and scale to -1.0 to 1.0 range
+    // Raw error values from the tracker card are already scaled by 32
+    TrackSample sample;
+    sample.xError = data.rawErrorX / 10.0; // Scale to appropriate range for our system
+    sample.yError = data.rawErrorY / 10.0;
+    sample.arrivalNs = data.arrivalNs;
+    sample.frame = ++m_frameCount;
+    m_sample.store(sample);
+    m_lastValidNs = data.arrivalNs;
+
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    m_ingestLatency.record(static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec - data.arrivalNs);
+
+    // Update tracking status if changed
+    bool newTrackingState = data.isTracking();
+    const bool changed = m_isTracking.exchange(newTrackingState) != newTrackingState;
+
+    // Polled by the control thread: publishStatus() signals it later
+    if (m_scheduled) {
+        return true;
+    }
+
+    if (changed) {
+        emit trackingStatusChanged(newTrackingState);
+    }
+
+    // Emit signal with new tracking errors
+    emit trackingErrorsUpdated(sample.xError, sample.yError);
     return true;
 }
 
-void TrackerInterface::cleanupMemoryMapping()
+void TrackerInterface::publishStatus()
 {
-    if (m_mappedMem != nullptr && m_mappedMem != MAP_FAILED) {
-        munmap(m_mappedMem, m_memSize);
-        m_mappedMem = nullptr;
+    const TrackSample sample = m_sample.load();
+    const bool tracking = m_isTracking.load();
+
+    if (tracking != m_notifiedTracking) {
+        m_notifiedTracking = tracking;
+        emit trackingStatusChanged(tracking);
     }
 
-    if (m_fd != -1) {
-        close(m_fd);
-        m_fd = -1;
+    // Only the latest of the messages since the last call
+    if (sample.frame != m_notifiedFrame) {
+        m_notifiedFrame = sample.frame;
+        emit trackingErrorsUpdated(sample.xError, sample.yError);
     }
+}
 
+bool TrackerInterface::setupMemoryMapping()
+{
+    // Configure the PCI device and map its memory (or the simulated mailbox)
+    TrackerLocation location;
+    location.baseAddress = m_baseAddress;
+    location.memSize = m_memSize;
+    location.pciBus = m_pciBus;
+    location.pciSlot = m_pciSlot;
+    location.pciFunc = m_pciFunc;
+    if (m_ingestConfig.useInterrupt) {
+        location.interruptDevice = m_ingestConfig.interruptDevice;
+    }
+
+    std::string error;
+    if (!m_source->open(location, error)) {
+        emit errorOccurred(QString::fromStdString(error));
+        return false;
+    }
+
+    m_mappedMem = m_source->memory();
+    qDebug() << "Memory mapped successfully at" << QString::number(m_baseAddress, 16);
+    return true;
+}
+
+void TrackerInterface::cleanupMemoryMapping()
+{
+    m_source->close();
+    m_mappedMem = nullptr;
     m_initialized = false;
 }
 
@@ -366,32 +475,39 @@ bool TrackerInterface::readStatusData(TrackData &data)
         return false; // No new status available
     }
 
-    // Read the status message header (sync word and message type)
-    uint16_t syncWord = readWord(STATUS_MESSAGE_OFFSET);
-    uint16_t msgType = readWord(STATUS_MESSAGE_OFFSET + 2);
-
-    // Verify sync word and message type
-    if (syncWord != 0xA5A5 || (msgType & 0xFF00) != 0xFF00) {
-        // Invalid status message, clear mailbox and return
-        writeWord(STATUS_MAILBOX_OFFSET, 0);
-        return false;
-    }
-
-    // Read raw track errors
-    data.rawErrorX = static_cast<float>(static_cast<int16_t>(readWord(STATUS_MESSAGE_OFFSET + 4))) / 32.0f;
-    data.rawErrorY = static_cast<float>(static_cast<int16_t>(readWord(STATUS_MESSAGE_OFFSET + 6))) / 32.0f;
+    // Stamp the message as soon as the mailbox is seen set
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    data.arrivalNs = static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
 
-    // Read status information
-    uint16_t statusWord = readWord(STATUS_MESSAGE_OFFSET + 10);
-    data.trackState = (statusWord >> 3) & 0x0007; // Extract track state bits
-    data.status = readWord(STATUS_MESSAGE_OFFSET + 12);
+    // Copy the whole message in a few wide reads, then parse it from
+    // cached memory
+    uint16_t words[STATUS_MESSAGE_WORDS];
+    TrackerStatus::copyBlock(m_mappedMem, words);
 
     // Clear the status mailbox to indicate we've read the message
     writeWord(STATUS_MAILBOX_OFFSET, 0);
 
+    if (TrackerStatus::parse(words, data) != StatusParseResult::OK) {
+        // Invalid or torn status message
+        m_rejectedFrames.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
     return true;
 }
 
+void TrackerInterface::postStatusMessage(const uint16_t *message)
+{
+    for (int i = 0; i < STATUS_MESSAGE_WORDS; i++) {
+        writeWord(STATUS_MESSAGE_OFFSET + i * 2, message[i]);
+    }
+
+    // The message is complete before the mailbox says so
+    std::atomic_thread_fence(std::memory_order_release);
+    writeWord(STATUS_MAILBOX_OFFSET, 1);
+}
+
 bool TrackerInterface::isReadyForCommand()
 {
     // Check if the command mailbox contains a zero value
@@ -400,14 +516,5 @@ bool TrackerInterface::isReadyForCommand()
 
 uint16_t TrackerInterface::calculateChecksum(const uint16_t* data, size_t words)
 {
-    uint16_t sum = 0;
-
-    // Add each byte separately (endian-aware)
-    for (size_t i = 0; i < words; ++i) {
-        sum += (data[i] >> 8) & 0xFF;  // High byte
-        sum += data[i] & 0xFF;         // Low byte
-    }
-
-    // Two's complement
-    return (~sum) + 1;
-}
\ No newline at end of file
+    return TrackerStatus::checksum(data, words);
+}
@@ -0,0 +1,66 @@
+#include "tracker_status.h"
+#include <cstring>
+
+namespace TrackerStatus {
+
+uint16_t checksum(const uint16_t *data, size_t words)
+{
+    uint16_t sum = 0;
+
+    // Add each byte separately (endian-aware)
+    for (size_t i = 0; i < words; ++i) {
+        sum += (data[i] >> 8) & 0xFF;  // High byte
+        sum += data[i] & 0xFF;         // Low byte
+    }
+
+    // Two's complement
+    return (~sum) + 1;
+}
+
+void copyBlock(const volatile void *base, uint16_t *words)
+{
+    const volatile char *block = static_cast<const volatile char *>(base) + STATUS_MESSAGE_OFFSET;
+
+    static_assert((STATUS_MESSAGE_WORDS * sizeof(uint16_t)) % sizeof(uint64_t) == 0,
+                  "status block must be a whole number of 64-bit words");
+
+    if (reinterpret_cast<uintptr_t>(block) % sizeof(uint64_t) == 0) {
+        const volatile uint64_t *src = reinterpret_cast<const volatile uint64_t *>(block);
+        const size_t count = STATUS_MESSAGE_WORDS * sizeof(uint16_t) / sizeof(uint64_t);
+        for (size_t i = 0; i < count; i++) {
+            const uint64_t value = src[i];
+            std::memcpy(words + i * 4, &value, sizeof(value));
+        }
+        return;
+    }
+
+    const volatile uint16_t *src = reinterpret_cast<const volatile uint16_t *>(block);
+    for (size_t i = 0; i < STATUS_MESSAGE_WORDS; i++) {
+        words[i] = src[i];
+    }
+}
+
+StatusParseResult parse(const uint16_t *words, TrackData &data)
+{
+    // Verify sync word and message type
+    if (words[STATUS_SYNC_WORD / 2] != TRACKER_SYNC_WORD ||
+        (words[STATUS_MSG_TYPE / 2] & 0xFF00) != 0xFF00) {
+        return StatusParseResult::BAD_HEADER;
+    }
+
+    if (checksum(words, STATUS_CHECKSUM / 2) != words[STATUS_CHECKSUM / 2]) {
+        return StatusParseResult::BAD_CHECKSUM;
+    }
+
+    // Raw track errors are in 1/32 pixel
+    data.rawErrorX = static_cast<float>(static_cast<int16_t>(words[STATUS_ERROR_X / 2])) / 32.0f;
+    data.rawErrorY = static_cast<float>(static_cast<int16_t>(words[STATUS_ERROR_Y / 2])) / 32.0f;
+
+    // Extract track state bits
+    data.trackState = (words[STATUS_STATUS_WORD / 2] >> 3) & 0x0007;
+    data.status = words[STATUS_STATUS / 2];
+
+    return StatusParseResult::OK;
+}
+
+} // namespace TrackerStatus
@@ -0,0 +1,40 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <cmath>
+#include <cstdio>
+
+// Minimal checks for the behaviour tests. A failed check is reported with
+// its location and the test goes on; main() returns checkResult().
+static int g_checkFailures = 0;
+
+#define CHECK(condition)                                                              \
+    do {                                                                              \
+        if (!(condition)) {                                                           \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,    \
+                         #condition);                                                 \
+            g_checkFailures++;                                                        \
+        }                                                                             \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance)                                       \
+    do {                                                                              \
+        const double checkActual = (actual);                                          \
+        const double checkExpected = (expected);                                      \
+        if (!(std::abs(checkActual - checkExpected) <= (tolerance))) {                \
+            std::fprintf(stderr, "%s:%d: check failed: %s = %.9g, expected %.9g\n",   \
+                         __FILE__, __LINE__, #actual, checkActual, checkExpected);    \
+            g_checkFailures++;                                                        \
+        }                                                                             \
+    } while (0)
+
+static inline int checkResult()
+{
+    if (g_checkFailures != 0) {
+        std::fprintf(stderr, "%d checks failed\n", g_checkFailures);
+        return 1;
+    }
+    return 0;
+}
+
+#endif // CHECK_H
@@ -0,0 +1,114 @@
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "broadcast_ring.h"
+#include "check.h"
+
+namespace {
+
+struct Sample {
+    uint64_t n;
+    uint64_t inverted;
+};
+
+typedef BroadcastRing<Sample, 8> Ring;
+
+void testReadersKeepUp()
+{
+    Ring ring;
+    Sample s;
+    CHECK(!ring.latest(s));
+    CHECK(ring.read(0, s) == Ring::ReadResult::NOT_YET);
+
+    for (uint64_t n = 0; n < 5; n++) {
+        ring.push(Sample{n, ~n});
+    }
+    CHECK(ring.head() == 5);
+    CHECK(ring.latest(s) && s.n == 4);
+
+    // Two readers with their own cursors see the same elements
+    uint64_t cursorA = 0, cursorB = 0, lostA = 0, lostB = 0;
+    Sample out[16];
+    CHECK(ring.readFrom(cursorA, out, 3, lostA) == 3);
+    CHECK(out[0].n == 0 && out[2].n == 2);
+    CHECK(ring.readFrom(cursorA, out, 16, lostA) == 2);
+    CHECK(out[0].n == 3 && out[1].n == 4);
+    CHECK(ring.readFrom(cursorB, out, 16, lostB) == 5);
+    CHECK(cursorA == 5 && cursorB == 5);
+    CHECK(lostA == 0 && lostB == 0);
+    CHECK(ring.readFrom(cursorA, out, 16, lostA) == 0);
+}
+
+void testOverwriteCounting()
+{
+    Ring ring;
+    for (uint64_t n = 0; n < 30; n++) {
+        ring.push(Sample{n, ~n});
+    }
+
+    Sample s;
+    CHECK(ring.read(3, s) == Ring::ReadResult::OVERWRITTEN);
+    CHECK(ring.read(30, s) == Ring::ReadResult::NOT_YET);
+    CHECK(ring.read(29, s) == Ring::ReadResult::OK && s.n == 29);
+
+    // A reader that fell behind loses what was overwritten and resumes
+    // at the oldest element still held
+    uint64_t cursor = 0, lost = 0;
+    Sample out[16];
+    CHECK(ring.readFrom(cursor, out, 16, lost) == 8);
+    CHECK(lost == 22);
+    CHECK(out[0].n == 22 && out[7].n == 29);
+    CHECK(cursor == 30);
+
+    // A second reader further along is not affected
+    uint64_t ahead = 25, lostAhead = 0;
+    CHECK(ring.readFrom(ahead, out, 16, lostAhead) == 5);
+    CHECK(lostAhead == 0 && out[0].n == 25);
+}
+
+void testConcurrentReader()
+{
+    // Every position is either read intact or counted as lost, never both
+    const uint64_t count = 300000;
+    Ring ring;
+    std::atomic<bool> done(false);
+
+    std::thread writer([&]() {
+        for (uint64_t n = 0; n < count; n++) {
+            ring.push(Sample{n, ~n});
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    uint64_t cursor = 0, lost = 0, received = 0;
+    bool intact = true;
+    Sample out[4];
+    for (;;) {
+        const bool finished = done.load(std::memory_order_acquire);
+        size_t n;
+        while ((n = ring.readFrom(cursor, out, 4, lost)) > 0) {
+            for (size_t i = 0; i < n; i++) {
+                intact &= out[i].inverted == ~out[i].n;
+            }
+            received += n;
+        }
+        if (finished && cursor == ring.head()) {
+            break;
+        }
+    }
+    writer.join();
+
+    CHECK(intact);
+    CHECK(received + lost == count);
+}
+
+} // namespace
+
+int main()
+{
+    testReadersKeepUp();
+    testOverwriteCounting();
+    testConcurrentReader();
+    return checkResult();
+}
@@ -0,0 +1,99 @@
+#include <cmath>
+
+#include "check.h"
+#include "mode_blend.h"
+
+namespace {
+
+void testIdle()
+{
+    ModeBlend blend;
+    CHECK(!blend.isActive());
+    CHECK(blend.weight() == 1.0);
+    CHECK(blend.mix(2.0, 5.0) == 5.0);
+
+    // Zero or negative lengths switch at once
+    blend.start(0);
+    CHECK(!blend.isActive());
+    CHECK(blend.weight() == 1.0);
+    blend.start(-3);
+    CHECK(!blend.isActive());
+}
+
+void testFade()
+{
+    // Raised cosine over 10 commits: the first already moves, the last
+    // lands on the new source, and the weights rise monotonically
+    const int commits = 10;
+    ModeBlend blend;
+    blend.start(commits);
+
+    double previous = 0.0;
+    for (int i = 0; i < commits; i++) {
+        CHECK(blend.isActive());
+        const double w = blend.weight();
+        CHECK_NEAR(w, 0.5 - 0.5 * std::cos(M_PI * (i + 1) / commits), 1e-12);
+        CHECK(w > previous);
+        CHECK_NEAR(blend.mix(-1.0, 3.0), -1.0 + 4.0 * w, 1e-12);
+        previous = w;
+        blend.advance();
+    }
+    CHECK(previous == 1.0);
+    CHECK(!blend.isActive());
+
+    // Advancing past the end holds the new source
+    blend.advance();
+    CHECK(blend.weight() == 1.0);
+}
+
+void testSymmetricAndSmooth()
+{
+    // Symmetric about the midpoint, with smaller steps at both ends than
+    // in the middle
+    const int commits = 100;
+    ModeBlend blend;
+    blend.start(commits);
+
+    double weights[commits];
+    for (int i = 0; i < commits; i++) {
+        weights[i] = blend.weight();
+        blend.advance();
+    }
+    for (int i = 0; i < commits - 1; i++) {
+        CHECK_NEAR(weights[i] + weights[commits - 2 - i], 1.0, 1e-12);
+    }
+    const double firstStep = weights[1] - weights[0];
+    const double middleStep = weights[commits / 2] - weights[commits / 2 - 1];
+    const double lastStep = weights[commits - 1] - weights[commits - 2];
+    CHECK(firstStep < 0.1 * middleStep);
+    CHECK(lastStep < 0.1 * middleStep);
+}
+
+void testRestartAndStop()
+{
+    ModeBlend blend;
+    blend.start(10);
+    for (int i = 0; i < 5; i++) {
+        blend.advance();
+    }
+
+    // A new mode change starts over from its own beginning
+    blend.start(4);
+    CHECK(blend.isActive());
+    CHECK_NEAR(blend.weight(), 0.5 - 0.5 * std::cos(M_PI / 4), 1e-12);
+
+    blend.stop();
+    CHECK(!blend.isActive());
+    CHECK(blend.weight() == 1.0);
+}
+
+} // namespace
+
+int main()
+{
+    testIdle();
+    testFade();
+    testSymmetricAndSmooth();
+    testRestartAndStop();
+    return checkResult();
+}
@@ -0,0 +1,154 @@
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <time.h>
+
+#include "check.h"
+#include "mpsc_queue.h"
+
+namespace {
+
+int64_t monotonicNs()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+}
+
+struct Item {
+    uint32_t producer;
+    uint32_t sequence;
+};
+
+void testFullAndWraparound()
+{
+    MpscQueue<int, 4> queue;
+    int value = -1;
+    CHECK(!queue.pop(value));
+
+    // Many laps of the cells, filling the queue every time
+    int next = 0;
+    int expected = 0;
+    for (int lap = 0; lap < 500; lap++) {
+        for (int i = 0; i < 4; i++) {
+            CHECK(queue.push(next++));
+        }
+        CHECK(!queue.push(-1));
+        for (int i = 0; i < 4; i++) {
+            CHECK(queue.pop(value));
+            CHECK(value == expected++);
+        }
+        CHECK(!queue.pop(value));
+    }
+    CHECK(queue.droppedCount() == 500);
+    CHECK(queue.skippedCount() == 0);
+}
+
+void testProducers()
+{
+    // Each producer's elements arrive in its order; none is lost uncounted
+    // and none is skipped while every producer keeps running
+    const int producers = 4;
+    const uint32_t perProducer = 100000;
+    std::unique_ptr<MpscQueue<Item, 256>> queue(new MpscQueue<Item, 256>());
+    std::atomic<int> running(producers);
+
+    std::thread threads[producers];
+    for (int p = 0; p < producers; p++) {
+        threads[p] = std::thread([&, p]() {
+            for (uint32_t n = 0; n < perProducer; n++) {
+                queue->push(Item{static_cast<uint32_t>(p), n});
+            }
+            running--;
+        });
+    }
+
+    uint64_t received = 0;
+    int64_t last[producers] = {-1, -1, -1, -1};
+    bool ordered = true;
+    Item item;
+    for (;;) {
+        const bool finished = running.load() == 0;
+        while (queue->pop(item, monotonicNs(), 1000000000LL)) {
+            if (static_cast<int64_t>(item.sequence) <= last[item.producer]) {
+                ordered = false;
+            }
+            last[item.producer] = item.sequence;
+            received++;
+        }
+        if (finished) {
+            break;
+        }
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    CHECK(ordered);
+    CHECK(received + queue->droppedCount() == static_cast<uint64_t>(producers) * perProducer);
+    CHECK(queue->skippedCount() == 0);
+}
+
+// Large enough that copying it keeps the producer between claiming its
+// cell and publishing it for a while
+struct Bulk {
+    uint64_t words[1 << 20];
+};
+
+void testStalledProducer()
+{
+    std::unique_ptr<MpscQueue<Bulk, 2>> queue(new MpscQueue<Bulk, 2>());
+    std::unique_ptr<Bulk> value(new Bulk());
+    std::unique_ptr<Bulk> out(new Bulk());
+
+    // The consumer polls with no stall timeout, so it skips the cell if it
+    // sees it claimed but unpublished twice. The late producer must then
+    // drop its element instead of publishing it.
+    bool skipped = false;
+    for (int attempt = 0; attempt < 50 && !skipped; attempt++) {
+        value->words[0] = static_cast<uint64_t>(attempt);
+        std::atomic<bool> pushed(false);
+        std::atomic<bool> done(false);
+        std::thread producer([&]() {
+            pushed.store(queue->push(*value));
+            done.store(true, std::memory_order_release);
+        });
+
+        const uint64_t skippedBefore = queue->skippedCount();
+        bool popped = false;
+        while (!done.load(std::memory_order_acquire) && queue->skippedCount() == skippedBefore) {
+            popped |= queue->pop(*out, monotonicNs(), 0);
+        }
+        producer.join();
+
+        if (queue->skippedCount() != skippedBefore) {
+            skipped = true;
+            CHECK(!popped);
+            CHECK(!pushed.load());
+            CHECK(!queue->pop(*out));
+        } else if (!popped) {
+            CHECK(queue->pop(*out));
+            CHECK(out->words[0] == static_cast<uint64_t>(attempt));
+        }
+    }
+    CHECK(skipped);
+
+    // The skipped cell is usable again on the next lap
+    for (uint64_t n = 0; n < 4; n++) {
+        value->words[0] = 1000 + n;
+        CHECK(queue->push(*value));
+        CHECK(queue->pop(*out));
+        CHECK(out->words[0] == 1000 + n);
+    }
+}
+
+} // namespace
+
+int main()
+{
+    testFullAndWraparound();
+    testProducers();
+    testStalledProducer();
+    return checkResult();
+}
@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <cmath>
+
+#include "check.h"
+#include "output_limiter.h"
+
+namespace {
+
+const double RATE_HZ = 1000.0;
+const double DT = 1.0 / RATE_HZ;
+
+OutputLimiter::Config oneChannel(double rate, double acceleration, double jerk)
+{
+    OutputLimiter::Config config;
+    config.channel[0] = OutputLimiter::ChannelLimits{rate, acceleration, jerk};
+    return config;
+}
+
+void testConfigureRejects()
+{
+    OutputLimiter limiter;
+    CHECK(limiter.configure(oneChannel(10.0, 100.0, 0.0), 1, RATE_HZ));
+
+    CHECK(!limiter.configure(oneChannel(10.0, 100.0, 0.0), 0, RATE_HZ));
+    CHECK(!limiter.configure(oneChannel(10.0, 100.0, 0.0), OutputLimiter::MAX_CHANNELS + 1, RATE_HZ));
+    CHECK(!limiter.configure(oneChannel(10.0, 100.0, 0.0), 1, 0.0));
+    CHECK(!limiter.configure(oneChannel(-1.0, 0.0, 0.0), 1, RATE_HZ));
+    CHECK(!limiter.configure(oneChannel(10.0, NAN, 0.0), 1, RATE_HZ));
+
+    // Jerk needs an acceleration limit and a boxcar of at most
+    // MAX_JERK_TAPS commits: 100 / 2000 s at 1 kHz is 50 taps
+    CHECK(!limiter.configure(oneChannel(10.0, 0.0, 1000.0), 1, RATE_HZ));
+    CHECK(!limiter.configure(oneChannel(10.0, 100.0, 2000.0), 1, RATE_HZ));
+    CHECK(limiter.configure(oneChannel(10.0, 100.0, 100.0 * RATE_HZ / OutputLimiter::MAX_JERK_TAPS), 1, RATE_HZ));
+
+    // A rejected configuration leaves the previous one
+    CHECK(limiter.config().channel[0].jerk == 100.0 * RATE_HZ / OutputLimiter::MAX_JERK_TAPS);
+}
+
+void testBypass()
+{
+    OutputLimiter::Config config = oneChannel(1.0, 1.0, 0.0);
+    config.bypass = true;
+    OutputLimiter limiter;
+    CHECK(limiter.configure(config, 1, RATE_HZ));
+
+    double command = 0.75;
+    CHECK(!limiter.apply(&command));
+    CHECK(command == 0.75);
+}
+
+void testRateLimit()
+{
+    OutputLimiter limiter;
+    CHECK(limiter.configure(oneChannel(10.0, 0.0, 0.0), 1, RATE_HZ));
+    const double start = 0.0;
+    limiter.reset(&start);
+
+    // 10 /s at 1 kHz moves 0.01 per commit and lands on the command
+    double previous = 0.0;
+    int commits = 0;
+    bool limited = true;
+    while (limited && commits < 1000) {
+        double output = 1.0;
+        limited = limiter.apply(&output);
+        CHECK(output - previous <= 10.0 * DT + 1e-12);
+        CHECK(output <= 1.0);
+        previous = output;
+        commits++;
+    }
+    CHECK(commits == 100);
+    CHECK_NEAR(previous, 1.0, 1e-12);
+}
+
+// Step to target and back, checking the limits on the output trajectory
+void checkStep(double rate, double acceleration, double jerk, double target)
+{
+    OutputLimiter limiter;
+    CHECK(limiter.configure(oneChannel(rate, acceleration, jerk), 1, RATE_HZ));
+    const double start = 0.0;
+    limiter.reset(&start);
+
+    double position = 0.0;
+    double velocity = 0.0;
+    double maxVelocityStep = 0.0;
+    double maxAccelStep = 0.0;
+    double maxJerkStep = 0.0;
+    double previousAccel = 0.0;
+    bool monotonic = true;
+    bool settled = false;
+    for (int i = 0; i < 20000 && !settled; i++) {
+        double output = target;
+        settled = !limiter.apply(&output);
+
+        const double v = output - position;
+        const double a = v - velocity;
+        maxVelocityStep = std::max(maxVelocityStep, std::abs(v));
+        maxAccelStep = std::max(maxAccelStep, std::abs(a));
+        maxJerkStep = std::max(maxJerkStep, std::abs(a - previousAccel));
+        monotonic &= v >= -1e-12;
+        CHECK(output <= target + 1e-12);
+
+        position = output;
+        velocity = v;
+        previousAccel = a;
+    }
+
+    CHECK(settled);
+    CHECK(monotonic);
+    CHECK_NEAR(position, target, 1e-9);
+    CHECK(maxVelocityStep <= rate * DT * (1.0 + 1e-9));
+    CHECK(maxAccelStep <= acceleration * DT * DT * (1.0 + 1e-9));
+    if (jerk > 0.0) {
+        // The boxcar spreads each acceleration step over its taps
+        const int taps = static_cast<int>(std::ceil(acceleration / jerk * RATE_HZ - 1e-9));
+        CHECK(maxJerkStep <= 2.0 * acceleration * DT * DT / taps * (1.0 + 1e-9));
+    }
+}
+
+void testNoOvershoot()
+{
+    checkStep(10.0, 100.0, 0.0, 1.0);
+    checkStep(10.0, 100.0, 0.0, 0.003);   // Never reaches the rate limit
+    checkStep(10.0, 100.0, 5000.0, 1.0);
+    checkStep(2.0, 50.0, 2500.0, 0.37);
+}
+
+void testReversal()
+{
+    // Commanded back while moving: decelerate and return without passing
+    // the new command
+    OutputLimiter limiter;
+    CHECK(limiter.configure(oneChannel(10.0, 100.0, 5000.0), 1, RATE_HZ));
+    const double start = 0.0;
+    limiter.reset(&start);
+
+    double output = 0.0;
+    for (int i = 0; i < 100; i++) {
+        output = 1.0;
+        limiter.apply(&output);
+    }
+    const double turn = output;
+    CHECK(turn > 0.0 && turn < 1.0);
+
+    double peak = turn;
+    for (int i = 0; i < 5000; i++) {
+        output = 0.0;
+        limiter.apply(&output);
+        peak = std::max(peak, output);
+        CHECK(output >= -1e-12);
+    }
+    CHECK(peak < 1.0);
+    CHECK_NEAR(output, 0.0, 1e-9);
+}
+
+void testChannelsIndependent()
+{
+    OutputLimiter::Config config;
+    config.channel[0] = OutputLimiter::ChannelLimits{10.0, 0.0, 0.0};
+    config.channel[1] = OutputLimiter::ChannelLimits{0.0, 0.0, 0.0};
+    OutputLimiter limiter;
+    CHECK(limiter.configure(config, 2, RATE_HZ));
+    const double start[2] = {0.0, 0.0};
+    limiter.reset(start);
+
+    double outputs[2] = {1.0, -0.5};
+    CHECK(limiter.apply(outputs));
+    CHECK_NEAR(outputs[0], 0.01, 1e-12);
+    CHECK(outputs[1] == -0.5);
+}
+
+} // namespace
+
+int main()
+{
+    testConfigureRejects();
+    testBypass();
+    testRateLimit();
+    testNoOvershoot();
+    testReversal();
+    testChannelsIndependent();
+    return checkResult();
+}
@@ -0,0 +1,146 @@
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "check.h"
+#include "command_slot.h"
+#include "seqlock.h"
+
+namespace {
+
+// Every field derives from n, so a torn read shows as a mismatch
+struct Sample {
+    uint64_t n;
+    uint64_t twice;
+    uint64_t inverted;
+    double half;
+};
+
+Sample makeSample(uint64_t n)
+{
+    return Sample{n, 2 * n, ~n, 0.5 * static_cast<double>(n)};
+}
+
+bool consistent(const Sample &s)
+{
+    return s.twice == 2 * s.n && s.inverted == ~s.n && s.half == 0.5 * static_cast<double>(s.n);
+}
+
+void testVersions()
+{
+    SeqLock<Sample> lock;
+    CHECK(lock.version() == 0);
+
+    lock.store(makeSample(7));
+    lock.store(makeSample(8));
+    CHECK(lock.version() == 2);
+
+    Sample s;
+    uint32_t version = 0;
+    CHECK(lock.tryLoad(s, version));
+    CHECK(version == 2);
+    CHECK(s.n == 8 && consistent(s));
+    CHECK(lock.load().n == 8);
+}
+
+void testConcurrentReaders()
+{
+    const uint64_t writes = 200000;
+    SeqLock<Sample> lock(makeSample(0));
+    std::atomic<bool> done(false);
+    std::atomic<int> torn(0);
+    std::atomic<int> backwards(0);
+
+    auto reader = [&]() {
+        uint64_t last = 0;
+        while (!done.load(std::memory_order_acquire)) {
+            const Sample s = lock.load();
+            if (!consistent(s)) {
+                torn++;
+            }
+            if (s.n < last) {
+                backwards++;
+            }
+            last = s.n;
+        }
+    };
+
+    std::thread r1(reader);
+    std::thread r2(reader);
+    for (uint64_t n = 1; n <= writes; n++) {
+        lock.store(makeSample(n));
+    }
+    done.store(true, std::memory_order_release);
+    r1.join();
+    r2.join();
+
+    CHECK(torn.load() == 0);
+    CHECK(backwards.load() == 0);
+    CHECK(lock.load().n == writes);
+    CHECK(lock.version() == writes + 1);
+}
+
+void testCommandSlotChanges()
+{
+    CommandSlot<Sample> slot(makeSample(1));
+    uint32_t seen = 0;
+    Sample s;
+
+    // The initial store is a change; loading it again is not
+    CHECK(slot.loadIfChanged(s, seen));
+    CHECK(s.n == 1 && seen == slot.version());
+    CHECK(!slot.loadIfChanged(s, seen));
+
+    slot.store(makeSample(2));
+    slot.store(makeSample(3));
+    CHECK(slot.loadIfChanged(s, seen));
+    CHECK(s.n == 3 && consistent(s));
+    CHECK(!slot.loadIfChanged(s, seen));
+    CHECK(slot.contentionCount() == 0);
+}
+
+void testCommandSlotWriters()
+{
+    // Any thread may store; the writers are serialized, so every value
+    // read is one of theirs and complete
+    const uint64_t writes = 50000;
+    CommandSlot<Sample> slot(makeSample(0));
+    std::atomic<bool> done(false);
+    std::atomic<int> torn(0);
+
+    std::thread reader([&]() {
+        while (!done.load(std::memory_order_acquire)) {
+            if (!consistent(slot.load())) {
+                torn++;
+            }
+        }
+    });
+
+    auto writer = [&](uint64_t base) {
+        for (uint64_t n = 0; n < writes; n++) {
+            slot.store(makeSample(base + n));
+        }
+    };
+    std::thread w1(writer, 0);
+    std::thread w2(writer, 1000000);
+    w1.join();
+    w2.join();
+    done.store(true, std::memory_order_release);
+    reader.join();
+
+    CHECK(torn.load() == 0);
+    CHECK(slot.version() == 2 * writes + 1);
+    const Sample last = slot.load();
+    CHECK(last.n == writes - 1 || last.n == 1000000 + writes - 1);
+}
+
+} // namespace
+
+int main()
+{
+    testVersions();
+    testConcurrentReaders();
+    testCommandSlotChanges();
+    testCommandSlotWriters();
+    return checkResult();
+}
@@ -0,0 +1,127 @@
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "check.h"
+#include "spsc_ring.h"
+
+namespace {
+
+void testFullAndDropped()
+{
+    SpscRing<int, 8> ring;
+    for (int i = 0; i < 8; i++) {
+        CHECK(ring.push(i));
+    }
+    CHECK(ring.size() == 8);
+
+    // Full: the new element is dropped, the queued ones are kept
+    CHECK(!ring.push(100));
+    CHECK(!ring.push(101));
+    CHECK(ring.droppedCount() == 2);
+
+    int value = -1;
+    for (int i = 0; i < 8; i++) {
+        CHECK(ring.pop(value));
+        CHECK(value == i);
+    }
+    CHECK(!ring.pop(value));
+    CHECK(ring.size() == 0);
+}
+
+void testWraparound()
+{
+    // Indices run far past the capacity; order and contents hold
+    SpscRing<int, 4> ring;
+    int next = 0;
+    int expected = 0;
+    for (int round = 0; round < 1000; round++) {
+        const int count = 1 + round % 4;
+        for (int i = 0; i < count; i++) {
+            CHECK(ring.push(next++));
+        }
+        int value = -1;
+        for (int i = 0; i < count; i++) {
+            CHECK(ring.pop(value));
+            CHECK(value == expected++);
+        }
+    }
+    CHECK(ring.droppedCount() == 0);
+}
+
+void testPopBulkAcrossTheEnd()
+{
+    SpscRing<int, 8> ring;
+    int value;
+    for (int i = 0; i < 6; i++) {
+        ring.push(i);
+    }
+    for (int i = 0; i < 6; i++) {
+        ring.pop(value);
+    }
+
+    // Elements 6..13 occupy the last two and the first six slots
+    for (int i = 6; i < 14; i++) {
+        CHECK(ring.push(i));
+    }
+    int out[16] = {};
+    CHECK(ring.popBulk(out, 5) == 5);
+    CHECK(ring.popBulk(out + 5, 16) == 3);
+    for (int i = 0; i < 8; i++) {
+        CHECK(out[i] == 6 + i);
+    }
+
+    ring.push(1);
+    ring.push(2);
+    ring.clear();
+    CHECK(ring.size() == 0);
+    CHECK(!ring.pop(value));
+}
+
+void testProducerConsumer()
+{
+    // Everything pushed is either popped, in order, or counted as dropped
+    const uint64_t count = 500000;
+    SpscRing<uint64_t, 64> ring;
+    std::atomic<bool> done(false);
+
+    std::thread producer([&]() {
+        for (uint64_t n = 0; n < count; n++) {
+            ring.push(n);
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    uint64_t received = 0;
+    uint64_t last = 0;
+    bool ordered = true;
+    uint64_t value;
+    for (;;) {
+        const bool finished = done.load(std::memory_order_acquire);
+        while (ring.pop(value)) {
+            if (received > 0 && value <= last) {
+                ordered = false;
+            }
+            last = value;
+            received++;
+        }
+        if (finished) {
+            break;
+        }
+    }
+    producer.join();
+
+    CHECK(ordered);
+    CHECK(received + ring.droppedCount() == count);
+}
+
+} // namespace
+
+int main()
+{
+    testFullAndDropped();
+    testWraparound();
+    testPopBulkAcrossTheEnd();
+    testProducerConsumer();
+    return checkResult();
+}
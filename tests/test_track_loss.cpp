@@ -0,0 +1,168 @@
+#include <cstdint>
+
+#include "check.h"
+#include "track_loss.h"
+
+namespace {
+
+typedef TrackLossPolicy::State State;
+
+const int64_t MS = 1000000;
+
+TrackLossPolicy::Config makeConfig(int64_t coastMs, int64_t holdMs, TrackLossPolicy::Fallback fallback)
+{
+    TrackLossPolicy::Config config;
+    config.coastNs = coastMs * MS;
+    config.holdNs = holdMs * MS;
+    config.fallback = fallback;
+    return config;
+}
+
+// Ticks every millisecond from `from` up to and including `to`
+void runTicks(TrackLossPolicy &policy, bool tracking, int64_t from, int64_t to)
+{
+    for (int64_t t = from; t <= to; t++) {
+        policy.update(true, tracking, t * MS);
+    }
+}
+
+void testConfigure()
+{
+    TrackLossPolicy policy;
+    CHECK(policy.configure(makeConfig(100, 500, TrackLossPolicy::Fallback::HOLD)));
+    CHECK(!policy.configure(makeConfig(-1, 500, TrackLossPolicy::Fallback::CENTER)));
+    CHECK(!policy.configure(makeConfig(100, -1, TrackLossPolicy::Fallback::CENTER)));
+    CHECK(policy.config().fallback == TrackLossPolicy::Fallback::HOLD);
+}
+
+void testTimeline()
+{
+    TrackLossPolicy policy;
+    CHECK(policy.configure(makeConfig(100, 500, TrackLossPolicy::Fallback::CENTER)));
+    CHECK(policy.state() == State::IDLE);
+
+    // No target since entering auto track: nothing to coast on
+    CHECK(policy.update(true, false, 0));
+    CHECK(policy.state() == State::ACQUIRING);
+    runTicks(policy, false, 1, 1000);
+    CHECK(policy.state() == State::ACQUIRING);
+    CHECK(policy.statistics().losses == 0);
+
+    runTicks(policy, true, 1001, 1100);
+    CHECK(policy.state() == State::TRACKING);
+
+    // Lost at 1101 ms: coast for 100 ms, hold for 500 ms, then fall back
+    CHECK(policy.update(true, false, 1101 * MS));
+    CHECK(policy.state() == State::COASTING);
+    CHECK(policy.statistics().losses == 1);
+    runTicks(policy, false, 1102, 1200);
+    CHECK(policy.state() == State::COASTING);
+    CHECK(policy.update(true, false, 1201 * MS));
+    CHECK(policy.state() == State::HOLDING);
+    runTicks(policy, false, 1202, 1700);
+    CHECK(policy.state() == State::HOLDING);
+    CHECK(policy.update(true, false, 1701 * MS));
+    CHECK(policy.state() == State::FALLBACK);
+    runTicks(policy, false, 1702, 2000);
+    CHECK(policy.state() == State::FALLBACK);
+    CHECK(policy.statistics().handedOff == 0);
+
+    // Reacquired after the fallback, 1000 ms after the loss
+    CHECK(policy.update(true, true, 2101 * MS));
+    CHECK(policy.state() == State::TRACKING);
+
+    const TrackLossStatistics stats = policy.statistics();
+    CHECK(stats.losses == 1);
+    CHECK(stats.reacquiredCoasting == 0);
+    CHECK(stats.reacquiredHolding == 0);
+    CHECK(stats.reacquiredFallback == 1);
+    CHECK(stats.reacquisition.count == 1);
+    CHECK_NEAR(stats.reacquisition.maxNs, 1000.0 * MS, 1000.0 * MS / LatencyHistogram::SUB_BUCKETS);
+}
+
+void testReacquisitionOutcomes()
+{
+    TrackLossPolicy policy;
+    CHECK(policy.configure(makeConfig(100, 500, TrackLossPolicy::Fallback::CENTER)));
+    runTicks(policy, true, 0, 10);
+
+    // Back within the coast time, then within the hold time
+    runTicks(policy, false, 11, 60);
+    runTicks(policy, true, 61, 100);
+    runTicks(policy, false, 101, 400);
+    CHECK(policy.state() == State::HOLDING);
+    runTicks(policy, true, 401, 500);
+
+    const TrackLossStatistics stats = policy.statistics();
+    CHECK(stats.losses == 2);
+    CHECK(stats.reacquiredCoasting == 1);
+    CHECK(stats.reacquiredHolding == 1);
+    CHECK(stats.reacquiredFallback == 0);
+    CHECK(stats.reacquisition.count == 2);
+
+    // Availability over the 500 ms in auto track: 350 ms without a target
+    CHECK(stats.autoNs == 500 * MS);
+    CHECK(stats.trackedNs == 150 * MS);
+}
+
+void testManualFallback()
+{
+    TrackLossPolicy policy;
+    CHECK(policy.configure(makeConfig(0, 0, TrackLossPolicy::Fallback::MANUAL)));
+    runTicks(policy, true, 0, 10);
+
+    // Zero coast and hold times pass straight through to the fallback
+    CHECK(policy.update(true, false, 11 * MS));
+    CHECK(policy.state() == State::FALLBACK);
+    CHECK(policy.statistics().handedOff == 1);
+
+    // Leaving auto track ends the loss without an outcome
+    CHECK(policy.update(false, false, 12 * MS));
+    CHECK(policy.state() == State::IDLE);
+    CHECK(!policy.update(false, true, 13 * MS));
+    const TrackLossStatistics stats = policy.statistics();
+    CHECK(stats.reacquiredFallback == 0);
+    CHECK(stats.reacquisition.count == 0);
+}
+
+void testResetAndRestart()
+{
+    TrackLossPolicy policy;
+    runTicks(policy, true, 0, 10);
+    runTicks(policy, false, 11, 20);
+    runTicks(policy, true, 21, 30);
+    CHECK(policy.statistics().losses == 1);
+
+    // The counters clear on the next update, the histogram on its next
+    // reacquisition
+    policy.resetStatistics();
+    policy.update(true, true, 31 * MS);
+    TrackLossStatistics stats = policy.statistics();
+    CHECK(stats.losses == 0);
+    CHECK(stats.reacquiredCoasting == 0);
+    CHECK(stats.autoNs == 1 * MS);
+    runTicks(policy, false, 32, 40);
+    runTicks(policy, true, 41, 50);
+    stats = policy.statistics();
+    CHECK(stats.losses == 1);
+    CHECK(stats.reacquisition.count == 1);
+
+    // A restart waits for a target again, keeping the statistics
+    policy.restart();
+    CHECK(policy.state() == State::IDLE);
+    policy.update(true, false, 100 * MS);
+    CHECK(policy.state() == State::ACQUIRING);
+    CHECK(policy.statistics().losses == 1);
+}
+
+} // namespace
+
+int main()
+{
+    testConfigure();
+    testTimeline();
+    testReacquisitionOutcomes();
+    testManualFallback();
+    testResetAndRestart();
+    return checkResult();
+}
@@ -0,0 +1,193 @@
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <sys/stat.h>
+
+#include "telemetry_recorder.h"
+
+// Offline converter for telemetry recordings (.bctr)
+//
+//   bc-trail-convert --csv <recording> <output.csv>
+//   bc-trail-convert --columns <recording> <output-dir>
+//
+// --columns writes one raw little-endian file per field plus schema.txt,
+// which loads directly with numpy.fromfile() or similar.
+
+namespace {
+
+const char *typeName(uint32_t type)
+{
+    switch (type) {
+    case FIELD_U64: return "uint64";
+    case FIELD_I64: return "int64";
+    case FIELD_I32: return "int32";
+    case FIELD_F64: return "float64";
+    default: return "unknown";
+    }
+}
+
+size_t typeSize(uint32_t type)
+{
+    return type == FIELD_I32 ? 4 : 8;
+}
+
+void printValue(FILE *out, const unsigned char *p, uint32_t type)
+{
+    switch (type) {
+    case FIELD_U64: {
+        uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        std::fprintf(out, "%" PRIu64, v);
+        break;
+    }
+    case FIELD_I64: {
+        int64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        std::fprintf(out, "%" PRId64, v);
+        break;
+    }
+    case FIELD_I32: {
+        int32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        std::fprintf(out, "%" PRId32, v);
+        break;
+    }
+    case FIELD_F64: {
+        double v;
+        std::memcpy(&v, p, sizeof(v));
+        std::fprintf(out, "%.9g", v);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+int writeCsv(const RecordingReader &reader, const char *path)
+{
+    FILE *out = std::fopen(path, "w");
+    if (!out) {
+        std::perror(path);
+        return 1;
+    }
+
+    const RecordingHeader &header = reader.header();
+    for (uint32_t f = 0; f < header.fieldCount; ++f) {
+        std::fprintf(out, f ? ",%s" : "%s", header.fields[f].name);
+    }
+    std::fputc('\n', out);
+
+    for (uint64_t i = 0; i < reader.recordCount(); ++i) {
+        const unsigned char *record = reader.record(i);
+        for (uint32_t f = 0; f < header.fieldCount; ++f) {
+            if (f) {
+                std::fputc(',', out);
+            }
+            printValue(out, record + header.fields[f].offset, header.fields[f].type);
+        }
+        std::fputc('\n', out);
+    }
+
+    return std::fclose(out) == 0 ? 0 : 1;
+}
+
+int writeColumns(const RecordingReader &reader, const char *dir)
+{
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        std::perror(dir);
+        return 1;
+    }
+
+    const RecordingHeader &header = reader.header();
+    std::string schemaPath = std::string(dir) + "/schema.txt";
+    FILE *schema = std::fopen(schemaPath.c_str(), "w");
+    if (!schema) {
+        std::perror(schemaPath.c_str());
+        return 1;
+    }
+    std::fprintf(schema, "records %" PRIu64 "\n", reader.recordCount());
+    std::fprintf(schema, "dropped %" PRIu64 "\n", header.droppedRecords);
+    std::fprintf(schema, "control_rate_hz %" PRIu32 "\n", header.controlRateHz);
+    std::fprintf(schema, "start_realtime_ns %" PRId64 "\n", header.startRealtimeNs);
+    std::fprintf(schema, "start_monotonic_ns %" PRId64 "\n", header.startMonotonicNs);
+
+    for (uint32_t f = 0; f < header.fieldCount; ++f) {
+        const RecordingField &field = header.fields[f];
+        std::fprintf(schema, "column %s %s %s.bin\n", field.name, typeName(field.type), field.name);
+
+        std::string path = std::string(dir) + "/" + field.name + ".bin";
+        FILE *out = std::fopen(path.c_str(), "wb");
+        if (!out) {
+            std::perror(path.c_str());
+            std::fclose(schema);
+            return 1;
+        }
+        size_t size = typeSize(field.type);
+        for (uint64_t i = 0; i < reader.recordCount(); ++i) {
+            std::fwrite(reader.record(i) + field.offset, size, 1, out);
+        }
+        if (std::fclose(out) != 0) {
+            std::perror(path.c_str());
+            std::fclose(schema);
+            return 1;
+        }
+    }
+
+    return std::fclose(schema) == 0 ? 0 : 1;
+}
+
+void usage(const char *program)
+{
+    std::fprintf(stderr,
+                 "Usage: %s --csv <recording> <output.csv>\n"
+                 "       %s --columns <recording> <output-dir>\n"
+                 "       %s --info <recording>\n",
+                 program, program, program);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::string mode = argv[1];
+    RecordingReader reader;
+    std::string error;
+    if (!reader.open(argv[2], error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    const RecordingHeader &header = reader.header();
+    if (mode == "--info") {
+        std::printf("records:   %" PRIu64 " of %" PRIu64 "\n", header.recordCount, header.capacity);
+        std::printf("dropped:   %" PRIu64 "\n", header.droppedRecords);
+        std::printf("rate:      %" PRIu32 " Hz\n", header.controlRateHz);
+        std::printf("fields:   ");
+        for (uint32_t f = 0; f < header.fieldCount; ++f) {
+            std::printf(" %s:%s", header.fields[f].name, typeName(header.fields[f].type));
+        }
+        std::printf("\n");
+        return 0;
+    }
+
+    if (argc < 4) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (mode == "--csv") {
+        return writeCsv(reader, argv[3]);
+    }
+    if (mode == "--columns") {
+        return writeColumns(reader, argv[3]);
+    }
+
+    usage(argv[0]);
+    return 2;
+}
@@ -0,0 +1,224 @@
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <time.h>
+#include <unistd.h>
+
+#include "ipc_channel.h"
+
+// Client of a running bc-traild over shared memory
+//
+//   bc-trail-ctl [--name <shm>] status
+//   bc-trail-ctl [--name <shm>] tail [count]
+//   bc-trail-ctl [--name <shm>] start | stop | reset-stats
+//   bc-trail-ctl [--name <shm>] mode coarse|fine|auto
+//   bc-trail-ctl [--name <shm>] servo|fsm-output|gimbal-output on|off
+//   bc-trail-ctl [--name <shm>] fsm-deadzone|gimbal-deadzone <fraction>
+//   bc-trail-ctl [--name <shm>] invert fsm-x|fsm-y|az|el|aux on|off
+
+namespace {
+
+const char *modeName(int32_t mode)
+{
+    switch (mode) {
+    case 0: return "coarse";
+    case 1: return "fine";
+    case 2: return "auto";
+    default: return "unknown";
+    }
+}
+
+int64_t monotonicNs()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+}
+
+void usage(const char *argv0)
+{
+    std::fprintf(stderr,
+                 "usage: %s [--name <shm>] <command> [args]\n"
+                 "  status                               Loop state and counters\n"
+                 "  tail [count]                         Print telemetry as it is published\n"
+                 "  start | stop | reset-stats\n"
+                 "  mode coarse|fine|auto\n"
+                 "  servo|fsm-output|gimbal-output on|off\n"
+                 "  fsm-deadzone|gimbal-deadzone <fraction>\n"
+                 "  invert fsm-x|fsm-y|az|el|aux on|off\n",
+                 argv0);
+}
+
+bool parseSwitch(const char *arg, int32_t &value)
+{
+    if (std::strcmp(arg, "on") == 0) {
+        value = 1;
+        return true;
+    }
+    if (std::strcmp(arg, "off") == 0) {
+        value = 0;
+        return true;
+    }
+    return false;
+}
+
+int printStatus(const IpcClient &client)
+{
+    const IpcStatus status = client.status();
+    const double ageMs = (monotonicNs() - status.updatedNs) / 1e6;
+
+    std::printf("running:    %s (updated %.0f ms ago)\n", status.running ? "yes" : "no", ageMs);
+    std::printf("mode:       %s\n", modeName(status.mode));
+    std::printf("servo:      %s\n", status.servoEnabled ? "on" : "off");
+    std::printf("rate:       %" PRId32 " Hz\n", status.controlRateHz);
+    std::printf("cycles:     %" PRIu64 "\n", status.cycles);
+    std::printf("overruns:   %" PRIu64 ", deadline misses %" PRIu64 "\n", status.overruns, status.deadlineMisses);
+    std::printf("commands:   %" PRIu64 " applied, %" PRIu64 " rejected, %" PRIu64 " skipped\n",
+                status.commandsApplied, status.commandsRejected, status.commandsSkipped);
+    std::printf("fsm:        output %s, deadzone %.3f, invert x %s y %s\n",
+                status.manual.fsmOutputEnabled ? "on" : "off", status.manual.fsmDeadzone,
+                status.manual.invertMask & MANUAL_INVERT_FSM_X ? "on" : "off",
+                status.manual.invertMask & MANUAL_INVERT_FSM_Y ? "on" : "off");
+    std::printf("gimbal:     output %s, deadzone %.3f, invert az %s el %s aux %s\n",
+                status.manual.gimbalOutputEnabled ? "on" : "off", status.manual.gimbalDeadzone,
+                status.manual.invertMask & MANUAL_INVERT_GIMBAL_AZ ? "on" : "off",
+                status.manual.invertMask & MANUAL_INVERT_GIMBAL_EL ? "on" : "off",
+                status.manual.invertMask & MANUAL_INVERT_GIMBAL_AUX ? "on" : "off");
+    return 0;
+}
+
+int tail(IpcClient &client, uint64_t count)
+{
+    std::printf("cycle,timestamp_ns,mode,tracking,fsm_x,fsm_y,gimbal_az,gimbal_el,gimbal_aux_el,"
+                "track_error_x,track_error_y,track_age_ns\n");
+
+    TelemetrySnapshot batch[256];
+    uint64_t printed = 0;
+    while (count == 0 || printed < count) {
+        const size_t n = client.readTelemetry(batch, sizeof(batch) / sizeof(batch[0]));
+        for (size_t i = 0; i < n && (count == 0 || printed < count); i++, printed++) {
+            const TelemetrySnapshot &s = batch[i];
+            std::printf("%" PRIu64 ",%" PRId64 ",%" PRId32 ",%" PRId32 ",%.6f,%.6f,%.6f,%.6f,%.6f,%.4f,%.4f,%" PRId64 "\n",
+                        s.cycle, s.timestampNs, s.mode, s.tracking, s.fsmX, s.fsmY,
+                        s.gimbalAz, s.gimbalEl, s.gimbalAuxEl, s.trackErrorX, s.trackErrorY, s.trackAgeNs);
+        }
+        if (n == 0) {
+            std::fflush(stdout);
+            usleep(10000);
+        }
+    }
+
+    if (client.lostCount() != 0) {
+        std::fprintf(stderr, "%" PRIu64 " snapshots overwritten before they were read\n", client.lostCount());
+    }
+    return 0;
+}
+
+// Queue a command and wait for the daemon to report it applied
+int send(IpcClient &client, IpcCommandType type, int32_t arg, double value)
+{
+    const uint64_t rejectedBefore = client.status().commandsRejected;
+    const uint64_t sequence = client.send(type, arg, value);
+    if (sequence == 0) {
+        std::fprintf(stderr, "Command queue full\n");
+        return 1;
+    }
+
+    const int64_t deadline = monotonicNs() + 1000000000LL;
+    while (monotonicNs() < deadline) {
+        const IpcStatus status = client.status();
+        if (status.lastCommandSequence == sequence) {
+            if (status.commandsRejected != rejectedBefore) {
+                std::fprintf(stderr, "Command rejected\n");
+                return 1;
+            }
+            return 0;
+        }
+        usleep(2000);
+    }
+
+    std::fprintf(stderr, "No confirmation from the control process within 1 s\n");
+    return 1;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::string name = IPC_DEFAULT_NAME;
+    int argi = 1;
+    if (argc > 2 && std::strcmp(argv[1], "--name") == 0) {
+        name = argv[2];
+        argi = 3;
+    }
+    if (argi >= argc) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    IpcClient client;
+    if (!client.open(name)) {
+        std::fprintf(stderr, "%s\n", client.lastError().c_str());
+        return 1;
+    }
+
+    const std::string command = argv[argi];
+    const char *arg = argi + 1 < argc ? argv[argi + 1] : nullptr;
+    const char *arg2 = argi + 2 < argc ? argv[argi + 2] : nullptr;
+    int32_t on = 0;
+
+    if (command == "status") {
+        return printStatus(client);
+    }
+    if (command == "tail") {
+        return tail(client, arg ? std::strtoull(arg, nullptr, 10) : 0);
+    }
+    if (command == "start") {
+        return send(client, IpcCommandType::START, 0, 0.0);
+    }
+    if (command == "stop") {
+        return send(client, IpcCommandType::STOP, 0, 0.0);
+    }
+    if (command == "reset-stats") {
+        return send(client, IpcCommandType::RESET_STATISTICS, 0, 0.0);
+    }
+    if (command == "mode" && arg) {
+        const std::string mode = arg;
+        if (mode == "coarse" || mode == "fine" || mode == "auto") {
+            return send(client, IpcCommandType::SET_MODE, mode == "coarse" ? 0 : mode == "fine" ? 1 : 2, 0.0);
+        }
+    }
+    if (arg && parseSwitch(arg, on)) {
+        if (command == "servo") {
+            return send(client, IpcCommandType::SET_SERVO, on, 0.0);
+        }
+        if (command == "fsm-output") {
+            return send(client, IpcCommandType::SET_FSM_OUTPUT, on, 0.0);
+        }
+        if (command == "gimbal-output") {
+            return send(client, IpcCommandType::SET_GIMBAL_OUTPUT, on, 0.0);
+        }
+    }
+    if (command == "fsm-deadzone" && arg) {
+        return send(client, IpcCommandType::SET_FSM_DEADZONE, 0, std::atof(arg));
+    }
+    if (command == "gimbal-deadzone" && arg) {
+        return send(client, IpcCommandType::SET_GIMBAL_DEADZONE, 0, std::atof(arg));
+    }
+    if (command == "invert" && arg && arg2 && parseSwitch(arg2, on)) {
+        const std::string axis = arg;
+        const uint32_t bit = axis == "fsm-x" ? MANUAL_INVERT_FSM_X
+                           : axis == "fsm-y" ? MANUAL_INVERT_FSM_Y
+                           : axis == "az" ? MANUAL_INVERT_GIMBAL_AZ
+                           : axis == "el" ? MANUAL_INVERT_GIMBAL_EL
+                           : axis == "aux" ? MANUAL_INVERT_GIMBAL_AUX : 0;
+        if (bit != 0) {
+            return send(client, IpcCommandType::SET_INVERT, static_cast<int32_t>(bit), on);
+        }
+    }
+
+    usage(argv[0]);
+    return 2;
+}